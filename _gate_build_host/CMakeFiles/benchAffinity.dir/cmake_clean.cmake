@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/benchAffinity.dir/bench/benchAffinity.cpp.o"
+  "CMakeFiles/benchAffinity.dir/bench/benchAffinity.cpp.o.d"
+  "benchAffinity"
+  "benchAffinity.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/benchAffinity.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/unittestProbe.dir/test/unittestProbe.cpp.o"
+  "CMakeFiles/unittestProbe.dir/test/unittestProbe.cpp.o.d"
+  "unittestProbe"
+  "unittestProbe.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/unittestProbe.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,18 @@
+# CMake generated Testfile for 
+# Source directory: /root/repo/base-firmware/host
+# Build directory: /root/repo/_gate_build_host
+# 
+# This file includes the relevant testing commands required for 
+# testing this directory and lists subdirectories to be tested as well.
+add_test(unittestCore "/root/repo/_gate_build_host/unittestCore")
+set_tests_properties(unittestCore PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/base-firmware/host/CMakeLists.txt;73;add_test;/root/repo/base-firmware/host/CMakeLists.txt;0;")
+add_test(unittestFSM "/root/repo/_gate_build_host/unittestFSM")
+set_tests_properties(unittestFSM PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/base-firmware/host/CMakeLists.txt;77;add_test;/root/repo/base-firmware/host/CMakeLists.txt;0;")
+add_test(unittestProbe "/root/repo/_gate_build_host/unittestProbe")
+set_tests_properties(unittestProbe PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/base-firmware/host/CMakeLists.txt;81;add_test;/root/repo/base-firmware/host/CMakeLists.txt;0;")
+add_test(unittestScheduler "/root/repo/_gate_build_host/unittestScheduler")
+set_tests_properties(unittestScheduler PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/base-firmware/host/CMakeLists.txt;85;add_test;/root/repo/base-firmware/host/CMakeLists.txt;0;")
+add_test(unittestPipeline "/root/repo/_gate_build_host/unittestPipeline")
+set_tests_properties(unittestPipeline PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/base-firmware/host/CMakeLists.txt;89;add_test;/root/repo/base-firmware/host/CMakeLists.txt;0;")
+add_test(unittestVBV "/root/repo/_gate_build_host/unittestVBV")
+set_tests_properties(unittestVBV PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/base-firmware/host/CMakeLists.txt;97;add_test;/root/repo/base-firmware/host/CMakeLists.txt;0;")
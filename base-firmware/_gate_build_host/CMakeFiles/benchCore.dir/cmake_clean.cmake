@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/benchCore.dir/bench/benchCore.cpp.o"
+  "CMakeFiles/benchCore.dir/bench/benchCore.cpp.o.d"
+  "benchCore"
+  "benchCore.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/benchCore.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,36 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/base-firmware/components/App/_pipeline.cpp" "CMakeFiles/mars_core.dir/root/repo/base-firmware/components/App/_pipeline.cpp.o" "gcc" "CMakeFiles/mars_core.dir/root/repo/base-firmware/components/App/_pipeline.cpp.o.d"
+  "/root/repo/base-firmware/components/App/_wing_calibration.cpp" "CMakeFiles/mars_core.dir/root/repo/base-firmware/components/App/_wing_calibration.cpp.o" "gcc" "CMakeFiles/mars_core.dir/root/repo/base-firmware/components/App/_wing_calibration.cpp.o.d"
+  "/root/repo/base-firmware/components/App/decomposer.cpp" "CMakeFiles/mars_core.dir/root/repo/base-firmware/components/App/decomposer.cpp.o" "gcc" "CMakeFiles/mars_core.dir/root/repo/base-firmware/components/App/decomposer.cpp.o.d"
+  "/root/repo/base-firmware/components/Memory/_alloc_count.cpp" "CMakeFiles/mars_core.dir/root/repo/base-firmware/components/Memory/_alloc_count.cpp.o" "gcc" "CMakeFiles/mars_core.dir/root/repo/base-firmware/components/Memory/_alloc_count.cpp.o.d"
+  "/root/repo/base-firmware/components/PID/_gain_schedule.cpp" "CMakeFiles/mars_core.dir/root/repo/base-firmware/components/PID/_gain_schedule.cpp.o" "gcc" "CMakeFiles/mars_core.dir/root/repo/base-firmware/components/PID/_gain_schedule.cpp.o.d"
+  "/root/repo/base-firmware/components/PID/_pid.cpp" "CMakeFiles/mars_core.dir/root/repo/base-firmware/components/PID/_pid.cpp.o" "gcc" "CMakeFiles/mars_core.dir/root/repo/base-firmware/components/PID/_pid.cpp.o.d"
+  "/root/repo/base-firmware/components/PTAM/_ptam.cpp" "CMakeFiles/mars_core.dir/root/repo/base-firmware/components/PTAM/_ptam.cpp.o" "gcc" "CMakeFiles/mars_core.dir/root/repo/base-firmware/components/PTAM/_ptam.cpp.o.d"
+  "/root/repo/base-firmware/components/PTAM/_ptam_persist.cpp" "CMakeFiles/mars_core.dir/root/repo/base-firmware/components/PTAM/_ptam_persist.cpp.o" "gcc" "CMakeFiles/mars_core.dir/root/repo/base-firmware/components/PTAM/_ptam_persist.cpp.o.d"
+  "/root/repo/base-firmware/components/PTAM/_ptam_regfile.cpp" "CMakeFiles/mars_core.dir/root/repo/base-firmware/components/PTAM/_ptam_regfile.cpp.o" "gcc" "CMakeFiles/mars_core.dir/root/repo/base-firmware/components/PTAM/_ptam_regfile.cpp.o.d"
+  "/root/repo/base-firmware/components/Profiling/_probe.cpp" "CMakeFiles/mars_core.dir/root/repo/base-firmware/components/Profiling/_probe.cpp.o" "gcc" "CMakeFiles/mars_core.dir/root/repo/base-firmware/components/Profiling/_probe.cpp.o.d"
+  "/root/repo/base-firmware/components/Profiling/_timestep.cpp" "CMakeFiles/mars_core.dir/root/repo/base-firmware/components/Profiling/_timestep.cpp.o" "gcc" "CMakeFiles/mars_core.dir/root/repo/base-firmware/components/Profiling/_timestep.cpp.o.d"
+  "/root/repo/base-firmware/components/system/VBV.cpp" "CMakeFiles/mars_core.dir/root/repo/base-firmware/components/system/VBV.cpp.o" "gcc" "CMakeFiles/mars_core.dir/root/repo/base-firmware/components/system/VBV.cpp.o.d"
+  "/root/repo/base-firmware/components/system/_flight_fsm.cpp" "CMakeFiles/mars_core.dir/root/repo/base-firmware/components/system/_flight_fsm.cpp.o" "gcc" "CMakeFiles/mars_core.dir/root/repo/base-firmware/components/system/_flight_fsm.cpp.o.d"
+  "/root/repo/base-firmware/components/system/_fsm.cpp" "CMakeFiles/mars_core.dir/root/repo/base-firmware/components/system/_fsm.cpp.o" "gcc" "CMakeFiles/mars_core.dir/root/repo/base-firmware/components/system/_fsm.cpp.o.d"
+  "/root/repo/base-firmware/components/system/_health.cpp" "CMakeFiles/mars_core.dir/root/repo/base-firmware/components/system/_health.cpp.o" "gcc" "CMakeFiles/mars_core.dir/root/repo/base-firmware/components/system/_health.cpp.o.d"
+  "/root/repo/base-firmware/components/system/_memory.cpp" "CMakeFiles/mars_core.dir/root/repo/base-firmware/components/system/_memory.cpp.o" "gcc" "CMakeFiles/mars_core.dir/root/repo/base-firmware/components/system/_memory.cpp.o.d"
+  "/root/repo/base-firmware/components/system/_rate_scheduler.cpp" "CMakeFiles/mars_core.dir/root/repo/base-firmware/components/system/_rate_scheduler.cpp.o" "gcc" "CMakeFiles/mars_core.dir/root/repo/base-firmware/components/system/_rate_scheduler.cpp.o.d"
+  "/root/repo/base-firmware/components/system/_state.cpp" "CMakeFiles/mars_core.dir/root/repo/base-firmware/components/system/_state.cpp.o" "gcc" "CMakeFiles/mars_core.dir/root/repo/base-firmware/components/system/_state.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
@@ -0,0 +1,45 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/mars_core.dir/root/repo/base-firmware/components/App/_pipeline.cpp.o"
+  "CMakeFiles/mars_core.dir/root/repo/base-firmware/components/App/_pipeline.cpp.o.d"
+  "CMakeFiles/mars_core.dir/root/repo/base-firmware/components/App/_wing_calibration.cpp.o"
+  "CMakeFiles/mars_core.dir/root/repo/base-firmware/components/App/_wing_calibration.cpp.o.d"
+  "CMakeFiles/mars_core.dir/root/repo/base-firmware/components/App/decomposer.cpp.o"
+  "CMakeFiles/mars_core.dir/root/repo/base-firmware/components/App/decomposer.cpp.o.d"
+  "CMakeFiles/mars_core.dir/root/repo/base-firmware/components/Memory/_alloc_count.cpp.o"
+  "CMakeFiles/mars_core.dir/root/repo/base-firmware/components/Memory/_alloc_count.cpp.o.d"
+  "CMakeFiles/mars_core.dir/root/repo/base-firmware/components/PID/_gain_schedule.cpp.o"
+  "CMakeFiles/mars_core.dir/root/repo/base-firmware/components/PID/_gain_schedule.cpp.o.d"
+  "CMakeFiles/mars_core.dir/root/repo/base-firmware/components/PID/_pid.cpp.o"
+  "CMakeFiles/mars_core.dir/root/repo/base-firmware/components/PID/_pid.cpp.o.d"
+  "CMakeFiles/mars_core.dir/root/repo/base-firmware/components/PTAM/_ptam.cpp.o"
+  "CMakeFiles/mars_core.dir/root/repo/base-firmware/components/PTAM/_ptam.cpp.o.d"
+  "CMakeFiles/mars_core.dir/root/repo/base-firmware/components/PTAM/_ptam_persist.cpp.o"
+  "CMakeFiles/mars_core.dir/root/repo/base-firmware/components/PTAM/_ptam_persist.cpp.o.d"
+  "CMakeFiles/mars_core.dir/root/repo/base-firmware/components/PTAM/_ptam_regfile.cpp.o"
+  "CMakeFiles/mars_core.dir/root/repo/base-firmware/components/PTAM/_ptam_regfile.cpp.o.d"
+  "CMakeFiles/mars_core.dir/root/repo/base-firmware/components/Profiling/_probe.cpp.o"
+  "CMakeFiles/mars_core.dir/root/repo/base-firmware/components/Profiling/_probe.cpp.o.d"
+  "CMakeFiles/mars_core.dir/root/repo/base-firmware/components/Profiling/_timestep.cpp.o"
+  "CMakeFiles/mars_core.dir/root/repo/base-firmware/components/Profiling/_timestep.cpp.o.d"
+  "CMakeFiles/mars_core.dir/root/repo/base-firmware/components/system/VBV.cpp.o"
+  "CMakeFiles/mars_core.dir/root/repo/base-firmware/components/system/VBV.cpp.o.d"
+  "CMakeFiles/mars_core.dir/root/repo/base-firmware/components/system/_flight_fsm.cpp.o"
+  "CMakeFiles/mars_core.dir/root/repo/base-firmware/components/system/_flight_fsm.cpp.o.d"
+  "CMakeFiles/mars_core.dir/root/repo/base-firmware/components/system/_fsm.cpp.o"
+  "CMakeFiles/mars_core.dir/root/repo/base-firmware/components/system/_fsm.cpp.o.d"
+  "CMakeFiles/mars_core.dir/root/repo/base-firmware/components/system/_health.cpp.o"
+  "CMakeFiles/mars_core.dir/root/repo/base-firmware/components/system/_health.cpp.o.d"
+  "CMakeFiles/mars_core.dir/root/repo/base-firmware/components/system/_memory.cpp.o"
+  "CMakeFiles/mars_core.dir/root/repo/base-firmware/components/system/_memory.cpp.o.d"
+  "CMakeFiles/mars_core.dir/root/repo/base-firmware/components/system/_rate_scheduler.cpp.o"
+  "CMakeFiles/mars_core.dir/root/repo/base-firmware/components/system/_rate_scheduler.cpp.o.d"
+  "CMakeFiles/mars_core.dir/root/repo/base-firmware/components/system/_state.cpp.o"
+  "CMakeFiles/mars_core.dir/root/repo/base-firmware/components/system/_state.cpp.o.d"
+  "libmars_core.a"
+  "libmars_core.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/mars_core.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/mars_tune.dir/tune/_autotune.cpp.o"
+  "CMakeFiles/mars_tune.dir/tune/_autotune.cpp.o.d"
+  "libmars_tune.a"
+  "libmars_tune.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/mars_tune.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/tunePID.dir/tune/tunePID.cpp.o"
+  "CMakeFiles/tunePID.dir/tune/tunePID.cpp.o.d"
+  "tunePID"
+  "tunePID.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/tunePID.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
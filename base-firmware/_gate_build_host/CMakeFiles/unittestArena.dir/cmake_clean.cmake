@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/unittestArena.dir/test/unittestArena.cpp.o"
+  "CMakeFiles/unittestArena.dir/test/unittestArena.cpp.o.d"
+  "unittestArena"
+  "unittestArena.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/unittestArena.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
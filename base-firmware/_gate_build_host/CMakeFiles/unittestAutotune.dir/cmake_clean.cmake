@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/unittestAutotune.dir/test/unittestAutotune.cpp.o"
+  "CMakeFiles/unittestAutotune.dir/test/unittestAutotune.cpp.o.d"
+  "unittestAutotune"
+  "unittestAutotune.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/unittestAutotune.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
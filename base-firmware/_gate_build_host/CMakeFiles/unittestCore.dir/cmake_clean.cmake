@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/unittestCore.dir/test/unittestCore.cpp.o"
+  "CMakeFiles/unittestCore.dir/test/unittestCore.cpp.o.d"
+  "unittestCore"
+  "unittestCore.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/unittestCore.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
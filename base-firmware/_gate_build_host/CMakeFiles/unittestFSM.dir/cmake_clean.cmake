@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/unittestFSM.dir/test/unittestFSM.cpp.o"
+  "CMakeFiles/unittestFSM.dir/test/unittestFSM.cpp.o.d"
+  "unittestFSM"
+  "unittestFSM.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/unittestFSM.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/unittestHealth.dir/test/unittestHealth.cpp.o"
+  "CMakeFiles/unittestHealth.dir/test/unittestHealth.cpp.o.d"
+  "unittestHealth"
+  "unittestHealth.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/unittestHealth.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
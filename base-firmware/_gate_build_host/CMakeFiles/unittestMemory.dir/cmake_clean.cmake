@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/unittestMemory.dir/test/unittestMemory.cpp.o"
+  "CMakeFiles/unittestMemory.dir/test/unittestMemory.cpp.o.d"
+  "unittestMemory"
+  "unittestMemory.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/unittestMemory.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
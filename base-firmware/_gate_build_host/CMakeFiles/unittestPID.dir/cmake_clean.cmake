@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/unittestPID.dir/test/unittestPID.cpp.o"
+  "CMakeFiles/unittestPID.dir/test/unittestPID.cpp.o.d"
+  "unittestPID"
+  "unittestPID.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/unittestPID.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
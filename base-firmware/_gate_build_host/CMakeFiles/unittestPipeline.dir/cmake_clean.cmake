@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/unittestPipeline.dir/test/unittestPipeline.cpp.o"
+  "CMakeFiles/unittestPipeline.dir/test/unittestPipeline.cpp.o.d"
+  "unittestPipeline"
+  "unittestPipeline.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/unittestPipeline.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
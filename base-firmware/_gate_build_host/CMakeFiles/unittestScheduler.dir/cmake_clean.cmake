@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/unittestScheduler.dir/test/unittestScheduler.cpp.o"
+  "CMakeFiles/unittestScheduler.dir/test/unittestScheduler.cpp.o.d"
+  "unittestScheduler"
+  "unittestScheduler.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/unittestScheduler.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
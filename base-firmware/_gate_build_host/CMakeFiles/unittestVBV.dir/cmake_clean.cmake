@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/unittestVBV.dir/VBV_unittest.cpp.o"
+  "CMakeFiles/unittestVBV.dir/VBV_unittest.cpp.o.d"
+  "unittestVBV"
+  "unittestVBV.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/unittestVBV.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,28 @@
+# CMake generated Testfile for 
+# Source directory: /root/repo/base-firmware/host
+# Build directory: /root/repo/base-firmware/_gate_build_host
+# 
+# This file includes the relevant testing commands required for 
+# testing this directory and lists subdirectories to be tested as well.
+add_test(unittestCore "/root/repo/base-firmware/_gate_build_host/unittestCore")
+set_tests_properties(unittestCore PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/base-firmware/host/CMakeLists.txt;80;add_test;/root/repo/base-firmware/host/CMakeLists.txt;0;")
+add_test(unittestFSM "/root/repo/base-firmware/_gate_build_host/unittestFSM")
+set_tests_properties(unittestFSM PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/base-firmware/host/CMakeLists.txt;84;add_test;/root/repo/base-firmware/host/CMakeLists.txt;0;")
+add_test(unittestProbe "/root/repo/base-firmware/_gate_build_host/unittestProbe")
+set_tests_properties(unittestProbe PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/base-firmware/host/CMakeLists.txt;88;add_test;/root/repo/base-firmware/host/CMakeLists.txt;0;")
+add_test(unittestScheduler "/root/repo/base-firmware/_gate_build_host/unittestScheduler")
+set_tests_properties(unittestScheduler PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/base-firmware/host/CMakeLists.txt;92;add_test;/root/repo/base-firmware/host/CMakeLists.txt;0;")
+add_test(unittestPipeline "/root/repo/base-firmware/_gate_build_host/unittestPipeline")
+set_tests_properties(unittestPipeline PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/base-firmware/host/CMakeLists.txt;96;add_test;/root/repo/base-firmware/host/CMakeLists.txt;0;")
+add_test(unittestMemory "/root/repo/base-firmware/_gate_build_host/unittestMemory")
+set_tests_properties(unittestMemory PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/base-firmware/host/CMakeLists.txt;100;add_test;/root/repo/base-firmware/host/CMakeLists.txt;0;")
+add_test(unittestHealth "/root/repo/base-firmware/_gate_build_host/unittestHealth")
+set_tests_properties(unittestHealth PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/base-firmware/host/CMakeLists.txt;104;add_test;/root/repo/base-firmware/host/CMakeLists.txt;0;")
+add_test(unittestPID "/root/repo/base-firmware/_gate_build_host/unittestPID")
+set_tests_properties(unittestPID PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/base-firmware/host/CMakeLists.txt;108;add_test;/root/repo/base-firmware/host/CMakeLists.txt;0;")
+add_test(unittestAutotune "/root/repo/base-firmware/_gate_build_host/unittestAutotune")
+set_tests_properties(unittestAutotune PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/base-firmware/host/CMakeLists.txt;120;add_test;/root/repo/base-firmware/host/CMakeLists.txt;0;")
+add_test(unittestArena "/root/repo/base-firmware/_gate_build_host/unittestArena")
+set_tests_properties(unittestArena PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/base-firmware/host/CMakeLists.txt;124;add_test;/root/repo/base-firmware/host/CMakeLists.txt;0;")
+add_test(unittestVBV "/root/repo/base-firmware/_gate_build_host/unittestVBV")
+set_tests_properties(unittestVBV PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/base-firmware/host/CMakeLists.txt;132;add_test;/root/repo/base-firmware/host/CMakeLists.txt;0;")
@@ -0,0 +1,342 @@
+/*MIT License
+Copyright (c) 2023 limitless Aeronautics
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#ifndef WING_MIXER_H
+#define WING_MIXER_H
+
+#include <cstdint>
+#include "decomposer.h"
+
+//Mixer inputs, normalised commands in [-1, 1]
+enum mix_input_t : uint8_t {
+    MIX_PITCH = 0,          //+ nose up
+    MIX_ROLL,               //+ right wing down
+    MIX_YAW,                //+ nose right
+    MIX_THROTTLE,           //+ collective sweep (drag), - has no surface
+    MIX_INPUTS
+};
+
+enum wing_id_t : uint8_t {
+    WING_FL = 0,
+    WING_FR,
+    WING_RL,
+    WING_RR,
+    WING_COUNT
+};
+
+struct mix_command_t {
+    double pitch;
+    double roll;
+    double yaw;
+    double throttle;
+};
+
+//Servo travel of one wing: position = deployed + direction * sweep
+struct mix_surface_t {
+    double deployed;        //Neutral servo position (deg)
+    double direction;       //+1 sweeps towards higher servo angles, -1 lower
+    double limit;           //Largest sweep from deployed (deg)
+};
+
+//____________________________________________________________
+/* Mixing table
+===========================================================================
+|    Wings only sweep one way from deployed, so each input has a column
+|    for its positive and one for its negative half:
+|      sweep[w] = sum over inputs of weight[w][i] * |command[i]|
+|    taken from positive[][] or negative[][] by the command's sign, as a
+|    fraction of the wing's limit. Weights are >= 0.
+|    priority lists the inputs most important first (see WingMixer).
+===========================================================================
+*/
+struct mixer_table_t {
+    double positive[WING_COUNT][MIX_INPUTS];
+    double negative[WING_COUNT][MIX_INPUTS];
+    mix_surface_t surfaces[WING_COUNT];
+    mix_input_t priority[MIX_INPUTS];
+};
+
+//____________________________________________________________
+/* The airframe's mix
+===========================================================================
+|    Nose up sweeps the rear pair, nose down the front pair, roll right the
+|    right pair, roll left the left pair (the legacy decomposer's roles).
+|    Yaw sweeps a diagonal pair, which leaves pitch and roll moments
+|    balanced. Throttle sweeps all four together.
+|    Left wings sweep 270 -> 230, right wings 90 -> 130.
+|    Attitude first: pitch, roll, then yaw, then throttle.
+===========================================================================
+*/
+constexpr mixer_table_t MIXER_DEFAULT_TABLE = {
+    //         pitch roll yaw  throttle
+    {
+        /*FL*/ {0.0, 0.0, 1.0, 1.0},
+        /*FR*/ {0.0, 1.0, 0.0, 1.0},
+        /*RL*/ {1.0, 0.0, 0.0, 1.0},
+        /*RR*/ {1.0, 1.0, 1.0, 1.0},
+    },
+    {
+        /*FL*/ {1.0, 1.0, 0.0, 0.0},
+        /*FR*/ {1.0, 0.0, 1.0, 0.0},
+        /*RL*/ {0.0, 1.0, 1.0, 0.0},
+        /*RR*/ {0.0, 0.0, 0.0, 0.0},
+    },
+    {
+        {WING_LEFT_DEPLOYED, -1.0, WING_SWEEP_LIMIT},
+        {WING_RIGHT_DEPLOYED, 1.0, WING_SWEEP_LIMIT},
+        {WING_LEFT_DEPLOYED, -1.0, WING_SWEEP_LIMIT},
+        {WING_RIGHT_DEPLOYED, 1.0, WING_SWEEP_LIMIT},
+    },
+    {MIX_PITCH, MIX_ROLL, MIX_YAW, MIX_THROTTLE},
+};
+
+//Weights >= 0, limits > 0, priority a permutation of the inputs
+constexpr bool mixer_valid(const mixer_table_t& table) {
+    bool seen[MIX_INPUTS] = {};
+    for (int i = 0; i < MIX_INPUTS; ++i) {
+        const int input = table.priority[i];
+        if (input >= MIX_INPUTS || seen[input]) {
+            return false;
+        }
+        seen[input] = true;
+    }
+    for (int w = 0; w < WING_COUNT; ++w) {
+        if (!(table.surfaces[w].limit > 0.0)) {
+            return false;
+        }
+        for (int i = 0; i < MIX_INPUTS; ++i) {
+            if (table.positive[w][i] < 0.0 || table.negative[w][i] < 0.0) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static_assert(mixer_valid(MIXER_DEFAULT_TABLE), "default mixing table");
+
+//A command clamped to [-1, 1], NaN holds it at neutral
+constexpr double mix_clamp(double value) {
+    return !(value == value) ? 0.0 : (value > 1.0 ? 1.0 : (value < -1.0 ? -1.0 : value));
+}
+
+//____________________________________________________________
+/* Table driven mixer, every input to all four wings in one pass
+===========================================================================
+|    Saturation priority: inputs are added in priority order, each one
+|    scaled down just enough that no wing passes its limit given what the
+|    more important inputs already use. A saturating roll therefore never
+|    eats into pitch, and yaw / throttle get what is left. An input cut
+|    this way is reported so the caller can hold its integrator.
+|    No allocation, no branches on strings, constexpr: a table can be
+|    checked at compile time.
+===========================================================================
+*/
+class WingMixer {
+public:
+    constexpr explicit WingMixer(const mixer_table_t& table = MIXER_DEFAULT_TABLE) : table_(table) {}
+
+    //____________________________________________________________
+    /* Main subroutine -> command to wing positions
+    ===========================================================================
+    |    command         Inputs, clamped to [-1, 1]
+    |    out             Servo positions, inside every surface's limit
+    |    Returns         Bit (1 << mix_input_t) set for each input that was
+    |                    scaled down by saturation
+    ===========================================================================
+    */
+    constexpr uint8_t mix(const mix_command_t& command, wing_set_t& out) const {
+        double sweep[WING_COUNT] = {};
+        const uint8_t cut = sweeps(command, sweep);
+        positions(sweep, out);
+        return cut;
+    }
+
+    //mix() before the surfaces: sweeps as fractions of each limit, [0, 1]
+    constexpr uint8_t sweeps(const mix_command_t& command, double (&sweep)[WING_COUNT]) const {
+        const double inputs[MIX_INPUTS] = {command.pitch, command.roll, command.yaw, command.throttle};
+        uint8_t cut = 0;
+        for (int w = 0; w < WING_COUNT; ++w) {
+            sweep[w] = 0.0;
+        }
+        for (int p = 0; p < MIX_INPUTS; ++p) {
+            const mix_input_t input = table_.priority[p];
+            const double value = mix_clamp(inputs[input]);
+            const double magnitude = value < 0.0 ? -value : value;
+            const double (&weights)[WING_COUNT][MIX_INPUTS] = value < 0.0 ? table_.negative : table_.positive;
+
+            //Largest share of the input every wing still has room for
+            double scale = 1.0;
+            for (int w = 0; w < WING_COUNT; ++w) {
+                const double add = magnitude * weights[w][input];
+                const double room = 1.0 - sweep[w];
+                if (add > 0.0 && add * scale > room) {
+                    scale = room > 0.0 ? room / add : 0.0;
+                }
+            }
+            if (scale < 1.0) {
+                cut |= uint8_t(1u << input);
+            }
+            for (int w = 0; w < WING_COUNT; ++w) {
+                sweep[w] += scale * magnitude * weights[w][input];
+            }
+        }
+        return cut;
+    }
+
+    //Sweep fractions to servo positions through the table's surfaces
+    constexpr void positions(const double (&sweep)[WING_COUNT], wing_set_t& out) const {
+        double* const positions[WING_COUNT] = {&out.fl, &out.fr, &out.rl, &out.rr};
+        for (int w = 0; w < WING_COUNT; ++w) {
+            const mix_surface_t& s = table_.surfaces[w];
+            const double fraction = sweep[w] > 1.0 ? 1.0 : (sweep[w] < 0.0 ? 0.0 : sweep[w]);
+            *positions[w] = s.deployed + s.direction * fraction * s.limit;
+        }
+    }
+
+    constexpr const mixer_table_t& table() const { return table_; }
+
+private:
+    mixer_table_t table_;
+};
+
+//Allocated pitch / roll axes
+enum alloc_axis_t : uint8_t {
+    ALLOC_PITCH = 0,
+    ALLOC_ROLL,
+    ALLOC_AXES
+};
+
+//Gauss-Seidel sweeps per allocation, fixed so every tick costs the same
+#define ALLOC_SWEEPS 8
+
+//____________________________________________________________
+/* Control allocation model
+===========================================================================
+|    moment[a] = sum over wings of effectiveness[a][w] * sweep[w], in the
+|    mixer's normalised command units (sweep as a fraction of the limit).
+|    weight ranks the axes' errors when both cannot be met, sweep_cost
+|    keeps the wings no further out than the moments need (small enough
+|    to move the moments by ~1e-6 only).
+===========================================================================
+*/
+struct alloc_model_t {
+    double effectiveness[ALLOC_AXES][WING_COUNT];
+    double weight[ALLOC_AXES];
+    double sweep_cost;
+};
+
+//The moments wingsToAxes reads back: pitch (rear - front) / 2, roll (right - left) / 2
+constexpr alloc_model_t ALLOC_DEFAULT_MODEL = {
+    {
+        //   FL    FR    RL    RR
+        {-0.5, -0.5, 0.5, 0.5},
+        {-0.5, 0.5, -0.5, 0.5},
+    },
+    {1.0, 1.0},
+    1e-6,
+};
+
+//Achieved moments of an allocation
+struct alloc_moments_t {
+    double pitch;
+    double roll;
+};
+
+//____________________________________________________________
+/* Coupled pitch + roll allocation, all four wings
+===========================================================================
+|    Box constrained least squares per tick:
+|      min  sum_a weight[a] (B s - d)_a^2 + sweep_cost |s|^2,  0 <= s <= 1
+|    solved by projected Gauss-Seidel over the four sweeps. It starts from
+|    WingMixer's sweeps (exact whenever both demands fit) and every update
+|    lowers the cost, so the result is never worse than the priority
+|    mixer. Converges in ~4 sweeps on the default model. When the demands do not fit
+|    the error is shared by weight instead of dropping roll first.
+|    A fixed ALLOC_SWEEPS, no early exit: deterministic time.
+===========================================================================
+*/
+class WingAllocator {
+public:
+    constexpr explicit WingAllocator(const alloc_model_t& model = ALLOC_DEFAULT_MODEL,
+                                     const mixer_table_t& table = MIXER_DEFAULT_TABLE)
+        : model_(model), mixer_(table), hessian_(), diagonal_() {
+        //Normal equations, fixed for the model: H = B^T W B + sweep_cost I
+        for (int i = 0; i < WING_COUNT; ++i) {
+            for (int j = 0; j < WING_COUNT; ++j) {
+                double h = i == j ? model.sweep_cost : 0.0;
+                for (int a = 0; a < ALLOC_AXES; ++a) {
+                    h += model.weight[a] * model.effectiveness[a][i] * model.effectiveness[a][j];
+                }
+                hessian_[i][j] = h;
+            }
+            diagonal_[i] = hessian_[i][i] > 0.0 ? 1.0 / hessian_[i][i] : 0.0;
+        }
+    }
+
+    //____________________________________________________________
+    /* Main subroutine -> pitch and roll demands to wing positions
+    ===========================================================================
+    |    pitch, roll     Normalised demands, clamped to [-1, 1]
+    |    out             Servo positions, inside every surface's limit
+    |    Returns         The moments the wings give, equal to the demands
+    |                    whenever they can be met
+    ===========================================================================
+    */
+    constexpr alloc_moments_t allocate(double pitch, double roll, wing_set_t& out) const {
+        const double demand[ALLOC_AXES] = {mix_clamp(pitch), mix_clamp(roll)};
+        double sweep[WING_COUNT] = {};
+        mixer_.sweeps({demand[ALLOC_PITCH], demand[ALLOC_ROLL], 0.0, 0.0}, sweep);
+
+        //Linear term B^T W d
+        double linear[WING_COUNT] = {};
+        for (int w = 0; w < WING_COUNT; ++w) {
+            for (int a = 0; a < ALLOC_AXES; ++a) {
+                linear[w] += model_.weight[a] * model_.effectiveness[a][w] * demand[a];
+            }
+        }
+        for (int k = 0; k < ALLOC_SWEEPS; ++k) {
+            for (int w = 0; w < WING_COUNT; ++w) {
+                double gradient = -linear[w];
+                for (int j = 0; j < WING_COUNT; ++j) {
+                    gradient += hessian_[w][j] * sweep[j];
+                }
+                const double next = sweep[w] - gradient * diagonal_[w];
+                sweep[w] = next < 0.0 ? 0.0 : (next > 1.0 ? 1.0 : next);
+            }
+        }
+
+        mixer_.positions(sweep, out);
+        alloc_moments_t achieved = {0.0, 0.0};
+        for (int w = 0; w < WING_COUNT; ++w) {
+            achieved.pitch += model_.effectiveness[ALLOC_PITCH][w] * sweep[w];
+            achieved.roll += model_.effectiveness[ALLOC_ROLL][w] * sweep[w];
+        }
+        return achieved;
+    }
+
+    constexpr const alloc_model_t& model() const { return model_; }
+
+private:
+    alloc_model_t model_;
+    WingMixer mixer_;
+    double hessian_[WING_COUNT][WING_COUNT];
+    double diagonal_[WING_COUNT];
+};
+
+#endif // WING_MIXER_H
@@ -0,0 +1,265 @@
+/*MIT License
+Copyright (c) 2023 limitless Aeronautics
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#include "_pipeline.h"
+#include "../Profiling/_probe_clock.h"
+
+#include <algorithm>
+#include <cmath>
+
+#define PIPELINE_RAD_TO_DEG (180.0 / M_PI)
+#define PIPELINE_DEG_TO_RAD (M_PI / 180.0)
+//Metres per degree of latitude (mean earth radius)
+#define PIPELINE_M_PER_DEG 111195.0
+
+static const char* const STAGE_NAMES[PIPELINE_STAGE_COUNT] = {
+    "guidance", "attitude", "pid", "decompose", "actuate"
+};
+
+//Heading error folded into [-180, 180)
+static double wrap180(double deg) {
+    deg = std::fmod(deg + 180.0, 360.0);
+    if (deg < 0.0) {
+        deg += 360.0;
+    }
+    return deg - 180.0;
+}
+
+FlightPipeline::FlightPipeline(const pipeline_config_t& config, pipeline_actuator_t actuator, void* ctx)
+    : config_(config), actuator_(actuator), ctx_(ctx), mission_(), missionCount_(0),
+      pid_(pidConfig(config)), schedule_(nullptr), speed_(config.cruise_speed), lastFix_(),
+      sinceFix_(0.0), haveFix_(false), guidance_(), attitude_(), axis_(), wings_(), times_() {
+    DECOMPOSER::mixToWings(0.0, 0.0, wings_);
+}
+
+FlightPipeline::axis_pid_t::config_t FlightPipeline::pidConfig(const pipeline_config_t& config) {
+    axis_pid_t::config_t pid;
+    pid.set(AXIS_PITCH, config.pitch, config.pitch_shaping);
+    pid.set(AXIS_ROLL, config.roll, config.roll_shaping);
+    return pid;
+}
+
+bool FlightPipeline::setMission(const waypoint_t* waypoints, std::size_t count) {
+    if (count == 0 || count > PIPELINE_MAX_WAYPOINTS) {
+        return false;
+    }
+    std::copy(waypoints, waypoints + count, mission_);
+    missionCount_ = count;
+    reset();
+    return true;
+}
+
+void FlightPipeline::setSchedule(const GainSchedule* schedule) {
+    schedule_ = schedule;
+    //Detached: back to the fixed gains
+    pid_.setConfig(pidConfig(config_));
+}
+
+void FlightPipeline::reset() {
+    pid_.reset();
+    speed_ = config_.cruise_speed;
+    sinceFix_ = 0.0;
+    haveFix_ = false;
+    guidance_ = guidance_t();
+    if (missionCount_ != 0) {
+        guidance_.target = mission_[0];
+    }
+    attitude_ = attitude_cmd_t();
+    axis_ = axis_cmd_t();
+    DECOMPOSER::mixToWings(0.0, 0.0, wings_);
+}
+
+void FlightPipeline::step(const nav_state_t& nav, double dt) {
+    //Each stage timed on the probe clock (32 bit, differences wrap safely)
+    const uint32_t t0 = probe_ticks();
+    runGuidance(nav);
+    const uint32_t t1 = probe_ticks();
+    runAttitude(nav);
+    const uint32_t t2 = probe_ticks();
+    runSchedule(nav, dt);
+    runPID(nav, dt);
+    const uint32_t t3 = probe_ticks();
+    runDecompose();
+    const uint32_t t4 = probe_ticks();
+    runActuate();
+    const uint32_t t5 = probe_ticks();
+
+    const uint32_t spans[PIPELINE_STAGE_COUNT] = {t1 - t0, t2 - t1, t3 - t2, t4 - t3, t5 - t4};
+    for (std::size_t i = 0; i < PIPELINE_STAGE_COUNT; ++i) {
+        stage_time_t& time = times_[i];
+        time.runs++;
+        time.last = spans[i];
+        time.sum += spans[i];
+        if (spans[i] > time.max) {
+            time.max = spans[i];
+        }
+    }
+}
+
+//____________________________________________________________
+/* Stage 1 -> active waypoint, distance and bearing to it
+===========================================================================
+|    A waypoint inside accept_radius hands over to the next one, the last
+|    one marks the mission complete
+===========================================================================
+*/
+void FlightPipeline::runGuidance(const nav_state_t& nav) {
+    if (missionCount_ == 0 || !nav.position_valid) {
+        return;
+    }
+    while (!guidance_.complete) {
+        const waypoint_t& target = mission_[guidance_.index];
+        const double dx = target.x - nav.x;
+        const double dy = target.y - nav.y;
+        const double dz = target.z - nav.z;
+        guidance_.target = target;
+        guidance_.distance = std::sqrt(dx * dx + dy * dy + dz * dz);
+        guidance_.bearing = std::atan2(dy, dx) * PIPELINE_RAD_TO_DEG;
+        if (guidance_.distance > config_.accept_radius) {
+            break;
+        }
+        if (guidance_.index + 1u >= missionCount_) {
+            guidance_.complete = true;
+            break;
+        }
+        guidance_.index++;
+    }
+}
+
+//____________________________________________________________
+/* Stage 2 -> pitch and roll to fly towards the waypoint
+===========================================================================
+|    Pitch is the climb angle to the waypoint (as in
+|    FlightControl::calculatePitchAndRoll), roll banks towards its bearing.
+|    No fix or mission complete -> wings level.
+===========================================================================
+*/
+void FlightPipeline::runAttitude(const nav_state_t& nav) {
+    if (missionCount_ == 0 || !nav.position_valid || guidance_.complete) {
+        attitude_.pitch = 0.0;
+        attitude_.roll = 0.0;
+        return;
+    }
+    const double dx = guidance_.target.x - nav.x;
+    const double dy = guidance_.target.y - nav.y;
+    const double dz = guidance_.target.z - nav.z;
+    const double climb = std::atan2(dz, std::sqrt(dx * dx + dy * dy)) * PIPELINE_RAD_TO_DEG;
+    const double headingError = wrap180(guidance_.bearing - nav.yaw);
+    attitude_.pitch = std::clamp(climb, -config_.max_pitch, config_.max_pitch);
+    attitude_.roll = std::clamp(config_.heading_gain * headingError, -config_.max_roll, config_.max_roll);
+}
+
+void FlightPipeline::transfer(const wing_set_t& wings, const nav_state_t& nav) {
+    //Targets of the first step, as step() will compute them
+    runGuidance(nav);
+    runAttitude(nav);
+    double pitch = 0.0, roll = 0.0;
+    DECOMPOSER::wingsToAxes(wings, pitch, roll);
+    pid_.transfer({pid_real_t(pitch), pid_real_t(roll)},
+                  {pid_real_t(attitude_.pitch), pid_real_t(attitude_.roll)},
+                  {pid_real_t(nav.pitch), pid_real_t(nav.roll)});
+    axis_ = {pitch, roll};
+    DECOMPOSER::allocateToWings(pitch, roll, wings_);
+}
+
+//____________________________________________________________
+/* Stage 3a -> operating point and scheduled gains
+===========================================================================
+|    Speed is the distance between two different fixes over the time
+|    between them (fixes arrive slower than the control rate), low-passed.
+|    No airspeed sensor: over ground is the best estimate there is.
+===========================================================================
+*/
+void FlightPipeline::runSchedule(const nav_state_t& nav, double dt) {
+    if (nav.position_valid) {
+        sinceFix_ += dt > 0.0 ? dt : 0.0;
+        const double dx = nav.x - lastFix_[0], dy = nav.y - lastFix_[1], dz = nav.z - lastFix_[2];
+        const bool moved = dx != 0.0 || dy != 0.0 || dz != 0.0;
+        if (haveFix_ && moved && sinceFix_ > 0.0) {
+            const double measured = std::sqrt(dx * dx + dy * dy + dz * dz) / sinceFix_;
+            speed_ += sinceFix_ / (config_.speed_tau + sinceFix_) * (measured - speed_);
+        }
+        if (!haveFix_ || moved) {
+            lastFix_[0] = nav.x;
+            lastFix_[1] = nav.y;
+            lastFix_[2] = nav.z;
+            sinceFix_ = 0.0;
+            haveFix_ = true;
+        }
+    }
+
+    gain_triplet_t gains[GAIN_AXES];
+    if (schedule_ != nullptr && schedule_->lookup(speed_, nav.z, gains)) {
+        pid_.setGains(AXIS_PITCH, gains[AXIS_PITCH].kp, gains[AXIS_PITCH].ki, gains[AXIS_PITCH].kd);
+        pid_.setGains(AXIS_ROLL, gains[AXIS_ROLL].kp, gains[AXIS_ROLL].ki, gains[AXIS_ROLL].kd);
+    } else if (schedule_ != nullptr) {
+        //Table cleared: the fixed gains again
+        pid_.setGains(AXIS_PITCH, config_.pitch.kp, config_.pitch.ki, config_.pitch.kd);
+        pid_.setGains(AXIS_ROLL, config_.roll.kp, config_.roll.ki, config_.roll.kd);
+    }
+}
+
+//Stage 3 -> attitude error to normalised axis commands
+void FlightPipeline::runPID(const nav_state_t& nav, double dt) {
+    const axis_pid_t::vector_t target = {pid_real_t(attitude_.pitch), pid_real_t(attitude_.roll)};
+    const axis_pid_t::vector_t current = {pid_real_t(nav.pitch), pid_real_t(nav.roll)};
+    axis_pid_t::vector_t out;
+    pid_.step(target, current, pid_real_t(dt), out);
+    axis_.pitch = out[AXIS_PITCH];
+    axis_.roll = out[AXIS_ROLL];
+}
+
+//Stage 4 -> axis commands to wing positions, both axes allocated together
+void FlightPipeline::runDecompose() {
+    DECOMPOSER::allocateToWings(axis_.pitch, axis_.roll, wings_);
+}
+
+//Stage 5 -> hand the wing positions to the (non-blocking) sink
+void FlightPipeline::runActuate() {
+    if (actuator_ != nullptr) {
+        actuator_(ctx_, wings_);
+    }
+}
+
+std::size_t FlightPipeline::stats(pipeline_stage_stats_t* out, std::size_t max) const {
+    const uint64_t perUs = probe_ticks_per_us();
+    //Ticks to nanoseconds
+    auto ns = [perUs](uint64_t ticks) { return static_cast<uint32_t>(ticks * 1000 / perUs); };
+    std::size_t n = 0;
+    for (std::size_t i = 0; i < PIPELINE_STAGE_COUNT && n < max; ++i) {
+        const stage_time_t& time = times_[i];
+        pipeline_stage_stats_t& s = out[n++];
+        s.name = STAGE_NAMES[i];
+        s.runs = time.runs;
+        s.last_ns = ns(time.last);
+        s.max_ns = ns(time.max);
+        s.mean_ns = time.runs != 0 ? ns(time.sum / time.runs) : 0;
+    }
+    return n;
+}
+
+void FlightPipeline::resetStats() {
+    for (stage_time_t& time : times_) {
+        time = stage_time_t();
+    }
+}
+
+void FlightPipeline::geoToLocal(double lat, double lon, double ref_lat, double ref_lon, double& north, double& east) {
+    north = (lat - ref_lat) * PIPELINE_M_PER_DEG;
+    east = (lon - ref_lon) * PIPELINE_M_PER_DEG * std::cos(ref_lat * PIPELINE_DEG_TO_RAD);
+}
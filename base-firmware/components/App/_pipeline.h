@@ -0,0 +1,243 @@
+/*MIT License
+Copyright (c) 2023 limitless Aeronautics
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#ifndef FLIGHT_PIPELINE_H
+#define FLIGHT_PIPELINE_H
+
+#include <cstddef>
+#include <cstdint>
+#include "decomposer.h"
+#include "../PID/_pid.h"
+#include "../PID/_pid_flight.h"
+#include "../PID/_gain_schedule.h"
+
+//Waypoints held by the pipeline, the mission is copied in
+#define PIPELINE_MAX_WAYPOINTS 16
+
+//____________________________________________________________
+/* Flight pipeline frames and stage outputs
+===========================================================================
+|    Local frame: x north, y east, z altitude (metres). Angles in degrees,
+|    yaw clockwise from north, positive pitch nose up, positive roll right
+|    wing down (turns towards increasing yaw).
+===========================================================================
+*/
+struct nav_state_t {
+    double x;
+    double y;
+    double z;
+    double pitch;
+    double roll;
+    double yaw;
+    bool position_valid;    //false: no fix, guidance holds wings level
+};
+
+struct waypoint_t {
+    double x;
+    double y;
+    double z;
+};
+
+//Stage 1 -> where to go
+struct guidance_t {
+    uint8_t index;          //Active waypoint
+    waypoint_t target;
+    double distance;        //Metres to the active waypoint
+    double bearing;         //Degrees, clockwise from north
+    bool complete;          //Every waypoint reached
+};
+
+//Stage 2 -> attitude to fly
+struct attitude_cmd_t {
+    double pitch;
+    double roll;
+};
+
+//Stage 3 -> normalised axis commands, [-1, 1]
+struct axis_cmd_t {
+    double pitch;
+    double roll;
+};
+
+struct pipeline_config_t {
+    double accept_radius;   //Waypoint reached inside this distance (m)
+    double max_pitch;       //Attitude command limits (deg)
+    double max_roll;
+    double heading_gain;    //Roll command per degree of heading error
+    pid_gains_t pitch;
+    pid_gains_t roll;
+    pid_shaping_t pitch_shaping;    //Anti-windup, derivative filter, slew limit
+    pid_shaping_t roll_shaping;
+    double cruise_speed;    //Speed assumed for the gain schedule before a fix (m/s)
+    double speed_tau;       //Time constant of the speed estimate (s)
+};
+
+constexpr pipeline_config_t PIPELINE_DEFAULT_CONFIG = {
+    20.0,
+    15.0,
+    30.0,
+    1.0,
+    {0.08, 0.01, 0.02, -1.0, 1.0},
+    {0.06, 0.01, 0.015, -1.0, 1.0},
+    //Back-calculation at 2 / s, 10 Hz derivative cutoff (20 samples at
+    //200 Hz), full travel in 0.25 s (the MG90S does 40 deg in ~0.07 s)
+    {2.0, 10.0, 8.0},
+    {2.0, 10.0, 8.0},
+    15.0,
+    1.0,
+};
+
+enum pipeline_stage_t : uint8_t {
+    STAGE_GUIDANCE = 0,
+    STAGE_ATTITUDE,
+    STAGE_PID,
+    STAGE_DECOMPOSE,
+    STAGE_ACTUATE,
+    PIPELINE_STAGE_COUNT
+};
+
+struct pipeline_stage_stats_t {
+    const char* name;
+    uint32_t runs;
+    uint32_t last_ns;
+    uint32_t max_ns;
+    uint32_t mean_ns;
+};
+
+//Final stage sink, must not block (e.g. publish a PTAM snapshot)
+typedef void (*pipeline_actuator_t)(void* ctx, const wing_set_t& wings);
+
+//____________________________________________________________
+/* ARMED flight application -> guidance, attitude, PID, decomposition, actuation
+===========================================================================
+|    step() runs the five stages once, each one reading the previous
+|    stage's struct and filling its own. Everything is preallocated in
+|    the object: no std::vector, no locks, no logging on the tick path,
+|    so it can run inside a control rate group.
+|    Every stage is timed with the probe clock (see stats()).
+|    Not thread safe, one task owns the pipeline.
+===========================================================================
+*/
+class FlightPipeline {
+public:
+    explicit FlightPipeline(const pipeline_config_t& config = PIPELINE_DEFAULT_CONFIG,
+                            pipeline_actuator_t actuator = nullptr, void* ctx = nullptr);
+
+    //____________________________________________________________
+    /* Main subroutine -> load a mission and restart it
+    ===========================================================================
+    |    waypoints       Copied, flown in order
+    |    Returns         false if count is 0 or above PIPELINE_MAX_WAYPOINTS
+    ===========================================================================
+    */
+    bool setMission(const waypoint_t* waypoints, std::size_t count);
+
+    //Back to the first waypoint with fresh PID state
+    void reset();
+
+    //____________________________________________________________
+    /* Main subroutine -> bumpless takeover (BYPASS -> ARMED)
+    ===========================================================================
+    |    wings           Positions the servos hold now
+    |    nav             Current estimate
+    |    The first step() continues from these wings instead of jumping
+    |    to the PID output of an empty integrator
+    ===========================================================================
+    */
+    void transfer(const wing_set_t& wings, const nav_state_t& nav);
+
+    //____________________________________________________________
+    /* Main subroutine -> one control tick
+    ===========================================================================
+    |    nav             Current estimate
+    |    dt              Seconds since the previous step
+    ===========================================================================
+    */
+    void step(const nav_state_t& nav, double dt);
+
+    const guidance_t& guidance() const { return guidance_; }
+    const attitude_cmd_t& attitudeCommand() const { return attitude_; }
+    const axis_cmd_t& axisCommand() const { return axis_; }
+    const wing_set_t& wings() const { return wings_; }
+    const pipeline_config_t& config() const { return config_; }
+
+    //____________________________________________________________
+    /* Main subroutine -> schedule the PID gains
+    ===========================================================================
+    |    schedule        Looked up at (speed(), altitude) every step, its
+    |                    gains replace config().pitch / roll gains while it
+    |                    holds a table. Not owned, nullptr detaches.
+    |    Limits and shaping stay the config's, gain changes are bumpless
+    ===========================================================================
+    */
+    void setSchedule(const GainSchedule* schedule);
+
+    //Speed over ground from the fixes (m/s), cruise_speed until the second fix
+    double speed() const { return speed_; }
+
+    std::size_t stats(pipeline_stage_stats_t* out, std::size_t max) const;
+    void resetStats();
+
+    //Flat earth offset of (lat, lon) from (ref_lat, ref_lon), metres north / east
+    static void geoToLocal(double lat, double lon, double ref_lat, double ref_lon, double& north, double& east);
+
+private:
+    void runGuidance(const nav_state_t& nav);
+    void runAttitude(const nav_state_t& nav);
+    void runSchedule(const nav_state_t& nav, double dt);
+    void runPID(const nav_state_t& nav, double dt);
+    void runDecompose();
+    void runActuate();
+
+    struct stage_time_t {
+        uint32_t runs;
+        uint64_t last;
+        uint64_t max;
+        uint64_t sum;
+    };
+
+    pipeline_config_t config_;
+    pipeline_actuator_t actuator_;
+    void* ctx_;
+
+    waypoint_t mission_[PIPELINE_MAX_WAYPOINTS];
+    std::size_t missionCount_;
+
+    //Pitch and roll stepped together, AXIS_PITCH / AXIS_ROLL
+    enum : std::size_t { AXIS_PITCH = 0, AXIS_ROLL, AXIS_COUNT };
+    typedef FlightPID<AXIS_COUNT> axis_pid_t;
+    static axis_pid_t::config_t pidConfig(const pipeline_config_t& config);
+
+    axis_pid_t pid_;
+    const GainSchedule* schedule_;
+
+    //Speed estimate: the fix it was last measured from
+    double speed_;
+    double lastFix_[3];
+    double sinceFix_;
+    bool haveFix_;
+
+    guidance_t guidance_;
+    attitude_cmd_t attitude_;
+    axis_cmd_t axis_;
+    wing_set_t wings_;
+
+    stage_time_t times_[PIPELINE_STAGE_COUNT];
+};
+
+#endif // FLIGHT_PIPELINE_H
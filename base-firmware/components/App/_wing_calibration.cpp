@@ -0,0 +1,100 @@
+/*MIT License
+Copyright (c) 2023 limitless Aeronautics
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#include "_wing_calibration.h"
+
+#include <cmath>
+
+//Ideal position of a wing at a sweep (deg) from deployed
+static double ideal_position(int wing, double sweep) {
+    const mix_surface_t& s = MIXER_DEFAULT_TABLE.surfaces[wing];
+    return s.deployed + s.direction * sweep;
+}
+
+//Sweep (deg) of breakpoint i
+static double breakpoint(int wing, int i) {
+    return MIXER_DEFAULT_TABLE.surfaces[wing].limit * i / (WING_CAL_POINTS - 1);
+}
+
+WingCalibration::WingCalibration() : table_(), correction_() {
+    load(identity());
+}
+
+bool WingCalibration::load(const wing_calibration_t& table) {
+    if (!validate(table)) {
+        return false;
+    }
+    table_ = table;
+    for (int w = 0; w < WING_COUNT; ++w) {
+        double correction[WING_CAL_POINTS];
+        for (int i = 0; i < WING_CAL_POINTS; ++i) {
+            correction[i] = table.servo[w][i] - ideal_position(w, breakpoint(w, i));
+        }
+        correction_[w] = wing_curve_t::points(0.0, MIXER_DEFAULT_TABLE.surfaces[w].limit, correction);
+    }
+    return true;
+}
+
+double WingCalibration::servo(wing_id_t wing, double position) const {
+    if (wing >= WING_COUNT) {
+        return position;
+    }
+    const mix_surface_t& s = MIXER_DEFAULT_TABLE.surfaces[wing];
+    return position + correction_[wing](s.direction * (position - s.deployed));
+}
+
+wing_calibration_t WingCalibration::identity() {
+    wing_calibration_t table = {};
+    table.version = WING_CAL_VERSION;
+    for (int w = 0; w < WING_COUNT; ++w) {
+        for (int i = 0; i < WING_CAL_POINTS; ++i) {
+            table.servo[w][i] = static_cast<float>(ideal_position(w, breakpoint(w, i)));
+        }
+    }
+    return table;
+}
+
+bool WingCalibration::validate(const wing_calibration_t& table) {
+    if (table.version != WING_CAL_VERSION) {
+        return false;
+    }
+    for (int w = 0; w < WING_COUNT; ++w) {
+        const double direction = MIXER_DEFAULT_TABLE.surfaces[w].direction;
+        for (int i = 0; i < WING_CAL_POINTS; ++i) {
+            const double servo = table.servo[w][i];
+            if (!std::isfinite(servo) ||
+                std::fabs(servo - ideal_position(w, breakpoint(w, i))) > WING_CAL_MAX_CORRECTION) {
+                return false;
+            }
+            //The servo turns the way the wing sweeps, or the curve has no inverse
+            if (i > 0 && !(direction * (servo - table.servo[w][i - 1]) > 0.0)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool WingCalibration::save(PTAMStore& store, const wing_calibration_t& table) {
+    return validate(table) && store.write(WING_CAL_STORE_KEY, &table, sizeof(table)) && store.commit();
+}
+
+bool WingCalibration::restore(PTAMStore& store, wing_calibration_t& table) {
+    //A size or version mismatch (older layout) reads as no calibration
+    return store.read(WING_CAL_STORE_KEY, &table, sizeof(table)) && validate(table);
+}
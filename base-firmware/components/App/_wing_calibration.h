@@ -0,0 +1,99 @@
+/*MIT License
+Copyright (c) 2023 limitless Aeronautics
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#ifndef WING_CALIBRATION_H
+#define WING_CALIBRATION_H
+
+#include <cstdint>
+#include "_mixer.h"
+#include "../PID/_lut.h"
+#include "../PTAM/_ptam_persist.h"
+
+//Breakpoints per wing, evenly spaced over the sweep 0 .. limit
+#define WING_CAL_POINTS 9
+//Layout version of wing_calibration_t, stored with the curves
+#define WING_CAL_VERSION 1
+//Largest servo correction a curve may hold (deg), a sanity bound
+#define WING_CAL_MAX_CORRECTION 20.0
+//NVS namespace and key of the persisted curves
+#define WING_CAL_STORE_NAMESPACE "wingcal"
+#define WING_CAL_STORE_KEY "curves"
+
+//____________________________________________________________
+/* Linkage calibration of the four wings
+===========================================================================
+|    servo[w][i] is the servo angle (deg) that puts wing w at sweep
+|    i * limit / (WING_CAL_POINTS - 1) from deployed, measured on the
+|    airframe. The linkage is not linear, so neither is the curve.
+|    Trivially copyable, stored as one blob.
+===========================================================================
+*/
+struct wing_calibration_t {
+    uint32_t version;
+    float servo[WING_COUNT][WING_CAL_POINTS];
+};
+
+typedef FixedLUT<WING_CAL_POINTS> wing_curve_t;
+
+//____________________________________________________________
+/* Wing position -> servo angle through the calibrated linkage
+===========================================================================
+|    The decomposer works in wing positions (deployed + direction *
+|    sweep, the servo frame of an ideal linkage). servo() adds the
+|    correction the curve holds at that sweep, interpolated in Q16.16
+|    from a table built once by load(). Outside the wing's travel the
+|    correction at the nearer end is held, so manual (BYPASS) positions
+|    keep working. The identity calibration changes nothing.
+|    load() before the actuation group starts, lookups are not guarded.
+===========================================================================
+*/
+class WingCalibration {
+public:
+    WingCalibration();
+
+    //____________________________________________________________
+    /* Main subroutine -> replace the curves
+    ===========================================================================
+    |    table           Copied, see validate()
+    |    Returns         false if invalid, the curves in use are kept
+    ===========================================================================
+    */
+    bool load(const wing_calibration_t& table);
+
+    //Servo angle (deg) for a wing position (deg)
+    double servo(wing_id_t wing, double position) const;
+
+    const wing_calibration_t& table() const { return table_; }
+
+    //Servo angle = wing position, the default surfaces of MIXER_DEFAULT_TABLE
+    static wing_calibration_t identity();
+
+    //Version, finite, every correction within WING_CAL_MAX_CORRECTION and
+    //each curve strictly monotonic in its wing's direction
+    static bool validate(const wing_calibration_t& table);
+
+    //Blob under WING_CAL_STORE_KEY, committed; restore() validates what it reads
+    static bool save(PTAMStore& store, const wing_calibration_t& table);
+    static bool restore(PTAMStore& store, wing_calibration_t& table);
+
+private:
+    wing_calibration_t table_;
+    wing_curve_t correction_[WING_COUNT];   //Servo - ideal position, over the sweep in deg
+};
+
+#endif // WING_CALIBRATION_H
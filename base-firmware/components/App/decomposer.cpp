@@ -17,228 +17,235 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.*/
 
 #include "decomposer.h"
+#include "_mixer.h"
+#include "../PID/_pid_bank.h"
+#include "../PID/_lut.h"
+#include "../Profiling/_timestep.h"
 
-#include <vector>
 #include <algorithm>
-#include <string>
 
-//PITCH
-std::vector<double> integralPitch = {0.0, 0.0, 0.0};
-std::vector<double> previous_errorsPitch = {0.0, 0.0, 0.0};
-// Pitch PID control parameters
+//Pitch and roll PID gains (one axis each, the legacy [0, 90] output)
 double kp_pitch = 1.01;
 double ki_pitch = 0.12;
 double kd_pitch = 0.68;
-double dt_pitch = 0.1;  // Time step
 double min_outputPitch = 0;
 double max_outputPitch = 90;
 
-//ROLL
-// PID control parameters
 double kp_roll = 1.01;
 double ki_roll = 0.12;
 double kd_roll = 0.68;
-double dt_roll = 0.1;  // Time step
 double min_output_roll = 0;
 double max_output_roll = 90;
 
-// Initialize integral and previous_errors vectors
-std::vector<double> integralRoll = {0.0, 0.0, 0.0};
-std::vector<double> previous_errorsRoll = {0.0, 0.0, 0.0};
+//Signed output, the magnitude is taken after the step: |clamp(x, -max, max)|
+//equals the old clamp(|x|, 0, max) (see PID::calculate_control_signal)
+static PIDBank<1, double> pitchPid(PIDBank<1, double>::gains_t::uniform(kp_pitch, ki_pitch, kd_pitch,
+                                                                         -max_outputPitch, max_outputPitch));
+static PIDBank<1, double> rollPid(PIDBank<1, double>::gains_t::uniform(kp_roll, ki_roll, kd_roll,
+                                                                        -max_output_roll, max_output_roll));
+
+//Measured interval since the previous call of the axis (was a fixed 0.1 s)
+static double pitchDt() {
+    static TimeStep* step = TimeStepTable::getInstance().timestep("decomp.pitch", DECOMPOSER_NOMINAL_US);
+    return step ? step->tick() : DECOMPOSER_NOMINAL_US / 1e6;
+}
 
+static double rollDt() {
+    static TimeStep* step = TimeStepTable::getInstance().timestep("decomp.roll", DECOMPOSER_NOMINAL_US);
+    return step ? step->tick() : DECOMPOSER_NOMINAL_US / 1e6;
+}
 
-double DECOMPOSER::linearInterpolate(double input, double input_start, double input_end, 
-                                        double output_start, double output_end) {
-    // Map input range to output range
-    double slope = (output_end - output_start) / (input_end - input_start);
-    double output = output_start + slope * (input - input_start);
-    return output;
+//Legacy magnitude of a signed PID output, clamped to [min_output, max_output]
+static double legacyMagnitude(double signal, double min_output, double max_output) {
+    return std::clamp(signal < 0 ? -signal : signal, min_output, max_output);
 }
 
-double DECOMPOSER::mapToRangePitch(double currentInput, double targetInput, double output_start, double output_end) {
-    //Run PID through to output
-    // Sample target and current values
-    //PITCH PID CONTROLLER
-    std::vector<double> target = {targetInput, 0.0, 0.0};
-    std::vector<double> current = {currentInput, 0.0, 0.0};
-
-    PID *pobj = new PID();
-    // Call the PID controller
-    std::vector<double> control_signals = pobj -> pid_controller(target, current, kp_pitch, ki_pitch, kd_pitch,
-                                                         integralPitch, previous_errorsPitch, dt_pitch,
-                                                         min_outputPitch, max_outputPitch);
-    //linear interpolate to range specified
-    double elem = control_signals.front();
-    double interpolatedValue = linearInterpolate(elem, 0, 90, output_start, output_end);
-    return interpolatedValue;
+//One PID step of each axis, as the legacy [0, 90] magnitude
+static double pitch_magnitude(double current, double target) {
+    const double control = pitchPid.step({target}, {current}, pitchDt())[0];
+    return legacyMagnitude(control, min_outputPitch, max_outputPitch);
 }
 
-double DECOMPOSER::mapToRangeRoll(double currentInput, double targetInput, double output_start, double output_end) {
-    //Run PID through to output
-    // Sample target and current values
-    // ROLL PID CONTROLLER
-    std::vector<double> target = {targetInput, 0.0, 0.0};
-    std::vector<double> current = {currentInput, 0.0, 0.0};
-
-    PID *pobj = new PID();
-    // Call the PID controller
-    std::vector<double> control_signals = pobj -> pid_controller(target, current, kp_roll, ki_roll, kd_roll,
-                                                         integralRoll, previous_errorsRoll, dt_roll,
-                                                         min_output_roll, max_output_roll);
-    //linear interpolate to range specified
-    double elem = control_signals.front();
-    double interpolatedValue = linearInterpolate(elem, 0, 90, output_start, output_end);
-    return interpolatedValue;
-}
-
-std::vector<double> DECOMPOSER::decomposeFL(std::string angleType, double angleValueCurrent, double angleValueTarget) {
-    double finalPos = 0;
-    std::vector<double> pos;
-    
-    if (angleType == "Pitch") {
-        // Angle type is pitch:
-        // Pitch -> 0 - 90
-        // ServoPos (FL) -> 180 - 270
-        //Limit to 40 deg movement from deployed pos
-        //ServoPos (FL) -> 230 - 270 (with limit)
-        finalPos = mapToRangePitch(angleValueCurrent, angleValueTarget, 270, 230);
-        pos.push_back(finalPos);
-    }
+static double roll_magnitude(double current, double target) {
+    const double control = rollPid.step({target}, {current}, rollDt())[0];
+    return legacyMagnitude(control, min_output_roll, max_output_roll);
+}
 
-    if (angleType == "Roll") {
-        // Angle type is Roll:
-        // Roll -> 0 - 180
-        // ServoPos (FL) -> 180 - 270 (actual)
-        //Limit to 40 deg movement from deployed pos
-        //ServoPos (FL) -> 230 - 270 (with limit)
-        finalPos = mapToRangeRoll(angleValueCurrent, angleValueTarget, 270, 230);
-        pos.push_back(finalPos);
-    }
+//Legacy servo range of each wing, PID magnitude [0, 90] -> deployed .. fully
+//swept, built from the mixer's surfaces at compile time
+typedef FixedLUT<2> legacy_map_t;
 
-    return pos;
+static constexpr legacy_map_t legacy_map(wing_id_t wing) {
+    const mix_surface_t& s = MIXER_DEFAULT_TABLE.surfaces[wing];
+    return legacy_map_t::linear(0.0, 90.0, s.deployed, s.deployed + s.direction * s.limit);
 }
 
-std::vector<double> DECOMPOSER::decomposeFR(std::string angleType, double angleValueCurrent, double angleValueTarget) {
-    double finalPos = 0;
-    std::vector<double> pos;
-    
+static constexpr legacy_map_t LEGACY_MAPS[WING_COUNT] = {
+    legacy_map(WING_FL), legacy_map(WING_FR), legacy_map(WING_RL), legacy_map(WING_RR),
+};
+
+static_assert(LEGACY_MAPS[WING_FL](90.0) == 230.0 && LEGACY_MAPS[WING_FR](90.0) == 130.0,
+              "left wings sweep 270 -> 230, right wings 90 -> 130");
+
+static constexpr WingMixer WING_MIXER;
+static constexpr WingAllocator WING_ALLOCATOR;
+
+//The legacy angle type, parsed once per call instead of per wing
+static mix_input_t legacy_axis(std::string_view angleType) {
     if (angleType == "Pitch") {
-        // Angle type is pitch:
-        // Pitch -> 0 - 90
-        // ServoPos (FR) -> 90 - 180 (actual)
-        //Limit to 40 deg movement from deployed pos
-        //ServoPos (FR) -> 90 - 130 (with limit)
-        finalPos = mapToRangePitch(angleValueCurrent, angleValueTarget, 90, 130);
-        pos.push_back(finalPos);
+        return MIX_PITCH;
     }
-
     if (angleType == "Roll") {
-        // Angle type is Roll:
-        // Roll -> 0 - 180
-        // ServoPos (FR) -> 90 - 180 (actual)
-        //Limit to 40 deg movement from deployed pos
-        //ServoPos (FR) -> 90 - 130 (with limit)
-        finalPos = mapToRangeRoll(angleValueCurrent, angleValueTarget, 90, 130);
-        pos.push_back(finalPos);
+        return MIX_ROLL;
     }
+    return MIX_INPUTS;
+}
 
-    return pos;
+static double legacy_magnitude(mix_input_t axis, double current, double target) {
+    return axis == MIX_PITCH ? pitch_magnitude(current, target) : roll_magnitude(current, target);
 }
 
-std::vector<double> DECOMPOSER::decomposeRL(std::string angleType, double angleValueCurrent, double angleValueTarget) {
-    double finalPos = 0;
-    std::vector<double> pos;
-    
-    if (angleType == "Pitch") {
-        // Angle type is pitch:
-        // Pitch -> 0 - 90
-        // ServoPos (RL) -> 180 - 270 (actual)
-        //Limit to 40 deg movement from deployed pos
-        //ServoPos (RL) -> 230 - 270 (with limit)
-        finalPos = mapToRangePitch(angleValueCurrent, angleValueTarget, 270, 230);
-        pos.push_back(finalPos);
+//____________________________________________________________
+/* Utillity subroutine -> one wing, one axis (decomposeXX)
+===========================================================================
+|    Returns         One position, or none for an unknown angle type or a
+|                    full arena
+===========================================================================
+*/
+static ScratchSpan<double> decompose(ScratchArena& arena, wing_id_t wing, std::string_view angleType,
+                                     double current, double target) {
+    const mix_input_t axis = legacy_axis(angleType);
+    if (axis != MIX_PITCH && axis != MIX_ROLL) {
+        return {nullptr, 0};
     }
-
-    if (angleType == "Roll") {
-        // Angle type is Roll:
-        // Roll -> 0 - 180
-        // ServoPos (RL) -> 180 - 270 (actual)
-        //Limit to 40 deg movement from deployed pos
-        //ServoPos (RL) -> 230 - 270 (with limit)
-        finalPos = mapToRangeRoll(angleValueCurrent, angleValueTarget, 270, 230);
-        pos.push_back(finalPos);
+    const double finalPos = LEGACY_MAPS[wing](legacy_magnitude(axis, current, target));
+    ScratchSpan<double> pos = arena.array<double>(1);
+    if (!pos.empty()) {
+        pos[0] = finalPos;
     }
-
     return pos;
 }
 
-std::vector<double> DECOMPOSER::decomposeRR(std::string angleType, double angleValueCurrent, double angleValueTarget) {
-    double finalPos = 0;
-    std::vector<double> pos;
-    
-    if (angleType == "Pitch") {
-        // Angle type is pitch:
-        // Pitch -> 0 - 90
-        // ServoPos (RR) -> 90 - 180 (actual)
-        //Limit to 40 deg movement from deployed pos
-        //ServoPos (RR) -> 90 - 130 (with limit)
-        finalPos = mapToRangePitch(angleValueCurrent, angleValueTarget, 90, 130);
-        pos.push_back(finalPos);
+//____________________________________________________________
+/* Utillity subroutine -> the wing pair of one axis (xxAxisToSweep)
+===========================================================================
+|    The axis PID is stepped once and its output mapped onto both wings
+|    (stepping it per wing gave the second wing a ~0 s time step)
+===========================================================================
+*/
+static ScratchSpan<double> sweep_pair(ScratchArena& arena, mix_input_t axis, wing_id_t first, wing_id_t second,
+                                      double current, double target) {
+    const double magnitude = legacy_magnitude(axis, current, target);
+    ScratchSpan<double> pos = arena.array<double>(2);
+    if (!pos.empty()) {
+        pos[0] = LEGACY_MAPS[first](magnitude);
+        pos[1] = LEGACY_MAPS[second](magnitude);
     }
+    return pos;
+}
 
-    if (angleType == "Roll") {
-        // Angle type is Roll:
-        // Roll -> 0 - 180
-        // ServoPos (RR) -> 90 - 180 (actual)
-        //Limit to 40 deg movement from deployed pos
-        //ServoPos (RR) -> 90 - 130 (with limit)
-        finalPos = mapToRangeRoll(angleValueCurrent, angleValueTarget, 90, 130);
-        pos.push_back(finalPos);
-    }
+double DECOMPOSER::linearInterpolate(double input, double input_start, double input_end, 
+                                        double output_start, double output_end) {
+    return lut_interpolate(input, input_start, input_end, output_start, output_end);
+}
 
-    return pos;
+double DECOMPOSER::mapToRangePitch(double currentInput, double targetInput, double output_start, double output_end) {
+    //PITCH PID CONTROLLER, magnitude interpolated to the range specified
+    return lut_interpolate(pitch_magnitude(currentInput, targetInput), 0, 90, output_start, output_end);
+}
+
+double DECOMPOSER::mapToRangeRoll(double currentInput, double targetInput, double output_start, double output_end) {
+    // ROLL PID CONTROLLER, magnitude interpolated to the range specified
+    return lut_interpolate(roll_magnitude(currentInput, targetInput), 0, 90, output_start, output_end);
+}
+
+//Pitch and Roll both sweep each wing over its 40 deg range:
+//FL / RL 270 -> 230, FR / RR 90 -> 130
+ScratchSpan<double> DECOMPOSER::decomposeFL(ScratchArena& arena, std::string_view angleType, double angleValueCurrent, double angleValueTarget) {
+    return decompose(arena, WING_FL, angleType, angleValueCurrent, angleValueTarget);
+}
+
+ScratchSpan<double> DECOMPOSER::decomposeFR(ScratchArena& arena, std::string_view angleType, double angleValueCurrent, double angleValueTarget) {
+    return decompose(arena, WING_FR, angleType, angleValueCurrent, angleValueTarget);
+}
+
+ScratchSpan<double> DECOMPOSER::decomposeRL(ScratchArena& arena, std::string_view angleType, double angleValueCurrent, double angleValueTarget) {
+    return decompose(arena, WING_RL, angleType, angleValueCurrent, angleValueTarget);
+}
+
+ScratchSpan<double> DECOMPOSER::decomposeRR(ScratchArena& arena, std::string_view angleType, double angleValueCurrent, double angleValueTarget) {
+    return decompose(arena, WING_RR, angleType, angleValueCurrent, angleValueTarget);
 }
 
-std::vector<double> DECOMPOSER::pitchAxisToSweep(double pitch_degCurrent, double pitch_degTarget) {
-    std::vector<double> pos;
-    
+ScratchSpan<double> DECOMPOSER::pitchAxisToSweep(ScratchArena& arena, double pitch_degCurrent, double pitch_degTarget) {
     if (pitch_degTarget >= pitch_degCurrent) {
         // Positive moment required, so rear wings will move
-        std::vector<double> tp1 = decomposeRL("Pitch", pitch_degCurrent, pitch_degTarget);
-        std::vector<double> tp2 = decomposeRR("Pitch", pitch_degCurrent, pitch_degTarget);
-        pos.insert(pos.end(), tp1.begin(), tp1.end());
-        pos.insert(pos.end(), tp2.begin(), tp2.end());
-    }
-
-    if (pitch_degTarget < pitch_degCurrent) {
-        // Negative moment required, so front wings will move
-        std::vector<double> tp1 = decomposeFL("Pitch", pitch_degCurrent, pitch_degTarget);
-        std::vector<double> tp2 = decomposeFR("Pitch", pitch_degCurrent, pitch_degTarget);
-        pos.insert(pos.end(), tp1.begin(), tp1.end());
-        pos.insert(pos.end(), tp2.begin(), tp2.end());
+        return sweep_pair(arena, MIX_PITCH, WING_RL, WING_RR, pitch_degCurrent, pitch_degTarget);
     }
-
-    return pos;
+    // Negative moment required, so front wings will move
+    return sweep_pair(arena, MIX_PITCH, WING_FL, WING_FR, pitch_degCurrent, pitch_degTarget);
 }
 
-std::vector<double> DECOMPOSER::rollAxisToSweep(double roll_degCurrent, double roll_degTarget) {
-    std::vector<double> pos;
-    
+ScratchSpan<double> DECOMPOSER::rollAxisToSweep(ScratchArena& arena, double roll_degCurrent, double roll_degTarget) {
     if (roll_degTarget >= roll_degCurrent) {
         // Positive moment requested, so right side wings will move
-        std::vector<double> tp1 = decomposeFR("Roll", roll_degCurrent, roll_degTarget);
-        std::vector<double> tp2 = decomposeRR("Roll", roll_degCurrent, roll_degTarget);
-        pos.insert(pos.end(), tp1.begin(), tp1.end());
-        pos.insert(pos.end(), tp2.begin(), tp2.end());
+        return sweep_pair(arena, MIX_ROLL, WING_FR, WING_RR, roll_degCurrent, roll_degTarget);
     }
+    // Negative moment requested, so left side wings will move
+    return sweep_pair(arena, MIX_ROLL, WING_FL, WING_RL, roll_degCurrent, roll_degTarget);
+}
 
-    if (roll_degTarget < roll_degCurrent) {
-        // Negative moment requested, so left side wings will move
-        std::vector<double> tp1 = decomposeFL("Roll", roll_degCurrent, roll_degTarget);
-        std::vector<double> tp2 = decomposeRL("Roll", roll_degCurrent, roll_degTarget);
-        pos.insert(pos.end(), tp1.begin(), tp1.end());
-        pos.insert(pos.end(), tp2.begin(), tp2.end());
+//____________________________________________________________
+/* Main subroutine -> both axes of one tick to all four wings
+===========================================================================
+|    pitchAxisToSweep / rollAxisToSweep each return their own pair, so
+|    when both axes need correcting one set overwrites the other. Here
+|    each PID is stepped once, its signed output (of max_output) is the
+|    axis demand and the allocator solves for the four wings together.
+|    Returns         fl, fr, rl, rr, or none for a full arena
+===========================================================================
+*/
+ScratchSpan<double> DECOMPOSER::axesToSweep(ScratchArena& arena, double pitch_degCurrent, double pitch_degTarget,
+                                            double roll_degCurrent, double roll_degTarget) {
+    const double pitch = pitchPid.step({pitch_degTarget}, {pitch_degCurrent}, pitchDt())[0] / max_outputPitch;
+    const double roll = rollPid.step({roll_degTarget}, {roll_degCurrent}, rollDt())[0] / max_output_roll;
+    wing_set_t wings;
+    allocateToWings(pitch, roll, wings);
+    ScratchSpan<double> pos = arena.array<double>(WING_COUNT);
+    if (!pos.empty()) {
+        pos[WING_FL] = wings.fl;
+        pos[WING_FR] = wings.fr;
+        pos[WING_RL] = wings.rl;
+        pos[WING_RR] = wings.rr;
     }
-
     return pos;
-}
\ No newline at end of file
+}
+
+void DECOMPOSER::allocateToWings(double pitch, double roll, wing_set_t& out) {
+    WING_ALLOCATOR.allocate(pitch, roll, out);
+}
+
+//____________________________________________________________
+/* Main subroutine -> pitch and roll commands to all four wings
+===========================================================================
+|    pitch, roll     Normalised commands, [-1, 1], positive = nose up / right
+|    out             Servo positions, deployed + sweep per wing
+|
+|    WingMixer with MIXER_DEFAULT_TABLE (yaw and throttle neutral): the
+|    legacy wing roles, and when a wing is asked for more than its 40 deg
+|    roll is scaled back before pitch is touched.
+===========================================================================
+*/
+void DECOMPOSER::mixToWings(double pitch, double roll, wing_set_t& out) {
+    WING_MIXER.mix({pitch, roll, 0.0, 0.0}, out);
+}
+
+void DECOMPOSER::wingsToAxes(const wing_set_t& wings, double& pitch, double& roll) {
+    //Normalised sweeps, 0 deployed .. 1 at the limit
+    const double fl = (WING_LEFT_DEPLOYED - wings.fl) / WING_SWEEP_LIMIT;
+    const double fr = (wings.fr - WING_RIGHT_DEPLOYED) / WING_SWEEP_LIMIT;
+    const double rl = (WING_LEFT_DEPLOYED - wings.rl) / WING_SWEEP_LIMIT;
+    const double rr = (wings.rr - WING_RIGHT_DEPLOYED) / WING_SWEEP_LIMIT;
+    pitch = std::clamp(((rl + rr) - (fl + fr)) / 2.0, -1.0, 1.0);
+    roll = std::clamp(((fr + rr) - (fl + rl)) / 2.0, -1.0, 1.0);
+}
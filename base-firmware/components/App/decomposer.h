@@ -19,10 +19,27 @@ SOFTWARE.*/
 #ifndef DECOMPOSER_
 #define DECOMPOSER_
 
-#include <vector>
 #include <algorithm>
-#include <string>
+#include <string_view>
 #include "../PID/_pid.h"
+#include "../Memory/_arena.h"
+
+//Servo position of each wing, degrees
+struct wing_set_t {
+    double fl;
+    double fr;
+    double rl;
+    double rr;
+};
+
+//Deployed (neutral) servo position and 40 deg sweep limit of each side
+#define WING_LEFT_DEPLOYED      270.0
+#define WING_RIGHT_DEPLOYED     90.0
+#define WING_SWEEP_LIMIT        40.0
+//Smallest wing move worth a servo write (MG90S deadband is ~5 us, ~0.5 deg)
+#define WING_DEADBAND_DEG       0.25
+//Expected interval between mapToRangePitch / Roll calls, the PIDs get the measured one
+#define DECOMPOSER_NOMINAL_US   100000
 
 class DECOMPOSER {
     public:
@@ -33,17 +50,37 @@ class DECOMPOSER {
 
         static double mapToRangeRoll(double currentInput, double targetInput, double output_start, double output_end);
         
-        static std::vector<double> decomposeFL(std::string angleType, double angleValueCurrent, double angleValueTarget);
+        //Legacy single wing, single axis ("Pitch" / "Roll") positions
+        static ScratchSpan<double> decomposeFL(ScratchArena& arena, std::string_view angleType, double angleValueCurrent, double angleValueTarget);
+
+        static ScratchSpan<double> decomposeFR(ScratchArena& arena, std::string_view angleType, double angleValueCurrent, double angleValueTarget);
+
+        static ScratchSpan<double> decomposeRL(ScratchArena& arena, std::string_view angleType, double angleValueCurrent, double angleValueTarget);
+
+        static ScratchSpan<double> decomposeRR(ScratchArena& arena, std::string_view angleType, double angleValueCurrent, double angleValueTarget);
+
+        //Wing positions are scratch data of the caller's cycle, valid
+        //until its arena is reset
+        static ScratchSpan<double> pitchAxisToSweep(ScratchArena& arena, double pitch_degCurrent, double pitch_degTarget);
 
-        static std::vector<double> decomposeFR(std::string angleType, double angleValueCurrent, double angleValueTarget);
+        static ScratchSpan<double> rollAxisToSweep(ScratchArena& arena, double roll_degCurrent, double roll_degTarget);
 
-        static std::vector<double> decomposeRL(std::string angleType, double angleValueCurrent, double angleValueTarget);
+        //Pitch and roll in the same tick: both PIDs stepped once, the outputs
+        //allocated to all four wings together (fl, fr, rl, rr)
+        static ScratchSpan<double> axesToSweep(ScratchArena& arena, double pitch_degCurrent, double pitch_degTarget,
+                                               double roll_degCurrent, double roll_degTarget);
 
-        static std::vector<double> decomposeRR(std::string angleType, double angleValueCurrent, double angleValueTarget);
+        //Coupled allocation, no arena: pitch / roll demands in [-1, 1] to the
+        //wing positions that meet both best (WingAllocator in _mixer.h)
+        static void allocateToWings(double pitch, double roll, wing_set_t& out);
 
-        static std::vector<double> pitchAxisToSweep(double pitch_degCurrent, double pitch_degTarget);
+        //Both axes at once, no allocation: pitch / roll commands in [-1, 1] to
+        //wing positions (WingMixer in _mixer.h also takes yaw and throttle)
+        static void mixToWings(double pitch, double roll, wing_set_t& out);
 
-        static std::vector<double> rollAxisToSweep(double roll_degCurrent, double roll_degTarget);
+        //Inverse of mixToWings (least squares over the four sweeps), for a
+        //bumpless takeover from manually set wings
+        static void wingsToAxes(const wing_set_t& wings, double& pitch, double& roll);
 };
 
 #endif
\ No newline at end of file
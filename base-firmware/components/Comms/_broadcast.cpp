@@ -33,6 +33,8 @@ SOFTWARE.*/
 #include "lwip/err.h"
 #include "lwip/sys.h"
 #include <sys/param.h>
+#include <algorithm>
+#include <cstring>
 
 #define _ESP_WIFI_SSID      "HIVE2"
 #define _ESP_WIFI_PASS      "HIVE_PASS"
@@ -40,8 +42,18 @@ SOFTWARE.*/
 #define _MAX_STA_CONN       1
 #define MAX_DATA_LEN        100
 
+//Fields an INC_ handler reads, missing ones parse as 0 (= no change)
+#define HTTP_MIN_FIELDS     5
+
 static const char *TAG = "wifi softAP";
 
+//Handlers run one at a time on the httpd task: one request arena, and a
+//pool slot per driver object a handler needs
+static StaticArena<HTTPD_ARENA_BYTES> requestArena;
+static StaticPool<VEHICLE_BARO, 1> baroPool;
+static StaticPool<BATTERY, 1> batteryPool;
+static StaticPool<CONTROLLER_TASKS, 1> controllerPool;
+
 void BroadcastedServer::wifi_event_handler(void* arg, esp_event_base_t event_base,
                                     int32_t event_id, void* event_data)
 {
@@ -92,7 +104,10 @@ void BroadcastedServer::wifi_init_softap(void)
 
     httpd_handle_t server = NULL;
     httpd_config_t config = HTTPD_DEFAULT_CONFIG();
-    config.max_uri_handlers = 16;
+    config.max_uri_handlers = 19;
+    //Web UI polling stays off the control core
+    config.core_id = HTTPD_TASK_CORE;
+    config.task_priority = HTTPD_TASK_PRIORITY;
 
     /* HTTP server configuration */
 
@@ -187,6 +202,48 @@ void BroadcastedServer::wifi_init_softap(void)
         .user_ctx  = NULL
     };
 
+    httpd_uri_t GAINS_uri = {
+        .uri       = "/INC_GAINS",
+        .method    = HTTP_POST,
+        .handler   = handle_GAINS_incoming,
+        .user_ctx  = NULL
+    };
+
+    httpd_uri_t PTAM_uri = {
+        .uri       = "/GET_PTAM",
+        .method    = HTTP_POST,
+        .handler   = handle_PTAM_dump_request,
+        .user_ctx  = NULL
+    };
+
+    httpd_uri_t PROBE_uri = {
+        .uri       = "/GET_PROBES",
+        .method    = HTTP_POST,
+        .handler   = handle_probe_request,
+        .user_ctx  = NULL
+    };
+
+    httpd_uri_t TIMESTEP_uri = {
+        .uri       = "/GET_TIMESTEPS",
+        .method    = HTTP_POST,
+        .handler   = handle_timestep_request,
+        .user_ctx  = NULL
+    };
+
+    httpd_uri_t MEM_uri = {
+        .uri       = "/GET_MEM",
+        .method    = HTTP_POST,
+        .handler   = handle_memory_request,
+        .user_ctx  = NULL
+    };
+
+    httpd_uri_t HEALTH_uri = {
+        .uri       = "/GET_HEALTH",
+        .method    = HTTP_POST,
+        .handler   = handle_health_request,
+        .user_ctx  = NULL
+    };
+
     // Start the HTTP server
     if (httpd_start(&server, &config) == ESP_OK) {
         //Register root
@@ -202,33 +259,59 @@ void BroadcastedServer::wifi_init_softap(void)
         httpd_register_uri_handler(server, &TOKEN_uri);
         httpd_register_uri_handler(server, &AUTH_uri);
         httpd_register_uri_handler(server, &OTA_uri);
+        httpd_register_uri_handler(server, &GAINS_uri);
         httpd_register_uri_handler(server, &BATT_uri);
+        httpd_register_uri_handler(server, &PTAM_uri);
+        httpd_register_uri_handler(server, &PROBE_uri);
+        httpd_register_uri_handler(server, &TIMESTEP_uri);
+        httpd_register_uri_handler(server, &MEM_uri);
+        httpd_register_uri_handler(server, &HEALTH_uri);
     }
 
 }
 
-std::string BroadcastedServer::packData(const std::string& id1, float value1,
-                     const std::string& id2, float value2,
-                     const std::string& id3, float value3,
-                     const std::string& id4, float value4) {
-    std::ostringstream packed;
-    packed << id1 << value1 << "_" << id2 << value2 << "_" << id3 << value3 << "_" << id4 << value4;
-    return packed.str();
+ScratchSpan<char> BroadcastedServer::packData(ScratchArena& arena, const char* id1, float value1,
+                     const char* id2, float value2,
+                     const char* id3, float value3,
+                     const char* id4, float value4) {
+    //%g matches the default ostream formatting the web UI parses
+    return arena.format("%s%g_%s%g_%s%g_%s%g", id1, value1, id2, value2, id3, value3, id4, value4);
 }
 
-void BroadcastedServer::extractValuesAndIds(const std::string& data, std::vector<std::string>& ids, std::vector<double>& values) {
-    std::stringstream ss(data);
-    std::string item;
+std::size_t BroadcastedServer::extractValuesAndIds(const char* data, ScratchArena& arena,
+                                                   ScratchSpan<ScratchSpan<char>>& ids, ScratchSpan<double>& values) {
+    std::size_t fields = 1;
+    for (const char* c = data; *c != '\0'; ++c) {
+        fields += (*c == '_') ? 1 : 0;
+    }
+    //Padded with zeros so handlers can index the fields they expect
+    ids = arena.array<ScratchSpan<char>>(std::max<std::size_t>(fields, HTTP_MIN_FIELDS));
+    values = arena.array<double>(std::max<std::size_t>(fields, HTTP_MIN_FIELDS));
+    if (ids.empty() || values.empty()) {
+        return 0;
+    }
 
-    while (getline(ss, item, '_')) {
+    std::size_t n = 0;
+    const char* item = data;
+    while (n < fields) {
+        const char* end = std::strchr(item, '_');
+        const std::size_t len = end != nullptr ? std::size_t(end - item) : std::strlen(item);
         // Extract the ID and value from each item
-        std::string id = item.substr(0, item.find_first_of("0123456789.-"));
-        double value = std::stod(item.substr(item.find_first_of("0123456789.-")));
-
-        // Add the ID and value to the respective vectors
-        ids.push_back(id);
-        values.push_back(value);
+        const std::size_t idLen = std::min(std::strcspn(item, "0123456789.-"), len);
+        ScratchSpan<char> id = arena.array<char>(idLen + 1);
+        if (!id.empty()) {
+            std::memcpy(id.data, item, idLen);
+            id.count = idLen;
+        }
+        ids[n] = id;
+        values[n] = std::strtod(item + idLen, nullptr);
+        n++;
+        if (end == nullptr) {
+            break;
+        }
+        item = end + 1;
     }
+    return n;
 }
 
 /* Handler for the root ("/") endpoint */
@@ -245,51 +328,51 @@ esp_err_t BroadcastedServer::root_handler(httpd_req_t *req) {
 
 /* Handler for the "/GET_GPS" endpoint */
 esp_err_t BroadcastedServer::handle_GPS_request(httpd_req_t *req) {
-    VEHICLE_BARO *baro = new VEHICLE_BARO();
+    ArenaCycle cycle(requestArena);
+    PoolRef<VEHICLE_BARO, 1> baro(baroPool);
     // Check if the request is a POST request
     if (req->method == HTTP_POST) {
 
-        std::string id1 = "LAT";
+        const char* id1 = "LAT";
         double value1 = 56;
-        std::string id2 = "LONG";
+        const char* id2 = "LONG";
         double value2 = 78.50;
-        std::string id3 = "SAT";
+        const char* id3 = "SAT";
         double value3 = 72.34;
-        std::string id4 = "ALT";
+        const char* id4 = "ALT";
         double value4 = 48.2; //baro -> pushAltitude(DEFAULT_SEA_LEVEL);
 
-        std::string packed_data = packData(id1, value1, id2, value2, id3, value3, id4, value4);
+        ScratchSpan<char> packed_data = packData(requestArena, id1, value1, id2, value2, id3, value3, id4, value4);
 
         // Send a response to the client
-        httpd_resp_send(req, packed_data.c_str(), packed_data.length());
+        httpd_resp_send(req, packed_data.data, packed_data.size());
         return ESP_OK;
     }
 
     // If the request is not a POST request, return 404 Not Found
     httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "Not Found");
-
-    delete baro;
     return ESP_OK;
 }
 
 
 /* Handler for the "/IMU1" endpoint */
 esp_err_t BroadcastedServer::handle_IMU1_request(httpd_req_t *req) {
+    ArenaCycle cycle(requestArena);
     // Check if the request is a POST request
     if (req->method == HTTP_POST) {
 
-        std::string id1 = "PITCH";
+        const char* id1 = "PITCH";
         double value1 = 98;
-        std::string id2 = "ROLL";
+        const char* id2 = "ROLL";
         double value2 = 42;
-        std::string id3 = "YAW";
+        const char* id3 = "YAW";
         double value3 = 87;
-        std::string id4 = "GYROY";
+        const char* id4 = "GYROY";
         double value4 =22;
 
-        std::string packed_data = packData(id1, value1, id2, value2, id3, value3, id4, value4);
+        ScratchSpan<char> packed_data = packData(requestArena, id1, value1, id2, value2, id3, value3, id4, value4);
         // Send a response to the client
-        httpd_resp_send(req, packed_data.c_str(), packed_data.length());
+        httpd_resp_send(req, packed_data.data, packed_data.size());
         return ESP_OK;
     }
 
@@ -300,21 +383,22 @@ esp_err_t BroadcastedServer::handle_IMU1_request(httpd_req_t *req) {
 
 /* Handler for the "/IMU1" endpoint */
 esp_err_t BroadcastedServer::handle_IMU2_request(httpd_req_t *req) {
+    ArenaCycle cycle(requestArena);
     // Check if the request is a POST request
     if (req->method == HTTP_POST) {
 
-        std::string id1 = "ACCX";
+        const char* id1 = "ACCX";
         double value1 = 98;
-        std::string id2 = "ACCY";
+        const char* id2 = "ACCY";
         double value2 = 42;
-        std::string id3 = "ACCZ";
+        const char* id3 = "ACCZ";
         double value3 = 87;
-        std::string id4 = "GYROX";
+        const char* id4 = "GYROX";
         double value4 =22;
 
-        std::string packed_data = packData(id1, value1, id2, value2, id3, value3, id4, value4);
+        ScratchSpan<char> packed_data = packData(requestArena, id1, value1, id2, value2, id3, value3, id4, value4);
         // Send a response to the client
-        httpd_resp_send(req, packed_data.c_str(), packed_data.length());
+        httpd_resp_send(req, packed_data.data, packed_data.size());
         return ESP_OK;
     }
 
@@ -325,22 +409,55 @@ esp_err_t BroadcastedServer::handle_IMU2_request(httpd_req_t *req) {
 
 /* Handler for the "/W1" endpoint */
 esp_err_t BroadcastedServer::handle_W1_request(httpd_req_t *req) {
+    PROBE_SCOPE("http.W1");
+    ArenaCycle cycle(requestArena);
     // Check if the request is a POST request
     if (req->method == HTTP_POST) {
 
-       std::string id1 = "WFL";
-        double value1 = 165;
-        std::string id2 = "WFR";
-        double value2 = 148;
-        std::string id3 = "WRL";
-        double value3 = 109;
-        std::string id4 = "WRR";
-        double value4 = 112;
+        //Lock-free snapshots, do not contend with the flight loop. Flight
+        //and BYPASS wings have one writer each, the newer one is reported
+        SharedMemory& sharedMemory = SharedMemory::getInstance();
+        ptam_wings_t wings = sharedMemory.wings().read();
+        if(sharedMemory.bypassWings().version() != 0){
+            const ptam_wings_t bypass = sharedMemory.bypassWings().read();
+            if(bypass.time_us > wings.time_us){
+                wings = bypass;
+            }
+        }
+
+        const char* id1 = "WFL";
+        double value1 = wings.fl;
+        const char* id2 = "WFR";
+        double value2 = wings.fr;
+        const char* id3 = "WRL";
+        double value3 = wings.rl;
+        const char* id4 = "WRR";
+        double value4 = wings.rr;
 
-        std::string packed_data = packData(id1, value1, id2, value2, id3, value3, id4, value4);
+        ScratchSpan<char> packed_data = packData(requestArena, id1, value1, id2, value2, id3, value3, id4, value4);
 
         // Send a response to the client
-        httpd_resp_send(req, packed_data.c_str(), packed_data.length());
+        httpd_resp_send(req, packed_data.data, packed_data.size());
+        return ESP_OK;
+    }
+
+    // If the request is not a POST request, return 404 Not Found
+    httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "Not Found");
+    return ESP_OK;
+}
+
+
+/* Whole PTAM blackboard in one CBOR document (see RegisterFile::dump) */
+esp_err_t BroadcastedServer::handle_PTAM_dump_request(httpd_req_t *req) {
+    PROBE_SCOPE("http.PTAM");
+    // Check if the request is a POST request
+    if (req->method == HTTP_POST) {
+        //Handlers run one at a time on the httpd task, a static buffer is safe
+        static uint8_t dump[PTAM_DUMP_MAX_BYTES];
+        std::size_t len = SharedMemory::getInstance().dump(dump, sizeof(dump));
+
+        httpd_resp_set_type(req, "application/cbor");
+        httpd_resp_send(req, reinterpret_cast<const char*>(dump), len);
         return ESP_OK;
     }
 
@@ -349,31 +466,102 @@ esp_err_t BroadcastedServer::handle_W1_request(httpd_req_t *req) {
     return ESP_OK;
 }
 
+esp_err_t BroadcastedServer::handle_probe_request(httpd_req_t *req) {
+    PROBE_SCOPE("http.PROBES");
+    // Check if the request is a POST request
+    if (req->method == HTTP_POST) {
+        //Handlers run one at a time on the httpd task, a static buffer is safe
+        static uint8_t dump[PROBE_DUMP_MAX_BYTES];
+        std::size_t len = ProbeTable::getInstance().dump(dump, sizeof(dump));
+
+        httpd_resp_set_type(req, "application/cbor");
+        httpd_resp_send(req, reinterpret_cast<const char*>(dump), len);
+        return ESP_OK;
+    }
+
+    // If the request is not a POST request, return 404 Not Found
+    httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "Not Found");
+    return ESP_OK;
+}
+
+esp_err_t BroadcastedServer::handle_timestep_request(httpd_req_t *req) {
+    PROBE_SCOPE("http.TIMESTEPS");
+    // Check if the request is a POST request
+    if (req->method == HTTP_POST) {
+        //Measured control intervals and their jitter
+        static uint8_t dump[TIMESTEP_DUMP_MAX_BYTES];
+        std::size_t len = TimeStepTable::getInstance().dump(dump, sizeof(dump));
+
+        httpd_resp_set_type(req, "application/cbor");
+        httpd_resp_send(req, reinterpret_cast<const char*>(dump), len);
+        return ESP_OK;
+    }
+
+    // If the request is not a POST request, return 404 Not Found
+    httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "Not Found");
+    return ESP_OK;
+}
+
+esp_err_t BroadcastedServer::handle_memory_request(httpd_req_t *req) {
+    PROBE_SCOPE("http.MEM");
+    // Check if the request is a POST request
+    if (req->method == HTTP_POST) {
+        //Pressure level, heap marks, shedding and per-component use
+        static uint8_t dump[MEM_DUMP_MAX_BYTES];
+        std::size_t len = MemoryManager::getInstance().dump(dump, sizeof(dump));
+
+        httpd_resp_set_type(req, "application/cbor");
+        httpd_resp_send(req, reinterpret_cast<const char*>(dump), len);
+        return ESP_OK;
+    }
+
+    // If the request is not a POST request, return 404 Not Found
+    httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "Not Found");
+    return ESP_OK;
+}
+
+esp_err_t BroadcastedServer::handle_health_request(httpd_req_t *req) {
+    PROBE_SCOPE("http.HEALTH");
+    // Check if the request is a POST request
+    if (req->method == HTTP_POST) {
+        //Escalation level, watchdog feeds, per-task deadlines, stack and CPU share
+        static uint8_t dump[HEALTH_DUMP_MAX_BYTES];
+        std::size_t len = HealthMonitor::getInstance().dump(dump, sizeof(dump));
+
+        httpd_resp_set_type(req, "application/cbor");
+        httpd_resp_send(req, reinterpret_cast<const char*>(dump), len);
+        return ESP_OK;
+    }
+
+    // If the request is not a POST request, return 404 Not Found
+    httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "Not Found");
+    return ESP_OK;
+}
 
 esp_err_t BroadcastedServer::handle_AMB_request(httpd_req_t *req) {
-    BATTERY *power = new BATTERY();
+    ArenaCycle cycle(requestArena);
+    PoolRef<BATTERY, 1> power(batteryPool);
     // Check if the request is a POST request
     if (req->method == HTTP_POST) {
 
-       std::string id1 = "OAT";
+       const char* id1 = "OAT";
         double value1 = 165;
-        std::string id2 = "PRESS";
+        const char* id2 = "PRESS";
         double value2 = 148;
-        std::string id3 = "GYROZ";
+        const char* id3 = "GYROZ";
         double value3 = 109;
-        std::string id4 = "THROT";
+        const char* id4 = "THROT";
         double value4 = power -> returnBatteryPercent();
 
-        std::string packed_data = packData(id1, value1, id2, value2, id3, value3, id4, value4);
+        ScratchSpan<char> packed_data = packData(requestArena, id1, value1, id2, value2, id3, value3, id4, value4);
 
         // Send a response to the client
-        httpd_resp_send(req, packed_data.c_str(), packed_data.length());
+        httpd_resp_send(req, packed_data.data, packed_data.size());
         return ESP_OK;
     }
 
     // If the request is not a POST request, return 404 Not Found
     httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "Not Found");
-    delete power;
     return ESP_OK;
 }
 
@@ -382,20 +570,18 @@ esp_err_t BroadcastedServer::handle_arm_token_request(httpd_req_t *req) {
     if (req->method == HTTP_POST) {
         uint32_t seed1 = esp_random();
         uint32_t seed2 = esp_random();
-        CONTROLLER_TASKS *cobj = new CONTROLLER_TASKS();
+        PoolRef<CONTROLLER_TASKS, 1> cobj(controllerPool);
         SharedMemory& sharedMemory = SharedMemory::getInstance();
         std::string packed_data = "";
         if(cobj -> verifyFlightConfiguration() != 0){
             packed_data = cobj -> generateRandomAlphanumericToken(seed1, seed2, 6);
             //UPDATE PTAM REGISTERS
-            sharedMemory.clearData("arm_token");
             sharedMemory.storeString("arm_token", packed_data);
             // Send a response to the client
             httpd_resp_send(req, packed_data.c_str(), packed_data.length());
         }else{
             //We do not send anything so the request will fail
         }
-        delete cobj;
         return ESP_OK;
     }
 
@@ -405,34 +591,34 @@ esp_err_t BroadcastedServer::handle_arm_token_request(httpd_req_t *req) {
 }
 
 esp_err_t BroadcastedServer::handle_battery_request(httpd_req_t *req) {
-    BATTERY *power = new BATTERY();
+    ArenaCycle cycle(requestArena);
+    PoolRef<BATTERY, 1> power(batteryPool);
     // Check if the request is a POST request
     if (req->method == HTTP_POST) {
 
-       std::string id1 = "VOLTAGE";
+       const char* id1 = "VOLTAGE";
         double value1 = power -> returnBatteryVoltage();
-        std::string id2 = "CURRENT";
+        const char* id2 = "CURRENT";
         double value2 = power -> returnBatteryCurrentDraw();
-        std::string id3 = "PERCENT";
+        const char* id3 = "PERCENT";
         double value3 = power -> returnBatteryPercent();
-        std::string id4 = "XXX";
+        const char* id4 = "XXX";
         double value4 = 112;
 
-        std::string packed_data = packData(id1, value1, id2, value2, id3, value3, id4, value4);
+        ScratchSpan<char> packed_data = packData(requestArena, id1, value1, id2, value2, id3, value3, id4, value4);
 
         // Send a response to the client
-        httpd_resp_send(req, packed_data.c_str(), packed_data.length());
+        httpd_resp_send(req, packed_data.data, packed_data.size());
         return ESP_OK;
     }
 
     // If the request is not a POST request, return 404 Not Found
     httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "Not Found");
-
-    delete power;
     return ESP_OK;
 }
 
 esp_err_t BroadcastedServer::handle_SWP_incoming(httpd_req_t *req){
+    PROBE_SCOPE("http.SWP");
     char received_data[MAX_DATA_LEN] = "";
     // Check if the request is a POST request
     if (req->method == HTTP_POST) {
@@ -460,11 +646,12 @@ esp_err_t BroadcastedServer::handle_SWP_incoming(httpd_req_t *req){
     received_data[received] = '\0';
         // Send a response to the client
         //httpd_resp_send(req, packed_data.c_str(), packed_data.length());
-        std::string data = received_data;
-        std::vector<std::string> ids;
-        std::vector<double> values;
-
-        extractValuesAndIds(data, ids, values);
+        ArenaCycle cycle(requestArena);
+        ScratchSpan<ScratchSpan<char>> ids;
+        ScratchSpan<double> values;
+        if (extractValuesAndIds(received_data, requestArena, ids, values) == 0) {
+            return ESP_FAIL;
+        }
         ESP_LOGI("TAG", "%f",values[0]);
         
         //UPDATE PTAM REGISTERS
@@ -472,32 +659,22 @@ esp_err_t BroadcastedServer::handle_SWP_incoming(httpd_req_t *req){
         //If value from frontend is not 0, update PTAM register for respective variable
         if(values[0] != 0){
             //Latitude
-            //Clear previous register to avoid memory overflow
-            sharedMemory.clearData("TLat");
             sharedMemory.storeDouble("TLat", values[0]);
         }
         if(values[1] != 0){
             //Longitude
-            //Clear previous register to avoid memory overflow
-            sharedMemory.clearData("TLong");
             sharedMemory.storeDouble("TLong", values[1]);
         }
         if(values[2] != 0){
             //Altitude - target
-            //Clear previous register to avoid memory overflow
-            sharedMemory.clearData("TAlt");
             sharedMemory.storeDouble("TAlt", values[2]);
         }
         if(values[3] != 0){
             //Altitude - cruise
-            //Clear previous register to avoid memory overflow
-            sharedMemory.clearData("CAlt");
             sharedMemory.storeDouble("CAlt", values[3]);
         }
         if(values[4] != 0){
             //Velocity
-            //Clear previous register to avoid memory overflow
-            sharedMemory.clearData("TVel");
             sharedMemory.storeDouble("TVel", values[4]);
         }
         return ESP_OK;
@@ -536,11 +713,12 @@ esp_err_t BroadcastedServer::handle_SYS_incoming(httpd_req_t *req){
     received_data[received] = '\0';
         // Send a response to the client
         //httpd_resp_send(req, packed_data.c_str(), packed_data.length());
-        std::string data = received_data;
-        std::vector<std::string> ids;
-        std::vector<double> values;
-
-        extractValuesAndIds(data, ids, values);
+        ArenaCycle cycle(requestArena);
+        ScratchSpan<ScratchSpan<char>> ids;
+        ScratchSpan<double> values;
+        if (extractValuesAndIds(received_data, requestArena, ids, values) == 0) {
+            return ESP_FAIL;
+        }
         ESP_LOGI("TAG", "%f",values[0]);
         
         //UPDATE PTAM REGISTERS
@@ -548,32 +726,22 @@ esp_err_t BroadcastedServer::handle_SYS_incoming(httpd_req_t *req){
         //If value from frontend is not 0, update PTAM register for respective variable
         if(values[0] != 0){
             //Latitude
-            //Clear previous register to avoid memory overflow
-            sharedMemory.clearData("WingFL");
             sharedMemory.storeDouble("WingFL", values[0]);
         }
         if(values[1] != 0){
             //Longitude
-            //Clear previous register to avoid memory overflow
-            sharedMemory.clearData("WingFR");
             sharedMemory.storeDouble("WingFR", values[1]);
         }
         if(values[2] != 0){
             //Altitude - target
-            //Clear previous register to avoid memory overflow
-            sharedMemory.clearData("WingRL");
             sharedMemory.storeDouble("WingRL", values[2]);
         }
         if(values[3] != 0){
             //Altitude - cruise
-            //Clear previous register to avoid memory overflow
-            sharedMemory.clearData("WingRR");
             sharedMemory.storeDouble("WingRR", values[3]);
         }
         if(values[4] != 0){
             //Velocity
-            //Clear previous register to avoid memory overflow
-            sharedMemory.clearData("THR");
             sharedMemory.storeDouble("THR", values[4]);
         }
         return ESP_OK;
@@ -585,6 +753,7 @@ esp_err_t BroadcastedServer::handle_SYS_incoming(httpd_req_t *req){
 }
 
 esp_err_t BroadcastedServer::handle_STATE_incoming(httpd_req_t *req){
+    PROBE_SCOPE("http.STATE");
     char received_data[MAX_DATA_LEN] = "";
     // Check if the request is a POST request
     if (req->method == HTTP_POST) {
@@ -612,33 +781,34 @@ esp_err_t BroadcastedServer::handle_STATE_incoming(httpd_req_t *req){
     received_data[received] = '\0';
         // Send a response to the client
         //httpd_resp_send(req, packed_data.c_str(), packed_data.length());
-        std::string data = received_data;
-        std::vector<std::string> ids;
-        std::vector<double> values;
-
-        extractValuesAndIds(data, ids, values);
+        ArenaCycle cycle(requestArena);
+        ScratchSpan<ScratchSpan<char>> ids;
+        ScratchSpan<double> values;
+        if (extractValuesAndIds(received_data, requestArena, ids, values) == 0) {
+            return ESP_FAIL;
+        }
 
-        //If value from frontend is not 0, update respective variable
+        //If value from frontend is not 0, post the respective state machine event
+        FlightStateMachine& fsm = FlightStateMachine::getInstance();
         if(values[0] != 0){
-            STATE *switchS = new STATE();
             switch(int(values[0])){
                 case 1:
                     //State switch to PREP
-                    switchS -> updateState(PREP);
+                    fsm.post(EVT_REQ_PREP);
                     break;
                 case 2:
                     //State switch to ARMED
-                    switchS -> updateState(ARMED);
+                    fsm.post(EVT_REQ_ARMED);
                     break;
                 case 3:
                     //State switch to BYPASS
-                    switchS -> updateState(BYPASS);
+                    fsm.post(EVT_REQ_BYPASS);
                     break;
             }
-            delete switchS;
         }
         if(values[1] != 0){
-
+            //Abort, latched until a PREP request
+            fsm.post(EVT_ABORT);
         }
         if(values[2] != 0){
 
@@ -685,26 +855,18 @@ esp_err_t BroadcastedServer::handle_AUTH_incoming(httpd_req_t *req){
     received_data[received] = '\0';
         // Send a response to the client
         //httpd_resp_send(req, packed_data.c_str(), packed_data.length());
-        std::string data = received_data;
         //Compare token data sent with token data in PTAM register
         //If they match state can be changed to armed
         SharedMemory& sharedMemory = SharedMemory::getInstance();
-        std::string token_saved = sharedMemory.getLastString("arm_token");
+        std::string token_saved = sharedMemory.getLastString(REG_ARM_TOKEN);
         if(received_data != token_saved){
             // Send a response to the client indicating no match
-            std::string packed_data = "STATE-CHANGE-FAIL";
-            httpd_resp_send(req, packed_data.c_str(), packed_data.length());
+            httpd_resp_send(req, "STATE-CHANGE-FAIL", HTTPD_RESP_USE_STRLEN);
         }else{
-            //Change state to armed by modifying PTAM register
-            //Clear previous register to avoid memory overflow
-            sharedMemory.clearData("state");
-            sharedMemory.storeDouble("state", 2);
-            //Clear previous register to avoid memory overflow
-            sharedMemory.clearData("stateDescript");
-            sharedMemory.storeString("stateDescript", "ARMED");
+            //Request ARMED, the state machine publishes the state once it is entered
+            FlightStateMachine::getInstance().post(EVT_AUTH_OK);
             // Send a response to the client indicating direct match
-            std::string packed_data = "STATE-CHANGE-SUCCESS";
-            httpd_resp_send(req, packed_data.c_str(), packed_data.length());
+            httpd_resp_send(req, "STATE-CHANGE-SUCCESS", HTTPD_RESP_USE_STRLEN);
         }
 
         return ESP_OK;
@@ -715,6 +877,43 @@ esp_err_t BroadcastedServer::handle_AUTH_incoming(httpd_req_t *req){
     return ESP_OK;
 }
 
+//____________________________________________________________
+/* Handler -> PID gain table upload (text, see GainSchedule::parse)
+===========================================================================
+|    400 if the table is too big, does not parse or fails validation,
+|    the table in use is then kept
+===========================================================================
+*/
+esp_err_t BroadcastedServer::handle_GAINS_incoming(httpd_req_t *req){
+    PROBE_SCOPE("http.GAINS");
+    //Handlers run one at a time on the httpd task, a static buffer is safe
+    static char received_data[GAIN_UPLOAD_MAX_BYTES];
+    const int total_len = req->content_len;
+    if (total_len <= 0 || total_len > GAIN_UPLOAD_MAX_BYTES) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Bad gain table size");
+        return ESP_FAIL;
+    }
+
+    int received = 0;
+    while (received < total_len) {
+        const int cur_len = httpd_req_recv(req, received_data + received, total_len - received);
+        if (cur_len <= 0) {
+            if (cur_len == HTTPD_SOCK_ERR_TIMEOUT) {
+                continue;
+            }
+            return ESP_FAIL;
+        }
+        received += cur_len;
+    }
+
+    if (!CONTROLLER_TASKS::uploadGains(received_data, static_cast<std::size_t>(received))) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid gain table");
+        return ESP_FAIL;
+    }
+    httpd_resp_sendstr(req, "OK");
+    return ESP_OK;
+}
+
 esp_err_t BroadcastedServer::handle_OTA_incoming(httpd_req_t *req){
     char buf[1000];
 	esp_ota_handle_t ota_handle;
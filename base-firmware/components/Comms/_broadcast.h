@@ -33,10 +33,18 @@ SOFTWARE.*/
 #include"esp_log.h"
 #include"esp_random.h"
 #include"../PTAM/_ptam.h"
+#include"../Profiling/_probe.h"
+#include"../Profiling/_timestep.h"
 #include"../system/sys_controller.h"
 #include"../HALX/Barometer/_barometerEntry.h"
 #include"../HALX/Battery/_battery.h"
 #include"../system/_state.h"
+#include"../system/_flight_fsm.h"
+#include"../system/_task_layout.h"
+#include"../system/_memory.h"
+#include"../system/_health.h"
+#include"../Memory/_arena.h"
+#include"../Memory/_pool.h"
 #include "os_config.h"
 
 class BroadcastedServer {
@@ -46,12 +54,16 @@ class BroadcastedServer {
         void wifi_init_softap(void);
 
     private:
-        static std::string packData(const std::string& id1, float value1,
-                     const std::string& id2, float value2,
-                     const std::string& id3, float value3,
-                     const std::string& id4, float value4);
-        
-        static void extractValuesAndIds(const std::string& data, std::vector<std::string>& ids, std::vector<double>& values);
+        //"ID1v1_ID2v2_ID3v3_ID4v4" in the request arena
+        static ScratchSpan<char> packData(ScratchArena& arena, const char* id1, float value1,
+                     const char* id2, float value2,
+                     const char* id3, float value3,
+                     const char* id4, float value4);
+
+        //Splits "ID1v1_ID2v2..." into arena spans, padded to HTTP_MIN_FIELDS
+        //with zero values. Returns the fields parsed, 0 if the arena is full
+        static std::size_t extractValuesAndIds(const char* data, ScratchArena& arena,
+                                               ScratchSpan<ScratchSpan<char>>& ids, ScratchSpan<double>& values);
 
     private:
         static esp_err_t root_handler(httpd_req_t *req);
@@ -80,6 +92,17 @@ class BroadcastedServer {
 
         static esp_err_t handle_OTA_incoming(httpd_req_t *req);
 
+        static esp_err_t handle_GAINS_incoming(httpd_req_t *req);
+
+        static esp_err_t handle_PTAM_dump_request(httpd_req_t *req);
+
+        static esp_err_t handle_probe_request(httpd_req_t *req);
+
+        static esp_err_t handle_timestep_request(httpd_req_t *req);
+
+        static esp_err_t handle_memory_request(httpd_req_t *req);
+        static esp_err_t handle_health_request(httpd_req_t *req);
+
     private:
         const char *html_content = responseXX;
 };
@@ -21,6 +21,7 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.*/
 
 #include "bmi088.h"
+#include "../../PID/_lut.h"
 #include <stdio.h>
 #include <stdint.h>
 #include <math.h>
@@ -147,32 +148,48 @@ typedef enum
 }mpu_register_address;
 
 void BMI088_IMU::IMU_INIT(){
+    ESP_ERROR_CHECK(IMU_START());
+}
+
+esp_err_t BMI088_IMU::IMU_START(){
     uint8_t data[2];
-    ESP_ERROR_CHECK(i2c_master_init());
+    esp_err_t err = i2c_master_init();
+    if (err != ESP_OK) {
+        return err;
+    }
     ESP_LOGI(TAG, "I2C initialized successfully");
 
     /* Read the BM1088 GYRO_CHIP_ID REGISTER, on power up the register should have the value 0x0F */
-    ESP_ERROR_CHECK(bm1088_gyro_read(GYRO_CHIP_ID, data, 1));
+    if ((err = bm1088_gyro_read(GYRO_CHIP_ID, data, 1)) != ESP_OK) {
+        return err;
+    }
     ESP_LOGI(TAG, "GYRO_CHIP_ID_REGISTER_VALUE = %X", data[0]);
 
     /* Read the BM1088 ACC_PWR_CTRL REGISTER to check power on reset */
     uint8_t check_por[2];
-    ESP_ERROR_CHECK(bm1088_accel_read(ACC_PWR_CTRL, check_por, 1));
+    if ((err = bm1088_accel_read(ACC_PWR_CTRL, check_por, 1)) != ESP_OK) {
+        return err;
+    }
     vTaskDelay(1/ portTICK_PERIOD_MS);
 
     /* Enable accel module by writing 0x04 to power control register */
     uint8_t acc_pwr_ctr = 0x04;
     acc_pwr_ctr |= check_por[0];
 
-    ESP_ERROR_CHECK(bm1088_accel_write_byte(ACC_PWR_CTRL, acc_pwr_ctr));
+    if ((err = bm1088_accel_write_byte(ACC_PWR_CTRL, acc_pwr_ctr)) != ESP_OK) {
+        return err;
+    }
     vTaskDelay(50/ portTICK_PERIOD_MS);
-    ESP_ERROR_CHECK(bm1088_accel_read(ACC_PWR_CTRL, check_por, 1));
+    if ((err = bm1088_accel_read(ACC_PWR_CTRL, check_por, 1)) != ESP_OK) {
+        return err;
+    }
     
     if (check_por[0] == acc_pwr_ctr)
     {
         ESP_LOGI(TAG, "Accelerometer configured successfully");
     }
     else ESP_LOGI(TAG, "Accelerometer not configured ");
+    return ESP_OK;
 }
 
 /**
@@ -374,23 +391,57 @@ double BMI088_IMU::angle_read_roll(){
 }
 
 double BMI088_IMU::angle_read_yaw(){
-    double previousTime, currentTime, elapsedTime;
-    previousTime = esp_timer_get_time();        // Previous time is stored before the actual time read
-    currentTime = esp_timer_get_time();           // Current time actual time read
-    elapsedTime = (currentTime - previousTime) / 1000; // Divide by 1000 to get seconds
+    //Gyro Z integrated over the measured interval since the previous read.
+    //Two back-to-back timer reads here used to give an elapsed time of ~0
+    static TimeStep* step = TimeStepTable::getInstance().timestep("imu.yaw", BMI088_YAW_NOMINAL_US);
+    static double yaw = 0;
+    const double dt = step ? step->tick() : BMI088_YAW_NOMINAL_US / 1e6;
 
     double GyroZ = gyro_read_rawZ();
-    
-    double yaw = GyroZ * elapsedTime;
+
+    yaw = remainder(yaw + GyroZ * dt, 360.0);
     return yaw;
 }
 
+//Accelerometer pitch (-90 to 90) augmented to the vehicle's roll range
+static constexpr FixedLUT<2> PITCH_TO_ROLL = FixedLUT<2>::linear(-90, 90, -180, 180);
+
+esp_err_t BMI088_IMU::read_attitude(double& pitch, double& roll, double& yaw, double dt_s){
+    //X, Y, Z accel in one transfer, then gyro Z; short timeout, no retries
+    uint8_t accel[6];
+    uint8_t gyro[2];
+    uint8_t reg = ACC_X_LSB;
+    esp_err_t err = i2c_master_write_read_device(i2c_port_t(I2C_MASTER_NUM), BM1088_ACCEL_ADDRESS, &reg, 1,
+                                                 accel, sizeof(accel), BMI088_READ_TIMEOUT_TICKS);
+    if (err != ESP_OK) {
+        return err;
+    }
+    reg = GYRO_Z_LSB;
+    err = i2c_master_write_read_device(i2c_port_t(I2C_MASTER_NUM), BM1088_GYRO_ADDRESS, &reg, 1,
+                                       gyro, sizeof(gyro), BMI088_READ_TIMEOUT_TICKS);
+    if (err != ESP_OK) {
+        return err;
+    }
+    const double x = lsb_to_mps2(int16_t((accel[1] << 8) | accel[0]), 24, 16);
+    const double y = lsb_to_mps2(int16_t((accel[3] << 8) | accel[2]), 24, 16);
+    const double z = lsb_to_mps2(int16_t((accel[5] << 8) | accel[4]), 24, 16);
+    const double gyro_z = lsb_to_dps(int16_t((gyro[1] << 8) | gyro[0]), (float)250, 16);
+
+    //Same sensor-to-vehicle mapping as readAugmentedIMUData()
+    const double sensor_pitch = atan2(-x, sqrt(y * y + z * z)) * 57.3;
+    const double sensor_roll = atan2(y, z) * 57.3;
+    static double heading = 0;
+    heading = remainder(heading + gyro_z * dt_s, 360.0);
+
+    pitch = -sensor_roll;
+    roll = -(PITCH_TO_ROLL(sensor_pitch));
+    yaw = heading;
+    return ESP_OK;
+}
+
 double BMI088_IMU::linearInterpolate(double input, double input_start, double input_end, 
                                         double output_start, double output_end) {
-    // Map input range to output range
-    double slope = (output_end - output_start) / (input_end - input_start);
-    double output = output_start + slope * (input - input_start);
-    return output;
+    return lut_interpolate(input, input_start, input_end, output_start, output_end);
 }
 
 double BMI088_IMU::readAugmentedIMUData(uint8_t angle_type){
@@ -405,7 +456,7 @@ double BMI088_IMU::readAugmentedIMUData(uint8_t angle_type){
             return -(angle_read_roll());
             break;
         case ROLL:
-            return -(linearInterpolate(angle_read_pitch(), -90, 90, -180, 180));
+            return -(PITCH_TO_ROLL(angle_read_pitch()));
             break;
         case YAW:
             return angle_read_yaw();
@@ -31,14 +31,35 @@ SOFTWARE.*/
 #include "freertos/task.h"
 #include "esp_log.h"
 #include "driver/i2c.h"
+#include "../../Profiling/_timestep.h"
 
 #define PITCH (uint8_t) 0
 #define ROLL (uint8_t) 1
 #define YAW (uint8_t) 2
 
+//Expected interval between angle_read_yaw() calls, the real one is measured
+#define BMI088_YAW_NOMINAL_US 10000
+//I2C timeout of read_attitude() (one FreeRTOS tick), a late sample is dropped
+#define BMI088_READ_TIMEOUT_TICKS 1
+
 class BMI088_IMU {
     public:
         static void IMU_INIT();
+
+        /**
+         * @brief IMU_INIT without aborting: returns the first I2C error instead
+         */
+        static esp_err_t IMU_START();
+
+        /**
+         * @brief One attitude sample for the sense rate group, never aborts
+         *
+         * Burst reads the accelerometer and gyro Z, pitch / roll / yaw in deg in
+         * the vehicle frame of readAugmentedIMUData(). Yaw integrates gyro Z over
+         * dt_s (the caller's measured interval). Returns the I2C error, the
+         * outputs are only written on ESP_OK.
+         */
+        static esp_err_t read_attitude(double& pitch, double& roll, double& yaw, double dt_s);
         /**
          * @brief Read a sequence of bytes from a BM1088 accel sensor registers
          */
@@ -110,6 +131,7 @@ class BMI088_IMU {
 
         static double angle_read_roll();
 
+        //Integrated gyro Z heading, deg in [-180, 180], drifts without a reference
         static double angle_read_yaw();
 
         static double linearInterpolate(double input, double input_start, double input_end,
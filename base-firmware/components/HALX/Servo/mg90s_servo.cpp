@@ -21,6 +21,7 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.*/
 
 #include "mg90s_servo.h"
+#include "../../PID/_lut.h"
 #include <stdio.h>
 #include <time.h>
 #include <string.h>
@@ -35,6 +36,9 @@ SOFTWARE.*/
 #define ServoMsMax 2.1
 #define ServoMsAvg ((ServoMsMax-ServoMsMin)/2.0)
 
+//Target angle 0 - 360 to pulse width, slope taken at compile time
+static constexpr FixedLUT<2> SERVO_PULSE_MAP = FixedLUT<2>::linear(0, 360, ServoMsMin, ServoMsMax);
+
 uint8_t SERVO_POS_1 = 0;
 
 uint8_t SERVO_POS_2 = 0;
@@ -50,10 +54,7 @@ uint8_t SERVO_POS_4 = 0;
 */
 double WingTranslate::linearInterpolate(double input, double input_start, double input_end, 
                                         double output_start, double output_end) {
-    // Map input range to output range
-    double slope = (output_end - output_start) / (input_end - input_start);
-    double output = output_start + slope * (input - input_start);
-    return output;
+    return lut_interpolate(input, input_start, input_end, output_start, output_end);
 }
 
 //____________________________________________________________
@@ -98,7 +99,7 @@ void WingTranslate::actuateServo(double targetPos, uint8_t pin) {
 */
 uint8_t WingTranslate::servo_control(double target, uint8_t pin){
     //Map target in the 0 - 360 range to ServoMsMin and ServoMsMax
-    double mapped_target = linearInterpolate(target, 0, 360, ServoMsMin, ServoMsMax);
+    double mapped_target = SERVO_PULSE_MAP(target);
     actuateServo(mapped_target, pin);
     UPDATE_SERVO_POS(pin,target);
     return mapped_target;
@@ -29,9 +29,40 @@
  */
 
 #include "../PTAM/_ptam.h"
+#include "../Profiling/_probe.h"
+#include "../Profiling/_timestep.h"
+#include "../system/_flight_fsm.h"
 #include "logger.hpp"
 #include "esp_timer.h"
 
+/**
+ * @brief Position held by a wing register sample
+ *
+ * @param sample
+ * @return double (0 if the register was never written, like getLastDouble)
+ */
+static double sample_position(const ptam_sample_t &sample)
+{
+    return sample.seq == 0 ? 0.0 : sample.value.d;
+}
+
+/**
+ * @brief Formats the freshness of a ptam sample as "seq <n> age <us>us"
+ *
+ * @param sample
+ * @param now_us
+ * @return std::string ("never" if the register was never written)
+ */
+static std::string format_freshness(const ptam_sample_t &sample, uint64_t now_us)
+{
+    if (sample.seq == 0)
+    {
+        return "never";
+    }
+    return "seq " + std::to_string(sample.seq) + " age " +
+           std::to_string(static_cast<int64_t>(now_us) - sample.time_us) + "us";
+}
+
 /**
  * @brief Queries all required ptam registers, formats them, logs them, and returns the log
  *
@@ -43,16 +74,16 @@ std::string Logger::EVENT_LOG_SDD(void)
     SharedMemory &obj = SharedMemory::getInstance();
 
     /* Query ptam registers for required data */
-    std::string ID = obj.getLastString("stateDescript");
-    int state_data = obj.getLastInt("state");
-
-    double FLS = obj.getLastDouble("WingFL");
+    std::string ID = obj.getLastString(REG_STATE_DESCRIPT);
+    int state_data = obj.getLastInt(REG_STATE);
 
-    double FRS = obj.getLastDouble("WingFR");
-
-    double RLS = obj.getLastDouble("WingRL");
-
-    double RRS = obj.getLastDouble("WingRR");
+    /* Wing samples carry their write time and sequence number for freshness */
+    RegisterFile &regs = obj.registers();
+    ptam_sample_t FLS = {}, FRS = {}, RLS = {}, RRS = {}; // seq 0 until latest() fills them
+    regs.latest(REG_WING_FL, FLS);
+    regs.latest(REG_WING_FR, FRS);
+    regs.latest(REG_WING_RL, RLS);
+    regs.latest(REG_WING_RR, RRS);
 
     uint64_t end_time = esp_timer_get_time();
     uint64_t elapsed_time = end_time;
@@ -67,10 +98,14 @@ std::string Logger::EVENT_LOG_SDD(void)
     formatted_output += "\t\tTIME: " + std::to_string(elapsed_time) + "\n";
     formatted_output += "\t\tDATA: " + std::to_string(state_data) + "\n";
     formatted_output += "\t\tMACHINE-STATE: " + std::to_string(state_data) + "\n";
-    formatted_output += "\t\tWING-FL-POS: " + std::to_string(FLS) + "\n";
-    formatted_output += "\t\tWING-FR-POS: " + std::to_string(FRS) + "\n";
-    formatted_output += "\t\tWING-RL-POS: " + std::to_string(RLS) + "\n";
-    formatted_output += "\t\tWING-RR-POS: " + std::to_string(RRS) + "\n";
+    formatted_output += "\t\tWING-FL-POS: " + std::to_string(sample_position(FLS)) + "\n";
+    formatted_output += "\t\tWING-FR-POS: " + std::to_string(sample_position(FRS)) + "\n";
+    formatted_output += "\t\tWING-RL-POS: " + std::to_string(sample_position(RLS)) + "\n";
+    formatted_output += "\t\tWING-RR-POS: " + std::to_string(sample_position(RRS)) + "\n";
+    formatted_output += "\t\tWING-FL-FRESH: " + format_freshness(FLS, end_time) + "\n";
+    formatted_output += "\t\tWING-FR-FRESH: " + format_freshness(FRS, end_time) + "\n";
+    formatted_output += "\t\tWING-RL-FRESH: " + format_freshness(RLS, end_time) + "\n";
+    formatted_output += "\t\tWING-RR-FRESH: " + format_freshness(RRS, end_time) + "\n";
     formatted_output += "\t}\n\n";
 
     return formatted_output;
@@ -87,10 +122,13 @@ std::string Logger::EVENT_LOG_SSL(void)
     SharedMemory &obj = SharedMemory::getInstance();
 
     /* Query ptam registers */
-    std::string state = obj.getLastString("stateDescript");
+    std::string state = obj.getLastString(REG_STATE_DESCRIPT);
     std::string ID = "LOG_SSL_ID";
 
-    int state_data = obj.getLastInt("state");
+    int state_data = obj.getLastInt(REG_STATE);
+
+    /* Transition latency, post() -> entry action done */
+    fsm_stats_t fsm = FlightStateMachine::getInstance().engine().stats();
 
     uint64_t end_time = esp_timer_get_time();
     uint64_t elapsed_time = end_time;
@@ -105,6 +143,9 @@ std::string Logger::EVENT_LOG_SSL(void)
     formatted_output += "\t\tTIME: " + std::to_string(elapsed_time) + "\n";
     formatted_output += "\t\tMACHINE-STATE: " + std::to_string(state_data) + "\n";
     formatted_output += "\t\tSTATE: " + state + "\n";
+    formatted_output += "\t\tFSM-TRANSITIONS: " + std::to_string(fsm.transitions) + "\n";
+    formatted_output += "\t\tFSM-LAST-LATENCY: " + std::to_string(fsm.last_latency_us) + "us\n";
+    formatted_output += "\t\tFSM-WORST-LATENCY: " + std::to_string(fsm.worst_latency_us) + "us\n";
     formatted_output += "\t}\n\n";
 
     return formatted_output;
@@ -124,7 +165,7 @@ std::string Logger::EVENT_LOG_SEL(std::string ID, mars_exception_t::Type excepti
     SharedMemory &obj = SharedMemory::getInstance();
 
     /* Get ptam data */
-    int state_data = obj.getLastInt("state");
+    int state_data = obj.getLastInt(REG_STATE);
 
     uint64_t end_time = esp_timer_get_time();
     uint64_t elapsed_time = end_time;
@@ -159,6 +200,58 @@ std::string Logger::EVENT_LOG_SEL(std::string ID, mars_exception_t::Type excepti
     return formatted_output;
 }
 
+/**
+ * @brief Formats every probe as "n <count> min <ns> mean <ns> max <ns> p99 <ns>" (ns)
+ *        and every time step as "n <count> mean <us> jitter <us> max <us> capped <n>" (us)
+ *
+ * @param void
+ * @return std::string
+ */
+std::string Logger::EVENT_LOG_PRB(void)
+{
+    SharedMemory &obj = SharedMemory::getInstance();
+
+    /* Query the probe table */
+    probe_stats_t probes[PROBE_MAX];
+    std::size_t count = ProbeTable::getInstance().snapshot(probes, PROBE_MAX);
+    timestep_stats_t steps[TIMESTEP_MAX];
+    std::size_t stepCount = TimeStepTable::getInstance().snapshot(steps, TIMESTEP_MAX);
+
+    int state_data = obj.getLastInt(REG_STATE);
+
+    uint64_t end_time = esp_timer_get_time();
+    uint64_t elapsed_time = end_time;
+
+    /* Format and output data */
+    std::string log_ev = "LOG_PRB";
+
+    std::string formatted_output;
+    formatted_output += "\n\n" + log_ev + ":\n";
+    formatted_output += "\t{\n";
+    formatted_output += "\t\tID: LOG_PRB_ID\n";
+    formatted_output += "\t\tTIME: " + std::to_string(elapsed_time) + "\n";
+    formatted_output += "\t\tMACHINE-STATE: " + std::to_string(state_data) + "\n";
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        formatted_output += "\t\tPROBE-" + std::string(probes[i].name) + ": n " + std::to_string(probes[i].count) +
+                            " min " + std::to_string(probes[i].min_ns) +
+                            " mean " + std::to_string(probes[i].mean_ns) +
+                            " max " + std::to_string(probes[i].max_ns) +
+                            " p99 " + std::to_string(probes[i].p99_ns) + "\n";
+    }
+    for (std::size_t i = 0; i < stepCount; ++i)
+    {
+        formatted_output += "\t\tDT-" + std::string(steps[i].name) + ": n " + std::to_string(steps[i].count) +
+                            " mean " + std::to_string(steps[i].mean_us) +
+                            " jitter " + std::to_string(steps[i].jitter_mean_us) +
+                            " max " + std::to_string(steps[i].jitter_max_us) +
+                            " capped " + std::to_string(steps[i].capped) + "\n";
+    }
+    formatted_output += "\t}\n\n";
+
+    return formatted_output;
+}
+
 /**
  * @brief Parses a log to return the ID of the specific event
  *
@@ -63,6 +63,13 @@ public:
     std::string EVENT_LOG_SEL(std::string ID, mars_exception_t::Type exceptionType,
                               std::string additionalInfo);
 
+    /**
+     * @brief Probe Timing Logs(PRB) dump the cycle-count probe statistics
+     *
+     * @return std::string
+     */
+    std::string EVENT_LOG_PRB(void);
+
     /**
      * @brief Get the event id from log message
      *
@@ -0,0 +1,100 @@
+/*MIT License
+Copyright (c) 2023 limitless Aeronautics
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#include "_alloc_count.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<uint32_t> allocs{0};
+static std::atomic<uint32_t> frees{0};
+
+uint32_t mem_alloc_count() {
+    return allocs.load(std::memory_order_relaxed);
+}
+
+uint32_t mem_free_count() {
+    return frees.load(std::memory_order_relaxed);
+}
+
+static void* counted_alloc(std::size_t size) {
+    allocs.fetch_add(1, std::memory_order_relaxed);
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+static void* counted_alloc_or_fail(std::size_t size) {
+    void* p = counted_alloc(size);
+    if (p == nullptr) {
+#if __cpp_exceptions
+        throw std::bad_alloc();
+#else
+        std::abort();
+#endif
+    }
+    return p;
+}
+
+//Over-aligned types (alignas > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+static void* counted_aligned(std::size_t size, std::align_val_t align) {
+    const std::size_t a = static_cast<std::size_t>(align);
+    allocs.fetch_add(1, std::memory_order_relaxed);
+    //aligned_alloc wants a size that is a multiple of the alignment
+    return std::aligned_alloc(a, size == 0 ? a : (size + a - 1) / a * a);
+}
+
+static void* counted_aligned_or_fail(std::size_t size, std::align_val_t align) {
+    void* p = counted_aligned(size, align);
+    if (p == nullptr) {
+#if __cpp_exceptions
+        throw std::bad_alloc();
+#else
+        std::abort();
+#endif
+    }
+    return p;
+}
+
+static void counted_free(void* p) {
+    if (p != nullptr) {
+        frees.fetch_add(1, std::memory_order_relaxed);
+        std::free(p);
+    }
+}
+
+void* operator new(std::size_t size) { return counted_alloc_or_fail(size); }
+void* operator new[](std::size_t size) { return counted_alloc_or_fail(size); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return counted_alloc(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return counted_alloc(size); }
+void operator delete(void* p) noexcept { counted_free(p); }
+void operator delete[](void* p) noexcept { counted_free(p); }
+void operator delete(void* p, std::size_t) noexcept { counted_free(p); }
+void operator delete[](void* p, std::size_t) noexcept { counted_free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { counted_free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { counted_free(p); }
+
+void* operator new(std::size_t size, std::align_val_t align) { return counted_aligned_or_fail(size, align); }
+void* operator new[](std::size_t size, std::align_val_t align) { return counted_aligned_or_fail(size, align); }
+void* operator new(std::size_t size, std::align_val_t align, const std::nothrow_t&) noexcept { return counted_aligned(size, align); }
+void* operator new[](std::size_t size, std::align_val_t align, const std::nothrow_t&) noexcept { return counted_aligned(size, align); }
+void operator delete(void* p, std::align_val_t) noexcept { counted_free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { counted_free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { counted_free(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { counted_free(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { counted_free(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { counted_free(p); }
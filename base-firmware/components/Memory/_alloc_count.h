@@ -0,0 +1,38 @@
+/*MIT License
+Copyright (c) 2023 limitless Aeronautics
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#ifndef ALLOC_COUNT_H
+#define ALLOC_COUNT_H
+
+#include <cstdint>
+
+//____________________________________________________________
+/* Heap allocation counter
+===========================================================================
+|    Every C++ operator new / delete (throwing, nothrow and aligned forms)
+|    is counted by the replacements in _alloc_count.cpp. Plain malloc calls
+|    from C code are not. Take the count before and after a steady-state
+|    cycle: a control path that allocates shows up as a non-zero delta.
+|    The Memory component is linked whole-archive on target so the
+|    replacements are always the ones used; /GET_MEM reports the totals.
+===========================================================================
+*/
+uint32_t mem_alloc_count();
+uint32_t mem_free_count();
+
+#endif // ALLOC_COUNT_H
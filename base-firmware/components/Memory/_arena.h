@@ -0,0 +1,167 @@
+/*MIT License
+Copyright (c) 2023 limitless Aeronautics
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#ifndef SCRATCH_ARENA_H
+#define SCRATCH_ARENA_H
+
+#include <cstdarg>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+//View of an arena allocation, valid until the arena is reset
+template <typename T>
+struct ScratchSpan {
+    T* data;
+    std::size_t count;
+
+    T* begin() const { return data; }
+    T* end() const { return data + count; }
+    std::size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    T& operator[](std::size_t i) const { return data[i]; }
+    T& front() const { return data[0]; }
+};
+
+//____________________________________________________________
+/* Per-cycle bump allocator
+===========================================================================
+|    Scratch data of one cycle (a control tick, an HTTP request) is
+|    carved out of a fixed buffer and dropped all at once by reset(),
+|    which only rewinds an offset. Nothing is ever freed one by one, so
+|    only trivially destructible types are accepted.
+|    A full arena returns nullptr / an empty span and counts a failure,
+|    it never falls back to the heap.
+|    Not thread safe, one task owns an arena.
+===========================================================================
+*/
+class ScratchArena {
+public:
+    ScratchArena(uint8_t* buffer, std::size_t capacity)
+        : buffer_(buffer), capacity_(capacity), used_(0), highWater_(0), failures_(0) {}
+
+    ScratchArena(const ScratchArena&) = delete;
+    ScratchArena& operator=(const ScratchArena&) = delete;
+
+    //____________________________________________________________
+    /* Main subroutine -> raw aligned block
+    ===========================================================================
+    |    bytes           Size of the block
+    |    align           Power of two
+    |    Returns         nullptr if the arena cannot fit it
+    ===========================================================================
+    */
+    void* allocate(std::size_t bytes, std::size_t align = alignof(std::max_align_t)) {
+        const uintptr_t base = reinterpret_cast<uintptr_t>(buffer_);
+        const uintptr_t start = (base + used_ + align - 1) & ~(uintptr_t(align) - 1);
+        const std::size_t offset = start - base;
+        if (offset > capacity_ || bytes > capacity_ - offset) {
+            failures_++;
+            return nullptr;
+        }
+        used_ = offset + bytes;
+        if (used_ > highWater_) {
+            highWater_ = used_;
+        }
+        return buffer_ + offset;
+    }
+
+    //count value-initialised elements, empty span if full
+    template <typename T>
+    ScratchSpan<T> array(std::size_t count) {
+        static_assert(std::is_trivially_destructible_v<T>, "reset() runs no destructors");
+        void* block = allocate(sizeof(T) * count, alignof(T));
+        if (block == nullptr) {
+            return {nullptr, 0};
+        }
+        T* data = static_cast<T*>(block);
+        for (std::size_t i = 0; i < count; ++i) {
+            new (data + i) T();
+        }
+        return {data, count};
+    }
+
+    template <typename T, typename... Args>
+    T* make(Args&&... args) {
+        static_assert(std::is_trivially_destructible_v<T>, "reset() runs no destructors");
+        void* block = allocate(sizeof(T), alignof(T));
+        return block == nullptr ? nullptr : new (block) T(std::forward<Args>(args)...);
+    }
+
+    //printf into the arena, terminated; size() excludes the terminator
+    __attribute__((format(printf, 2, 3)))
+    ScratchSpan<char> format(const char* fmt, ...) {
+        va_list args;
+        va_start(args, fmt);
+        const int len = std::vsnprintf(nullptr, 0, fmt, args);
+        va_end(args);
+        if (len < 0) {
+            return {nullptr, 0};
+        }
+        char* text = static_cast<char*>(allocate(std::size_t(len) + 1, 1));
+        if (text == nullptr) {
+            return {nullptr, 0};
+        }
+        va_start(args, fmt);
+        std::vsnprintf(text, std::size_t(len) + 1, fmt, args);
+        va_end(args);
+        return {text, std::size_t(len)};
+    }
+
+    //End of the cycle, O(1)
+    void reset() { used_ = 0; }
+
+    std::size_t used() const { return used_; }
+    std::size_t capacity() const { return capacity_; }
+    std::size_t highWater() const { return highWater_; }
+    uint32_t failures() const { return failures_; }
+
+private:
+    uint8_t* buffer_;
+    std::size_t capacity_;
+    std::size_t used_;
+    std::size_t highWater_;
+    uint32_t failures_;
+};
+
+//Arena with its buffer inline (static or task-owned storage, never the heap)
+template <std::size_t Bytes>
+class StaticArena : public ScratchArena {
+public:
+    StaticArena() : ScratchArena(storage_, Bytes) {}
+
+private:
+    alignas(std::max_align_t) uint8_t storage_[Bytes];
+};
+
+//Resets the arena when the cycle's scope ends
+class ArenaCycle {
+public:
+    explicit ArenaCycle(ScratchArena& arena) : arena_(arena) {}
+    ~ArenaCycle() { arena_.reset(); }
+    ArenaCycle(const ArenaCycle&) = delete;
+    ArenaCycle& operator=(const ArenaCycle&) = delete;
+
+private:
+    ScratchArena& arena_;
+};
+
+#endif // SCRATCH_ARENA_H
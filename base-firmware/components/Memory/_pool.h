@@ -0,0 +1,105 @@
+/*MIT License
+Copyright (c) 2023 limitless Aeronautics
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#ifndef STATIC_POOL_H
+#define STATIC_POOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+
+//____________________________________________________________
+/* Fixed pool of driver objects
+===========================================================================
+|    N slots of T in static storage. acquire() constructs into a free
+|    slot, release() destroys it, so a driver can be created per request
+|    without touching the heap. An empty pool returns nullptr.
+|    Not thread safe, one task owns a pool.
+===========================================================================
+*/
+template <typename T, std::size_t N>
+class StaticPool {
+public:
+    StaticPool() : used_(), failures_(0) {}
+    StaticPool(const StaticPool&) = delete;
+    StaticPool& operator=(const StaticPool&) = delete;
+
+    template <typename... Args>
+    T* acquire(Args&&... args) {
+        for (std::size_t i = 0; i < N; ++i) {
+            if (!used_[i]) {
+                used_[i] = true;
+                return new (slots_[i]) T(std::forward<Args>(args)...);
+            }
+        }
+        failures_++;
+        return nullptr;
+    }
+
+    void release(T* obj) {
+        for (std::size_t i = 0; i < N; ++i) {
+            if (used_[i] && reinterpret_cast<T*>(slots_[i]) == obj) {
+                obj->~T();
+                used_[i] = false;
+                return;
+            }
+        }
+    }
+
+    std::size_t inUse() const {
+        std::size_t n = 0;
+        for (bool used : used_) {
+            n += used ? 1 : 0;
+        }
+        return n;
+    }
+    std::size_t capacity() const { return N; }
+    uint32_t failures() const { return failures_; }
+
+private:
+    alignas(T) uint8_t slots_[N][sizeof(T)];
+    bool used_[N];
+    uint32_t failures_;
+};
+
+//Pool slot released when the handle goes out of scope (every return path)
+template <typename T, std::size_t N>
+class PoolRef {
+public:
+    template <typename... Args>
+    explicit PoolRef(StaticPool<T, N>& pool, Args&&... args)
+        : pool_(pool), obj_(pool.acquire(std::forward<Args>(args)...)) {}
+    ~PoolRef() {
+        if (obj_ != nullptr) {
+            pool_.release(obj_);
+        }
+    }
+    PoolRef(const PoolRef&) = delete;
+    PoolRef& operator=(const PoolRef&) = delete;
+
+    explicit operator bool() const { return obj_ != nullptr; }
+    T* operator->() const { return obj_; }
+    T* get() const { return obj_; }
+
+private:
+    StaticPool<T, N>& pool_;
+    T* obj_;
+};
+
+#endif // STATIC_POOL_H
@@ -0,0 +1,79 @@
+/*MIT License
+Copyright (c) 2023 limitless Aeronautics
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#ifndef FIXED_Q16_H
+#define FIXED_Q16_H
+
+#include <cstdint>
+
+//____________________________________________________________
+/* Q16.16 fixed point
+===========================================================================
+|    Signed 32 bit, 16 fraction bits: range +-32768 with a resolution of
+|    1.5e-5. Arithmetic saturates instead of wrapping, so an integrator
+|    or a bad dt pins at the range ends rather than flipping sign.
+|    Products and quotients go through 64 bit intermediates.
+===========================================================================
+*/
+struct q16_t {
+    static constexpr int FRAC_BITS = 16;
+    static constexpr int32_t ONE = int32_t(1) << FRAC_BITS;
+
+    int32_t raw;
+
+    constexpr q16_t() : raw(0) {}
+    constexpr explicit q16_t(double value) : raw(saturate(int64_t(value * ONE + (value < 0 ? -0.5 : 0.5)))) {}
+
+    static constexpr q16_t fromRaw(int32_t raw) {
+        q16_t q;
+        q.raw = raw;
+        return q;
+    }
+
+    constexpr explicit operator double() const { return double(raw) / ONE; }
+    constexpr explicit operator float() const { return float(raw) / ONE; }
+
+    static constexpr int32_t saturate(int64_t value) {
+        return value > INT32_MAX ? INT32_MAX : (value < INT32_MIN ? INT32_MIN : int32_t(value));
+    }
+
+    friend constexpr q16_t operator+(q16_t a, q16_t b) { return fromRaw(saturate(int64_t(a.raw) + b.raw)); }
+    friend constexpr q16_t operator-(q16_t a, q16_t b) { return fromRaw(saturate(int64_t(a.raw) - b.raw)); }
+    friend constexpr q16_t operator-(q16_t a) { return fromRaw(saturate(-int64_t(a.raw))); }
+    friend constexpr q16_t operator*(q16_t a, q16_t b) {
+        return fromRaw(saturate((int64_t(a.raw) * b.raw) >> FRAC_BITS));
+    }
+    //Division by zero saturates towards the sign of the dividend
+    friend constexpr q16_t operator/(q16_t a, q16_t b) {
+        if (b.raw == 0) {
+            return fromRaw(a.raw < 0 ? INT32_MIN : INT32_MAX);
+        }
+        return fromRaw(saturate((int64_t(a.raw) * ONE) / b.raw));
+    }
+    constexpr q16_t& operator+=(q16_t b) { return *this = *this + b; }
+    constexpr q16_t& operator-=(q16_t b) { return *this = *this - b; }
+
+    friend constexpr bool operator==(q16_t a, q16_t b) { return a.raw == b.raw; }
+    friend constexpr bool operator!=(q16_t a, q16_t b) { return a.raw != b.raw; }
+    friend constexpr bool operator<(q16_t a, q16_t b) { return a.raw < b.raw; }
+    friend constexpr bool operator>(q16_t a, q16_t b) { return a.raw > b.raw; }
+    friend constexpr bool operator<=(q16_t a, q16_t b) { return a.raw <= b.raw; }
+    friend constexpr bool operator>=(q16_t a, q16_t b) { return a.raw >= b.raw; }
+};
+
+#endif // FIXED_Q16_H
@@ -0,0 +1,278 @@
+/*MIT License
+Copyright (c) 2023 limitless Aeronautics
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#include "_gain_schedule.h"
+
+#include <cmath>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+GainSchedule::GainSchedule() : slots_(), active_(-1), reading_(-1), version_(0) {
+}
+
+bool GainSchedule::load(const gain_table_t& table) {
+    if (!validate(table)) {
+        return false;
+    }
+    //Of three slots at least one is neither published nor being read
+    const int active = active_.load();
+    const int reading = reading_.load();
+    int slot = 0;
+    while (slot == active || slot == reading) {
+        slot++;
+    }
+    slots_[slot] = table;
+    active_.store(slot);
+    version_.fetch_add(1, std::memory_order_release);
+    return true;
+}
+
+void GainSchedule::clear() {
+    active_.store(-1);
+    version_.fetch_add(1, std::memory_order_release);
+}
+
+//____________________________________________________________
+/* Utillity subroutine -> cell and weight of a value on an even axis
+===========================================================================
+|    index           Lower breakpoint, at most points - 2
+|    Returns         Weight of the upper breakpoint, [0, 1]
+===========================================================================
+*/
+static float axis_weight(double value, float min, float step, uint8_t points, int& index) {
+    index = 0;
+    if (points < 2 || !(value > min)) {
+        return 0.0f;
+    }
+    const double position = (value - min) / step;
+    if (position >= points - 1) {
+        index = points - 2;
+        return 1.0f;
+    }
+    index = static_cast<int>(position);
+    return static_cast<float>(position - index);
+}
+
+bool GainSchedule::lookup(double speed, double alt, gain_triplet_t out[GAIN_AXES]) const {
+    int slot = active_.load();
+    if (slot < 0) {
+        return false;
+    }
+    //Mark the slot, then make sure it was not replaced meanwhile (load()
+    //never writes a marked slot, so after this check it is stable)
+    reading_.store(slot);
+    for (int published = active_.load(); published != slot; published = active_.load()) {
+        if (published < 0) {
+            reading_.store(-1);
+            return false;
+        }
+        slot = published;
+        reading_.store(slot);
+    }
+    const gain_table_t& table = slots_[slot];
+
+    int i, j;
+    const float ws = axis_weight(speed, table.speed_min, table.speed_step, table.speed_points, i);
+    const float wa = axis_weight(alt, table.alt_min, table.alt_step, table.alt_points, j);
+    //A single point axis has no upper neighbour, its weight is 0
+    const int i1 = table.speed_points > 1 ? i + 1 : i;
+    const int j1 = table.alt_points > 1 ? j + 1 : j;
+    const float w00 = (1.0f - ws) * (1.0f - wa);
+    const float w10 = ws * (1.0f - wa);
+    const float w01 = (1.0f - ws) * wa;
+    const float w11 = ws * wa;
+    for (int axis = 0; axis < GAIN_AXES; ++axis) {
+        const gain_triplet_t& g00 = table.gains[axis][j][i];
+        const gain_triplet_t& g10 = table.gains[axis][j][i1];
+        const gain_triplet_t& g01 = table.gains[axis][j1][i];
+        const gain_triplet_t& g11 = table.gains[axis][j1][i1];
+        out[axis].kp = w00 * g00.kp + w10 * g10.kp + w01 * g01.kp + w11 * g11.kp;
+        out[axis].ki = w00 * g00.ki + w10 * g10.ki + w01 * g01.ki + w11 * g11.ki;
+        out[axis].kd = w00 * g00.kd + w10 * g10.kd + w01 * g01.kd + w11 * g11.kd;
+    }
+    reading_.store(-1);
+    return true;
+}
+
+static bool gain_valid(float value) {
+    return std::isfinite(value) && value >= 0.0f && value <= GAIN_MAX_VALUE;
+}
+
+bool GainSchedule::validate(const gain_table_t& table) {
+    if (table.version != GAIN_TABLE_VERSION) {
+        return false;
+    }
+    if (table.speed_points < 1 || table.speed_points > GAIN_SPEED_POINTS ||
+        table.alt_points < 1 || table.alt_points > GAIN_ALT_POINTS) {
+        return false;
+    }
+    if (!std::isfinite(table.speed_min) || !std::isfinite(table.alt_min)) {
+        return false;
+    }
+    //The step only matters with a second breakpoint
+    if ((table.speed_points > 1 && !(table.speed_step > 0.0f && std::isfinite(table.speed_step))) ||
+        (table.alt_points > 1 && !(table.alt_step > 0.0f && std::isfinite(table.alt_step)))) {
+        return false;
+    }
+    for (int axis = 0; axis < GAIN_AXES; ++axis) {
+        for (int j = 0; j < table.alt_points; ++j) {
+            for (int i = 0; i < table.speed_points; ++i) {
+                const gain_triplet_t& g = table.gains[axis][j][i];
+                if (!gain_valid(g.kp) || !gain_valid(g.ki) || !gain_valid(g.kd)) {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+//____________________________________________________________
+/* Utillity subroutine -> next number of a bounded text
+===========================================================================
+|    cursor          Advanced past the number and its separators
+|    Returns         false at the end of the text or on a non number
+===========================================================================
+*/
+static bool next_number(const char*& cursor, const char* end, double& value) {
+    while (cursor < end && (*cursor == ' ' || *cursor == ',' || *cursor == '\t' ||
+                            *cursor == '\r' || *cursor == '\n')) {
+        cursor++;
+    }
+    if (cursor == end) {
+        return false;
+    }
+    //strtod needs a terminated string, numbers are short
+    char token[32];
+    std::size_t len = 0;
+    while (cursor + len < end && len < sizeof(token) - 1 && std::strchr(" ,\t\r\n", cursor[len]) == nullptr) {
+        token[len] = cursor[len];
+        len++;
+    }
+    token[len] = '\0';
+    char* parsed = nullptr;
+    value = std::strtod(token, &parsed);
+    if (parsed != token + len || len == 0) {
+        return false;
+    }
+    cursor += len;
+    return true;
+}
+
+bool GainSchedule::parse(const char* text, std::size_t len, gain_table_t& out) {
+    if (text == nullptr || len > GAIN_UPLOAD_MAX_BYTES) {
+        return false;
+    }
+    const char* cursor = text;
+    const char* end = text + len;
+    double header[6];
+    for (double& value : header) {
+        if (!next_number(cursor, end, value)) {
+            return false;
+        }
+    }
+    if (header[0] < 1 || header[0] > GAIN_SPEED_POINTS || header[1] < 1 || header[1] > GAIN_ALT_POINTS ||
+        header[0] != std::floor(header[0]) || header[1] != std::floor(header[1])) {
+        return false;
+    }
+    std::memset(&out, 0, sizeof(out));
+    out.version = GAIN_TABLE_VERSION;
+    out.speed_points = static_cast<uint8_t>(header[0]);
+    out.alt_points = static_cast<uint8_t>(header[1]);
+    out.speed_min = static_cast<float>(header[2]);
+    out.speed_step = static_cast<float>(header[3]);
+    out.alt_min = static_cast<float>(header[4]);
+    out.alt_step = static_cast<float>(header[5]);
+    for (int axis = 0; axis < GAIN_AXES; ++axis) {
+        for (int j = 0; j < out.alt_points; ++j) {
+            for (int i = 0; i < out.speed_points; ++i) {
+                double kp, ki, kd;
+                if (!next_number(cursor, end, kp) || !next_number(cursor, end, ki) || !next_number(cursor, end, kd)) {
+                    return false;
+                }
+                out.gains[axis][j][i] = {static_cast<float>(kp), static_cast<float>(ki), static_cast<float>(kd)};
+            }
+        }
+    }
+    //Anything but separators left means the sizes did not match the data
+    double extra;
+    if (next_number(cursor, end, extra) || cursor != end) {
+        return false;
+    }
+    return validate(out);
+}
+
+//printf at used, false (used unchanged) once out is full
+__attribute__((format(printf, 4, 5)))
+static bool append(char* out, std::size_t len, std::size_t& used, const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    const int n = std::vsnprintf(out + used, len - used, fmt, args);
+    va_end(args);
+    if (n < 0 || used + n >= len) {
+        return false;
+    }
+    used += n;
+    return true;
+}
+
+std::size_t GainSchedule::format(const gain_table_t& table, char* out, std::size_t len) {
+    if (!validate(table) || out == nullptr || len == 0) {
+        return 0;
+    }
+    //%.9g round trips a float exactly
+    std::size_t used = 0;
+    bool ok = append(out, len, used, "%u %u %.9g %.9g %.9g %.9g\n", unsigned(table.speed_points),
+                     unsigned(table.alt_points), table.speed_min, table.speed_step, table.alt_min, table.alt_step);
+    for (int axis = 0; axis < GAIN_AXES; ++axis) {
+        for (int j = 0; j < table.alt_points; ++j) {
+            for (int i = 0; i < table.speed_points; ++i) {
+                const gain_triplet_t& g = table.gains[axis][j][i];
+                ok = ok && append(out, len, used, "%s%.9g %.9g %.9g", i == 0 ? "" : "  ", g.kp, g.ki, g.kd);
+            }
+            ok = ok && append(out, len, used, "\n");
+        }
+    }
+    if (!ok) {
+        out[0] = '\0';
+        return 0;
+    }
+    return used;
+}
+
+gain_table_t GainSchedule::uniform(const gain_triplet_t gains[GAIN_AXES]) {
+    gain_table_t table = {};
+    table.version = GAIN_TABLE_VERSION;
+    table.speed_points = 1;
+    table.alt_points = 1;
+    for (int axis = 0; axis < GAIN_AXES; ++axis) {
+        table.gains[axis][0][0] = gains[axis];
+    }
+    return table;
+}
+
+bool GainSchedule::save(PTAMStore& store, const gain_table_t& table) {
+    return validate(table) && store.write(GAIN_STORE_KEY, &table, sizeof(table)) && store.commit();
+}
+
+bool GainSchedule::restore(PTAMStore& store, gain_table_t& table) {
+    //A size or version mismatch (older layout) reads as no table
+    return store.read(GAIN_STORE_KEY, &table, sizeof(table)) && validate(table);
+}
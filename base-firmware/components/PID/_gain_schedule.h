@@ -0,0 +1,149 @@
+/*MIT License
+Copyright (c) 2023 limitless Aeronautics
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#ifndef GAIN_SCHEDULE_H
+#define GAIN_SCHEDULE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "../PTAM/_ptam_persist.h"
+
+//Breakpoints per table dimension
+#define GAIN_SPEED_POINTS 8
+#define GAIN_ALT_POINTS 6
+//Scheduled axes, pitch then roll (the pipeline's AXIS_PITCH / AXIS_ROLL)
+#define GAIN_AXES 2
+//Layout version of gain_table_t, stored with the table
+#define GAIN_TABLE_VERSION 1
+//Largest text table accepted by parse() (and the upload endpoint)
+#define GAIN_UPLOAD_MAX_BYTES 4096
+//NVS namespace and key of the persisted table
+#define GAIN_STORE_NAMESPACE "gains"
+#define GAIN_STORE_KEY "table"
+//Sanity bound of an uploaded gain
+#define GAIN_MAX_VALUE 100.0f
+
+struct gain_triplet_t {
+    float kp;
+    float ki;
+    float kd;
+};
+
+//____________________________________________________________
+/* Gain table indexed by airspeed and altitude
+===========================================================================
+|    Breakpoints are evenly spaced: speed_min + i * speed_step (m/s) and
+|    alt_min + j * alt_step (m), so finding the cell is arithmetic, not a
+|    search. gains[axis][j][i] holds the gains at (speed i, altitude j),
+|    only the first alt_points x speed_points entries are used.
+|    Trivially copyable, stored as one blob.
+===========================================================================
+*/
+struct gain_table_t {
+    uint32_t version;
+    uint8_t speed_points;
+    uint8_t alt_points;
+    uint8_t reserved[2];
+    float speed_min;
+    float speed_step;
+    float alt_min;
+    float alt_step;
+    gain_triplet_t gains[GAIN_AXES][GAIN_ALT_POINTS][GAIN_SPEED_POINTS];
+};
+
+//____________________________________________________________
+/* Gain schedule shared between a loader and the control task
+===========================================================================
+|    lookup() bilinearly interpolates every axis' gains at (speed, alt),
+|    clamped to the table's edges: a fixed amount of arithmetic whatever
+|    the table size, O(1) per control step.
+|
+|    Three table slots, no lock: load() writes a slot that is neither the
+|    published one nor the one lookup() may still be reading, then
+|    publishes it. lookup() marks the slot it reads and re-checks that it
+|    is still the published one.
+|    One task loads (HTTP / init), one task looks up (control).
+===========================================================================
+*/
+class GainSchedule {
+public:
+    GainSchedule();
+
+    //____________________________________________________________
+    /* Main subroutine -> publish a new table (loader task)
+    ===========================================================================
+    |    table           Copied, see validate()
+    |    Returns         false if invalid, the published table is kept
+    ===========================================================================
+    */
+    bool load(const gain_table_t& table);
+
+    //Back to no table: lookup() users fall back to their fixed gains
+    void clear();
+
+    bool active() const { return active_.load(std::memory_order_acquire) >= 0; }
+    //Bumped by every load() / clear()
+    uint32_t version() const { return version_.load(std::memory_order_acquire); }
+
+    //____________________________________________________________
+    /* Main subroutine -> gains at the operating point (control task)
+    ===========================================================================
+    |    speed / alt     Operating point, clamped to the table
+    |    out             One triplet per axis
+    |    Returns         false (out untouched) if no table is loaded
+    ===========================================================================
+    */
+    bool lookup(double speed, double alt, gain_triplet_t out[GAIN_AXES]) const;
+
+    //Sizes in range, evenly spaced axes, gains finite in [0, GAIN_MAX_VALUE]
+    static bool validate(const gain_table_t& table);
+
+    //____________________________________________________________
+    /* Main subroutine -> text table (upload format)
+    ===========================================================================
+    |    Whitespace or comma separated numbers:
+    |      speed_points alt_points speed_min speed_step alt_min alt_step
+    |      then per axis (pitch, roll), per altitude row, per speed:
+    |      kp ki kd
+    |    Returns         false on a short, long or invalid table
+    ===========================================================================
+    */
+    static bool parse(const char* text, std::size_t len, gain_table_t& out);
+
+    //parse()'s format, one altitude row per line, terminated
+    //Returns         Characters written, 0 if invalid or out is too small
+    static std::size_t format(const gain_table_t& table, char* out, std::size_t len);
+
+    //1 x 1 table holding fixed gains
+    static gain_table_t uniform(const gain_triplet_t gains[GAIN_AXES]);
+
+    //Blob under GAIN_STORE_KEY, committed; restore() validates what it reads
+    static bool save(PTAMStore& store, const gain_table_t& table);
+    static bool restore(PTAMStore& store, gain_table_t& table);
+
+private:
+    static constexpr int SLOTS = 3;
+
+    gain_table_t slots_[SLOTS];
+    std::atomic<int> active_;               //Published slot, -1 = none
+    mutable std::atomic<int> reading_;      //Slot lookup() is in, -1 = none
+    std::atomic<uint32_t> version_;
+};
+
+#endif // GAIN_SCHEDULE_H
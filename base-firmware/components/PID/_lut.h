@@ -0,0 +1,152 @@
+/*MIT License
+Copyright (c) 2023 limitless Aeronautics
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#ifndef FIXED_LUT_H
+#define FIXED_LUT_H
+
+#include <cstddef>
+#include <cstdint>
+#include "_fixed.h"
+
+//Most breakpoints of one table, keeps the index product inside 64 bits
+#define LUT_MAX_POINTS 65
+//Fraction bits of the position inside a cell
+#define LUT_FRAC_BITS 24
+
+//____________________________________________________________
+/* Utillity subroutine -> map input from one range onto another
+===========================================================================
+|    The one linear remap shared by the decomposer, servo and IMU code,
+|    for ranges only known at run time. Extrapolates outside the input
+|    range. Constant ranges belong in a FixedLUT, which has no division.
+===========================================================================
+*/
+constexpr double lut_interpolate(double input, double input_start, double input_end,
+                                 double output_start, double output_end) {
+    const double slope = (output_end - output_start) / (input_end - input_start);
+    return output_start + slope * (input - input_start);
+}
+
+//____________________________________________________________
+/* Lookup table with Q16.16 interpolation
+===========================================================================
+|    N breakpoints evenly spaced over [x_min, x_max], so the cell is found
+|    by a multiply instead of a search, and the reciprocal of the spacing
+|    is taken once when the table is built: a lookup is two 64 bit
+|    multiplies and shifts, no division, no floating point in between.
+|    Inputs are clamped to the table. N = 2 is a plain linear map, more
+|    breakpoints follow a nonlinear curve (linkage geometry, calibration).
+|    Built at compile time from constexpr data or at load time from a
+|    stored table.
+===========================================================================
+*/
+template <std::size_t N>
+class FixedLUT {
+    static_assert(N >= 2 && N <= LUT_MAX_POINTS, "2 .. LUT_MAX_POINTS breakpoints");
+
+public:
+    constexpr FixedLUT() : x0_(), span_(0), scale_(0), y_() {}
+
+    //Breakpoint values y[i] at x_min + i * (x_max - x_min) / (N - 1), x_max > x_min
+    static constexpr FixedLUT points(double x_min, double x_max, const double (&y)[N]) {
+        FixedLUT lut;
+        lut.x0_ = q16_t(x_min);
+        lut.span_ = int64_t(q16_t(x_max).raw) - lut.x0_.raw;
+        //Cell index = offset * (N - 1) / span, the division done here.
+        //Rounded up, so an input on a breakpoint lands on it, not just below
+        const uint64_t span = uint64_t(lut.span_);
+        lut.scale_ = lut.span_ > 0 ? ((uint64_t(N - 1) << 48) + span - 1) / span : 0;
+        for (std::size_t i = 0; i < N; ++i) {
+            lut.y_[i] = q16_t(y[i]);
+        }
+        return lut;
+    }
+
+    //Straight line from (x_min, y_min) to (x_max, y_max)
+    static constexpr FixedLUT linear(double x_min, double x_max, double y_min, double y_max) {
+        double y[N] = {};
+        for (std::size_t i = 0; i < N; ++i) {
+            y[i] = y_min + (y_max - y_min) * double(i) / double(N - 1);
+        }
+        return points(x_min, x_max, y);
+    }
+
+    //Any constexpr callable sampled at the breakpoints
+    template <typename Fn>
+    static constexpr FixedLUT sample(double x_min, double x_max, Fn fn) {
+        double y[N] = {};
+        for (std::size_t i = 0; i < N; ++i) {
+            y[i] = fn(x_min + (x_max - x_min) * double(i) / double(N - 1));
+        }
+        return points(x_min, x_max, y);
+    }
+
+    //____________________________________________________________
+    /* Main subroutine -> value at x
+    ===========================================================================
+    |    x               Clamped to [x_min, x_max]
+    |    Returns         Linear interpolation between the two breakpoints
+    |                    around x, rounded to the nearest Q16.16 step
+    ===========================================================================
+    */
+    constexpr q16_t operator()(q16_t x) const {
+        int64_t offset = int64_t(x.raw) - x0_.raw;
+        offset = offset < 0 ? 0 : (offset > span_ ? span_ : offset);
+        //offset <= span, so offset * scale <= (N - 1) << 48. The cell index
+        //keeps 24 fraction bits: a wide cell still interpolates to about
+        //the Q16.16 step, and rise (< 2^32) * frac stays inside 64 bits
+        const uint64_t cell = (uint64_t(offset) * scale_) >> (48 - LUT_FRAC_BITS);
+        const std::size_t i = std::size_t(cell >> LUT_FRAC_BITS);
+        if (i >= N - 1) {
+            return y_[N - 1];
+        }
+        const int64_t frac = int64_t(cell & ((uint64_t(1) << LUT_FRAC_BITS) - 1));
+        const int64_t rise = int64_t(y_[i + 1].raw) - y_[i].raw;
+        const int64_t half = int64_t(1) << (LUT_FRAC_BITS - 1);
+        return q16_t::fromRaw(q16_t::saturate(y_[i].raw + ((rise * frac + half) >> LUT_FRAC_BITS)));
+    }
+
+    //Double in and out, clamped before the conversion (NaN reads as x_min)
+    constexpr double operator()(double x) const {
+        const double lo = double(x0_), hi = double(q16_t::fromRaw(q16_t::saturate(x0_.raw + span_)));
+        x = !(x >= lo) ? lo : (x > hi ? hi : x);
+        return double((*this)(q16_t(x)));
+    }
+
+    //Every step in one direction (strictly), so the table has an inverse
+    constexpr bool monotonic() const {
+        const bool rising = y_[1] > y_[0];
+        for (std::size_t i = 1; i < N; ++i) {
+            if (rising ? !(y_[i] > y_[i - 1]) : !(y_[i] < y_[i - 1])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    constexpr q16_t value(std::size_t i) const { return y_[i < N ? i : N - 1]; }
+    static constexpr std::size_t size() { return N; }
+
+private:
+    q16_t x0_;
+    int64_t span_;          //x_max - x_min, raw Q16.16
+    uint64_t scale_;        //((N - 1) << 48) / raw span, offset * scale is the cell index in Q48
+    q16_t y_[N];
+};
+
+#endif // FIXED_LUT_H
@@ -87,19 +87,45 @@ std::vector<double> PID::pid_controller(const std::vector<double>& target, const
                                    double kp, double ki, double kd, std::vector<double>& integral,
                                    std::vector<double>& previous_errors, double dt,
                                    double min_output, double max_output) {
-    std::vector<double> errors = calculate_error(target, current);
-    std::vector<double> integrals = calculate_integral(integral, errors, dt);
-    std::vector<double> derivatives(previous_errors.size());
-
     std::vector<double> control_signals(target.size());
-    for (std::size_t i = 0; i < target.size(); ++i) {
-        derivatives[i] = calculate_derivative(previous_errors[i], errors[i], dt);
-        control_signals[i] = calculate_control_signal(kp, ki, kd, errors[i], integrals[i], derivatives[i],
+    pid_controller(target.data(), current.data(), target.size(), kp, ki, kd, integral.data(),
+                   previous_errors.data(), dt, min_output, max_output, control_signals.data());
+    return control_signals;
+}
+
+void PID::pid_controller(const double* target, const double* current, std::size_t n,
+                         double kp, double ki, double kd, double* integral,
+                         double* previous_errors, double dt,
+                         double min_output, double max_output, double* control_signals) {
+    for (std::size_t i = 0; i < n; ++i) {
+        const double error = target[i] - current[i];
+        integral[i] = integral[i] + error * dt;
+        const double derivative = calculate_derivative(previous_errors[i], error, dt);
+        control_signals[i] = calculate_control_signal(kp, ki, kd, error, integral[i], derivative,
                                                       min_output, max_output);
+        previous_errors[i] = error;
     }
+}
+//____________________________________________________________
+/* Scalar PID step for the flight pipeline
 
-    integral = integrals;
-    previous_errors = errors;
-
-    return control_signals;
-}
\ No newline at end of file
+|    Same P, I and D terms as pid_controller, without vectors and without
+|    the absolute value hotfix: the output keeps its sign and is clamped
+|    to [min_output, max_output]. No derivative on the first step.
+===========================================================================
+*/
+double PID::step(const pid_gains_t& gains, pid_axis_t& state, double target, double current, double dt) {
+    const double error = target - current;
+    state.integral += error * dt;
+    const double derivative = (state.primed && dt > 0.0) ? (error - state.previous_error) / dt : 0.0;
+    state.previous_error = error;
+    state.primed = true;
+
+    const double control_signal = gains.kp * error + gains.ki * state.integral + gains.kd * derivative;
+    if (control_signal < gains.min_output) {
+        return gains.min_output;
+    } else if (control_signal > gains.max_output) {
+        return gains.max_output;
+    }
+    return control_signal;
+}
@@ -22,6 +22,22 @@ SOFTWARE.*/
 #include <vector>
 #include <cstddef> // Include for size_t
 
+//Gains and output limits of one scalar PID axis
+struct pid_gains_t {
+    double kp;
+    double ki;
+    double kd;
+    double min_output;
+    double max_output;
+};
+
+//State of one scalar PID axis, owned by the caller (zero to reset)
+struct pid_axis_t {
+    double integral;
+    double previous_error;
+    bool primed;            //previous_error is valid, no derivative kick on the first step
+};
+
 class PID {
     public:
         std::vector<double> calculate_error(const std::vector<double>& target, const std::vector<double>& current);
@@ -37,6 +53,16 @@ class PID {
                                    double kp, double ki, double kd, std::vector<double>& integral,
                                    std::vector<double>& previous_errors, double dt,
                                    double min_output, double max_output);
+
+        //Same controller on caller-owned arrays of n axes, no allocation.
+        //integral and previous_errors are updated in place.
+        void pid_controller(const double* target, const double* current, std::size_t n,
+                            double kp, double ki, double kd, double* integral,
+                            double* previous_errors, double dt,
+                            double min_output, double max_output, double* control_signals);
+
+        //Scalar, allocation free step with a signed clamped output
+        static double step(const pid_gains_t& gains, pid_axis_t& state, double target, double current, double dt);
 };
 
 #endif //_PID_
\ No newline at end of file
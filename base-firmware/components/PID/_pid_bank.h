@@ -0,0 +1,133 @@
+/*MIT License
+Copyright (c) 2023 limitless Aeronautics
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#ifndef PID_BANK_H
+#define PID_BANK_H
+
+#include <array>
+#include <cstddef>
+#include "_fixed.h"
+
+//Controller arithmetic: single precision on target (the ESP32 FPU has no
+//double support), also on host so both builds round alike
+typedef float pid_real_t;
+
+//____________________________________________________________
+/* Gains and output limits of N axes, one array per term
+===========================================================================
+|    Structure of arrays: each term of the step loop reads one contiguous
+|    array, which keeps the loop branch free and vectorizable.
+===========================================================================
+*/
+template <std::size_t N, typename T = pid_real_t>
+struct pid_bank_gains_t {
+    std::array<T, N> kp;
+    std::array<T, N> ki;
+    std::array<T, N> kd;
+    std::array<T, N> min_output;
+    std::array<T, N> max_output;
+
+    //Same gains on every axis
+    static constexpr pid_bank_gains_t uniform(double kp, double ki, double kd, double min_output, double max_output) {
+        pid_bank_gains_t gains{};
+        for (std::size_t i = 0; i < N; ++i) {
+            gains.kp[i] = T(kp);
+            gains.ki[i] = T(ki);
+            gains.kd[i] = T(kd);
+            gains.min_output[i] = T(min_output);
+            gains.max_output[i] = T(max_output);
+        }
+        return gains;
+    }
+};
+
+//____________________________________________________________
+/* N axis PID controller with fixed-size state
+===========================================================================
+|    T is float, double or q16_t. Same law as PID::step on every axis:
+|    signed output clamped to [min_output, max_output], no derivative on
+|    the first step (or after reset()). All state is std::array inside
+|    the object, a step never allocates.
+|    Not thread safe, one task owns a bank.
+===========================================================================
+*/
+template <std::size_t N, typename T = pid_real_t>
+class PIDBank {
+public:
+    typedef T value_type;
+    typedef std::array<T, N> vector_t;
+    typedef pid_bank_gains_t<N, T> gains_t;
+
+    static constexpr std::size_t axes = N;
+
+    explicit PIDBank(const gains_t& gains) : gains_(gains) { reset(); }
+
+    void setGains(const gains_t& gains) { gains_ = gains; }
+    const gains_t& gains() const { return gains_; }
+
+    //Clears the integrators and the derivative history
+    void reset() {
+        integral_.fill(T());
+        previous_.fill(T());
+        primed_ = false;
+    }
+
+    //____________________________________________________________
+    /* Main subroutine -> one step of every axis
+    ===========================================================================
+    |    target          Setpoints
+    |    current         Measurements
+    |    dt              Seconds since the previous step, <= 0 skips the
+    |                    derivative
+    |    out             Clamped control signals
+    ===========================================================================
+    */
+    void step(const vector_t& target, const vector_t& current, T dt, vector_t& out) {
+        //Hoisted out of the loop so its body has no branches
+        const T zero = T();
+        const T d_scale = (primed_ && dt > zero) ? T(1.0) / dt : zero;
+        for (std::size_t i = 0; i < N; ++i) {
+            const T error = target[i] - current[i];
+            integral_[i] += error * dt;
+            const T derivative = (error - previous_[i]) * d_scale;
+            previous_[i] = error;
+            const T signal = gains_.kp[i] * error + gains_.ki[i] * integral_[i] + gains_.kd[i] * derivative;
+            out[i] = clamp(signal, gains_.min_output[i], gains_.max_output[i]);
+        }
+        primed_ = true;
+    }
+
+    vector_t step(const vector_t& target, const vector_t& current, T dt) {
+        vector_t out;
+        step(target, current, dt, out);
+        return out;
+    }
+
+    const vector_t& integral() const { return integral_; }
+    const vector_t& previousError() const { return previous_; }
+
+private:
+    static T clamp(T value, T lo, T hi) { return value < lo ? lo : (value > hi ? hi : value); }
+
+    gains_t gains_;
+    vector_t integral_;
+    vector_t previous_;
+    bool primed_;
+};
+
+#endif // PID_BANK_H
@@ -0,0 +1,197 @@
+/*MIT License
+Copyright (c) 2023 limitless Aeronautics
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#ifndef PID_FLIGHT_H
+#define PID_FLIGHT_H
+
+#include <array>
+#include <cstddef>
+#include "_pid.h"
+#include "_pid_bank.h"
+
+//Output shaping of one scalar axis, on top of its pid_gains_t
+struct pid_shaping_t {
+    double kt;              //Back-calculation gain (1/s), 0 = conditional integration
+    double d_cutoff_hz;     //Derivative low-pass cutoff, 0 = unfiltered
+    double slew_rate;       //Largest output change per second, 0 = unlimited
+};
+
+template <std::size_t N, typename T = pid_real_t>
+struct pid_flight_config_t {
+    pid_bank_gains_t<N, T> gains;
+    std::array<T, N> kt;
+    std::array<T, N> d_cutoff_hz;
+    std::array<T, N> slew_rate;
+
+    //Axis i from its scalar description
+    void set(std::size_t i, const pid_gains_t& g, const pid_shaping_t& s) {
+        gains.kp[i] = T(g.kp);
+        gains.ki[i] = T(g.ki);
+        gains.kd[i] = T(g.kd);
+        gains.min_output[i] = T(g.min_output);
+        gains.max_output[i] = T(g.max_output);
+        kt[i] = T(s.kt);
+        d_cutoff_hz[i] = T(s.d_cutoff_hz);
+        slew_rate[i] = T(s.slew_rate);
+    }
+};
+
+//____________________________________________________________
+/* Production N axis PID for actuators
+===========================================================================
+|    Differences to PIDBank:
+|    - Derivative on measurement through a first-order low-pass: a
+|      setpoint step gives no derivative kick and sensor noise is not
+|      amplified into servo chatter.
+|    - Anti-windup: with kt > 0 the integrator is pulled back by
+|      kt * (applied - unsaturated output) (back-calculation), with
+|      kt = 0 it stops integrating while the output is pinned in the
+|      error's direction (clamping). Either way the integrator itself
+|      never leaves [min_output, max_output].
+|    - Slew limiting of the applied output, seen by the anti-windup.
+|    - The integrator is kept in output units, so gain changes and
+|      transfer() (manual -> automatic) are bumpless.
+|    T is float or double.
+|    Not thread safe, one task owns a controller.
+===========================================================================
+*/
+template <std::size_t N, typename T = pid_real_t>
+class FlightPID {
+public:
+    typedef T value_type;
+    typedef std::array<T, N> vector_t;
+    typedef pid_flight_config_t<N, T> config_t;
+
+    static constexpr std::size_t axes = N;
+
+    explicit FlightPID(const config_t& config) : config_(config) { reset(); }
+
+    //Integrator is in output units: new gains take over without a bump
+    void setConfig(const config_t& config) { config_ = config; }
+    const config_t& config() const { return config_; }
+
+    //Gains of one axis only (gain scheduling), limits and shaping are kept
+    void setGains(std::size_t i, T kp, T ki, T kd) {
+        config_.gains.kp[i] = kp;
+        config_.gains.ki[i] = ki;
+        config_.gains.kd[i] = kd;
+    }
+
+    //Neutral output, empty integrator and filters
+    void reset() {
+        integral_.fill(T());
+        previous_.fill(T());
+        derivative_.fill(T());
+        output_.fill(T());
+        primed_ = false;
+    }
+
+    //____________________________________________________________
+    /* Main subroutine -> take over from a manual output without a bump
+    ===========================================================================
+    |    output          What the actuators are at now (e.g. BYPASS wings)
+    |    target          Setpoints of the first step
+    |    current         Measurements now
+    |    The first step() then starts from output, the slew limit from
+    |    there as well
+    ===========================================================================
+    */
+    void transfer(const vector_t& output, const vector_t& target, const vector_t& current) {
+        for (std::size_t i = 0; i < N; ++i) {
+            const T lo = config_.gains.min_output[i];
+            const T hi = config_.gains.max_output[i];
+            output_[i] = clamp(output[i], lo, hi);
+            integral_[i] = clamp(output_[i] - config_.gains.kp[i] * (target[i] - current[i]), lo, hi);
+            previous_[i] = current[i];
+            derivative_[i] = T();
+        }
+        primed_ = true;
+    }
+
+    //____________________________________________________________
+    /* Main subroutine -> one step of every axis
+    ===========================================================================
+    |    dt              Seconds since the previous step, <= 0 holds the
+    |                    previous output
+    |    out             Applied (clamped, slew limited) outputs
+    ===========================================================================
+    */
+    void step(const vector_t& target, const vector_t& current, T dt, vector_t& out) {
+        if (!(dt > T())) {
+            out = output_;
+            return;
+        }
+        const T twoPi = T(6.283185307179586);
+        for (std::size_t i = 0; i < N; ++i) {
+            const T lo = config_.gains.min_output[i];
+            const T hi = config_.gains.max_output[i];
+            const T error = target[i] - current[i];
+
+            //Derivative of the measurement, low-passed (alpha = dt / (tau + dt))
+            const T raw = primed_ ? (previous_[i] - current[i]) / dt : T();
+            const T fc = config_.d_cutoff_hz[i];
+            const T alpha = fc > T() ? dt / (T(1) / (twoPi * fc) + dt) : T(1);
+            derivative_[i] += alpha * (raw - derivative_[i]);
+            previous_[i] = current[i];
+
+            const T proportional = config_.gains.kp[i] * error;
+            const T damping = config_.gains.kd[i] * derivative_[i];
+            const T unsaturated = proportional + integral_[i] + damping;
+            T applied = clamp(unsaturated, lo, hi);
+            const T rate = config_.slew_rate[i];
+            if (rate > T()) {
+                const T step = rate * dt;
+                applied = clamp(applied, output_[i] - step, output_[i] + step);
+            }
+
+            T integrate = config_.gains.ki[i] * error * dt;
+            if (config_.kt[i] > T()) {
+                integrate += config_.kt[i] * (applied - unsaturated) * dt;
+            } else if ((unsaturated > hi && integrate > T()) || (unsaturated < lo && integrate < T())) {
+                integrate = T();
+            }
+            integral_[i] = clamp(integral_[i] + integrate, lo, hi);
+
+            output_[i] = applied;
+            out[i] = applied;
+        }
+        primed_ = true;
+    }
+
+    vector_t step(const vector_t& target, const vector_t& current, T dt) {
+        vector_t out;
+        step(target, current, dt, out);
+        return out;
+    }
+
+    const vector_t& integral() const { return integral_; }
+    const vector_t& derivative() const { return derivative_; }
+    const vector_t& output() const { return output_; }
+
+private:
+    static T clamp(T value, T lo, T hi) { return value < lo ? lo : (value > hi ? hi : value); }
+
+    config_t config_;
+    vector_t integral_;         //Output units (ki already applied)
+    vector_t previous_;         //Last measurement
+    vector_t derivative_;       //Filtered d(measurement)/dt, sign flipped
+    vector_t output_;           //Last applied output
+    bool primed_;
+};
+
+#endif // PID_FLIGHT_H
@@ -38,19 +38,35 @@ SharedMemory& SharedMemory::getInstance() {
 ===========================================================================
 |    Designated ID   This creates the PTAM register with this ID an can only be referenced with this ID string
 |    Data Value      Data value of types std::string, double, int
+|    IDs declared in PTAM_REGISTER_TABLE are forwarded to the fixed register file
 ===========================================================================
 */
 void SharedMemory::storeString(const std::string& id, const std::string& data) {
+    ptam_reg_t reg;
+    if (ptam_lookup(id, reg)) {
+        registers_.storeString(reg, data);
+        return;
+    }
     std::lock_guard<std::mutex> lock(mutex_);
     stringData_[id].push_back(data);
 }
 
 void SharedMemory::storeDouble(const std::string& id, double data) {
+    ptam_reg_t reg;
+    if (ptam_lookup(id, reg)) {
+        registers_.storeDouble(reg, data);
+        return;
+    }
     std::lock_guard<std::mutex> lock(mutex_);
     doubleData_[id].push_back(data);
 }
 
 void SharedMemory::storeInt(const std::string& id, int data) {
+    ptam_reg_t reg;
+    if (ptam_lookup(id, reg)) {
+        registers_.storeInt(reg, data);
+        return;
+    }
     std::lock_guard<std::mutex> lock(mutex_);
     intData_[id].push_back(data);
 }
@@ -59,19 +75,58 @@ void SharedMemory::storeInt(const std::string& id, int data) {
 /* Main subroutines -> retrieves all the values from PTAM register of appropriate typdef
 ===========================================================================
 |   Designated ID   This references the PTAM register assigned with this ID
+|   Fixed registers return at most `depth` samples (see PTAM_REGISTER_TABLE)
 ===========================================================================
 */
+template <typename T, typename Convert>
+std::vector<T> SharedMemory::historyOf(ptam_reg_t reg, Convert convert) {
+    PTAMHistoryView history = registers_.view(reg);
+    std::vector<T> out;
+    out.reserve(history.size());
+    for (const ptam_sample_t& sample : history) {
+        out.push_back(convert(reg, sample));
+    }
+    return out;
+}
+
 std::vector<std::string> SharedMemory::getStringData(const std::string& id) {
+    ptam_reg_t reg;
+    if (ptam_lookup(id, reg)) {
+        if (RegisterFile::describe(reg).type != ptam_type_t::STRING) {
+            return {};
+        }
+        return historyOf<std::string>(reg, [](ptam_reg_t, const ptam_sample_t& sample) {
+            return std::string(sample.value.s);
+        });
+    }
     std::lock_guard<std::mutex> lock(mutex_);
     return stringData_[id];
 }
 
 std::vector<double> SharedMemory::getDoubleData(const std::string& id) {
+    ptam_reg_t reg;
+    if (ptam_lookup(id, reg)) {
+        if (RegisterFile::describe(reg).type == ptam_type_t::STRING) {
+            return {};
+        }
+        return historyOf<double>(reg, [](ptam_reg_t reg, const ptam_sample_t& sample) {
+            return RegisterFile::asDouble(reg, sample);
+        });
+    }
     std::lock_guard<std::mutex> lock(mutex_);
     return doubleData_[id];
 }
 
 std::vector<int> SharedMemory::getIntData(const std::string& id) {
+    ptam_reg_t reg;
+    if (ptam_lookup(id, reg)) {
+        if (RegisterFile::describe(reg).type == ptam_type_t::STRING) {
+            return {};
+        }
+        return historyOf<int>(reg, [](ptam_reg_t reg, const ptam_sample_t& sample) {
+            return RegisterFile::asInt(reg, sample);
+        });
+    }
     std::lock_guard<std::mutex> lock(mutex_);
     return intData_[id];
 }
@@ -83,6 +138,11 @@ std::vector<int> SharedMemory::getIntData(const std::string& id) {
 ===========================================================================
 */
 void SharedMemory::clearData(const std::string& id) {
+    ptam_reg_t reg;
+    if (ptam_lookup(id, reg)) {
+        registers_.clear(reg);
+        return;
+    }
     std::lock_guard<std::mutex> lock(mutex_);
     stringData_.erase(id);
     doubleData_.erase(id);
@@ -96,6 +156,7 @@ void SharedMemory::clearData(const std::string& id) {
 ===========================================================================
 */
 void SharedMemory::clearAllData() {
+    registers_.clearAll();
     std::lock_guard<std::mutex> lock(mutex_);
     stringData_.clear();
     doubleData_.clear();
@@ -109,20 +170,154 @@ void SharedMemory::clearAllData() {
 ===========================================================================
 */
 std::string SharedMemory::getLastString(const std::string& id) {
+    ptam_reg_t reg;
+    if (ptam_lookup(id, reg)) {
+        return registers_.getString(reg);
+    }
     std::lock_guard<std::mutex> lock(mutex_);
     return getLastElement(stringData_[id]);
 }
 
 double SharedMemory::getLastDouble(const std::string& id) {
+    ptam_reg_t reg;
+    if (ptam_lookup(id, reg)) {
+        return registers_.getDouble(reg);
+    }
     std::lock_guard<std::mutex> lock(mutex_);
     return getLastElement(doubleData_[id]);
 }
 
 int SharedMemory::getLastInt(const std::string& id) {
+    ptam_reg_t reg;
+    if (ptam_lookup(id, reg)) {
+        return registers_.getInt(reg);
+    }
     std::lock_guard<std::mutex> lock(mutex_);
     return getLastElement(intData_[id]);
 }
 
+//____________________________________________________________
+/* Main subroutines -> fixed register API, forwards to the register file
+===========================================================================
+|    Register        ptam_reg_t declared in PTAM_REGISTER_TABLE
+===========================================================================
+*/
+void SharedMemory::storeString(ptam_reg_t reg, const std::string& data) {
+    registers_.storeString(reg, data);
+}
+
+void SharedMemory::storeDouble(ptam_reg_t reg, double data) {
+    registers_.storeDouble(reg, data);
+}
+
+void SharedMemory::storeInt(ptam_reg_t reg, int data) {
+    registers_.storeInt(reg, data);
+}
+
+std::string SharedMemory::getLastString(ptam_reg_t reg) {
+    return registers_.getString(reg);
+}
+
+double SharedMemory::getLastDouble(ptam_reg_t reg) {
+    return registers_.getDouble(reg);
+}
+
+int SharedMemory::getLastInt(ptam_reg_t reg) {
+    return registers_.getInt(reg);
+}
+
+void SharedMemory::clearData(ptam_reg_t reg) {
+    registers_.clear(reg);
+}
+
+RegisterFile& SharedMemory::registers() {
+    return registers_;
+}
+
+//____________________________________________________________
+/* Main subroutines -> zero-copy history views
+===========================================================================
+|    Register / ID   Fixed register, unknown IDs give an empty view
+|    Returns         View iterating the stored samples oldest first
+===========================================================================
+*/
+PTAMHistoryView SharedMemory::view(ptam_reg_t reg) {
+    return registers_.view(reg);
+}
+
+PTAMHistoryView SharedMemory::view(const std::string& id) {
+    ptam_reg_t reg;
+    if (ptam_lookup(id, reg)) {
+        return registers_.view(reg);
+    }
+    return PTAMHistoryView();
+}
+
+//____________________________________________________________
+/* Main subroutines -> introspection of the fixed registers
+===========================================================================
+|    enumerate()     Name, type, depth, last write and write rate per register
+|    dump()          CBOR snapshot of every register, PTAM_DUMP_MAX_BYTES fits
+===========================================================================
+*/
+std::size_t SharedMemory::enumerate(ptam_reg_info_t* out, std::size_t max) {
+    return registers_.enumerate(out, max);
+}
+
+std::size_t SharedMemory::dump(uint8_t* out, std::size_t len) {
+    return registers_.dump(out, len);
+}
+
+//____________________________________________________________
+/* Main subroutines -> subscribe to writes on a group of fixed registers
+===========================================================================
+|    Mask            ptam_mask(REG_..., ...)
+|    Callback/Notifier  Woken after every matching write (writer's context)
+|    Returns         Subscription id, -1 if no slot is free
+===========================================================================
+*/
+int SharedMemory::subscribe(ptam_mask_t mask, ptam_callback_t callback, void* ctx) {
+    return registers_.subscribe(mask, callback, ctx);
+}
+
+int SharedMemory::subscribe(ptam_mask_t mask, PTAMNotifier& notifier, uint32_t bits) {
+    return registers_.subscribe(mask, notifier, bits);
+}
+
+void SharedMemory::unsubscribe(int id) {
+    registers_.unsubscribe(id);
+}
+
+//____________________________________________________________
+/* Main subroutines -> lock-free snapshot channels
+===========================================================================
+|    publish() from a single producer task, read() from anywhere
+===========================================================================
+*/
+PTAMSnapshot<ptam_attitude_t>& SharedMemory::attitude() {
+    return attitude_;
+}
+
+PTAMSnapshot<ptam_wings_t>& SharedMemory::wings() {
+    return wings_;
+}
+
+PTAMSnapshot<ptam_wings_t>& SharedMemory::bypassWings() {
+    return bypassWings_;
+}
+
+PTAMSnapshot<ptam_battery_t>& SharedMemory::battery() {
+    return battery_;
+}
+
+PTAMSnapshot<ptam_position_t>& SharedMemory::position() {
+    return position_;
+}
+
+PTAMQueue<ptam_wings_t, PTAM_ACTUATION_QUEUE>& SharedMemory::actuation() {
+    return actuation_;
+}
+
 //____________________________________________________________
 /* Utillity subroutines -> Retrieve last element in a vectors
 ===========================================================================
@@ -24,6 +24,12 @@ SOFTWARE.*/
 #include <unordered_map>
 #include <vector>
 #include <mutex>
+#include "_ptam_regfile.h"
+#include "_ptam_snapshot.h"
+#include "_ptam_queue.h"
+
+//Servo frames in flight from the control core to the main loop (50 Hz, drained every pass)
+#define PTAM_ACTUATION_QUEUE 32
 
 class SharedMemory {
 public:
@@ -44,6 +50,46 @@ public:
     double getLastDouble(const std::string& id);
     int getLastInt(const std::string& id);
 
+    //Fixed register API -> O(1) by ptam_reg_t, no hashing or allocation
+    void storeString(ptam_reg_t reg, const std::string& data);
+    void storeDouble(ptam_reg_t reg, double data);
+    void storeInt(ptam_reg_t reg, int data);
+
+    std::string getLastString(ptam_reg_t reg);
+    double getLastDouble(ptam_reg_t reg);
+    int getLastInt(ptam_reg_t reg);
+
+    void clearData(ptam_reg_t reg);
+
+    RegisterFile& registers();
+
+    //Zero-copy history of a fixed register, holds the register lock while alive.
+    //Undeclared (legacy) IDs return an empty view, use getXData for those.
+    PTAMHistoryView view(ptam_reg_t reg);
+    PTAMHistoryView view(const std::string& id);
+
+    //Introspection of the fixed registers and a one-pass CBOR dump of all of them
+    std::size_t enumerate(ptam_reg_info_t* out, std::size_t max);
+    std::size_t dump(uint8_t* out, std::size_t len);
+
+    //Change notifications for fixed registers, see RegisterFile::subscribe
+    int subscribe(ptam_mask_t mask, ptam_callback_t callback, void* ctx = nullptr);
+    int subscribe(ptam_mask_t mask, PTAMNotifier& notifier, uint32_t bits);
+    void unsubscribe(int id);
+
+    //Lock-free snapshot channels for hot register groups (one producer each)
+    PTAMSnapshot<ptam_attitude_t>& attitude();
+    //Flight wings, published by the control rate group only
+    PTAMSnapshot<ptam_wings_t>& wings();
+    //Operator (BYPASS) wings, published by the main loop only
+    PTAMSnapshot<ptam_wings_t>& bypassWings();
+    PTAMSnapshot<ptam_battery_t>& battery();
+    PTAMSnapshot<ptam_position_t>& position();
+
+    //Cross-core stream of actuated wing positions, pushed by the actuate
+    //rate group (APP_CPU), popped by the main loop (PRO_CPU)
+    PTAMQueue<ptam_wings_t, PTAM_ACTUATION_QUEUE>& actuation();
+
 private:
     SharedMemory();
     ~SharedMemory();
@@ -54,7 +100,19 @@ private:
 
     std::mutex mutex_;
 
+    RegisterFile registers_;
+
+    PTAMSnapshot<ptam_attitude_t> attitude_;
+    PTAMSnapshot<ptam_wings_t> wings_;
+    PTAMSnapshot<ptam_wings_t> bypassWings_;
+    PTAMSnapshot<ptam_battery_t> battery_;
+    PTAMSnapshot<ptam_position_t> position_;
+    PTAMQueue<ptam_wings_t, PTAM_ACTUATION_QUEUE> actuation_;
+
 private:
+    template <typename T, typename Convert>
+    std::vector<T> historyOf(ptam_reg_t reg, Convert convert);
+
     std::string getLastElement(const std::vector<std::string>& vec);
     double getLastElement(const std::vector<double>& vec);
     int getLastElement(const std::vector<int>& vec);
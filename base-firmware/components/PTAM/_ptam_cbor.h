@@ -0,0 +1,119 @@
+/*MIT License
+Copyright (c) 2023 limitless Aeronautics
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#ifndef PTAM_CBOR_H
+#define PTAM_CBOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+//____________________________________________________________
+/* Minimal CBOR (RFC 8949) encoder into a caller buffer
+===========================================================================
+|    Only what the PTAM dump needs: unsigned/negative integers, text
+|    strings, float64, null, definite arrays and maps. No allocation; once the
+|    buffer is full every further write is dropped and ok() turns false.
+===========================================================================
+*/
+class PTAMCborWriter {
+public:
+    PTAMCborWriter(uint8_t* out, std::size_t capacity) : out_(out), capacity_(capacity), size_(0), ok_(true) {}
+
+    void uint(uint64_t value) { head(0, value); }
+
+    void integer(int64_t value) {
+        if (value < 0) {
+            head(1, static_cast<uint64_t>(-(value + 1)));
+        } else {
+            head(0, static_cast<uint64_t>(value));
+        }
+    }
+
+    void text(std::string_view str) {
+        head(3, str.size());
+        raw(str.data(), str.size());
+    }
+
+    void float64(double value) {
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        byte(0xfb);
+        for (int shift = 56; shift >= 0; shift -= 8) {
+            byte(static_cast<uint8_t>(bits >> shift));
+        }
+    }
+
+    void null() { byte(0xf6); }
+
+    void array(std::size_t items) { head(4, items); }
+    void map(std::size_t pairs) { head(5, pairs); }
+
+    std::size_t size() const { return size_; }
+    bool ok() const { return ok_; }
+
+    //Encoded size of a head (type + argument), for buffer sizing
+    static constexpr std::size_t headSize(uint64_t value) {
+        return value < 24 ? 1 : value <= 0xff ? 2 : value <= 0xffff ? 3 : value <= 0xffffffffULL ? 5 : 9;
+    }
+
+private:
+    void head(uint8_t major, uint64_t value) {
+        const uint8_t type = static_cast<uint8_t>(major << 5);
+        if (value < 24) {
+            byte(type | static_cast<uint8_t>(value));
+        } else if (value <= 0xff) {
+            byte(type | 24);
+            byte(static_cast<uint8_t>(value));
+        } else if (value <= 0xffff) {
+            byte(type | 25);
+            be(value, 2);
+        } else if (value <= 0xffffffffULL) {
+            byte(type | 26);
+            be(value, 4);
+        } else {
+            byte(type | 27);
+            be(value, 8);
+        }
+    }
+
+    void be(uint64_t value, int bytes) {
+        for (int i = bytes - 1; i >= 0; --i) {
+            byte(static_cast<uint8_t>(value >> (8 * i)));
+        }
+    }
+
+    void byte(uint8_t b) { raw(&b, 1); }
+
+    void raw(const void* data, std::size_t len) {
+        if (!ok_ || size_ + len > capacity_) {
+            ok_ = false;
+            return;
+        }
+        std::memcpy(out_ + size_, data, len);
+        size_ += len;
+    }
+
+    uint8_t* out_;
+    std::size_t capacity_;
+    std::size_t size_;
+    bool ok_;
+};
+
+#endif // PTAM_CBOR_H
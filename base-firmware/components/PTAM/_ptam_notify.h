@@ -0,0 +1,123 @@
+/*MIT License
+Copyright (c) 2023 limitless Aeronautics
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#ifndef PTAM_NOTIFY_H
+#define PTAM_NOTIFY_H
+
+#include <cstdint>
+
+#ifdef ESP_PLATFORM
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#else
+#include <pthread.h>
+#include <time.h>
+#endif
+
+//Block until notified
+#define PTAM_WAIT_FOREVER UINT32_MAX
+
+//____________________________________________________________
+/* Task wake-up primitive used by PTAM subscriptions
+===========================================================================
+|    notify(bits)    ORs bits into the pending set and wakes the owner
+|    wait(ms)        Blocks the owner until bits are pending or timeout,
+|                    returns and clears the pending bits (0 on timeout)
+|
+|    On target this is the FreeRTOS direct-to-task notification of the task
+|    that constructed it (eSetBits), so a notifier must be created by the
+|    task that waits on it. Host builds use a pthread mutex + condition
+|    variable mock with the same semantics so subscriptions can be unit
+|    tested under Linux.
+===========================================================================
+*/
+class PTAMNotifier {
+public:
+#ifdef ESP_PLATFORM
+    PTAMNotifier() : task_(xTaskGetCurrentTaskHandle()) {}
+
+    void notify(uint32_t bits) {
+        xTaskNotify(task_, bits, eSetBits);
+    }
+
+    uint32_t wait(uint32_t timeout_ms) {
+        uint32_t bits = 0;
+        TickType_t ticks = timeout_ms == PTAM_WAIT_FOREVER ? portMAX_DELAY : pdMS_TO_TICKS(timeout_ms);
+        xTaskNotifyWait(0, UINT32_MAX, &bits, ticks);
+        return bits;
+    }
+
+private:
+    TaskHandle_t task_;
+#else
+    PTAMNotifier() {
+        pthread_condattr_t attr;
+        pthread_condattr_init(&attr);
+        pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+        pthread_cond_init(&wake_, &attr);
+        pthread_condattr_destroy(&attr);
+        pthread_mutex_init(&lock_, nullptr);
+    }
+
+    ~PTAMNotifier() {
+        pthread_cond_destroy(&wake_);
+        pthread_mutex_destroy(&lock_);
+    }
+
+    PTAMNotifier(const PTAMNotifier&) = delete;
+    PTAMNotifier& operator=(const PTAMNotifier&) = delete;
+
+    void notify(uint32_t bits) {
+        pthread_mutex_lock(&lock_);
+        pending_ |= bits;
+        pthread_cond_broadcast(&wake_);
+        pthread_mutex_unlock(&lock_);
+    }
+
+    uint32_t wait(uint32_t timeout_ms) {
+        timespec deadline;
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        deadline.tv_sec += timeout_ms / 1000;
+        deadline.tv_nsec += static_cast<long>(timeout_ms % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec += 1;
+            deadline.tv_nsec -= 1000000000L;
+        }
+
+        pthread_mutex_lock(&lock_);
+        while (pending_ == 0) {
+            if (timeout_ms == PTAM_WAIT_FOREVER) {
+                pthread_cond_wait(&wake_, &lock_);
+            } else if (pthread_cond_timedwait(&wake_, &lock_, &deadline) != 0) {
+                break;
+            }
+        }
+        uint32_t bits = pending_;
+        pending_ = 0;
+        pthread_mutex_unlock(&lock_);
+        return bits;
+    }
+
+private:
+    pthread_mutex_t lock_;
+    pthread_cond_t wake_;
+    uint32_t pending_ = 0;
+#endif
+};
+
+#endif // PTAM_NOTIFY_H
@@ -0,0 +1,248 @@
+/*MIT License
+Copyright (c) 2023 limitless Aeronautics
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#include "_ptam_persist.h"
+#include <cstring>
+
+#ifdef ESP_PLATFORM
+//____________________________________________________________
+/* Main subroutines -> NVS store
+===========================================================================
+|    Namespace       NVS namespace, opened read/write
+===========================================================================
+*/
+PTAMNvsStore::~PTAMNvsStore() {
+    if (open_) {
+        nvs_close(handle_);
+    }
+}
+
+bool PTAMNvsStore::open(const char* ns) {
+    if (!open_) {
+        open_ = nvs_open(ns, NVS_READWRITE, &handle_) == ESP_OK;
+    }
+    return open_;
+}
+
+bool PTAMNvsStore::read(const char* key, void* data, std::size_t len) {
+    if (!open_) {
+        return false;
+    }
+    std::size_t stored = len;
+    return nvs_get_blob(handle_, key, data, &stored) == ESP_OK && stored == len;
+}
+
+bool PTAMNvsStore::write(const char* key, const void* data, std::size_t len) {
+    return open_ && nvs_set_blob(handle_, key, data, len) == ESP_OK;
+}
+
+bool PTAMNvsStore::commit() {
+    return open_ && nvs_commit(handle_) == ESP_OK;
+}
+#else
+#include <fstream>
+
+//____________________________________________________________
+/* Main subroutines -> file backed NVS stand-in (host builds)
+===========================================================================
+|    File format     repeated [u8 key length][key][u32 blob length][blob]
+===========================================================================
+*/
+PTAMFileStore::PTAMFileStore(const std::string& path) : path_(path), writes_(0), commits_(0) {
+    std::ifstream in(path_, std::ios::binary);
+    uint8_t key_len;
+    while (in.read(reinterpret_cast<char*>(&key_len), sizeof(key_len))) {
+        std::string key(key_len, '\0');
+        uint32_t blob_len = 0;
+        in.read(&key[0], key_len);
+        in.read(reinterpret_cast<char*>(&blob_len), sizeof(blob_len));
+        std::vector<uint8_t> blob(blob_len);
+        in.read(reinterpret_cast<char*>(blob.data()), blob_len);
+        if (!in) {
+            break;
+        }
+        committed_[key] = blob;
+    }
+}
+
+bool PTAMFileStore::read(const char* key, void* data, std::size_t len) {
+    auto it = committed_.find(key);
+    if (it == committed_.end() || it->second.size() != len) {
+        return false;
+    }
+    std::memcpy(data, it->second.data(), len);
+    return true;
+}
+
+bool PTAMFileStore::write(const char* key, const void* data, std::size_t len) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    staged_[key] = std::vector<uint8_t>(bytes, bytes + len);
+    ++writes_;
+    return true;
+}
+
+bool PTAMFileStore::commit() {
+    for (auto& entry : staged_) {
+        committed_[entry.first] = entry.second;
+    }
+    staged_.clear();
+
+    std::ofstream out(path_, std::ios::binary | std::ios::trunc);
+    for (const auto& entry : committed_) {
+        uint8_t key_len = static_cast<uint8_t>(entry.first.size());
+        uint32_t blob_len = static_cast<uint32_t>(entry.second.size());
+        out.write(reinterpret_cast<const char*>(&key_len), sizeof(key_len));
+        out.write(entry.first.data(), key_len);
+        out.write(reinterpret_cast<const char*>(&blob_len), sizeof(blob_len));
+        out.write(reinterpret_cast<const char*>(entry.second.data()), blob_len);
+    }
+    ++commits_;
+    return static_cast<bool>(out);
+}
+#endif
+
+PTAMPersistence::PTAMPersistence(RegisterFile& regs, PTAMStore& store, int64_t interval_us)
+    : regs_(regs), store_(store), interval_us_(interval_us), last_flush_us_(0),
+      subscription_(-1), dirty_(0), stored_(0) {
+    std::memset(stored_values_, 0, sizeof(stored_values_));
+}
+
+PTAMPersistence::~PTAMPersistence() {
+    regs_.unsubscribe(subscription_);
+}
+
+//____________________________________________________________
+/* Main subroutine -> load flagged registers from the store
+===========================================================================
+|    Returns         Number of registers restored
+|    Restored writes happen before attach(), so they are not marked dirty
+===========================================================================
+*/
+std::size_t PTAMPersistence::restore() {
+    std::size_t restored = 0;
+    for (const ptam_reg_def_t& def : PTAM_REGISTER_TABLE) {
+        record_t record;
+        if (!def.persist || !store_.read(def.id, &record, sizeof(record))) {
+            continue;
+        }
+        if (record.type != static_cast<uint8_t>(def.type)) {
+            continue;
+        }
+        bool ok = false;
+        switch (def.type) {
+            case ptam_type_t::INT:
+                ok = regs_.storeInt(def.reg, record.value.i);
+                break;
+            case ptam_type_t::DOUBLE:
+                ok = regs_.storeDouble(def.reg, record.value.d);
+                break;
+            case ptam_type_t::STRING:
+                record.value.s[PTAM_STRING_LEN - 1] = '\0';
+                ok = regs_.storeString(def.reg, record.value.s);
+                break;
+        }
+        if (ok) {
+            stored_ |= ptam_mask(def.reg);
+            stored_values_[def.reg] = record.value;
+            ++restored;
+        }
+    }
+    return restored;
+}
+
+//____________________________________________________________
+/* Main subroutine -> start tracking writes to flagged registers
+===========================================================================
+|    Returns         false if there is no free subscription slot
+===========================================================================
+*/
+bool PTAMPersistence::attach() {
+    if (subscription_ < 0) {
+        subscription_ = regs_.subscribe(ptam_persist_mask(), onWrite, this);
+    }
+    return subscription_ >= 0;
+}
+
+void PTAMPersistence::onWrite(ptam_reg_t reg, const ptam_sample_t&, void* ctx) {
+    static_cast<PTAMPersistence*>(ctx)->dirty_.fetch_or(ptam_mask(reg), std::memory_order_release);
+}
+
+//____________________________________________________________
+/* Main subroutine -> batch write dirty registers
+===========================================================================
+|    now_us          ptam_time_us() of the call
+|    force           Ignore the rate limit
+|    Returns         true if a commit was made
+===========================================================================
+*/
+bool PTAMPersistence::flush(bool force) {
+    return flush(ptam_time_us(), force);
+}
+
+bool PTAMPersistence::flush(int64_t now_us, bool force) {
+    if (dirty_.load(std::memory_order_acquire) == 0) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(flushLock_);
+    if (!force && last_flush_us_ != 0 && now_us - last_flush_us_ < interval_us_) {
+        return false;
+    }
+    const ptam_mask_t dirty = dirty_.exchange(0, std::memory_order_acq_rel);
+    last_flush_us_ = now_us;
+
+    //Only known stored once the commit succeeded
+    ptam_mask_t written = 0;
+    ptam_value_t values[PTAM_REG_COUNT];
+    for (const ptam_reg_def_t& def : PTAM_REGISTER_TABLE) {
+        const ptam_mask_t bit = ptam_mask(def.reg);
+        ptam_sample_t sample;
+        if (!(dirty & bit) || !regs_.latest(def.reg, sample)) {
+            continue;
+        }
+        //Unchanged value, no flash write
+        if ((stored_ & bit) && std::memcmp(&stored_values_[def.reg], &sample.value, sizeof(ptam_value_t)) == 0) {
+            continue;
+        }
+        record_t record;
+        std::memset(&record, 0, sizeof(record));
+        record.type = static_cast<uint8_t>(def.type);
+        record.value = sample.value;
+        if (!store_.write(def.id, &record, sizeof(record))) {
+            //Retry on the next flush
+            dirty_.fetch_or(bit, std::memory_order_release);
+            continue;
+        }
+        written |= bit;
+        values[def.reg] = sample.value;
+    }
+    if (written == 0) {
+        return false;
+    }
+    if (!store_.commit()) {
+        //Nothing is known stored, every written register is retried
+        dirty_.fetch_or(written, std::memory_order_release);
+        return false;
+    }
+    for (uint8_t reg = 0; reg < PTAM_REG_COUNT; ++reg) {
+        if (written & ptam_mask(static_cast<ptam_reg_t>(reg))) {
+            stored_values_[reg] = values[reg];
+        }
+    }
+    stored_ |= written;
+    return true;
+}
@@ -0,0 +1,151 @@
+/*MIT License
+Copyright (c) 2023 limitless Aeronautics
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#ifndef PTAM_PERSIST_H
+#define PTAM_PERSIST_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include "_ptam_regfile.h"
+
+#ifdef ESP_PLATFORM
+#include "nvs.h"
+#else
+#include <map>
+#include <string>
+#include <vector>
+#endif
+
+//Minimum time between two NVS commits of dirty registers
+#define PTAM_PERSIST_INTERVAL_US (10LL * 1000 * 1000)
+//NVS namespace holding the persisted registers
+#define PTAM_PERSIST_NAMESPACE "ptam"
+
+//____________________________________________________________
+/* Key/blob store used by PTAMPersistence
+===========================================================================
+|    read()          false if the key does not exist or the size differs
+|    write()         Staged until commit()
+|    commit()        Makes staged writes durable, one flash commit
+===========================================================================
+*/
+class PTAMStore {
+public:
+    virtual ~PTAMStore() {}
+    virtual bool read(const char* key, void* data, std::size_t len) = 0;
+    virtual bool write(const char* key, const void* data, std::size_t len) = 0;
+    virtual bool commit() = 0;
+};
+
+#ifdef ESP_PLATFORM
+//NVS backed store, nvs_flash_init() must have run before open()
+class PTAMNvsStore : public PTAMStore {
+public:
+    PTAMNvsStore() : handle_(0), open_(false) {}
+    ~PTAMNvsStore();
+
+    bool open(const char* ns = PTAM_PERSIST_NAMESPACE);
+
+    bool read(const char* key, void* data, std::size_t len) override;
+    bool write(const char* key, const void* data, std::size_t len) override;
+    bool commit() override;
+
+private:
+    nvs_handle_t handle_;
+    bool open_;
+};
+#else
+//____________________________________________________________
+/* Host stand-in for NVS, one binary file per namespace
+===========================================================================
+|    The whole file is loaded on construction and rewritten on commit(),
+|    so a second instance on the same path sees what was committed, just
+|    like the flash after a restart.
+===========================================================================
+*/
+class PTAMFileStore : public PTAMStore {
+public:
+    explicit PTAMFileStore(const std::string& path);
+
+    bool read(const char* key, void* data, std::size_t len) override;
+    bool write(const char* key, const void* data, std::size_t len) override;
+    bool commit() override;
+
+    //Test hooks, flash wear is counted in writes and commits
+    std::size_t writes() const { return writes_; }
+    std::size_t commits() const { return commits_; }
+
+private:
+    std::string path_;
+    std::map<std::string, std::vector<uint8_t>> committed_;
+    std::map<std::string, std::vector<uint8_t>> staged_;
+    std::size_t writes_;
+    std::size_t commits_;
+};
+#endif
+
+//____________________________________________________________
+/* Opt-in persistence of flagged PTAM registers (persist in the table)
+===========================================================================
+|    restore()       Loads every flagged register from the store into the
+|                    register file. Run it before defaults are seeded.
+|    attach()        Subscribes to the flagged registers, writes only mark
+|                    them dirty
+|    flush()         Writes the latest value of every dirty register and
+|                    commits once, at most every interval_us. Values that
+|                    match what is already stored are not rewritten.
+|                    force skips the rate limit (use before esp_restart)
+|                    Safe to call from several tasks
+===========================================================================
+*/
+class PTAMPersistence {
+public:
+    PTAMPersistence(RegisterFile& regs, PTAMStore& store, int64_t interval_us = PTAM_PERSIST_INTERVAL_US);
+    ~PTAMPersistence();
+
+    std::size_t restore();
+    bool attach();
+
+    bool flush(bool force = false);
+    bool flush(int64_t now_us, bool force);
+
+    ptam_mask_t dirty() const { return dirty_.load(std::memory_order_acquire); }
+
+private:
+    //Stored blob, the type guards against a table change between firmwares
+    struct record_t {
+        uint8_t type;
+        ptam_value_t value;
+    };
+
+    static void onWrite(ptam_reg_t reg, const ptam_sample_t& sample, void* ctx);
+
+    RegisterFile& regs_;
+    PTAMStore& store_;
+    int64_t interval_us_;
+    int64_t last_flush_us_;
+    int subscription_;
+    std::atomic<ptam_mask_t> dirty_;
+    std::mutex flushLock_;
+    ptam_mask_t stored_;                    //Registers whose stored value is known
+    ptam_value_t stored_values_[PTAM_REG_COUNT];
+};
+
+#endif // PTAM_PERSIST_H
@@ -0,0 +1,91 @@
+/*MIT License
+Copyright (c) 2023 limitless Aeronautics
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#ifndef PTAM_QUEUE_H
+#define PTAM_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+//____________________________________________________________
+/* Lock-free single-producer / single-consumer queue
+===========================================================================
+|    Carries a stream of records between two tasks, typically across
+|    cores (control on APP_CPU -> comms / logging on PRO_CPU), where
+|    PTAMSnapshot would only keep the latest value.
+|
+|    Fixed ring of N slots (power of two), no allocation. The producer
+|    never blocks: push() on a full queue drops the record and counts it,
+|    so a stalled consumer cannot delay the control loop.
+|    Only one task may push() and only one task may pop().
+===========================================================================
+*/
+template <typename T, std::size_t N>
+class PTAMQueue {
+    static_assert(std::is_trivially_copyable_v<T>, "PTAMQueue needs a trivially copyable struct");
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "PTAMQueue size must be a power of two");
+
+public:
+    PTAMQueue() : head_(0), tail_(0), dropped_(0), slots_() {}
+
+    //Producer only, false (and counted) when full
+    bool push(const T& data) {
+        const uint32_t head = head_.load(std::memory_order_relaxed);
+        if (head - tail_.load(std::memory_order_acquire) == N) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        slots_[head & (N - 1)] = data;
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    //Consumer only, false when empty
+    bool pop(T& out) {
+        const uint32_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail == head_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        out = slots_[tail & (N - 1)];
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    //Records waiting, exact from either end, a hint from anywhere else
+    std::size_t size() const {
+        return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+    }
+
+    //Records lost to a full queue since boot
+    uint32_t dropped() const {
+        return dropped_.load(std::memory_order_relaxed);
+    }
+
+    static constexpr std::size_t capacity() { return N; }
+
+private:
+    //Producer and consumer indices on separate cache lines (no false sharing on host)
+    alignas(64) std::atomic<uint32_t> head_;
+    alignas(64) std::atomic<uint32_t> tail_;
+    std::atomic<uint32_t> dropped_;
+    T slots_[N];
+};
+
+#endif // PTAM_QUEUE_H
@@ -0,0 +1,422 @@
+/*MIT License
+Copyright (c) 2023 limitless Aeronautics
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#include "_ptam_regfile.h"
+#include <cstring>
+#include "../Profiling/_probe.h"
+
+RegisterFile::RegisterFile() {
+    std::memset(pool_, 0, sizeof(pool_));
+    for (uint8_t reg = 0; reg < PTAM_REG_COUNT; ++reg) {
+        slots_[reg].history = PTAMRing<ptam_sample_t>(&pool_[ptam_history_offset(reg)], depth(static_cast<ptam_reg_t>(reg)));
+    }
+}
+
+//____________________________________________________________
+/* Utillity subroutine -> append a sample to the register ring buffer
+===========================================================================
+|    Register        Fixed register slot
+|    Sample          Value and timestamp, overwrites the oldest when full
+|                    The next register sequence number is assigned here
+===========================================================================
+*/
+void RegisterFile::push(ptam_reg_t reg, ptam_sample_t& sample) {
+    PROBE_SCOPE("ptam.push");
+    Slot& slot = slots_[reg];
+    {
+        std::lock_guard<std::mutex> lock(slot.lock);
+        sample.seq = slot.seq.load(std::memory_order_relaxed) + 1;
+        slot.history.push(sample);
+        if (slot.last_write_us != 0) {
+            const int64_t interval = sample.time_us - slot.last_write_us;
+            slot.interval_us = slot.interval_us == 0 ? interval : slot.interval_us + (interval - slot.interval_us) / 8;
+        }
+        slot.last_write_us = sample.time_us;
+        //Publish after the sample is in the ring so seq() never runs ahead of latest()
+        slot.seq.store(sample.seq, std::memory_order_release);
+    }
+    //Subscribers run outside the slot lock so they may read the register
+    if (watched_.load(std::memory_order_acquire) & ptam_mask(reg)) {
+        dispatch(reg, sample);
+    }
+}
+
+//____________________________________________________________
+/* Utillity subroutine -> deliver a write to every matching subscriber
+===========================================================================
+|    Register        Register that was written
+|    Sample          The sample as stored, including its seq
+===========================================================================
+*/
+void RegisterFile::dispatch(ptam_reg_t reg, const ptam_sample_t& sample) {
+    const ptam_mask_t bit = ptam_mask(reg);
+    for (Subscriber& sub : subscribers_) {
+        if (!(sub.mask.load(std::memory_order_acquire) & bit)) {
+            continue;
+        }
+        if (sub.notifier != nullptr) {
+            sub.notifier->notify(sub.bits);
+        } else {
+            sub.callback(reg, sample, sub.ctx);
+        }
+    }
+}
+
+//____________________________________________________________
+/* Main subroutines -> stores value of datatypes (int, double, string)
+===========================================================================
+|    Register        Fixed register slot
+|    Data Value      Numeric values are converted to the register type
+|    Returns         false if the value type does not fit the register
+===========================================================================
+*/
+bool RegisterFile::storeInt(ptam_reg_t reg, int data) {
+    return storeDouble(reg, static_cast<double>(data));
+}
+
+bool RegisterFile::storeDouble(ptam_reg_t reg, double data) {
+    const ptam_type_t type = describe(reg).type;
+    if (type == ptam_type_t::STRING) {
+        return false;
+    }
+    ptam_sample_t sample;
+    std::memset(&sample.value, 0, sizeof(sample.value));
+    if (type == ptam_type_t::INT) {
+        sample.value.i = static_cast<int>(data);
+    } else {
+        sample.value.d = data;
+    }
+    sample.time_us = ptam_time_us();
+    push(reg, sample);
+    return true;
+}
+
+bool RegisterFile::storeString(ptam_reg_t reg, std::string_view data) {
+    if (describe(reg).type != ptam_type_t::STRING) {
+        return false;
+    }
+    ptam_sample_t sample;
+    std::memset(&sample.value, 0, sizeof(sample.value));
+    //Truncate to the fixed slot size, always leave room for the terminator
+    const std::size_t len = data.size() < PTAM_STRING_LEN - 1 ? data.size() : PTAM_STRING_LEN - 1;
+    std::memcpy(sample.value.s, data.data(), len);
+    sample.value.s[len] = '\0';
+    sample.time_us = ptam_time_us();
+    push(reg, sample);
+    return true;
+}
+
+//____________________________________________________________
+/* Main subroutines -> retrieves the current value of a register
+===========================================================================
+|    Register        Fixed register slot
+|    Returns         0 / 0.0 / "" if never written, like the string API
+===========================================================================
+*/
+int RegisterFile::getInt(ptam_reg_t reg) {
+    ptam_sample_t sample;
+    if (!latest(reg, sample)) {
+        return 0;
+    }
+    return asInt(reg, sample);
+}
+
+double RegisterFile::getDouble(ptam_reg_t reg) {
+    ptam_sample_t sample;
+    if (!latest(reg, sample)) {
+        return 0.0;
+    }
+    return asDouble(reg, sample);
+}
+
+std::string RegisterFile::getString(ptam_reg_t reg) {
+    char buffer[PTAM_STRING_LEN];
+    std::size_t len = getString(reg, buffer, sizeof(buffer));
+    return std::string(buffer, len);
+}
+
+std::size_t RegisterFile::getString(ptam_reg_t reg, char* out, std::size_t len) {
+    if (len == 0) {
+        return 0;
+    }
+    out[0] = '\0';
+    ptam_sample_t sample;
+    if (describe(reg).type != ptam_type_t::STRING || !latest(reg, sample)) {
+        return 0;
+    }
+    std::size_t n = std::strlen(sample.value.s);
+    if (n > len - 1) {
+        n = len - 1;
+    }
+    std::memcpy(out, sample.value.s, n);
+    out[n] = '\0';
+    return n;
+}
+
+//____________________________________________________________
+/* Main subroutines -> register state and clearing
+===========================================================================
+|    Register        Fixed register slot
+===========================================================================
+*/
+bool RegisterFile::isSet(ptam_reg_t reg) {
+    return size(reg) != 0;
+}
+
+std::size_t RegisterFile::size(ptam_reg_t reg) {
+    Slot& slot = slots_[reg];
+    std::lock_guard<std::mutex> lock(slot.lock);
+    return slot.history.size();
+}
+
+int64_t RegisterFile::ageUs(ptam_reg_t reg) {
+    ptam_sample_t sample;
+    if (!latest(reg, sample)) {
+        return -1;
+    }
+    return ptam_time_us() - sample.time_us;
+}
+
+void RegisterFile::clear(ptam_reg_t reg) {
+    Slot& slot = slots_[reg];
+    std::lock_guard<std::mutex> lock(slot.lock);
+    slot.history.clear();
+    //seq keeps counting, the rate starts over
+    slot.last_write_us = 0;
+    slot.interval_us = 0;
+}
+
+void RegisterFile::clearAll() {
+    for (uint8_t reg = 0; reg < PTAM_REG_COUNT; ++reg) {
+        clear(static_cast<ptam_reg_t>(reg));
+    }
+}
+
+//____________________________________________________________
+/* Main subroutines -> history API
+===========================================================================
+|    Register        Fixed register slot
+|    out             Caller buffer, samples are copied oldest first
+===========================================================================
+*/
+bool RegisterFile::latest(ptam_reg_t reg, ptam_sample_t& out) {
+    Slot& slot = slots_[reg];
+    std::lock_guard<std::mutex> lock(slot.lock);
+    if (slot.history.empty()) {
+        return false;
+    }
+    out = slot.history.latest();
+    return true;
+}
+
+std::size_t RegisterFile::window(ptam_reg_t reg, std::size_t n, ptam_sample_t* out) {
+    Slot& slot = slots_[reg];
+    std::lock_guard<std::mutex> lock(slot.lock);
+    return slot.history.window(n, out);
+}
+
+std::size_t RegisterFile::since(ptam_reg_t reg, int64_t time_us, ptam_sample_t* out, std::size_t max) {
+    Slot& slot = slots_[reg];
+    std::lock_guard<std::mutex> lock(slot.lock);
+    //Count back from the newest sample until one is not newer than time_us
+    std::size_t n = 0;
+    const std::size_t count = slot.history.size();
+    while (n < count && n < max && slot.history.at(count - 1 - n).time_us > time_us) {
+        ++n;
+    }
+    return slot.history.window(n, out);
+}
+
+PTAMHistoryView RegisterFile::view(ptam_reg_t reg) {
+    Slot& slot = slots_[reg];
+    return PTAMHistoryView(reg, slot.history, slot.lock);
+}
+
+//____________________________________________________________
+/* Main subroutines -> introspection
+===========================================================================
+|    Register        Fixed register slot
+|    out / len       Caller buffer, dump() needs at most PTAM_DUMP_MAX_BYTES
+===========================================================================
+*/
+ptam_reg_info_t RegisterFile::infoLocked(ptam_reg_t reg, int64_t now_us) const {
+    const Slot& slot = slots_[reg];
+    const ptam_reg_def_t& def = describe(reg);
+    ptam_reg_info_t info;
+    info.reg = reg;
+    info.id = def.id;
+    info.type = def.type;
+    info.depth = def.depth;
+    info.size = static_cast<uint16_t>(slot.history.size());
+    info.seq = slot.seq.load(std::memory_order_relaxed);
+    info.last_write_us = slot.last_write_us;
+    info.write_rate_hz = 0.0f;
+    //Use the silence since the last write once it is longer than the usual interval
+    int64_t interval = slot.interval_us;
+    if (slot.last_write_us != 0 && now_us - slot.last_write_us > interval) {
+        interval = now_us - slot.last_write_us;
+    }
+    if (info.seq > 1 && interval > 0) {
+        info.write_rate_hz = 1e6f / static_cast<float>(interval);
+    }
+    return info;
+}
+
+ptam_reg_info_t RegisterFile::info(ptam_reg_t reg) {
+    Slot& slot = slots_[reg];
+    std::lock_guard<std::mutex> lock(slot.lock);
+    return infoLocked(reg, ptam_time_us());
+}
+
+std::size_t RegisterFile::enumerate(ptam_reg_info_t* out, std::size_t max) {
+    std::size_t n = 0;
+    for (uint8_t reg = 0; reg < PTAM_REG_COUNT && n < max; ++reg) {
+        out[n++] = info(static_cast<ptam_reg_t>(reg));
+    }
+    return n;
+}
+
+std::size_t RegisterFile::dump(uint8_t* out, std::size_t len) {
+    PROBE_SCOPE("ptam.dump");
+    PTAMCborWriter cbor(out, len);
+    //Always in register order, so concurrent dumps cannot deadlock
+    for (Slot& slot : slots_) {
+        slot.lock.lock();
+    }
+    const int64_t now_us = ptam_time_us();
+    cbor.map(3);
+    cbor.text("v");
+    cbor.uint(1);
+    cbor.text("t");
+    cbor.integer(now_us);
+    cbor.text("regs");
+    cbor.array(PTAM_REG_COUNT);
+    for (uint8_t i = 0; i < PTAM_REG_COUNT; ++i) {
+        const ptam_reg_t reg = static_cast<ptam_reg_t>(i);
+        const ptam_reg_info_t info = infoLocked(reg, now_us);
+        cbor.array(7);
+        cbor.text(info.id);
+        cbor.uint(static_cast<uint8_t>(info.type));
+        cbor.uint(info.depth);
+        cbor.uint(info.seq);
+        cbor.integer(info.last_write_us);
+        cbor.float64(info.write_rate_hz);
+        if (slots_[reg].history.empty()) {
+            cbor.null();
+            continue;
+        }
+        const ptam_sample_t& sample = slots_[reg].history.latest();
+        switch (info.type) {
+            case ptam_type_t::INT:
+                cbor.integer(sample.value.i);
+                break;
+            case ptam_type_t::DOUBLE:
+                cbor.float64(sample.value.d);
+                break;
+            case ptam_type_t::STRING:
+                cbor.text(std::string_view(sample.value.s, strnlen(sample.value.s, PTAM_STRING_LEN)));
+                break;
+        }
+    }
+    for (int i = PTAM_REG_COUNT - 1; i >= 0; --i) {
+        slots_[i].lock.unlock();
+    }
+    return cbor.ok() ? cbor.size() : 0;
+}
+
+//____________________________________________________________
+/* Main subroutines -> subscriptions
+===========================================================================
+|    Mask            Registers to watch, 0 is rejected
+|    Returns         Subscription id, -1 if the table is full
+===========================================================================
+*/
+int RegisterFile::subscribe(ptam_mask_t mask, ptam_callback_t callback, void* ctx) {
+    if (callback == nullptr) {
+        return -1;
+    }
+    return addSubscriber(mask, callback, ctx, nullptr, 0);
+}
+
+int RegisterFile::subscribe(ptam_mask_t mask, PTAMNotifier& notifier, uint32_t bits) {
+    return addSubscriber(mask, nullptr, nullptr, &notifier, bits);
+}
+
+int RegisterFile::addSubscriber(ptam_mask_t mask, ptam_callback_t callback, void* ctx,
+                                PTAMNotifier* notifier, uint32_t bits) {
+    if (mask == 0) {
+        return -1;
+    }
+    std::lock_guard<std::mutex> lock(subscribeLock_);
+    for (int id = 0; id < PTAM_MAX_SUBSCRIBERS; ++id) {
+        Subscriber& sub = subscribers_[id];
+        if (sub.mask.load(std::memory_order_relaxed) != 0) {
+            continue;
+        }
+        sub.callback = callback;
+        sub.ctx = ctx;
+        sub.notifier = notifier;
+        sub.bits = bits;
+        //Writers only look at a slot once its mask is visible
+        sub.mask.store(mask, std::memory_order_release);
+        watched_.fetch_or(mask, std::memory_order_release);
+        return id;
+    }
+    return -1;
+}
+
+void RegisterFile::unsubscribe(int id) {
+    if (id < 0 || id >= PTAM_MAX_SUBSCRIBERS) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(subscribeLock_);
+    subscribers_[id].mask.store(0, std::memory_order_release);
+    ptam_mask_t watched = 0;
+    for (const Subscriber& sub : subscribers_) {
+        watched |= sub.mask.load(std::memory_order_relaxed);
+    }
+    watched_.store(watched, std::memory_order_release);
+}
+
+//____________________________________________________________
+/* Utillity subroutines -> numeric view of a sample
+===========================================================================
+|    Register        Register the sample belongs to (decides the union member)
+===========================================================================
+*/
+double RegisterFile::asDouble(ptam_reg_t reg, const ptam_sample_t& sample) {
+    switch (describe(reg).type) {
+        case ptam_type_t::INT:
+            return static_cast<double>(sample.value.i);
+        case ptam_type_t::DOUBLE:
+            return sample.value.d;
+        default:
+            return 0.0;
+    }
+}
+
+int RegisterFile::asInt(ptam_reg_t reg, const ptam_sample_t& sample) {
+    switch (describe(reg).type) {
+        case ptam_type_t::INT:
+            return sample.value.i;
+        case ptam_type_t::DOUBLE:
+            return static_cast<int>(sample.value.d);
+        default:
+            return 0;
+    }
+}
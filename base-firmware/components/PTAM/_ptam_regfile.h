@@ -0,0 +1,293 @@
+/*MIT License
+Copyright (c) 2023 limitless Aeronautics
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#ifndef PTAM_REGFILE_H
+#define PTAM_REGFILE_H
+
+#include <string>
+#include <atomic>
+#include <mutex>
+#include <type_traits>
+#include "_ptam_registers.h"
+#include "_ptam_ring.h"
+#include "_ptam_clock.h"
+#include "_ptam_notify.h"
+#include "_ptam_cbor.h"
+
+//Maximum simultaneous PTAM subscriptions
+#define PTAM_MAX_SUBSCRIBERS 8
+
+union ptam_value_t {
+    int i;
+    double d;
+    char s[PTAM_STRING_LEN];
+};
+
+struct ptam_sample_t {
+    ptam_value_t value;
+    int64_t time_us;    //ptam_time_us() at the time of the write
+    uint32_t seq;       //Register sequence number of the write, first write is 1
+};
+
+//Introspection record of one register, see RegisterFile::info()
+struct ptam_reg_info_t {
+    ptam_reg_t reg;
+    const char* id;
+    ptam_type_t type;
+    uint16_t depth;
+    uint16_t size;          //Samples currently held
+    uint32_t seq;           //Writes so far
+    int64_t last_write_us;  //ptam_time_us() of the last write, 0 if never written
+    float write_rate_hz;    //Smoothed write rate, decays once writes stop
+};
+
+//____________________________________________________________
+/* Upper bound of RegisterFile::dump() output, sized from the table
+===========================================================================
+|    {"v": 1, "t": now_us, "regs": [[id, type, depth, seq, last_write_us,
+|     write_rate_hz, value], ...]}     value is null for unset registers
+===========================================================================
+*/
+constexpr std::size_t ptam_dump_bound() {
+    std::size_t bytes = 1 + 2 + 1 + 2 + 9 + 5 + PTAMCborWriter::headSize(PTAM_REG_COUNT);
+    for (const ptam_reg_def_t& def : PTAM_REGISTER_TABLE) {
+        const std::size_t id_len = std::string_view(def.id).size();
+        bytes += 1                                          //record array
+               + PTAMCborWriter::headSize(id_len) + id_len  //id
+               + 1 + PTAMCborWriter::headSize(def.depth)    //type, depth
+               + 5 + 9 + 9                                  //seq, last write, rate
+               + (def.type == ptam_type_t::STRING ? 1 + PTAM_STRING_LEN : 9);
+    }
+    return bytes;
+}
+
+constexpr std::size_t PTAM_DUMP_MAX_BYTES = ptam_dump_bound();
+
+//____________________________________________________________
+/* Zero-copy read view of one register's history
+===========================================================================
+|    Holds the register's slot lock for its lifetime, so samples are read
+|    straight out of the ring storage without copying. Writers to that
+|    register block until the view is destroyed: keep views short-lived and
+|    never store into the same register while holding one.
+|    Iteration is oldest -> newest. A default constructed view is empty.
+===========================================================================
+*/
+class PTAMHistoryView {
+public:
+    using const_iterator = PTAMRing<ptam_sample_t>::const_iterator;
+
+    PTAMHistoryView() : ring_(nullptr), reg_(PTAM_REG_COUNT) {}
+
+    std::size_t size() const { return ring_ ? ring_->size() : 0; }
+    bool empty() const { return size() == 0; }
+    ptam_reg_t reg() const { return reg_; }
+
+    //i < size(), 0 is the oldest sample
+    const ptam_sample_t& operator[](std::size_t i) const { return ring_->at(i); }
+    //Precondition: !empty()
+    const ptam_sample_t& latest() const { return ring_->latest(); }
+
+    const_iterator begin() const { return ring_ ? ring_->begin() : const_iterator(); }
+    const_iterator end() const { return ring_ ? ring_->end() : const_iterator(); }
+
+private:
+    friend class RegisterFile;
+
+    PTAMHistoryView(ptam_reg_t reg, const PTAMRing<ptam_sample_t>& ring, std::mutex& lock)
+        : ring_(&ring), lock_(lock), reg_(reg) {}
+
+    const PTAMRing<ptam_sample_t>* ring_;
+    std::unique_lock<std::mutex> lock_;
+    ptam_reg_t reg_;
+};
+
+//Runs in the context of the writing task, keep it short and non-blocking
+typedef void (*ptam_callback_t)(ptam_reg_t reg, const ptam_sample_t& sample, void* ctx);
+
+//____________________________________________________________
+/* Fixed-slot PTAM backend
+===========================================================================
+|    One statically allocated slot per ptam_reg_t. Access is O(1) by enum,
+|    there is no heap allocation and no string hashing. Each slot has its
+|    own lock so writers to different registers never contend.
+|    Each slot keeps a ring buffer of its last `depth` samples (see
+|    PTAM_REGISTER_TABLE), so memory use is fixed at compile time.
+===========================================================================
+*/
+class RegisterFile {
+public:
+    RegisterFile();
+
+    //Numeric stores convert between INT and DOUBLE registers. Storing a
+    //string into a numeric register (or the reverse) is rejected.
+    bool storeInt(ptam_reg_t reg, int data);
+    bool storeDouble(ptam_reg_t reg, double data);
+    bool storeString(ptam_reg_t reg, std::string_view data);
+
+    int getInt(ptam_reg_t reg);
+    double getDouble(ptam_reg_t reg);
+    std::string getString(ptam_reg_t reg);
+    //Copies into a caller buffer, returns the string length
+    std::size_t getString(ptam_reg_t reg, char* out, std::size_t len);
+
+    bool isSet(ptam_reg_t reg);
+    void clear(ptam_reg_t reg);
+    void clearAll();
+
+    //____________________________________________________________
+    /* History API -> copies out of the register ring buffer, no allocation
+    ===========================================================================
+    |    latest()        Most recent sample, false if the register is empty
+    |    window(n)       Newest n samples, oldest first
+    |    since(t)        Samples written after t (ptam_time_us), oldest first
+    |    view()          Iterable in-place view, holds the register lock
+    |    Returns         Number of samples written to out
+    ===========================================================================
+    */
+    bool latest(ptam_reg_t reg, ptam_sample_t& out);
+    std::size_t window(ptam_reg_t reg, std::size_t n, ptam_sample_t* out);
+    std::size_t since(ptam_reg_t reg, int64_t time_us, ptam_sample_t* out, std::size_t max);
+    //Read-locked view of the whole history, no copy (see PTAMHistoryView)
+    PTAMHistoryView view(ptam_reg_t reg);
+
+    std::size_t size(ptam_reg_t reg);
+
+    //____________________________________________________________
+    /* Freshness API -> per-register monotonic sequence numbers
+    ===========================================================================
+    |    seq()           Number of writes to the register so far, 0 = never
+    |                    written. Lock-free, clear() does not reset it.
+    |    changedSince()  true if the register was written after the reader
+    |                    saw `seq`, wrap-safe
+    |    ageUs()         Microseconds since the last write, -1 if empty
+    ===========================================================================
+    */
+    uint32_t seq(ptam_reg_t reg) const {
+        return slots_[reg].seq.load(std::memory_order_acquire);
+    }
+    bool changedSince(ptam_reg_t reg, uint32_t seq) const {
+        return this->seq(reg) != seq;
+    }
+    int64_t ageUs(ptam_reg_t reg);
+
+    //____________________________________________________________
+    /* Subscription API -> wake consumers on writes instead of polling
+    ===========================================================================
+    |    Mask            Registers to watch, see ptam_mask()
+    |    Callback        Called with the new sample after every matching write
+    |    Notifier        bits are ORed into the notifier after a matching write
+    |    Returns         Subscription id for unsubscribe(), -1 if all
+    |                    PTAM_MAX_SUBSCRIBERS slots are taken
+    |    A write racing unsubscribe() may still deliver one last notification
+    ===========================================================================
+    */
+    int subscribe(ptam_mask_t mask, ptam_callback_t callback, void* ctx);
+    int subscribe(ptam_mask_t mask, PTAMNotifier& notifier, uint32_t bits);
+    void unsubscribe(int id);
+
+    //____________________________________________________________
+    /* Introspection API -> enumerate the blackboard
+    ===========================================================================
+    |    info()          Name, type, depth, fill, seq, last write, write rate
+    |    enumerate()     info() of every register in table order, returns count
+    |    dump()          CBOR of every register's metadata and latest value,
+    |                    taken in one pass with all register locks held so the
+    |                    dump is a consistent snapshot. Returns bytes written,
+    |                    0 if len < needed (PTAM_DUMP_MAX_BYTES always fits)
+    ===========================================================================
+    */
+    ptam_reg_info_t info(ptam_reg_t reg);
+    std::size_t enumerate(ptam_reg_info_t* out, std::size_t max);
+    std::size_t dump(uint8_t* out, std::size_t len);
+
+    static constexpr std::size_t depth(ptam_reg_t reg) {
+        return PTAM_REGISTER_TABLE[reg].depth;
+    }
+
+    //Reads a sample of a numeric register as double / int
+    static double asDouble(ptam_reg_t reg, const ptam_sample_t& sample);
+    static int asInt(ptam_reg_t reg, const ptam_sample_t& sample);
+
+    static constexpr const ptam_reg_def_t& describe(ptam_reg_t reg) {
+        return PTAM_REGISTER_TABLE[reg];
+    }
+
+    //____________________________________________________________
+    /* Compile-time typed access -> type checked against PTAM_REGISTER_TABLE
+    ===========================================================================
+    |    e.g. regs.get<REG_WING_FL>() returns double
+    ===========================================================================
+    */
+    template <ptam_reg_t R>
+    auto get() {
+        static_assert(R < PTAM_REG_COUNT, "Unknown PTAM register");
+        if constexpr (PTAM_REGISTER_TABLE[R].type == ptam_type_t::INT) {
+            return getInt(R);
+        } else if constexpr (PTAM_REGISTER_TABLE[R].type == ptam_type_t::DOUBLE) {
+            return getDouble(R);
+        } else {
+            return getString(R);
+        }
+    }
+
+    template <ptam_reg_t R, typename T>
+    void set(const T& data) {
+        static_assert(R < PTAM_REG_COUNT, "Unknown PTAM register");
+        if constexpr (PTAM_REGISTER_TABLE[R].type == ptam_type_t::STRING) {
+            storeString(R, data);
+        } else if constexpr (PTAM_REGISTER_TABLE[R].type == ptam_type_t::INT) {
+            static_assert(std::is_arithmetic_v<T>, "Numeric PTAM register needs a numeric value");
+            storeInt(R, static_cast<int>(data));
+        } else {
+            static_assert(std::is_arithmetic_v<T>, "Numeric PTAM register needs a numeric value");
+            storeDouble(R, static_cast<double>(data));
+        }
+    }
+
+private:
+    struct Slot {
+        PTAMRing<ptam_sample_t> history;
+        std::atomic<uint32_t> seq{0};
+        int64_t last_write_us = 0;
+        int64_t interval_us = 0;    //Smoothed time between writes (EWMA 1/8)
+        std::mutex lock;
+    };
+
+    struct Subscriber {
+        std::atomic<ptam_mask_t> mask{0};  //0 = free slot, set last on subscribe
+        ptam_callback_t callback;
+        void* ctx;
+        PTAMNotifier* notifier;
+        uint32_t bits;
+    };
+
+    void push(ptam_reg_t reg, ptam_sample_t& sample);
+    void dispatch(ptam_reg_t reg, const ptam_sample_t& sample);
+    //Slot lock must be held
+    ptam_reg_info_t infoLocked(ptam_reg_t reg, int64_t now_us) const;
+    int addSubscriber(ptam_mask_t mask, ptam_callback_t callback, void* ctx, PTAMNotifier* notifier, uint32_t bits);
+
+    Slot slots_[PTAM_REG_COUNT];
+    Subscriber subscribers_[PTAM_MAX_SUBSCRIBERS];
+    std::atomic<ptam_mask_t> watched_{0};   //Union of all subscriber masks
+    std::mutex subscribeLock_;
+    ptam_sample_t pool_[PTAM_HISTORY_TOTAL];
+};
+
+#endif // PTAM_REGFILE_H
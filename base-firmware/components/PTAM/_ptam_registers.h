@@ -0,0 +1,244 @@
+/*MIT License
+Copyright (c) 2023 limitless Aeronautics
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#ifndef PTAM_REGISTERS_H
+#define PTAM_REGISTERS_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string_view>
+
+//Maximum length (including terminator) of a string held in a PTAM register
+#define PTAM_STRING_LEN 16
+
+enum class ptam_type_t : uint8_t {
+    INT,
+    DOUBLE,
+    STRING
+};
+
+//____________________________________________________________
+/* PTAM register IDs
+===========================================================================
+|    The enum value is the register slot. Keep this list in the same order
+|    as PTAM_REGISTER_TABLE below (checked at compile time).
+===========================================================================
+*/
+enum ptam_reg_t : uint8_t {
+    //StateMachine
+    REG_STATE = 0,
+    REG_STATE_DESCRIPT,
+    REG_ARM_TOKEN,
+    //Functionality flags
+    REG_GPS_CHECK,
+    REG_IMU_CHECK,
+    REG_BMP_CHECK,
+    REG_LATITUDE_CHECK,
+    REG_LONGITUDE_CHECK,
+    REG_ALTITUDE_CHECK,
+    REG_VELOCITY_CHECK,
+    REG_PITCH_CHECK,
+    REG_ROLL_CHECK,
+    REG_YAW_CHECK,
+    REG_TEMPERATURE_CHECK,
+    REG_PRESSURE_CHECK,
+    REG_SETUP_SFLAG,
+    //Flight configuration (SWP)
+    REG_TLAT,
+    REG_TLONG,
+    REG_TALT,
+    REG_CALT,
+    REG_TVEL,
+    //Actuators
+    REG_WING_FL,
+    REG_WING_FR,
+    REG_WING_RL,
+    REG_WING_RR,
+    REG_THR,
+    //Control loop scheduler (RateScheduler::publish)
+    REG_RT_JITTER,
+    REG_RT_OVERRUN,
+    REG_RT_LOAD,
+    //Heap (MemoryManager::publish)
+    REG_HEAP_FREE,
+    REG_HEAP_LARGEST,
+    REG_HEAP_MIN,
+
+    PTAM_REG_COUNT
+};
+
+struct ptam_reg_def_t {
+    ptam_reg_t reg;
+    const char* id;
+    ptam_type_t type;
+    uint16_t depth;     //Samples of history kept in the register ring buffer
+    bool persist;       //Written back to NVS and restored on boot (see PTAMPersistence)
+};
+
+//____________________________________________________________
+/* PTAM register table -> every fixed register, its string ID, type and depth
+===========================================================================
+|    String IDs match the ones seeded by CONTROLLER_TASKS::PTAM_REGISTER_SET
+|    so the string API keeps resolving to the same registers
+|    Depth is the ring buffer size; flags only need their latest value
+|    Persist marks the mission configuration that survives a restart
+===========================================================================
+*/
+constexpr ptam_reg_def_t PTAM_REGISTER_TABLE[] = {
+    {REG_STATE,             "state",             ptam_type_t::INT,     8, false},
+    {REG_STATE_DESCRIPT,    "stateDescript",     ptam_type_t::STRING,  8, false},
+    {REG_ARM_TOKEN,         "arm_token",         ptam_type_t::STRING,  1, false},
+    {REG_GPS_CHECK,         "GPScheck",          ptam_type_t::INT,     1, false},
+    {REG_IMU_CHECK,         "IMUcheck",          ptam_type_t::INT,     1, false},
+    {REG_BMP_CHECK,         "BMPcheck",          ptam_type_t::INT,     1, false},
+    {REG_LATITUDE_CHECK,    "LATITUDE_CHECK",    ptam_type_t::INT,     1, false},
+    {REG_LONGITUDE_CHECK,   "LONGITUDE_CHECK",   ptam_type_t::INT,     1, false},
+    {REG_ALTITUDE_CHECK,    "ALTITUDE_CHECK",    ptam_type_t::INT,     1, false},
+    {REG_VELOCITY_CHECK,    "VELOCITY_CHECK",    ptam_type_t::INT,     1, false},
+    {REG_PITCH_CHECK,       "PITCH_CHECK",       ptam_type_t::INT,     1, false},
+    {REG_ROLL_CHECK,        "ROLL_CHECK",        ptam_type_t::INT,     1, false},
+    {REG_YAW_CHECK,         "YAW_CHECK",         ptam_type_t::INT,     1, false},
+    {REG_TEMPERATURE_CHECK, "TEMPERATURE_CHECK", ptam_type_t::INT,     1, false},
+    {REG_PRESSURE_CHECK,    "PRESSURE_CHECK",    ptam_type_t::INT,     1, false},
+    {REG_SETUP_SFLAG,       "setupSFlag",        ptam_type_t::INT,     1, false},
+    {REG_TLAT,              "TLat",              ptam_type_t::DOUBLE,  4, true },
+    {REG_TLONG,             "TLong",             ptam_type_t::DOUBLE,  4, true },
+    {REG_TALT,              "TAlt",              ptam_type_t::DOUBLE,  4, true },
+    {REG_CALT,              "CAlt",              ptam_type_t::DOUBLE,  4, true },
+    {REG_TVEL,              "TVel",              ptam_type_t::DOUBLE,  4, true },
+    {REG_WING_FL,           "WingFL",            ptam_type_t::DOUBLE, 16, false},
+    {REG_WING_FR,           "WingFR",            ptam_type_t::DOUBLE, 16, false},
+    {REG_WING_RL,           "WingRL",            ptam_type_t::DOUBLE, 16, false},
+    {REG_WING_RR,           "WingRR",            ptam_type_t::DOUBLE, 16, false},
+    {REG_THR,               "THR",               ptam_type_t::DOUBLE, 16, false},
+    {REG_RT_JITTER,         "RTJitter",          ptam_type_t::DOUBLE,  8, false},
+    {REG_RT_OVERRUN,        "RTOverrun",         ptam_type_t::INT,     8, false},
+    {REG_RT_LOAD,           "RTLoad",            ptam_type_t::DOUBLE,  8, false},
+    {REG_HEAP_FREE,         "HeapFree",          ptam_type_t::INT,     8, false},
+    {REG_HEAP_LARGEST,      "HeapLargest",       ptam_type_t::INT,     8, false},
+    {REG_HEAP_MIN,          "HeapMin",           ptam_type_t::INT,     1, false},
+};
+
+constexpr bool ptam_table_in_order() {
+    for (std::size_t i = 0; i < sizeof(PTAM_REGISTER_TABLE) / sizeof(PTAM_REGISTER_TABLE[0]); ++i) {
+        if (PTAM_REGISTER_TABLE[i].reg != i) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static_assert(sizeof(PTAM_REGISTER_TABLE) / sizeof(PTAM_REGISTER_TABLE[0]) == PTAM_REG_COUNT,
+              "PTAM_REGISTER_TABLE must declare every ptam_reg_t");
+static_assert(ptam_table_in_order(), "PTAM_REGISTER_TABLE must be ordered by ptam_reg_t");
+
+//____________________________________________________________
+/* Utillity subroutines -> static history layout
+===========================================================================
+|    Every register owns [offset, offset + depth) of one shared sample pool
+===========================================================================
+*/
+constexpr std::size_t ptam_history_offset(std::size_t reg) {
+    std::size_t offset = 0;
+    for (std::size_t i = 0; i < reg; ++i) {
+        offset += PTAM_REGISTER_TABLE[i].depth;
+    }
+    return offset;
+}
+
+constexpr std::size_t PTAM_HISTORY_TOTAL = ptam_history_offset(PTAM_REG_COUNT);
+
+constexpr std::size_t ptam_max_depth() {
+    std::size_t max = 0;
+    for (const ptam_reg_def_t& def : PTAM_REGISTER_TABLE) {
+        if (def.depth > max) {
+            max = def.depth;
+        }
+    }
+    return max;
+}
+
+constexpr std::size_t PTAM_MAX_DEPTH = ptam_max_depth();
+
+constexpr bool ptam_depths_valid() {
+    for (const ptam_reg_def_t& def : PTAM_REGISTER_TABLE) {
+        if (def.depth == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static_assert(ptam_depths_valid(), "Every PTAM register needs a depth of at least 1");
+
+//____________________________________________________________
+/* Utillity subroutine -> resolve a string ID to its fixed register
+===========================================================================
+|    Designated ID   String ID of the register
+|    Returns         true and sets reg if the ID is a fixed register
+|    constexpr so literal IDs can be resolved at compile time
+===========================================================================
+*/
+constexpr bool ptam_lookup(std::string_view id, ptam_reg_t& reg) {
+    for (const ptam_reg_def_t& def : PTAM_REGISTER_TABLE) {
+        if (id == def.id) {
+            reg = def.reg;
+            return true;
+        }
+    }
+    return false;
+}
+
+//____________________________________________________________
+/* Utillity subroutine -> register set used by PTAM subscriptions
+===========================================================================
+|    e.g. ptam_mask(REG_WING_FL, REG_WING_FR), one bit per ptam_reg_t
+===========================================================================
+*/
+typedef uint32_t ptam_mask_t;
+
+static_assert(PTAM_REG_COUNT <= 32, "ptam_mask_t needs one bit per PTAM register");
+
+template <typename... Regs>
+constexpr ptam_mask_t ptam_mask(Regs... regs) {
+    return (ptam_mask_t(0) | ... | (ptam_mask_t(1) << regs));
+}
+
+constexpr ptam_mask_t ptam_persist_mask() {
+    ptam_mask_t mask = 0;
+    for (const ptam_reg_def_t& def : PTAM_REGISTER_TABLE) {
+        if (def.persist) {
+            mask |= ptam_mask(def.reg);
+        }
+    }
+    return mask;
+}
+
+//NVS keys are the register IDs, limited to 15 characters
+constexpr bool ptam_persist_keys_valid() {
+    for (const ptam_reg_def_t& def : PTAM_REGISTER_TABLE) {
+        if (def.persist && std::string_view(def.id).size() > 15) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static_assert(ptam_persist_keys_valid(), "Persisted PTAM register IDs must fit an NVS key (15 chars)");
+
+#endif // PTAM_REGISTERS_H
@@ -0,0 +1,144 @@
+/*MIT License
+Copyright (c) 2023 limitless Aeronautics
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#ifndef PTAM_RING_H
+#define PTAM_RING_H
+
+#include <cstddef>
+#include <iterator>
+
+//____________________________________________________________
+/* Fixed-capacity ring buffer over caller-provided storage
+===========================================================================
+|    Storage       Array of at least Capacity elements, never reallocated
+|    Capacity      Number of samples kept, older samples are overwritten
+|    Index 0 of at() is the oldest sample still held
+===========================================================================
+*/
+template <typename T>
+class PTAMRing {
+public:
+    PTAMRing() : storage_(nullptr), capacity_(0), head_(0), count_(0) {}
+
+    PTAMRing(T* storage, std::size_t capacity)
+        : storage_(storage), capacity_(capacity), head_(0), count_(0) {}
+
+    void push(const T& item) {
+        storage_[head_] = item;
+        head_ = (head_ + 1) % capacity_;
+        if (count_ < capacity_) {
+            ++count_;
+        }
+    }
+
+    void clear() {
+        head_ = 0;
+        count_ = 0;
+    }
+
+    std::size_t size() const { return count_; }
+    std::size_t capacity() const { return capacity_; }
+    bool empty() const { return count_ == 0; }
+
+    //Oldest -> newest, i < size()
+    const T& at(std::size_t i) const {
+        return storage_[physical(i)];
+    }
+
+    //____________________________________________________________
+    /* Forward iterator, oldest -> newest, reads the storage in place
+    ===========================================================================
+    |    Invalidated by push()/clear(), hold the owner's lock while iterating
+    ===========================================================================
+    */
+    class const_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const T*;
+        using reference = const T&;
+
+        const_iterator() : ring_(nullptr), index_(0), pos_(0) {}
+        const_iterator(const PTAMRing* ring, std::size_t index)
+            : ring_(ring), index_(index), pos_(ring->physical(index)) {}
+
+        reference operator*() const { return ring_->storage_[pos_]; }
+        pointer operator->() const { return &ring_->storage_[pos_]; }
+
+        //Walks the storage and wraps once, no per-step modulo
+        const_iterator& operator++() {
+            ++index_;
+            if (++pos_ == ring_->capacity_) {
+                pos_ = 0;
+            }
+            return *this;
+        }
+        const_iterator operator++(int) {
+            const_iterator prev = *this;
+            ++(*this);
+            return prev;
+        }
+
+        bool operator==(const const_iterator& other) const { return index_ == other.index_ && ring_ == other.ring_; }
+        bool operator!=(const const_iterator& other) const { return !(*this == other); }
+
+    private:
+        const PTAMRing* ring_;
+        std::size_t index_;     //Logical position, 0 = oldest
+        std::size_t pos_;       //Index into storage_
+    };
+
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, count_); }
+
+    //Precondition: !empty()
+    const T& latest() const {
+        return storage_[(head_ + capacity_ - 1) % capacity_];
+    }
+
+    //____________________________________________________________
+    /* Copies the newest n samples into out, oldest first
+    ===========================================================================
+    |    n             Number of samples requested
+    |    out           Destination with room for n samples
+    |    Returns       Number of samples copied (<= size())
+    ===========================================================================
+    */
+    std::size_t window(std::size_t n, T* out) const {
+        if (n > count_) {
+            n = count_;
+        }
+        for (std::size_t i = 0; i < n; ++i) {
+            out[i] = at(count_ - n + i);
+        }
+        return n;
+    }
+
+private:
+    std::size_t physical(std::size_t i) const {
+        return capacity_ == 0 ? 0 : (head_ + capacity_ - count_ + i) % capacity_;
+    }
+
+    T* storage_;
+    std::size_t capacity_;
+    std::size_t head_;
+    std::size_t count_;
+};
+
+#endif // PTAM_RING_H
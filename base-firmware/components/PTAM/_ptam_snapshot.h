@@ -0,0 +1,157 @@
+/*MIT License
+Copyright (c) 2023 limitless Aeronautics
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#ifndef PTAM_SNAPSHOT_H
+#define PTAM_SNAPSHOT_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+//____________________________________________________________
+/* Lock-free single-writer / multi-reader snapshot channel
+===========================================================================
+|    One producer task publishes a whole struct, any number of readers get
+|    a consistent copy without taking a lock.
+|
+|    Double-buffered seqlock: the writer fills the slot readers are NOT
+|    looking at, then flips `current_`. A writer preempted mid-publish
+|    therefore never stalls readers (important when a higher priority
+|    reader shares the core). A read only retries if the writer laps it
+|    twice while it is copying.
+|
+|    Data is stored as relaxed atomic words so the copy is race free under
+|    the C++ memory model on both Xtensa and host builds.
+|    Only one task may call publish().
+===========================================================================
+*/
+template <typename T>
+class PTAMSnapshot {
+    static_assert(std::is_trivially_copyable_v<T>, "PTAMSnapshot needs a trivially copyable struct");
+
+public:
+    PTAMSnapshot() : current_(0) {
+        for (Slot& slot : slots_) {
+            slot.seq.store(0, std::memory_order_relaxed);
+            for (std::atomic<uint32_t>& word : slot.words) {
+                word.store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    //Producer only
+    void publish(const T& data) {
+        uint32_t words[WORDS] = {};
+        std::memcpy(words, &data, sizeof(T));
+
+        const uint32_t next = current_.load(std::memory_order_relaxed) + 1;
+        Slot& slot = slots_[next & 1];
+        const uint32_t seq = slot.seq.load(std::memory_order_relaxed);
+
+        slot.seq.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (std::size_t i = 0; i < WORDS; ++i) {
+            slot.words[i].store(words[i], std::memory_order_relaxed);
+        }
+        slot.seq.store(seq + 2, std::memory_order_release);
+        current_.store(next, std::memory_order_release);
+    }
+
+    //Single attempt, false if the writer overwrote the slot during the copy
+    bool tryRead(T& out) const {
+        const uint32_t current = current_.load(std::memory_order_acquire);
+        const Slot& slot = slots_[current & 1];
+
+        const uint32_t before = slot.seq.load(std::memory_order_acquire);
+        if (before & 1) {
+            return false;
+        }
+        uint32_t words[WORDS];
+        for (std::size_t i = 0; i < WORDS; ++i) {
+            words[i] = slot.words[i].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.seq.load(std::memory_order_relaxed) != before) {
+            return false;
+        }
+        std::memcpy(&out, words, sizeof(T));
+        return true;
+    }
+
+    T read() const {
+        T out;
+        while (!tryRead(out)) {
+        }
+        return out;
+    }
+
+    //Number of publishes so far, 0 = nothing published yet
+    uint32_t version() const {
+        return current_.load(std::memory_order_acquire);
+    }
+
+private:
+    static constexpr std::size_t WORDS = (sizeof(T) + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+
+    struct Slot {
+        std::atomic<uint32_t> seq;
+        std::atomic<uint32_t> words[WORDS];
+    };
+
+    Slot slots_[2];
+    std::atomic<uint32_t> current_;
+};
+
+//____________________________________________________________
+/* Hot register groups published through PTAMSnapshot
+===========================================================================
+|    time_us is the ptam_time_us() of the publish
+===========================================================================
+*/
+struct ptam_attitude_t {
+    double pitch;
+    double roll;
+    double yaw;
+    int64_t time_us;
+};
+
+struct ptam_wings_t {
+    double fl;
+    double fr;
+    double rl;
+    double rr;
+    int64_t time_us;
+};
+
+struct ptam_battery_t {
+    double voltage;
+    double current;
+    double percent;
+    int64_t time_us;
+};
+
+//Position fix, degrees / metres above sea level
+struct ptam_position_t {
+    double lat;
+    double lon;
+    double alt;
+    int64_t time_us;
+};
+
+#endif // PTAM_SNAPSHOT_H
@@ -0,0 +1,156 @@
+/*MIT License
+Copyright (c) 2023 limitless Aeronautics
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#include "_probe.h"
+#include <cstring>
+#include "../PTAM/_ptam_clock.h"
+
+//____________________________________________________________
+/* Main subroutine -> add one duration to the probe
+===========================================================================
+|    ticks           probe_ticks() difference
+===========================================================================
+*/
+void Probe::record(uint32_t ticks) {
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(ticks, std::memory_order_relaxed);
+    buckets_[probe_bucket(ticks)].fetch_add(1, std::memory_order_relaxed);
+
+    //min / max only change while the probe warms up, the loads are the common path
+    uint32_t seen = min_.load(std::memory_order_relaxed);
+    while (ticks < seen && !min_.compare_exchange_weak(seen, ticks, std::memory_order_relaxed)) {
+    }
+    seen = max_.load(std::memory_order_relaxed);
+    while (ticks > seen && !max_.compare_exchange_weak(seen, ticks, std::memory_order_relaxed)) {
+    }
+}
+
+ProbeTable& ProbeTable::getInstance() {
+    static ProbeTable instance;
+    return instance;
+}
+
+void ProbeTable::clear(Probe& probe) {
+    probe.count_.store(0, std::memory_order_relaxed);
+    probe.min_.store(UINT32_MAX, std::memory_order_relaxed);
+    probe.max_.store(0, std::memory_order_relaxed);
+    probe.sum_.store(0, std::memory_order_relaxed);
+    for (std::atomic<uint32_t>& bucket : probe.buckets_) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+Probe* ProbeTable::probe(const char* name) {
+    std::lock_guard<std::mutex> guard(lock_);
+    const std::size_t used = used_.load(std::memory_order_relaxed);
+    for (std::size_t i = 0; i < used; ++i) {
+        if (std::strncmp(probes_[i].name_, name, PROBE_NAME_LEN - 1) == 0) {
+            return &probes_[i];
+        }
+    }
+    if (used == PROBE_MAX) {
+        return nullptr;
+    }
+    Probe& probe = probes_[used];
+    std::strncpy(probe.name_, name, PROBE_NAME_LEN - 1);
+    probe.name_[PROBE_NAME_LEN - 1] = '\0';
+    clear(probe);
+    //Publish after the slot is initialised, snapshot() reads used_ without the lock
+    used_.store(used + 1, std::memory_order_release);
+    return &probe;
+}
+
+probe_stats_t ProbeTable::stats(const Probe& probe, uint32_t ticks_per_us) {
+    probe_stats_t stats = {};
+    stats.name = probe.name_;
+    stats.count = probe.count_.load(std::memory_order_relaxed);
+    if (stats.count == 0) {
+        return stats;
+    }
+    //Ticks -> ns in 64 bit, one tick is at most a few ns
+    auto to_ns = [ticks_per_us](uint64_t ticks) {
+        const uint64_t ns = ticks * 1000 / ticks_per_us;
+        return static_cast<uint32_t>(ns > UINT32_MAX ? UINT32_MAX : ns);
+    };
+    stats.min_ns = to_ns(probe.min_.load(std::memory_order_relaxed));
+    stats.max_ns = to_ns(probe.max_.load(std::memory_order_relaxed));
+    stats.mean_ns = to_ns(probe.sum_.load(std::memory_order_relaxed) / stats.count);
+
+    //Walk up to the bucket holding the 99th percentile sample
+    uint32_t histogram[PROBE_BUCKETS];
+    uint64_t total = 0;
+    for (std::size_t i = 0; i < PROBE_BUCKETS; ++i) {
+        histogram[i] = probe.buckets_[i].load(std::memory_order_relaxed);
+        total += histogram[i];
+    }
+    const uint64_t rank = (total * 99 + 99) / 100;
+    uint64_t seen = 0;
+    for (std::size_t i = 0; i < PROBE_BUCKETS; ++i) {
+        seen += histogram[i];
+        if (seen >= rank) {
+            stats.p99_ns = to_ns(probe_bucket_max(i));
+            break;
+        }
+    }
+    //The bucket bound can overshoot the largest sample
+    if (stats.p99_ns > stats.max_ns) {
+        stats.p99_ns = stats.max_ns;
+    }
+    return stats;
+}
+
+std::size_t ProbeTable::snapshot(probe_stats_t* out, std::size_t max) {
+    const uint32_t ticks_per_us = probe_ticks_per_us();
+    const std::size_t used = used_.load(std::memory_order_acquire);
+    std::size_t n = 0;
+    for (std::size_t i = 0; i < used && n < max; ++i) {
+        out[n++] = stats(probes_[i], ticks_per_us);
+    }
+    return n;
+}
+
+std::size_t ProbeTable::dump(uint8_t* out, std::size_t len) {
+    probe_stats_t stats[PROBE_MAX];
+    const std::size_t n = snapshot(stats, PROBE_MAX);
+
+    PTAMCborWriter cbor(out, len);
+    cbor.map(3);
+    cbor.text("v");
+    cbor.uint(1);
+    cbor.text("t");
+    cbor.integer(ptam_time_us());
+    cbor.text("probes");
+    cbor.array(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        cbor.array(6);
+        cbor.text(stats[i].name);
+        cbor.uint(stats[i].count);
+        cbor.uint(stats[i].min_ns);
+        cbor.uint(stats[i].mean_ns);
+        cbor.uint(stats[i].max_ns);
+        cbor.uint(stats[i].p99_ns);
+    }
+    return cbor.ok() ? cbor.size() : 0;
+}
+
+void ProbeTable::reset() {
+    const std::size_t used = used_.load(std::memory_order_acquire);
+    for (std::size_t i = 0; i < used; ++i) {
+        clear(probes_[i]);
+    }
+}
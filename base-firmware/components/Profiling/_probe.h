@@ -0,0 +1,222 @@
+/*MIT License
+Copyright (c) 2023 limitless Aeronautics
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#ifndef PROBE_H
+#define PROBE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include "_probe_clock.h"
+#include "../PTAM/_ptam_cbor.h"
+
+//Probes compile to nothing with PROBE_ENABLED 0
+#ifndef PROBE_ENABLED
+#define PROBE_ENABLED 1
+#endif
+
+//Size of the probe table, further probe() calls return nullptr
+#define PROBE_MAX 16
+//Maximum length (including terminator) of a probe name
+#define PROBE_NAME_LEN 24
+
+//____________________________________________________________
+/* Log-linear duration histogram layout
+===========================================================================
+|    Ticks 0..3 get a bucket each, above that every power of two is split
+|    into 4 sub-buckets, so a reported percentile is at most 25% high.
+|    Covers the whole 32 bit tick range in 124 buckets.
+===========================================================================
+*/
+constexpr std::size_t PROBE_BUCKETS = 124;
+
+constexpr std::size_t probe_bucket(uint32_t ticks) {
+    if (ticks < 4) {
+        return ticks;
+    }
+    std::size_t octave = 31;
+    while (!(ticks & (uint32_t(1) << octave))) {
+        --octave;
+    }
+    return octave * 4 + ((ticks >> (octave - 2)) & 3) - 4;
+}
+
+//Largest tick count that lands in bucket
+constexpr uint32_t probe_bucket_max(std::size_t bucket) {
+    if (bucket < 4) {
+        return static_cast<uint32_t>(bucket);
+    }
+    const std::size_t octave = (bucket + 4) / 4;
+    const uint64_t sub = (bucket + 4) % 4;
+    return static_cast<uint32_t>(((4 + sub + 1) << (octave - 2)) - 1);
+}
+
+static_assert(probe_bucket(UINT32_MAX) == PROBE_BUCKETS - 1, "PROBE_BUCKETS must cover the tick range");
+static_assert(probe_bucket(probe_bucket_max(57)) == 57 && probe_bucket(probe_bucket_max(57) + 1) == 58,
+              "probe_bucket_max must be the inclusive bucket bound");
+
+//Aggregated durations of one probe, see ProbeTable::snapshot()
+struct probe_stats_t {
+    const char* name;
+    uint32_t count;     //Samples since boot or the last reset()
+    uint32_t min_ns;
+    uint32_t mean_ns;
+    uint32_t max_ns;
+    uint32_t p99_ns;    //Bucket bound, at most 25% above the true p99
+};
+
+//____________________________________________________________
+/* One named probe
+===========================================================================
+|    record() is lock-free (relaxed atomics), any task may record into the
+|    same probe. Not for ISRs. Fields are read one by one, a snapshot taken
+|    while samples arrive can be off by the samples in flight.
+===========================================================================
+*/
+class Probe {
+public:
+    void record(uint32_t ticks);
+
+    const char* name() const { return name_; }
+
+private:
+    friend class ProbeTable;
+
+    char name_[PROBE_NAME_LEN];
+    std::atomic<uint32_t> count_;
+    std::atomic<uint32_t> min_;
+    std::atomic<uint32_t> max_;
+    std::atomic<uint64_t> sum_;
+    std::atomic<uint32_t> buckets_[PROBE_BUCKETS];
+};
+
+//____________________________________________________________
+/* Scoped timer -> records the lifetime of the scope into a probe
+===========================================================================
+|    A null probe (table full or PROBE_ENABLED 0) makes it a no-op.
+|    stop() records early, e.g. before the main loop goes to sleep.
+===========================================================================
+*/
+class ProbeScope {
+public:
+    explicit ProbeScope(Probe* probe) : probe_(probe), start_(probe ? probe_ticks() : 0) {}
+    ~ProbeScope() { stop(); }
+
+    ProbeScope(const ProbeScope&) = delete;
+    ProbeScope& operator=(const ProbeScope&) = delete;
+
+    void stop() {
+        if (probe_) {
+            probe_->record(probe_ticks() - start_);
+            probe_ = nullptr;
+        }
+    }
+
+private:
+    Probe* probe_;
+    uint32_t start_;
+};
+
+//____________________________________________________________
+/* Upper bound of ProbeTable::dump() output
+===========================================================================
+|    {"v": 1, "t": now_us, "probes": [[name, count, min_ns, mean_ns,
+|     max_ns, p99_ns], ...]}
+===========================================================================
+*/
+constexpr std::size_t PROBE_DUMP_MAX_BYTES = 1 + 2 + 1 + 2 + 9 + 7 + PTAMCborWriter::headSize(PROBE_MAX)
+                                           + PROBE_MAX * (1 + PTAMCborWriter::headSize(PROBE_NAME_LEN)
+                                                          + PROBE_NAME_LEN + 5 * 5);
+
+//____________________________________________________________
+/* Fixed table of named probes
+===========================================================================
+|    Probes are allocated on first use and live for the whole run, no heap.
+|    Lookup by name takes a mutex, so call sites resolve their probe once
+|    (PROBE_SCOPE caches it in a function static).
+===========================================================================
+*/
+class ProbeTable {
+public:
+    static ProbeTable& getInstance();
+
+    //____________________________________________________________
+    /* Main subroutine -> find or allocate a probe
+    ===========================================================================
+    |    name            Probe name, truncated to PROBE_NAME_LEN - 1
+    |    Returns         The probe, nullptr once PROBE_MAX probes exist
+    ===========================================================================
+    */
+    Probe* probe(const char* name);
+
+    //____________________________________________________________
+    /* Main subroutine -> aggregate every allocated probe
+    ===========================================================================
+    |    out / max       Caller array, returns the number of probes written
+    |    Probes that never recorded report count 0 and zero durations
+    ===========================================================================
+    */
+    std::size_t snapshot(probe_stats_t* out, std::size_t max);
+
+    //____________________________________________________________
+    /* Main subroutine -> CBOR encode snapshot(), see PROBE_DUMP_MAX_BYTES
+    ===========================================================================
+    |    out / len       Caller buffer
+    |    Returns         Bytes written, 0 if the buffer is too small
+    ===========================================================================
+    */
+    std::size_t dump(uint8_t* out, std::size_t len);
+
+    //Clears the statistics, probes stay allocated
+    void reset();
+
+    std::size_t size() const { return used_.load(std::memory_order_acquire); }
+
+private:
+    ProbeTable() : used_(0) {}
+
+    static void clear(Probe& probe);
+    static probe_stats_t stats(const Probe& probe, uint32_t ticks_per_us);
+
+    Probe probes_[PROBE_MAX];
+    std::atomic<std::size_t> used_;
+    std::mutex lock_;
+};
+
+//____________________________________________________________
+/* Probe macros
+===========================================================================
+|    PROBE_SCOPE("name")             times the rest of the enclosing scope
+|    PROBE_SCOPE_AS(var, "name")     same, named so var.stop() can end it early
+===========================================================================
+*/
+#define PROBE_CONCAT_(a, b) a##b
+#define PROBE_CONCAT(a, b) PROBE_CONCAT_(a, b)
+
+#if PROBE_ENABLED
+#define PROBE_SCOPE_AS(var, name) \
+    static Probe* const PROBE_CONCAT(var, _probe) = ProbeTable::getInstance().probe(name); \
+    ProbeScope var(PROBE_CONCAT(var, _probe))
+#else
+#define PROBE_SCOPE_AS(var, name) ProbeScope var(nullptr)
+#endif
+
+#define PROBE_SCOPE(name) PROBE_SCOPE_AS(PROBE_CONCAT(probe_scope_, __LINE__), name)
+
+#endif // PROBE_H
@@ -0,0 +1,59 @@
+/*MIT License
+Copyright (c) 2023 limitless Aeronautics
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#ifndef PROBE_CLOCK_H
+#define PROBE_CLOCK_H
+
+#include <cstdint>
+
+#ifdef ESP_PLATFORM
+#include "esp_cpu.h"
+#include "esp_rom_sys.h"
+#else
+#include <chrono>
+#endif
+
+//____________________________________________________________
+/* Utillity subroutine -> raw tick counter used by the probes
+===========================================================================
+|    Returns         CPU cycle count (CCOUNT) on target, steady_clock
+|                    nanoseconds on host builds. 32 bit and free running,
+|                    only differences of two reads are meaningful.
+|    CCOUNT is per core: a scope must start and stop on the same core, so
+|    probe pinned tasks (see os_config.h) or scopes that cannot migrate.
+===========================================================================
+*/
+inline uint32_t probe_ticks() {
+#ifdef ESP_PLATFORM
+    return static_cast<uint32_t>(esp_cpu_get_cycle_count());
+#else
+    return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+//Ticks per microsecond of probe_ticks()
+inline uint32_t probe_ticks_per_us() {
+#ifdef ESP_PLATFORM
+    return esp_rom_get_cpu_ticks_per_us();
+#else
+    return 1000;
+#endif
+}
+
+#endif // PROBE_CLOCK_H
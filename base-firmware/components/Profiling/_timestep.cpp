@@ -0,0 +1,158 @@
+/*MIT License
+Copyright (c) 2023 limitless Aeronautics
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#include "_timestep.h"
+#include <cstring>
+
+TimeStep::TimeStep(const char* name, uint32_t nominal_us, timestep_clock_t clock) {
+    configure(name, nominal_us, clock);
+}
+
+void TimeStep::configure(const char* name, uint32_t nominal_us, timestep_clock_t clock) {
+    std::strncpy(name_, name, TIMESTEP_NAME_LEN - 1);
+    name_[TIMESTEP_NAME_LEN - 1] = '\0';
+    nominal_us_ = nominal_us;
+    clock_ = clock;
+    last_us_ = -1;
+    resetStats();
+}
+
+double TimeStep::tick(int64_t now_us) {
+    const int64_t last = last_us_;
+    last_us_ = now_us;
+    if (last < 0) {
+        return nominal();
+    }
+    const int64_t elapsed = now_us > last ? now_us - last : 0;
+    const uint32_t interval = static_cast<uint32_t>(elapsed > UINT32_MAX ? UINT32_MAX : elapsed);
+    const uint32_t jitter = interval > nominal_us_ ? interval - nominal_us_ : nominal_us_ - interval;
+
+    //Single writer, plain compares are enough
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(interval, std::memory_order_relaxed);
+    jitterSum_.fetch_add(jitter, std::memory_order_relaxed);
+    if (interval < min_.load(std::memory_order_relaxed)) {
+        min_.store(interval, std::memory_order_relaxed);
+    }
+    if (interval > max_.load(std::memory_order_relaxed)) {
+        max_.store(interval, std::memory_order_relaxed);
+    }
+    if (jitter > jitterMax_.load(std::memory_order_relaxed)) {
+        jitterMax_.store(jitter, std::memory_order_relaxed);
+    }
+
+    const uint64_t cap = uint64_t(nominal_us_) * TIMESTEP_STALL_RATIO;
+    if (nominal_us_ > 0 && uint64_t(interval) > cap) {
+        capped_.fetch_add(1, std::memory_order_relaxed);
+        return cap / 1e6;
+    }
+    return interval / 1e6;
+}
+
+timestep_stats_t TimeStep::stats() const {
+    timestep_stats_t stats = {};
+    stats.name = name_;
+    stats.nominal_us = nominal_us_;
+    stats.count = count_.load(std::memory_order_relaxed);
+    if (stats.count == 0) {
+        return stats;
+    }
+    stats.min_us = min_.load(std::memory_order_relaxed);
+    stats.max_us = max_.load(std::memory_order_relaxed);
+    stats.mean_us = static_cast<uint32_t>(sum_.load(std::memory_order_relaxed) / stats.count);
+    stats.jitter_mean_us = static_cast<uint32_t>(jitterSum_.load(std::memory_order_relaxed) / stats.count);
+    stats.jitter_max_us = jitterMax_.load(std::memory_order_relaxed);
+    stats.capped = capped_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void TimeStep::resetStats() {
+    count_.store(0, std::memory_order_relaxed);
+    min_.store(UINT32_MAX, std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
+    sum_.store(0, std::memory_order_relaxed);
+    jitterSum_.store(0, std::memory_order_relaxed);
+    jitterMax_.store(0, std::memory_order_relaxed);
+    capped_.store(0, std::memory_order_relaxed);
+}
+
+TimeStepTable& TimeStepTable::getInstance() {
+    static TimeStepTable instance;
+    return instance;
+}
+
+TimeStep* TimeStepTable::timestep(const char* name, uint32_t nominal_us) {
+    std::lock_guard<std::mutex> guard(lock_);
+    const std::size_t used = used_.load(std::memory_order_relaxed);
+    for (std::size_t i = 0; i < used; ++i) {
+        if (std::strncmp(steps_[i].name(), name, TIMESTEP_NAME_LEN - 1) == 0) {
+            return &steps_[i];
+        }
+    }
+    if (used == TIMESTEP_MAX) {
+        return nullptr;
+    }
+    TimeStep& step = steps_[used];
+    step.configure(name, nominal_us);
+    //Publish after the slot is initialised, snapshot() reads used_ without the lock
+    used_.store(used + 1, std::memory_order_release);
+    return &step;
+}
+
+std::size_t TimeStepTable::snapshot(timestep_stats_t* out, std::size_t max) const {
+    const std::size_t used = used_.load(std::memory_order_acquire);
+    std::size_t n = 0;
+    for (std::size_t i = 0; i < used && n < max; ++i) {
+        out[n++] = steps_[i].stats();
+    }
+    return n;
+}
+
+std::size_t TimeStepTable::dump(uint8_t* out, std::size_t len) const {
+    timestep_stats_t stats[TIMESTEP_MAX];
+    const std::size_t n = snapshot(stats, TIMESTEP_MAX);
+
+    PTAMCborWriter cbor(out, len);
+    cbor.map(3);
+    cbor.text("v");
+    cbor.uint(1);
+    cbor.text("t");
+    cbor.integer(ptam_time_us());
+    cbor.text("steps");
+    cbor.array(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        cbor.array(9);
+        cbor.text(stats[i].name);
+        cbor.uint(stats[i].nominal_us);
+        cbor.uint(stats[i].count);
+        cbor.uint(stats[i].min_us);
+        cbor.uint(stats[i].mean_us);
+        cbor.uint(stats[i].max_us);
+        cbor.uint(stats[i].jitter_mean_us);
+        cbor.uint(stats[i].jitter_max_us);
+        cbor.uint(stats[i].capped);
+    }
+    return cbor.ok() ? cbor.size() : 0;
+}
+
+void TimeStepTable::resetStats() {
+    const std::size_t used = used_.load(std::memory_order_acquire);
+    for (std::size_t i = 0; i < used; ++i) {
+        steps_[i].resetStats();
+    }
+}
@@ -0,0 +1,163 @@
+/*MIT License
+Copyright (c) 2023 limitless Aeronautics
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#ifndef TIMESTEP_H
+#define TIMESTEP_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include "../PTAM/_ptam_clock.h"
+#include "../PTAM/_ptam_cbor.h"
+
+//Size of the time-step table, further timestep() calls return nullptr
+#define TIMESTEP_MAX 8
+//Maximum length (including terminator) of a time-step name
+#define TIMESTEP_NAME_LEN 24
+//Intervals longer than nominal * TIMESTEP_STALL_RATIO are capped there
+#define TIMESTEP_STALL_RATIO 4
+
+typedef int64_t (*timestep_clock_t)();
+
+//Measured intervals of one time step, see TimeStep::stats()
+struct timestep_stats_t {
+    const char* name;
+    uint32_t nominal_us;
+    uint32_t count;             //Intervals measured (the first tick has none)
+    uint32_t min_us;
+    uint32_t mean_us;
+    uint32_t max_us;
+    uint32_t jitter_mean_us;    //Mean |interval - nominal|
+    uint32_t jitter_max_us;
+    uint32_t capped;            //Intervals returned as the stall cap instead
+};
+
+//____________________________________________________________
+/* Monotonic time-step service
+===========================================================================
+|    Every integrator and differentiator asks its TimeStep for the real
+|    interval since its previous sample instead of assuming a rate:
+|    tick() reads the monotonic clock (esp_timer on target) and returns
+|    the elapsed seconds.
+|    - The first tick after construction or restart() has no previous
+|      sample and returns the nominal interval.
+|    - A stall (paused loop, state change) is capped at
+|      TIMESTEP_STALL_RATIO * nominal so one late sample cannot dump
+|      seconds into an integrator. Capped ticks are counted.
+|    - Back-to-back calls return ~0, callers treat dt <= 0 as "hold".
+|    One task ticks a TimeStep; stats() may be read from any task, the
+|    fields are relaxed atomics like the probes'.
+===========================================================================
+*/
+class TimeStep {
+public:
+    TimeStep() : TimeStep("", 0) {}
+    TimeStep(const char* name, uint32_t nominal_us, timestep_clock_t clock = ptam_time_us);
+
+    TimeStep(const TimeStep&) = delete;
+    TimeStep& operator=(const TimeStep&) = delete;
+
+    //____________________________________________________________
+    /* Main subroutine -> interval since the previous tick
+    ===========================================================================
+    |    now_us          Timestamp the caller already took (tick() reads
+    |                    the clock itself)
+    |    Returns         Seconds, nominal on the first tick, capped on a stall
+    ===========================================================================
+    */
+    double tick(int64_t now_us);
+    double tick() { return tick(clock_()); }
+
+    //Forget the previous sample, e.g. when a loop resumes after a pause
+    void restart() { last_us_ = -1; }
+
+    //(Re)name and rate a time step owned by another object, clears it
+    void configure(const char* name, uint32_t nominal_us, timestep_clock_t clock = ptam_time_us);
+
+    double nominal() const { return nominal_us_ / 1e6; }
+    const char* name() const { return name_; }
+
+    timestep_stats_t stats() const;
+    void resetStats();
+
+private:
+    char name_[TIMESTEP_NAME_LEN];
+    uint32_t nominal_us_;
+    timestep_clock_t clock_;
+    int64_t last_us_;                   //Owner task only, -1 before the first tick
+    std::atomic<uint32_t> count_;
+    std::atomic<uint32_t> min_;
+    std::atomic<uint32_t> max_;
+    std::atomic<uint64_t> sum_;
+    std::atomic<uint64_t> jitterSum_;
+    std::atomic<uint32_t> jitterMax_;
+    std::atomic<uint32_t> capped_;
+};
+
+//____________________________________________________________
+/* Upper bound of TimeStepTable::dump() output
+===========================================================================
+|    {"v": 1, "t": now_us, "steps": [[name, nominal_us, count, min_us,
+|     mean_us, max_us, jitter_mean_us, jitter_max_us, capped], ...]}
+===========================================================================
+*/
+constexpr std::size_t TIMESTEP_DUMP_MAX_BYTES = 1 + 2 + 1 + 2 + 9 + 6 + PTAMCborWriter::headSize(TIMESTEP_MAX)
+                                              + TIMESTEP_MAX * (1 + PTAMCborWriter::headSize(TIMESTEP_NAME_LEN)
+                                                                + TIMESTEP_NAME_LEN + 8 * 5);
+
+//____________________________________________________________
+/* Fixed table of the firmware's named time steps
+===========================================================================
+|    Allocated on first use and kept for the whole run, no heap. Lookup
+|    takes a mutex, call sites resolve their time step once (a function
+|    static). Tests construct standalone TimeSteps with their own clock.
+===========================================================================
+*/
+class TimeStepTable {
+public:
+    static TimeStepTable& getInstance();
+
+    //____________________________________________________________
+    /* Main subroutine -> find or allocate a time step
+    ===========================================================================
+    |    name            Truncated to TIMESTEP_NAME_LEN - 1
+    |    nominal_us      Expected interval, only used on allocation
+    |    Returns         The time step, nullptr once TIMESTEP_MAX exist
+    ===========================================================================
+    */
+    TimeStep* timestep(const char* name, uint32_t nominal_us);
+
+    std::size_t snapshot(timestep_stats_t* out, std::size_t max) const;
+
+    //CBOR encode snapshot(), see TIMESTEP_DUMP_MAX_BYTES; 0 if len is too small
+    std::size_t dump(uint8_t* out, std::size_t len) const;
+
+    void resetStats();
+
+    std::size_t size() const { return used_.load(std::memory_order_acquire); }
+
+private:
+    TimeStepTable() : used_(0) {}
+
+    TimeStep steps_[TIMESTEP_MAX];
+    std::atomic<std::size_t> used_;
+    std::mutex lock_;
+};
+
+#endif // TIMESTEP_H
@@ -0,0 +1,123 @@
+/*MIT License
+Copyright (c) 2023 limitless Aeronautics
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#include "_flight_fsm.h"
+#include "../PTAM/_ptam.h"
+#include "esp_log.h"
+
+static const char *TAG = "FSM";
+
+const fsm_state_def_t FlightStateMachine::STATES[] = {
+    {FLIGHT_PREP,   "PREP",   enterPrep,   exitPrep  },
+    {FLIGHT_ARMED,  "ARMED",  enterArmed,  exitArmed },
+    {FLIGHT_BYPASS, "BYPASS", enterBypass, exitBypass},
+    {FLIGHT_ABORT,  "ABORT",  enterAbort,  exitAbort },
+};
+
+//First match wins, so the specific rows sit above the FSM_ANY ones
+const fsm_transition_t FlightStateMachine::TRANSITIONS[] = {
+    //Battery
+    {FLIGHT_ARMED,  EVT_LOW_BATTERY, nullptr,   FLIGHT_ABORT,  markBatteryLow},
+    {FSM_ANY,       EVT_LOW_BATTERY, nullptr,   FSM_INTERNAL,  markBatteryLow},
+    {FSM_ANY,       EVT_BATTERY_OK,  nullptr,   FSM_INTERNAL,  markBatteryOk },
+    //Abort latches until an operator PREP request
+    {FLIGHT_ABORT,  EVT_ABORT,       nullptr,   FSM_INTERNAL,  nullptr       },
+    {FSM_ANY,       EVT_ABORT,       nullptr,   FLIGHT_ABORT,  nullptr       },
+    {FLIGHT_ABORT,  EVT_REQ_PREP,    nullptr,   FLIGHT_PREP,   nullptr       },
+    //PREP
+    {FLIGHT_PREP,   EVT_REQ_ARMED,   batteryOk, FLIGHT_ARMED,  nullptr       },
+    {FLIGHT_PREP,   EVT_AUTH_OK,     batteryOk, FLIGHT_ARMED,  nullptr       },
+    {FLIGHT_PREP,   EVT_REQ_BYPASS,  nullptr,   FLIGHT_BYPASS, nullptr       },
+    //ARMED
+    {FLIGHT_ARMED,  EVT_REQ_PREP,    nullptr,   FLIGHT_PREP,   nullptr       },
+    {FLIGHT_ARMED,  EVT_REQ_BYPASS,  nullptr,   FLIGHT_BYPASS, nullptr       },
+    //BYPASS
+    {FLIGHT_BYPASS, EVT_REQ_PREP,    nullptr,   FLIGHT_PREP,   nullptr       },
+    {FLIGHT_BYPASS, EVT_REQ_ARMED,   batteryOk, FLIGHT_ARMED,  nullptr       },
+    {FLIGHT_BYPASS, EVT_AUTH_OK,     batteryOk, FLIGHT_ARMED,  nullptr       },
+};
+
+FlightStateMachine& FlightStateMachine::getInstance() {
+    static FlightStateMachine instance;
+    return instance;
+}
+
+FlightStateMachine::FlightStateMachine(fsm_clock_t clock)
+    : engine_(STATES, sizeof(STATES) / sizeof(STATES[0]),
+              TRANSITIONS, sizeof(TRANSITIONS) / sizeof(TRANSITIONS[0]),
+              FLIGHT_PREP, this, clock),
+      batteryLow_(false), batteryLowSeen_(false), entryHooks_(), exitHooks_() {}
+
+void FlightStateMachine::batteryLevel(double percent) {
+    if (!batteryLowSeen_ && percent < FLIGHT_BATTERY_LOW_PCT) {
+        batteryLowSeen_ = true;
+        post(EVT_LOW_BATTERY);
+    } else if (batteryLowSeen_ && percent > FLIGHT_BATTERY_OK_PCT) {
+        batteryLowSeen_ = false;
+        post(EVT_BATTERY_OK);
+    }
+}
+
+void FlightStateMachine::onEntry(flight_state_t state, fsm_action_t hook, void* ctx) {
+    entryHooks_[state] = {hook, ctx};
+}
+
+void FlightStateMachine::onExit(flight_state_t state, fsm_action_t hook, void* ctx) {
+    exitHooks_[state] = {hook, ctx};
+}
+
+//____________________________________________________________
+/* Entry action of every state
+===========================================================================
+|    Mirrors the state into PTAM for the web UI and logger, then runs the
+|    state's hook
+===========================================================================
+*/
+void FlightStateMachine::enter(void* ctx, flight_state_t state) {
+    FlightStateMachine* self = static_cast<FlightStateMachine*>(ctx);
+    SharedMemory& sharedMemory = SharedMemory::getInstance();
+    sharedMemory.storeInt(REG_STATE, state);
+    sharedMemory.storeString(REG_STATE_DESCRIPT, self->engine_.name(state));
+    ESP_LOGI(TAG, "Entered %s", self->engine_.name(state));
+
+    const hook_t& hook = self->entryHooks_[state];
+    if (hook.fn) {
+        hook.fn(hook.ctx);
+    }
+}
+
+void FlightStateMachine::leave(void* ctx, flight_state_t state) {
+    FlightStateMachine* self = static_cast<FlightStateMachine*>(ctx);
+    const hook_t& hook = self->exitHooks_[state];
+    if (hook.fn) {
+        hook.fn(hook.ctx);
+    }
+}
+
+bool FlightStateMachine::batteryOk(void* ctx) {
+    return !static_cast<FlightStateMachine*>(ctx)->batteryLow();
+}
+
+void FlightStateMachine::markBatteryLow(void* ctx) {
+    static_cast<FlightStateMachine*>(ctx)->batteryLow_.store(true, std::memory_order_relaxed);
+    ESP_LOGW(TAG, "Battery low, arming refused");
+}
+
+void FlightStateMachine::markBatteryOk(void* ctx) {
+    static_cast<FlightStateMachine*>(ctx)->batteryLow_.store(false, std::memory_order_relaxed);
+}
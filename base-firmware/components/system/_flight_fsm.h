@@ -0,0 +1,122 @@
+/*MIT License
+Copyright (c) 2023 limitless Aeronautics
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#ifndef FLIGHT_FSM_H
+#define FLIGHT_FSM_H
+
+#include <atomic>
+#include "_fsm.h"
+
+//Battery hysteresis (percent), below LOW posts EVT_LOW_BATTERY, above OK posts EVT_BATTERY_OK
+#define FLIGHT_BATTERY_LOW_PCT  15.0
+#define FLIGHT_BATTERY_OK_PCT   20.0
+
+//Values match REG_STATE and the web UI state codes
+enum flight_state_t : fsm_state_id_t {
+    FLIGHT_PREP = 1,
+    FLIGHT_ARMED = 2,
+    FLIGHT_BYPASS = 3,
+    FLIGHT_ABORT = 4
+};
+
+enum flight_event_t : fsm_event_id_t {
+    EVT_REQ_PREP,       //Web UI state change
+    EVT_REQ_ARMED,
+    EVT_REQ_BYPASS,
+    EVT_AUTH_OK,        //Arm token matched (/INC_AUTH)
+    EVT_ABORT,
+    EVT_LOW_BATTERY,
+    EVT_BATTERY_OK
+};
+
+//____________________________________________________________
+/* MARS flight state machine
+===========================================================================
+|    PREP   -> ARMED    REQ_ARMED / AUTH_OK, refused while the battery is low
+|    PREP   -> BYPASS   REQ_BYPASS
+|    ARMED  -> PREP / BYPASS
+|    BYPASS -> PREP / ARMED (same guard)
+|    any    -> ABORT    ABORT, or LOW_BATTERY while ARMED
+|    ABORT  -> PREP     REQ_PREP (operator reset), every other request ignored
+|
+|    Entry publishes the state to REG_STATE / REG_STATE_DESCRIPT, then runs
+|    the hook set with onEntry() (e.g. reset the control loop on ARMED).
+===========================================================================
+*/
+class FlightStateMachine {
+public:
+    static FlightStateMachine& getInstance();
+
+    explicit FlightStateMachine(fsm_clock_t clock = ptam_time_us);
+
+    FSMEngine& engine() { return engine_; }
+
+    void start() { engine_.start(); }
+    bool post(flight_event_t event) { return engine_.post(event); }
+    std::size_t dispatch() { return engine_.dispatch(); }
+    flight_state_t state() const { return static_cast<flight_state_t>(engine_.state()); }
+
+    //____________________________________________________________
+    /* Main subroutine -> feed a battery reading
+    ===========================================================================
+    |    percent         Battery charge, posts LOW / OK on hysteresis edges only
+    |    Call from one task (the monitor task)
+    ===========================================================================
+    */
+    void batteryLevel(double percent);
+    bool batteryLow() const { return batteryLow_.load(std::memory_order_relaxed); }
+
+    //Extra entry / exit work per state, run on the dispatching task
+    void onEntry(flight_state_t state, fsm_action_t hook, void* ctx);
+    void onExit(flight_state_t state, fsm_action_t hook, void* ctx);
+
+private:
+    static constexpr std::size_t HOOKS = FLIGHT_ABORT + 1;
+
+    struct hook_t {
+        fsm_action_t fn;
+        void* ctx;
+    };
+
+    static const fsm_state_def_t STATES[];
+    static const fsm_transition_t TRANSITIONS[];
+
+    static void enter(void* ctx, flight_state_t state);
+    static void leave(void* ctx, flight_state_t state);
+    static void enterPrep(void* ctx) { enter(ctx, FLIGHT_PREP); }
+    static void enterArmed(void* ctx) { enter(ctx, FLIGHT_ARMED); }
+    static void enterBypass(void* ctx) { enter(ctx, FLIGHT_BYPASS); }
+    static void enterAbort(void* ctx) { enter(ctx, FLIGHT_ABORT); }
+    static void exitArmed(void* ctx) { leave(ctx, FLIGHT_ARMED); }
+    static void exitBypass(void* ctx) { leave(ctx, FLIGHT_BYPASS); }
+    static void exitAbort(void* ctx) { leave(ctx, FLIGHT_ABORT); }
+    static void exitPrep(void* ctx) { leave(ctx, FLIGHT_PREP); }
+
+    static bool batteryOk(void* ctx);
+    static void markBatteryLow(void* ctx);
+    static void markBatteryOk(void* ctx);
+
+    FSMEngine engine_;
+    std::atomic<bool> batteryLow_;
+    //Last edge posted by batteryLevel(), the flag itself changes on dispatch
+    bool batteryLowSeen_;
+    hook_t entryHooks_[HOOKS];
+    hook_t exitHooks_[HOOKS];
+};
+
+#endif // FLIGHT_FSM_H
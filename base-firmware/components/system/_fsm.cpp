@@ -0,0 +1,174 @@
+/*MIT License
+Copyright (c) 2023 limitless Aeronautics
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#include "_fsm.h"
+
+FSMEngine::FSMEngine(const fsm_state_def_t* states, std::size_t stateCount,
+                     const fsm_transition_t* transitions, std::size_t transitionCount,
+                     fsm_state_id_t initial, void* ctx, fsm_clock_t clock)
+    : states_(states), stateCount_(stateCount),
+      transitions_(transitions), transitionCount_(transitionCount),
+      ctx_(ctx), clock_(clock), current_(initial),
+      queue_(), head_(0), count_(0), notifier_(nullptr), notifyBits_(0), stats_() {}
+
+void FSMEngine::start() {
+    const fsm_state_def_t* def = find(current_);
+    if (def && def->on_entry) {
+        def->on_entry(ctx_);
+    }
+}
+
+bool FSMEngine::post(fsm_event_id_t event) {
+    PTAMNotifier* notifier;
+    uint32_t bits;
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        if (count_ == FSM_QUEUE_LEN) {
+            stats_.dropped++;
+            return false;
+        }
+        queue_[(head_ + count_) % FSM_QUEUE_LEN] = {event, clock_()};
+        count_++;
+        notifier = notifier_;
+        bits = notifyBits_;
+    }
+    //Outside the lock, the owner may already be waking up
+    if (notifier) {
+        notifier->notify(bits);
+    }
+    return true;
+}
+
+bool FSMEngine::pop(queued_t& out) {
+    std::lock_guard<std::mutex> guard(lock_);
+    if (count_ == 0) {
+        return false;
+    }
+    out = queue_[head_];
+    head_ = (head_ + 1) % FSM_QUEUE_LEN;
+    count_--;
+    return true;
+}
+
+std::size_t FSMEngine::dispatch() {
+    const uint32_t before = stats().transitions;
+    queued_t queued;
+    while (pop(queued)) {
+        handle(queued);
+    }
+    return stats().transitions - before;
+}
+
+//____________________________________________________________
+/* Main subroutine -> run one event through the transition table
+===========================================================================
+|    queued          Event and its post() time
+|    Actions run without the queue lock so they may post() follow-ups
+===========================================================================
+*/
+void FSMEngine::handle(const queued_t& queued) {
+    const fsm_state_id_t from = current_;
+    const fsm_transition_t* row = nullptr;
+    for (std::size_t i = 0; i < transitionCount_; ++i) {
+        const fsm_transition_t& t = transitions_[i];
+        if ((t.from == from || t.from == FSM_ANY) && t.event == queued.event &&
+            (!t.guard || t.guard(ctx_))) {
+            row = &t;
+            break;
+        }
+    }
+
+    if (!row) {
+        std::lock_guard<std::mutex> guard(lock_);
+        stats_.dispatched++;
+        stats_.rejected++;
+        return;
+    }
+
+    if (row->to == FSM_INTERNAL) {
+        if (row->action) {
+            row->action(ctx_);
+        }
+        std::lock_guard<std::mutex> guard(lock_);
+        stats_.dispatched++;
+        return;
+    }
+
+    const fsm_state_def_t* exitDef = find(from);
+    if (exitDef && exitDef->on_exit) {
+        exitDef->on_exit(ctx_);
+    }
+    if (row->action) {
+        row->action(ctx_);
+    }
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        current_ = row->to;
+    }
+    const fsm_state_def_t* entryDef = find(row->to);
+    if (entryDef && entryDef->on_entry) {
+        entryDef->on_entry(ctx_);
+    }
+
+    const int64_t latency = clock_() - queued.posted_us;
+    std::lock_guard<std::mutex> guard(lock_);
+    stats_.dispatched++;
+    stats_.transitions++;
+    stats_.last_latency_us = latency;
+    if (latency > stats_.worst_latency_us) {
+        stats_.worst_latency_us = latency;
+        stats_.worst_event = queued.event;
+        stats_.worst_from = from;
+        stats_.worst_to = row->to;
+    }
+}
+
+const fsm_state_def_t* FSMEngine::find(fsm_state_id_t state) const {
+    for (std::size_t i = 0; i < stateCount_; ++i) {
+        if (states_[i].state == state) {
+            return &states_[i];
+        }
+    }
+    return nullptr;
+}
+
+void FSMEngine::attach(PTAMNotifier* notifier, uint32_t bits) {
+    std::lock_guard<std::mutex> guard(lock_);
+    notifier_ = notifier;
+    notifyBits_ = bits;
+}
+
+fsm_state_id_t FSMEngine::state() const {
+    std::lock_guard<std::mutex> guard(lock_);
+    return current_;
+}
+
+const char* FSMEngine::name(fsm_state_id_t state) const {
+    const fsm_state_def_t* def = find(state);
+    return def ? def->name : "UNKNOWN";
+}
+
+fsm_stats_t FSMEngine::stats() const {
+    std::lock_guard<std::mutex> guard(lock_);
+    return stats_;
+}
+
+void FSMEngine::resetStats() {
+    std::lock_guard<std::mutex> guard(lock_);
+    stats_ = fsm_stats_t();
+}
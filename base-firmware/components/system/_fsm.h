@@ -0,0 +1,152 @@
+/*MIT License
+Copyright (c) 2023 limitless Aeronautics
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#ifndef FSM_H
+#define FSM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include "../PTAM/_ptam_clock.h"
+#include "../PTAM/_ptam_notify.h"
+
+//Events queued between dispatch() calls, further post() calls are dropped
+#define FSM_QUEUE_LEN 16
+//Transition row matching every source state
+#define FSM_ANY 0xff
+//Transition target that runs the action only, no exit / entry
+#define FSM_INTERNAL 0xfe
+
+typedef uint8_t fsm_state_id_t;
+typedef uint8_t fsm_event_id_t;
+
+typedef bool (*fsm_guard_t)(void* ctx);
+typedef void (*fsm_action_t)(void* ctx);
+//Microsecond clock, injectable so host tests run on a deterministic time base
+typedef int64_t (*fsm_clock_t)();
+
+struct fsm_state_def_t {
+    fsm_state_id_t state;
+    const char* name;
+    fsm_action_t on_entry;      //nullptr = none
+    fsm_action_t on_exit;       //nullptr = none
+};
+
+struct fsm_transition_t {
+    fsm_state_id_t from;        //or FSM_ANY
+    fsm_event_id_t event;
+    fsm_guard_t guard;          //nullptr = always taken
+    fsm_state_id_t to;          //or FSM_INTERNAL
+    fsm_action_t action;        //Runs between exit and entry, nullptr = none
+};
+
+//Counters and latencies of one engine, see FSMEngine::stats()
+struct fsm_stats_t {
+    uint32_t dispatched;        //Events handled
+    uint32_t transitions;       //State changes (internal rows not counted)
+    uint32_t rejected;          //No row matched or every guard refused
+    uint32_t dropped;           //post() with a full queue
+    int64_t last_latency_us;    //post() -> entry action done, last state change
+    int64_t worst_latency_us;   //Same, worst since start() / resetStats()
+    fsm_event_id_t worst_event;
+    fsm_state_id_t worst_from;
+    fsm_state_id_t worst_to;
+};
+
+//____________________________________________________________
+/* Table-driven, allocation-free state machine
+===========================================================================
+|    States and transitions are static tables owned by the caller. The
+|    first row matching (state or FSM_ANY, event) whose guard passes is
+|    taken: exit(old) -> action -> entry(new).
+|
+|    post() may be called from any task (it only queues the event and
+|    wakes the owner through an optional PTAMNotifier). dispatch() runs
+|    the queued events in order and must be called by one task only, the
+|    one that owns the actuators. Latency is measured from post() to the
+|    end of the entry action with the engine clock.
+===========================================================================
+*/
+class FSMEngine {
+public:
+    FSMEngine(const fsm_state_def_t* states, std::size_t stateCount,
+              const fsm_transition_t* transitions, std::size_t transitionCount,
+              fsm_state_id_t initial, void* ctx, fsm_clock_t clock = ptam_time_us);
+
+    //____________________________________________________________
+    /* Main subroutine -> enter the initial state (runs its entry action)
+    ===========================================================================
+    |    void            Call once before dispatch()
+    ===========================================================================
+    */
+    void start();
+
+    //____________________________________________________________
+    /* Main subroutine -> queue an event for the owner task
+    ===========================================================================
+    |    event           Event ID from the caller's table
+    |    Returns         false if the queue is full (counted as dropped)
+    ===========================================================================
+    */
+    bool post(fsm_event_id_t event);
+
+    //____________________________________________________________
+    /* Main subroutine -> run every queued event
+    ===========================================================================
+    |    Returns         Number of state changes taken
+    ===========================================================================
+    */
+    std::size_t dispatch();
+
+    //Wake notifier when an event is posted, nullptr to detach
+    void attach(PTAMNotifier* notifier, uint32_t bits);
+
+    fsm_state_id_t state() const;
+    const char* name(fsm_state_id_t state) const;
+
+    fsm_stats_t stats() const;
+    void resetStats();
+
+private:
+    struct queued_t {
+        fsm_event_id_t event;
+        int64_t posted_us;
+    };
+
+    bool pop(queued_t& out);
+    void handle(const queued_t& queued);
+    const fsm_state_def_t* find(fsm_state_id_t state) const;
+
+    const fsm_state_def_t* states_;
+    std::size_t stateCount_;
+    const fsm_transition_t* transitions_;
+    std::size_t transitionCount_;
+    void* ctx_;
+    fsm_clock_t clock_;
+    fsm_state_id_t current_;
+
+    queued_t queue_[FSM_QUEUE_LEN];
+    std::size_t head_;
+    std::size_t count_;
+    PTAMNotifier* notifier_;
+    uint32_t notifyBits_;
+    fsm_stats_t stats_;
+    mutable std::mutex lock_;
+};
+
+#endif // FSM_H
@@ -0,0 +1,323 @@
+/*MIT License
+Copyright (c) 2023 limitless Aeronautics
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#include "_health.h"
+#include "../PTAM/_ptam_cbor.h"
+#include "esp_log.h"
+
+#ifdef ESP_PLATFORM
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_task_wdt.h"
+#endif
+
+static const char* TAG = "Health";
+
+static const char* const LEVEL_NAMES[HEALTH_LEVEL_COUNT] = {
+    "ok", "late", "degraded", "safe", "reset"
+};
+
+uint32_t health_stack_free(void* task) {
+#ifdef ESP_PLATFORM
+    //ESP-IDF reports the high-water mark in bytes
+    return task == nullptr ? UINT32_MAX : uxTaskGetStackHighWaterMark(static_cast<TaskHandle_t>(task));
+#else
+    (void)task;
+    return UINT32_MAX;
+#endif
+}
+
+HealthMonitor::HealthMonitor(health_clock_t clock, health_stack_probe_t stack, const health_escalation_t& escalation)
+    : clock_(clock), stack_(stack), escalation_(escalation), tasks_(), reserved_(0), level_(HEALTH_OK),
+      feeds_(0), resetLatched_(false), windowStart_(-1), actions_(), actionCtx_() {
+}
+
+HealthMonitor& HealthMonitor::getInstance() {
+    static HealthMonitor monitor;
+    return monitor;
+}
+
+const char* HealthMonitor::levelName(health_level_t level) {
+    return LEVEL_NAMES[level < HEALTH_LEVEL_COUNT ? level : HEALTH_RESET];
+}
+
+HealthMonitor::Task* HealthMonitor::task(int id) {
+    if (id < 0 || id >= HEALTH_MAX_TASKS || !tasks_[id].registered.load(std::memory_order_acquire)) {
+        return nullptr;
+    }
+    return &tasks_[id];
+}
+
+int HealthMonitor::add(const health_task_def_t& def, void* handle) {
+    if (def.deadline_us == 0) {
+        ESP_LOGE(TAG, "No deadline for %s", def.name);
+        return -1;
+    }
+    //Claim a slot first, tasks may register concurrently
+    const std::size_t slot = reserved_.fetch_add(1, std::memory_order_relaxed);
+    if (slot >= HEALTH_MAX_TASKS) {
+        ESP_LOGE(TAG, "Cannot monitor %s, %d tasks already", def.name, HEALTH_MAX_TASKS);
+        return -1;
+    }
+    Task& t = tasks_[slot];
+    t.def = def;
+#ifdef ESP_PLATFORM
+    if (handle == nullptr) {
+        handle = xTaskGetCurrentTaskHandle();
+    }
+#endif
+    t.handle.store(handle, std::memory_order_relaxed);
+    t.active.store(def.active, std::memory_order_relaxed);
+    t.progress_us.store(clock_(), std::memory_order_relaxed);
+    t.level.store(HEALTH_OK, std::memory_order_relaxed);
+    t.stack_free_min.store(UINT32_MAX, std::memory_order_relaxed);
+    t.registered.store(true, std::memory_order_release);
+    return static_cast<int>(slot);
+}
+
+void HealthMonitor::attach(int id) {
+#ifdef ESP_PLATFORM
+    Task* t = task(id);
+    if (t != nullptr) {
+        t->handle.store(xTaskGetCurrentTaskHandle(), std::memory_order_relaxed);
+    }
+#else
+    (void)id;
+#endif
+}
+
+void HealthMonitor::beat(int id, uint32_t progress, uint32_t busy_us) {
+    Task* t = task(id);
+    if (t == nullptr) {
+        return;
+    }
+    t->beats.fetch_add(1, std::memory_order_relaxed);
+    t->busy_us.fetch_add(busy_us, std::memory_order_relaxed);
+    if (progress == 0) {
+        //Alive but stuck, the deadline keeps running
+        return;
+    }
+    t->progress.fetch_add(progress, std::memory_order_relaxed);
+    const int64_t now = clock_();
+    const int64_t gap = now - t->progress_us.exchange(now, std::memory_order_acq_rel);
+    if (t->active.load(std::memory_order_relaxed) && gap > int64_t(t->overdue_max_us.load(std::memory_order_relaxed))) {
+        t->overdue_max_us.store(gap > int64_t(UINT32_MAX) ? UINT32_MAX : uint32_t(gap), std::memory_order_relaxed);
+    }
+}
+
+void HealthMonitor::setActive(int id, bool active) {
+    Task* t = task(id);
+    if (t == nullptr) {
+        return;
+    }
+    if (active) {
+        t->progress_us.store(clock_(), std::memory_order_relaxed);
+    }
+    t->active.store(active, std::memory_order_release);
+}
+
+void HealthMonitor::onLevel(health_level_t level, health_action_t action, void* ctx) {
+    if (level < HEALTH_LEVEL_COUNT) {
+        actions_[level] = action;
+        actionCtx_[level] = ctx;
+    }
+}
+
+health_level_t HealthMonitor::classify(const Task& t, int64_t overdue) const {
+    const int64_t deadline = t.def.deadline_us;
+    if (overdue <= deadline) {
+        return HEALTH_OK;
+    }
+    if (t.def.critical) {
+        if (overdue >= deadline * escalation_.reset) {
+            return HEALTH_RESET;
+        }
+        if (overdue >= deadline * escalation_.safe) {
+            return HEALTH_SAFE;
+        }
+    }
+    if (overdue >= deadline * escalation_.degrade) {
+        return HEALTH_DEGRADED;
+    }
+    return HEALTH_LATE;
+}
+
+//____________________________________________________________
+/* Utillity subroutine -> CPU share and stack marks of the closing window
+===========================================================================
+*/
+void HealthMonitor::sample(int64_t now) {
+    const int64_t window = now - windowStart_;
+    for (std::size_t i = 0; i < HEALTH_MAX_TASKS; ++i) {
+        Task& t = tasks_[i];
+        if (!t.registered.load(std::memory_order_acquire)) {
+            continue;
+        }
+        const uint32_t busy = t.busy_us.load(std::memory_order_relaxed);
+        t.cpu_share.store(float(uint32_t(busy - t.window_busy_us)) / float(window), std::memory_order_relaxed);
+        t.window_busy_us = busy;
+        const uint32_t free_bytes = stack_(t.handle.load(std::memory_order_relaxed));
+        if (free_bytes < t.stack_free_min.load(std::memory_order_relaxed)) {
+            t.stack_free_min.store(free_bytes, std::memory_order_relaxed);
+        }
+    }
+    windowStart_ = now;
+}
+
+health_level_t HealthMonitor::check() {
+    const int64_t now = clock_();
+    if (windowStart_ < 0) {
+        windowStart_ = now;
+    } else if (now - windowStart_ >= HEALTH_WINDOW_US) {
+        sample(now);
+    }
+
+    health_level_t worst = HEALTH_OK;
+    const char* culprit = nullptr;
+    for (std::size_t i = 0; i < HEALTH_MAX_TASKS; ++i) {
+        Task& t = tasks_[i];
+        if (!t.registered.load(std::memory_order_acquire)) {
+            continue;
+        }
+        const int64_t overdue = now - t.progress_us.load(std::memory_order_acquire);
+        const health_level_t level = t.active.load(std::memory_order_acquire) ? classify(t, overdue) : HEALTH_OK;
+        const health_level_t previous = t.level.load(std::memory_order_relaxed);
+        if (level != previous) {
+            if (previous == HEALTH_OK) {
+                t.misses.fetch_add(1, std::memory_order_relaxed);
+            }
+            if (level == HEALTH_OK) {
+                ESP_LOGI(TAG, "%s recovered", t.def.name);
+            } else if (level > previous) {
+                ESP_LOGW(TAG, "%s %s, no progress for %lld us", t.def.name, LEVEL_NAMES[level], (long long)overdue);
+            }
+            t.level.store(level, std::memory_order_relaxed);
+        }
+        if (level > worst) {
+            worst = level;
+            culprit = t.def.name;
+        }
+    }
+
+    //Each step entered on the way up runs its action once
+    const health_level_t previous = level();
+    for (uint8_t step = previous + 1; step <= worst; ++step) {
+        ESP_LOGE(TAG, "Escalating to %s (%s)", LEVEL_NAMES[step], culprit);
+        if (actions_[step] != nullptr) {
+            actions_[step](actionCtx_[step], health_level_t(step), culprit);
+        }
+    }
+    level_.store(worst, std::memory_order_release);
+
+    //A reset decision is final, the watchdog takes it from here
+    if (worst >= HEALTH_RESET) {
+        resetLatched_ = true;
+    }
+    if (!resetLatched_) {
+#ifdef ESP_PLATFORM
+        esp_task_wdt_reset();
+#endif
+        feeds_.fetch_add(1, std::memory_order_relaxed);
+    }
+    return worst;
+}
+
+#ifdef ESP_PLATFORM
+bool HealthMonitor::startWatchdog(uint32_t timeout_ms) {
+    //Keep the idle task checks of sdkconfig, but panic (reset) on expiry
+    const esp_task_wdt_config_t config = {
+        .timeout_ms = timeout_ms,
+        .idle_core_mask = (1 << portNUM_PROCESSORS) - 1,
+        .trigger_panic = true,
+    };
+    esp_err_t err = esp_task_wdt_reconfigure(&config);
+    if (err == ESP_ERR_INVALID_STATE) {
+        err = esp_task_wdt_init(&config);
+    }
+    if (err == ESP_OK) {
+        err = esp_task_wdt_add(nullptr);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Task watchdog not armed (%d)", err);
+        return false;
+    }
+    return true;
+}
+#endif
+
+std::size_t HealthMonitor::stats(health_task_stats_t* out, std::size_t max) const {
+    std::size_t n = 0;
+    for (std::size_t i = 0; i < HEALTH_MAX_TASKS && n < max; ++i) {
+        const Task& t = tasks_[i];
+        if (!t.registered.load(std::memory_order_acquire)) {
+            continue;
+        }
+        out[n++] = {
+            t.def.name,
+            t.level.load(std::memory_order_relaxed),
+            t.active.load(std::memory_order_relaxed),
+            t.beats.load(std::memory_order_relaxed),
+            t.progress.load(std::memory_order_relaxed),
+            t.misses.load(std::memory_order_relaxed),
+            t.overdue_max_us.load(std::memory_order_relaxed),
+            t.stack_free_min.load(std::memory_order_relaxed),
+            t.cpu_share.load(std::memory_order_relaxed),
+        };
+    }
+    return n;
+}
+
+std::size_t HealthMonitor::dump(uint8_t* out, std::size_t len) const {
+    health_task_stats_t tasks[HEALTH_MAX_TASKS];
+    const std::size_t n = stats(tasks, HEALTH_MAX_TASKS);
+
+    PTAMCborWriter cbor(out, len);
+    cbor.map(5);
+    cbor.text("v");
+    cbor.uint(1);
+    cbor.text("t");
+    cbor.integer(clock_());
+    cbor.text("level");
+    cbor.text(levelName(level()));
+    cbor.text("wdt");
+    cbor.uint(watchdogFeeds());
+    cbor.text("tasks");
+    cbor.array(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        const health_task_stats_t& s = tasks[i];
+        cbor.array(8);
+        cbor.text(s.name);
+        cbor.text(levelName(s.level));
+        cbor.uint(s.active ? 1 : 0);
+        cbor.uint(s.beats);
+        cbor.uint(s.misses);
+        cbor.uint(s.overdue_max_us);
+        cbor.uint(s.stack_free_min);
+        cbor.float64(s.cpu_share);
+    }
+    return cbor.ok() ? cbor.size() : 0;
+}
+
+HealthMonitor::Work::Work(int id, HealthMonitor& monitor)
+    : monitor_(monitor), id_(id), start_(monitor.clock_()) {
+}
+
+HealthMonitor::Work::~Work() {
+    const int64_t busy = monitor_.clock_() - start_;
+    monitor_.beat(id_, 1, busy > 0 ? uint32_t(busy) : 0);
+}
@@ -0,0 +1,221 @@
+/*MIT License
+Copyright (c) 2023 limitless Aeronautics
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#ifndef HEALTH_MONITOR_H
+#define HEALTH_MONITOR_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "../PTAM/_ptam_clock.h"
+
+//Tasks per monitor
+#define HEALTH_MAX_TASKS 8
+//check() rate of the health task
+#define HEALTH_CHECK_HZ 10
+//CPU share and stack marks are refreshed once per window
+#define HEALTH_WINDOW_US 1000000
+//Task watchdog timeout once the monitor owns it, the last escalation step
+#define HEALTH_WDT_TIMEOUT_MS 5000
+//Upper bound of HealthMonitor::dump()
+#define HEALTH_DUMP_MAX_BYTES 512
+
+//Escalation steps, a task climbs them the longer it stays overdue
+enum health_level_t : uint8_t {
+    HEALTH_OK = 0,
+    HEALTH_LATE,            //Missed its deadline: logged
+    HEALTH_DEGRADED,        //Non-critical work is shed
+    HEALTH_SAFE,            //Safe mode (abort), critical tasks only
+    HEALTH_RESET,           //Watchdog no longer fed, critical tasks only
+    HEALTH_LEVEL_COUNT
+};
+
+struct health_task_def_t {
+    const char* name;
+    uint32_t deadline_us;   //Longest gap between two heartbeats that made progress
+    bool critical;          //May escalate past HEALTH_DEGRADED
+    bool active;            //Checked from registration on (see setActive)
+};
+
+//Overdue time, in deadlines, at which each step is entered (LATE is 1)
+struct health_escalation_t {
+    uint8_t degrade;
+    uint8_t safe;
+    uint8_t reset;
+};
+
+constexpr health_escalation_t HEALTH_DEFAULT_ESCALATION = {2, 4, 8};
+
+struct health_task_stats_t {
+    const char* name;
+    health_level_t level;
+    bool active;
+    uint32_t beats;
+    uint32_t progress;
+    uint32_t misses;            //Times the task went from OK to LATE
+    uint32_t overdue_max_us;    //Longest gap between two progressing heartbeats
+    uint32_t stack_free_min;    //Bytes of stack never touched, UINT32_MAX if unknown
+    float cpu_share;            //Busy time reported by the task / wall time, last window
+};
+
+typedef int64_t (*health_clock_t)();
+//Unused stack of a task in bytes, UINT32_MAX if it cannot be read
+typedef uint32_t (*health_stack_probe_t)(void* task);
+//Escalation action, runs on the monitor task
+typedef void (*health_action_t)(void* ctx, health_level_t level, const char* task);
+
+//Stack high-water mark of the running platform (FreeRTOS on target)
+uint32_t health_stack_free(void* task);
+
+//____________________________________________________________
+/* Task health monitor
+===========================================================================
+|    Registered tasks call beat() with how much progress they made (and
+|    optionally how long they were busy). A task is overdue once no
+|    progressing beat arrived for its deadline: beating without progress
+|    keeps it overdue, so a task spinning in a retry loop is caught too.
+|
+|    check() (health task, HEALTH_CHECK_HZ) escalates each overdue task
+|    log -> degrade -> safe mode -> watchdog reset. The monitor level is
+|    the worst task's; entering a level runs its action once. The monitor
+|    task is the only task watchdog subscriber and stops feeding it at
+|    HEALTH_RESET, so a hung critical task ends in a TWDT reset instead
+|    of a silent stall.
+|
+|    beat() is lock free and callable from any task, including the
+|    control rate groups. Host builds inject the clock and stack probe.
+===========================================================================
+*/
+class HealthMonitor {
+public:
+    explicit HealthMonitor(health_clock_t clock = ptam_time_us, health_stack_probe_t stack = health_stack_free,
+                           const health_escalation_t& escalation = HEALTH_DEFAULT_ESCALATION);
+
+    static HealthMonitor& getInstance();
+
+    //____________________________________________________________
+    /* Main subroutine -> register a task
+    ===========================================================================
+    |    def             Copied, the name must outlive the monitor
+    |    task            Task handle for the stack probe, nullptr binds the
+    |                    calling task (target)
+    |    Returns         Task id, -1 if the monitor is full
+    ===========================================================================
+    */
+    int add(const health_task_def_t& def, void* task = nullptr);
+
+    //Binds the calling task, for tasks registered before they run
+    void attach(int id);
+
+    //____________________________________________________________
+    /* Main subroutine -> heartbeat
+    ===========================================================================
+    |    progress        Work done since the last beat, 0 = alive but stuck
+    |    busy_us         Time spent working since the last beat (CPU share)
+    ===========================================================================
+    */
+    void beat(int id, uint32_t progress = 1, uint32_t busy_us = 0);
+
+    //Inactive tasks are not checked (e.g. rate groups while disarmed),
+    //activating restarts the deadline
+    void setActive(int id, bool active);
+
+    //Action run once when the monitor level reaches level
+    void onLevel(health_level_t level, health_action_t action, void* ctx);
+
+    //____________________________________________________________
+    /* Main subroutine -> escalate overdue tasks, feed the watchdog
+    ===========================================================================
+    |    Health task only, at HEALTH_CHECK_HZ
+    |    Returns         The monitor level after this check
+    ===========================================================================
+    */
+    health_level_t check();
+
+    health_level_t level() const { return level_.load(std::memory_order_acquire); }
+    bool degraded() const { return level() >= HEALTH_DEGRADED; }
+    static const char* levelName(health_level_t level);
+
+#ifdef ESP_PLATFORM
+    //Subscribes the calling (health) task to the TWDT, set to reset on expiry
+    bool startWatchdog(uint32_t timeout_ms = HEALTH_WDT_TIMEOUT_MS);
+#endif
+    //Watchdog feeds so far, stops growing at HEALTH_RESET
+    uint32_t watchdogFeeds() const { return feeds_.load(std::memory_order_relaxed); }
+
+    std::size_t stats(health_task_stats_t* out, std::size_t max) const;
+
+    //Levels, deadlines, stack marks and CPU share as CBOR for /GET_HEALTH
+    std::size_t dump(uint8_t* out, std::size_t len) const;
+
+    //____________________________________________________________
+    /* One unit of work: beats on exit with the time spent in the scope
+    ===========================================================================
+    |    Wrap a loop pass or a rate group run, not the idle wait
+    ===========================================================================
+    */
+    class Work {
+    public:
+        Work(int id, HealthMonitor& monitor = HealthMonitor::getInstance());
+        ~Work();
+        Work(const Work&) = delete;
+        Work& operator=(const Work&) = delete;
+
+    private:
+        HealthMonitor& monitor_;
+        int id_;
+        int64_t start_;
+    };
+
+private:
+    struct Task {
+        health_task_def_t def;
+        std::atomic<void*> handle;
+        std::atomic<bool> registered;
+        std::atomic<bool> active;
+        std::atomic<int64_t> progress_us;   //Last beat with progress
+        std::atomic<uint32_t> beats;
+        std::atomic<uint32_t> progress;
+        std::atomic<uint32_t> busy_us;
+        std::atomic<uint32_t> overdue_max_us;
+        //Monitor task only, read by stats()
+        std::atomic<health_level_t> level;
+        std::atomic<uint32_t> misses;
+        std::atomic<uint32_t> stack_free_min;
+        std::atomic<float> cpu_share;
+        uint32_t window_busy_us;
+    };
+
+    Task* task(int id);
+    health_level_t classify(const Task& t, int64_t overdue) const;
+    void sample(int64_t now);
+
+    health_clock_t clock_;
+    health_stack_probe_t stack_;
+    health_escalation_t escalation_;
+    Task tasks_[HEALTH_MAX_TASKS];
+    std::atomic<std::size_t> reserved_;
+    std::atomic<health_level_t> level_;
+    std::atomic<uint32_t> feeds_;
+    bool resetLatched_;
+    int64_t windowStart_;
+    health_action_t actions_[HEALTH_LEVEL_COUNT];
+    void* actionCtx_[HEALTH_LEVEL_COUNT];
+};
+
+#endif // HEALTH_MONITOR_H
@@ -0,0 +1,259 @@
+/*MIT License
+Copyright (c) 2023 limitless Aeronautics
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#include "_memory.h"
+#include "../PTAM/_ptam.h"
+#include "../PTAM/_ptam_cbor.h"
+#include "../Memory/_alloc_count.h"
+
+#include <algorithm>
+
+#ifdef ESP_PLATFORM
+#include "esp_heap_caps.h"
+#endif
+
+static const char* const COMPONENT_NAMES[MEM_COMPONENT_COUNT] = {
+    "ptam", "comms", "display", "logging", "control", "other"
+};
+
+static const char* const LEVEL_NAMES[MEM_PRESSURE_COUNT] = {
+    "normal", "low", "critical", "exhausted"
+};
+
+//Display goes first, then log verbosity, then telemetry is slowed down
+static const mem_shed_t SHEDDING[MEM_PRESSURE_COUNT] = {
+    {1, 1, ESP_LOG_INFO},
+    {4, 4, ESP_LOG_WARN},
+    {0, 16, ESP_LOG_ERROR},
+    {0, 16, ESP_LOG_ERROR},
+};
+
+//esp_log tags of this firmware, the only ones shedding lowers. ESP-IDF
+//tags (wifi, httpd, ...) keep the level they were configured with
+static const char* const SHED_LOG_TAGS[] = {
+    "Memory", "Restart", "Health", "FSM", "SCHED", "SAFE", "PTAM", "GAINS", "WINGCAL",
+    "SEN", "IMU", "BM1088 Module", "bmx280", "Meter", "wifi softAP", "TAG",
+};
+
+mem_sample_t mem_sample_heap() {
+#ifdef ESP_PLATFORM
+    return {
+        static_cast<uint32_t>(heap_caps_get_free_size(MALLOC_CAP_8BIT)),
+        static_cast<uint32_t>(heap_caps_get_largest_free_block(MALLOC_CAP_8BIT)),
+        static_cast<uint32_t>(heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT)),
+    };
+#else
+    //Host builds have no fixed heap, never under pressure
+    return {UINT32_MAX, UINT32_MAX, UINT32_MAX};
+#endif
+}
+
+MemoryManager::MemoryManager(mem_sampler_t sampler, mem_clock_t clock, const mem_limits_t& limits)
+    : sampler_(sampler), clock_(clock), limits_(limits), idleRestartUs_(MEM_IDLE_RESTART_US),
+      pressure_(MEM_NORMAL), restartPending_(false), free_(0), largest_(0), heapMin_(0),
+      minFree_(UINT32_MAX), minLargest_(UINT32_MAX), current_(), peak_(),
+      displayPass_(0), telemetryPass_(0) {
+}
+
+MemoryManager& MemoryManager::getInstance() {
+    static MemoryManager manager;
+    return manager;
+}
+
+//____________________________________________________________
+/* Utillity subroutine -> level of a sample
+===========================================================================
+|    margin          Added to every threshold, the hysteresis band when
+|                    checking whether a level can be left
+===========================================================================
+*/
+mem_pressure_t MemoryManager::classify(const mem_sample_t& s, uint32_t margin) const {
+    if (s.free_bytes < limits_.exhausted_free + margin) {
+        return MEM_EXHAUSTED;
+    }
+    if (s.free_bytes < limits_.critical_free + margin || s.largest_block < limits_.critical_block + margin) {
+        return MEM_CRITICAL;
+    }
+    if (s.free_bytes < limits_.low_free + margin || s.largest_block < limits_.low_block + margin) {
+        return MEM_LOW;
+    }
+    return MEM_NORMAL;
+}
+
+mem_pressure_t MemoryManager::update() {
+    const mem_sample_t s = sampler_();
+    free_.store(s.free_bytes, std::memory_order_relaxed);
+    largest_.store(s.largest_block, std::memory_order_relaxed);
+    heapMin_.store(s.min_free, std::memory_order_relaxed);
+    if (s.free_bytes < minFree_.load(std::memory_order_relaxed)) {
+        minFree_.store(s.free_bytes, std::memory_order_relaxed);
+    }
+    if (s.largest_block < minLargest_.load(std::memory_order_relaxed)) {
+        minLargest_.store(s.largest_block, std::memory_order_relaxed);
+    }
+
+    //Worse immediately, better only once clear of the hysteresis band
+    const mem_pressure_t previous = pressure();
+    mem_pressure_t level = classify(s, 0);
+    if (level < previous) {
+        const mem_pressure_t relaxed = classify(s, limits_.hysteresis);
+        level = relaxed < previous ? relaxed : previous;
+    }
+    if (level == MEM_EXHAUSTED) {
+        //Latched, the heap is not trusted to recover on its own
+        restartPending_.store(true, std::memory_order_release);
+    }
+    if (level != previous) {
+        pressure_.store(level, std::memory_order_release);
+        for (const char* tag : SHED_LOG_TAGS) {
+            esp_log_level_set(tag, SHEDDING[level].log_level);
+        }
+        ESP_LOGW("Memory", "Pressure %s -> %s (free %u, largest %u)", LEVEL_NAMES[previous],
+                 LEVEL_NAMES[level], unsigned(s.free_bytes), unsigned(s.largest_block));
+    }
+    return level;
+}
+
+mem_sample_t MemoryManager::sample() const {
+    return {
+        free_.load(std::memory_order_relaxed),
+        largest_.load(std::memory_order_relaxed),
+        heapMin_.load(std::memory_order_relaxed),
+    };
+}
+
+const mem_shed_t& MemoryManager::shedding(mem_pressure_t level) {
+    return SHEDDING[level < MEM_PRESSURE_COUNT ? level : MEM_EXHAUSTED];
+}
+
+const char* MemoryManager::levelName(mem_pressure_t level) {
+    return LEVEL_NAMES[level < MEM_PRESSURE_COUNT ? level : MEM_EXHAUSTED];
+}
+
+bool MemoryManager::displayDue(bool force) {
+    const uint8_t every = shedding(pressure()).display_every;
+    if (force) {
+        displayPass_ = 0;
+        return true;
+    }
+    if (every == 0) {
+        return false;
+    }
+    return displayPass_++ % every == 0;
+}
+
+bool MemoryManager::telemetryDue() {
+    const uint8_t every = shedding(pressure()).telemetry_every;
+    return telemetryPass_++ % every == 0;
+}
+
+void MemoryManager::account(mem_component_t component, int32_t bytes) {
+    if (component >= MEM_COMPONENT_COUNT) {
+        component = MEM_COMP_OTHER;
+    }
+    const int32_t now = current_[component].fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    int32_t peak = peak_[component].load(std::memory_order_relaxed);
+    while (now > peak && !peak_[component].compare_exchange_weak(peak, now, std::memory_order_relaxed)) {
+    }
+}
+
+std::size_t MemoryManager::usage(mem_usage_t* out, std::size_t max) const {
+    std::size_t n = 0;
+    for (std::size_t i = 0; i < MEM_COMPONENT_COUNT && n < max; ++i) {
+        out[n++] = {COMPONENT_NAMES[i], current_[i].load(std::memory_order_relaxed),
+                    peak_[i].load(std::memory_order_relaxed)};
+    }
+    return n;
+}
+
+MemoryManager::Scope::Scope(mem_component_t component, MemoryManager& manager)
+    : manager_(manager), component_(component), before_(manager.sampler_().free_bytes) {
+}
+
+MemoryManager::Scope::~Scope() {
+    const uint32_t after = manager_.sampler_().free_bytes;
+    manager_.account(component_, static_cast<int32_t>(static_cast<int64_t>(before_) - after));
+}
+
+mem_restart_t MemoryManager::restartDue(bool safe) const {
+    if (!safe) {
+        return MEM_RESTART_NONE;
+    }
+    if (restartPending_.load(std::memory_order_acquire)) {
+        return MEM_RESTART_MEMORY;
+    }
+    //Reached, not hit exactly: a late sample still restarts
+    if (idleRestartUs_ > 0 && clock_() >= idleRestartUs_) {
+        return MEM_RESTART_IDLE;
+    }
+    return MEM_RESTART_NONE;
+}
+
+void MemoryManager::publish() {
+    SharedMemory& sharedMemory = SharedMemory::getInstance();
+    const mem_sample_t s = sample();
+    //The allocator's mark also sees dips between two update() samples
+    const uint32_t low = std::min(s.min_free, minFree());
+    sharedMemory.storeInt(REG_HEAP_FREE, static_cast<int>(s.free_bytes));
+    sharedMemory.storeInt(REG_HEAP_LARGEST, static_cast<int>(s.largest_block));
+    sharedMemory.storeInt(REG_HEAP_MIN, static_cast<int>(low));
+}
+
+std::size_t MemoryManager::dump(uint8_t* out, std::size_t len) const {
+    const mem_sample_t s = sample();
+    mem_usage_t components[MEM_COMPONENT_COUNT];
+    const std::size_t n = usage(components, MEM_COMPONENT_COUNT);
+
+    PTAMCborWriter cbor(out, len);
+    cbor.map(8);
+    cbor.text("v");
+    cbor.uint(1);
+    cbor.text("t");
+    cbor.integer(ptam_time_us());
+    cbor.text("level");
+    cbor.text(levelName(pressure()));
+    cbor.text("restart");
+    cbor.uint(restartPending_.load(std::memory_order_acquire) ? 1 : 0);
+    cbor.text("heap");
+    cbor.array(5);
+    cbor.uint(s.free_bytes);
+    cbor.uint(s.largest_block);
+    cbor.uint(s.min_free);
+    cbor.uint(minFree());
+    cbor.uint(minLargest());
+    cbor.text("shed");
+    const mem_shed_t& shed = shedding(pressure());
+    cbor.array(3);
+    cbor.uint(shed.display_every);
+    cbor.uint(shed.telemetry_every);
+    cbor.uint(shed.log_level);
+    //Run-time C++ heap traffic (operator new / delete), all components
+    cbor.text("allocs");
+    cbor.array(2);
+    cbor.uint(mem_alloc_count());
+    cbor.uint(mem_free_count());
+    cbor.text("components");
+    cbor.array(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        cbor.array(3);
+        cbor.text(components[i].name);
+        cbor.integer(components[i].current);
+        cbor.integer(components[i].peak);
+    }
+    return cbor.ok() ? cbor.size() : 0;
+}
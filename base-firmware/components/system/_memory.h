@@ -0,0 +1,235 @@
+/*MIT License
+Copyright (c) 2023 limitless Aeronautics
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#ifndef MEMORY_MANAGER_H
+#define MEMORY_MANAGER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "esp_log.h"
+#include "../PTAM/_ptam_clock.h"
+
+//Upper bound of MemoryManager::dump()
+#define MEM_DUMP_MAX_BYTES 256
+//Idle restart after this much uptime, only taken in a safe state
+#define MEM_IDLE_RESTART_US (12LL * 60 * 60 * 1000000)
+
+//Worst first, each level sheds more non-critical work
+enum mem_pressure_t : uint8_t {
+    MEM_NORMAL = 0,
+    MEM_LOW,
+    MEM_CRITICAL,
+    MEM_EXHAUSTED,          //A restart is scheduled for the next safe state
+    MEM_PRESSURE_COUNT
+};
+
+//Components heap use is charged to (see MemoryManager::Scope)
+enum mem_component_t : uint8_t {
+    MEM_COMP_PTAM = 0,
+    MEM_COMP_COMMS,
+    MEM_COMP_DISPLAY,
+    MEM_COMP_LOGGING,
+    MEM_COMP_CONTROL,
+    MEM_COMP_OTHER,
+    MEM_COMPONENT_COUNT
+};
+
+enum mem_restart_t : uint8_t {
+    MEM_RESTART_NONE = 0,
+    MEM_RESTART_IDLE,       //Uptime passed the idle restart interval
+    MEM_RESTART_MEMORY      //Heap reached MEM_EXHAUSTED
+};
+
+//One heap reading, bytes of 8 bit capable memory
+struct mem_sample_t {
+    uint32_t free_bytes;
+    uint32_t largest_block;     //Largest single allocation that can succeed
+    uint32_t min_free;          //Low-water mark of free_bytes since boot
+};
+
+typedef mem_sample_t (*mem_sampler_t)();
+typedef int64_t (*mem_clock_t)();
+
+//A level is entered when free_bytes or largest_block drops below its
+//threshold, and left once both clear it by hysteresis bytes
+struct mem_limits_t {
+    uint32_t low_free;
+    uint32_t low_block;
+    uint32_t critical_free;
+    uint32_t critical_block;
+    uint32_t exhausted_free;
+    uint32_t hysteresis;
+};
+
+constexpr mem_limits_t MEM_DEFAULT_LIMITS = {
+    40 * 1024,
+    16 * 1024,
+    20 * 1024,
+    8 * 1024,
+    10000,
+    4 * 1024,
+};
+
+//What each level keeps running
+struct mem_shed_t {
+    uint8_t display_every;      //Display refresh every n-th main loop pass, 0 = off
+    uint8_t telemetry_every;    //PTAM stat publishing every n-th pass
+    esp_log_level_t log_level;  //esp_log verbosity of the firmware's own tags
+};
+
+struct mem_usage_t {
+    const char* name;
+    int32_t current;            //Net bytes retained by the component's scopes
+    int32_t peak;
+};
+
+//Heap reading of the running platform (heap_caps on target)
+mem_sample_t mem_sample_heap();
+
+//____________________________________________________________
+/* Memory pressure manager
+===========================================================================
+|    update() samples the heap (monitor task, ~1 Hz), tracks the low-water
+|    marks and classifies the pressure level with hysteresis. Rising
+|    pressure sheds the non-critical work first: display refresh, log
+|    verbosity, then telemetry rate. Flight control is never shed.
+|
+|    Restarts are only ever requested: restartDue() reports an idle or
+|    memory restart and the caller (main loop, outside ARMED) performs it,
+|    so an exhausted heap in flight keeps shedding instead of rebooting.
+===========================================================================
+*/
+class MemoryManager {
+public:
+    explicit MemoryManager(mem_sampler_t sampler = mem_sample_heap, mem_clock_t clock = ptam_time_us,
+                           const mem_limits_t& limits = MEM_DEFAULT_LIMITS);
+
+    static MemoryManager& getInstance();
+
+    //____________________________________________________________
+    /* Main subroutine -> sample the heap and move the pressure level
+    ===========================================================================
+    |    Applies the log verbosity of the new level on a change
+    |    Returns         The pressure level after this sample
+    ===========================================================================
+    */
+    mem_pressure_t update();
+
+    mem_pressure_t pressure() const { return pressure_.load(std::memory_order_acquire); }
+    mem_sample_t sample() const;
+    //Lowest free_bytes / largest_block seen by update()
+    uint32_t minFree() const { return minFree_.load(std::memory_order_relaxed); }
+    uint32_t minLargest() const { return minLargest_.load(std::memory_order_relaxed); }
+
+    static const mem_shed_t& shedding(mem_pressure_t level);
+    static const char* levelName(mem_pressure_t level);
+
+    //____________________________________________________________
+    /* Main subroutines -> shed work, called once per main loop pass
+    ===========================================================================
+    |    force           Refresh regardless (e.g. the flight state changed)
+    |    Returns         true if the display / telemetry should run this pass
+    ===========================================================================
+    */
+    bool displayDue(bool force = false);
+    bool telemetryDue();
+
+    //____________________________________________________________
+    /* Main subroutine -> charge heap use to a component
+    ===========================================================================
+    |    bytes           Allocated (> 0) or released (< 0)
+    |    Usually through Scope, which charges the heap delta of a block
+    ===========================================================================
+    */
+    void account(mem_component_t component, int32_t bytes);
+    std::size_t usage(mem_usage_t* out, std::size_t max) const;
+
+    //____________________________________________________________
+    /* Free heap delta of a block, charged to a component on exit
+    ===========================================================================
+    |    Other tasks allocate concurrently, so this is an attribution, not
+    |    an exact count. Meant for init and handler sized blocks.
+    |    Only what the Scope blocks retain is charged, so per-component use
+    |    is a boot-time attribution (display, PTAM, comms init), not run-time
+    |    tracking. Run-time heap traffic is only counted in total, see
+    |    mem_alloc_count() (Memory/_alloc_count.h).
+    ===========================================================================
+    */
+    class Scope {
+    public:
+        Scope(mem_component_t component, MemoryManager& manager = MemoryManager::getInstance());
+        ~Scope();
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        MemoryManager& manager_;
+        mem_component_t component_;
+        uint32_t before_;
+    };
+
+    //____________________________________________________________
+    /* Main subroutine -> is a restart wanted now
+    ===========================================================================
+    |    safe            The caller's state allows a restart (not ARMED)
+    |    Returns         MEM_RESTART_NONE while unsafe, else the pending
+    |                    memory restart, else the idle restart once uptime
+    |                    reaches the interval (any later sample works)
+    ===========================================================================
+    */
+    mem_restart_t restartDue(bool safe) const;
+    void setIdleRestart(int64_t after_us) { idleRestartUs_ = after_us; }
+
+    //____________________________________________________________
+    /* Main subroutine -> export the heap metrics to PTAM
+    ===========================================================================
+    |    REG_HEAP_FREE       Free bytes at the last update()
+    |    REG_HEAP_LARGEST    Largest free block at the last update()
+    |    REG_HEAP_MIN        Free heap low-water mark since boot
+    ===========================================================================
+    */
+    void publish();
+
+    //Levels, samples and component usage as CBOR for /GET_MEM
+    std::size_t dump(uint8_t* out, std::size_t len) const;
+
+private:
+    mem_pressure_t classify(const mem_sample_t& s, uint32_t margin) const;
+
+    mem_sampler_t sampler_;
+    mem_clock_t clock_;
+    mem_limits_t limits_;
+    int64_t idleRestartUs_;
+
+    std::atomic<mem_pressure_t> pressure_;
+    std::atomic<bool> restartPending_;
+    std::atomic<uint32_t> free_;
+    std::atomic<uint32_t> largest_;
+    std::atomic<uint32_t> heapMin_;         //Allocator's own low-water mark
+    std::atomic<uint32_t> minFree_;
+    std::atomic<uint32_t> minLargest_;
+    std::atomic<int32_t> current_[MEM_COMPONENT_COUNT];
+    std::atomic<int32_t> peak_[MEM_COMPONENT_COUNT];
+
+    //Main loop only
+    uint32_t displayPass_;
+    uint32_t telemetryPass_;
+};
+
+#endif // MEMORY_MANAGER_H
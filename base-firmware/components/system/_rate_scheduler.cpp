@@ -0,0 +1,328 @@
+/*MIT License
+Copyright (c) 2023 limitless Aeronautics
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#include "_rate_scheduler.h"
+#include "../PTAM/_ptam.h"
+
+static int64_t gcd(int64_t a, int64_t b) {
+    while (b != 0) {
+        const int64_t r = a % b;
+        a = b;
+        b = r;
+    }
+    return a;
+}
+
+RateScheduler::RateScheduler(rate_clock_t clock)
+    : clock_(clock), groups_(), count_(0), basePeriodUs_(0),
+      enabled_(false), rebase_(true), releasing_(false), epoch_us_(0) {
+#ifdef ESP_PLATFORM
+    timer_ = nullptr;
+    tick_ = 0;
+#endif
+}
+
+int RateScheduler::add(const rate_task_def_t& def) {
+    if (count_ == RATE_MAX_TASKS || def.rate_hz == 0 || 1000000 % def.rate_hz != 0) {
+        return -1;
+    }
+    Group& group = groups_[count_];
+    group.owner = this;
+    group.def = def;
+    group.period_us = 1000000 / def.rate_hz;
+    group.step.configure(def.name, static_cast<uint32_t>(group.period_us));
+    group.runs = 0;
+    group.restart.store(false);
+    group.pending.store(false);
+    clear(group);
+    basePeriodUs_ = count_ == 0 ? group.period_us : gcd(basePeriodUs_, group.period_us);
+    count_++;
+
+    //Rate-monotonic: one priority step below every faster group
+    for (std::size_t i = 0; i < count_; ++i) {
+        Group& g = groups_[i];
+        g.divider = static_cast<uint32_t>(g.period_us / basePeriodUs_);
+        uint8_t faster = 0;
+        for (std::size_t j = 0; j < count_; ++j) {
+            if (groups_[j].def.rate_hz > g.def.rate_hz) {
+                faster++;
+            }
+        }
+        g.priority = RATE_PRIORITY_TOP - faster;
+    }
+    return static_cast<int>(count_ - 1);
+}
+
+void RateScheduler::setEnabled(bool enabled) {
+    if (enabled && !enabled_.load()) {
+        rebase_.store(true);
+    }
+    enabled_.store(enabled);
+}
+
+bool RateScheduler::waitIdle(int64_t timeout_us) {
+    const int64_t deadline = clock_() + timeout_us;
+    while (1) {
+        //Sequentially consistent with onTimer: either it saw the disable,
+        //or its release is visible here as releasing_ / pending
+        bool busy = releasing_.load();
+        for (std::size_t i = 0; i < count_ && !busy; ++i) {
+            busy = groups_[i].pending.load();
+        }
+        if (!busy) {
+            return true;
+        }
+        if (clock_() >= deadline) {
+            return false;
+        }
+#ifdef ESP_PLATFORM
+        vTaskDelay(1);
+#else
+        //Host runs are synchronous (simulate), nothing can finish meanwhile
+        return false;
+#endif
+    }
+}
+
+//____________________________________________________________
+/* Main subroutine -> run one release of a group and account for it
+===========================================================================
+|    group           Released group (its own task on target)
+|    ideal_us        Ideal release time, jitter and deadline are relative to it
+===========================================================================
+*/
+void RateScheduler::run(Group& group, int64_t ideal_us) {
+    const int64_t start = clock_();
+    rate_tick_t tick;
+    tick.now_us = start;
+    if (group.restart.exchange(false, std::memory_order_acquire)) {
+        group.step.restart();
+    }
+    //Not the time since the last run before a pause: a re-armed PID would
+    //integrate the whole pause
+    tick.dt_s = group.step.tick(start);
+    tick.release = group.runs;
+    group.def.fn(group.def.ctx, tick);
+    const int64_t end = clock_();
+
+    group.runs++;
+
+    const uint32_t jitter = static_cast<uint32_t>(start > ideal_us ? start - ideal_us : 0);
+    const uint32_t exec = static_cast<uint32_t>(end - start);
+    group.releases.fetch_add(1, std::memory_order_relaxed);
+    group.jitter_sum_us.fetch_add(jitter, std::memory_order_relaxed);
+    group.exec_sum_us.fetch_add(exec, std::memory_order_relaxed);
+    //Single writer, a plain compare is enough
+    if (jitter > group.jitter_max_us.load(std::memory_order_relaxed)) {
+        group.jitter_max_us.store(jitter, std::memory_order_relaxed);
+    }
+    if (exec > group.exec_max_us.load(std::memory_order_relaxed)) {
+        group.exec_max_us.store(exec, std::memory_order_relaxed);
+    }
+    if (end > ideal_us + group.period_us) {
+        group.misses.fetch_add(1, std::memory_order_relaxed);
+    }
+    group.pending.store(false, std::memory_order_release);
+}
+
+#ifdef ESP_PLATFORM
+void RateScheduler::taskEntry(void* arg) {
+    Group* group = static_cast<Group*>(arg);
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        group->owner->run(*group, group->ideal_us.load(std::memory_order_acquire));
+    }
+}
+
+//____________________________________________________________
+/* Base rate timer callback (esp_timer task) -> release the due groups
+===========================================================================
+|    A group still pending from its last release is skipped, not queued
+===========================================================================
+*/
+void RateScheduler::onTimer(void* arg) {
+    RateScheduler* self = static_cast<RateScheduler*>(arg);
+    //Raised before the enabled check, see waitIdle()
+    self->releasing_.store(true);
+    if (!self->enabled_.load()) {
+        self->releasing_.store(false);
+        return;
+    }
+    if (self->rebase_.exchange(false)) {
+        self->epoch_us_ = self->clock_();
+        self->tick_ = 0;
+        for (std::size_t i = 0; i < self->count_; ++i) {
+            self->groups_[i].restart.store(true, std::memory_order_release);
+        }
+    }
+    const int64_t ideal = self->epoch_us_ + static_cast<int64_t>(self->tick_) * self->basePeriodUs_;
+    for (std::size_t i = 0; i < self->count_; ++i) {
+        Group& group = self->groups_[i];
+        if (self->tick_ % group.divider != 0) {
+            continue;
+        }
+        if (group.pending.load(std::memory_order_acquire)) {
+            group.skipped.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        group.ideal_us.store(ideal, std::memory_order_relaxed);
+        group.pending.store(true, std::memory_order_release);
+        xTaskNotifyGive(group.handle);
+    }
+    self->tick_++;
+    self->releasing_.store(false);
+}
+
+bool RateScheduler::start() {
+    if (timer_ != nullptr || count_ == 0) {
+        return false;
+    }
+    for (std::size_t i = 0; i < count_; ++i) {
+        Group& group = groups_[i];
+        if (xTaskCreatePinnedToCore(taskEntry, group.def.name, group.def.stack, &group,
+                                    group.priority, &group.handle, group.def.core) != pdPASS) {
+            return false;
+        }
+    }
+    esp_timer_create_args_t args = {};
+    args.callback = onTimer;
+    args.arg = this;
+    args.dispatch_method = ESP_TIMER_TASK;
+    args.name = "rate_sched";
+    if (esp_timer_create(&args, &timer_) != ESP_OK) {
+        return false;
+    }
+    return esp_timer_start_periodic(timer_, basePeriodUs_) == ESP_OK;
+}
+#else
+void RateScheduler::simulate(int64_t until_us, void (*advanceTo)(int64_t us)) {
+    if (!enabled_.load()) {
+        if (clock_() < until_us) {
+            advanceTo(until_us);
+        }
+        return;
+    }
+    if (rebase_.exchange(false)) {
+        epoch_us_ = clock_();
+        for (std::size_t i = 0; i < count_; ++i) {
+            groups_[i].next_us = epoch_us_;
+            groups_[i].restart.store(true, std::memory_order_release);
+        }
+    }
+    while (1) {
+        const int64_t now = clock_();
+        //Highest priority group with a release that is due
+        Group* best = nullptr;
+        for (std::size_t i = 0; i < count_; ++i) {
+            Group& group = groups_[i];
+            if (group.next_us <= now && group.next_us <= until_us &&
+                (best == nullptr || group.priority > best->priority)) {
+                best = &group;
+            }
+        }
+        if (best == nullptr) {
+            int64_t next = INT64_MAX;
+            for (std::size_t i = 0; i < count_; ++i) {
+                if (groups_[i].next_us < next) {
+                    next = groups_[i].next_us;
+                }
+            }
+            if (next > until_us) {
+                if (now < until_us) {
+                    advanceTo(until_us);
+                }
+                return;
+            }
+            advanceTo(next);
+            continue;
+        }
+
+        const int64_t ideal = best->next_us;
+        best->pending.store(true);
+        run(*best, ideal);
+        //Releases that arrived while this one was pending are dropped, as on target
+        const int64_t end = clock_();
+        int64_t next = ideal + best->period_us;
+        while (next < end) {
+            best->skipped.fetch_add(1, std::memory_order_relaxed);
+            next += best->period_us;
+        }
+        best->next_us = next;
+    }
+}
+#endif
+
+void RateScheduler::clear(Group& group) {
+    group.releases.store(0);
+    group.skipped.store(0);
+    group.misses.store(0);
+    group.jitter_max_us.store(0);
+    group.jitter_sum_us.store(0);
+    group.exec_max_us.store(0);
+    group.exec_sum_us.store(0);
+}
+
+std::size_t RateScheduler::stats(rate_task_stats_t* out, std::size_t max) const {
+    std::size_t n = 0;
+    for (std::size_t i = 0; i < count_ && n < max; ++i) {
+        const Group& group = groups_[i];
+        rate_task_stats_t& s = out[n++];
+        s.name = group.def.name;
+        s.rate_hz = group.def.rate_hz;
+        s.core = group.def.core;
+        s.releases = group.releases.load(std::memory_order_relaxed);
+        s.skipped = group.skipped.load(std::memory_order_relaxed);
+        s.misses = group.misses.load(std::memory_order_relaxed);
+        s.jitter_max_us = group.jitter_max_us.load(std::memory_order_relaxed);
+        s.exec_max_us = group.exec_max_us.load(std::memory_order_relaxed);
+        s.jitter_mean_us = 0;
+        s.exec_mean_us = 0;
+        s.load = 0.0f;
+        if (s.releases != 0) {
+            s.jitter_mean_us = static_cast<uint32_t>(group.jitter_sum_us.load(std::memory_order_relaxed) / s.releases);
+            s.exec_mean_us = static_cast<uint32_t>(group.exec_sum_us.load(std::memory_order_relaxed) / s.releases);
+            s.load = static_cast<float>(s.exec_mean_us) / static_cast<float>(group.period_us);
+        }
+    }
+    return n;
+}
+
+void RateScheduler::resetStats() {
+    for (std::size_t i = 0; i < count_; ++i) {
+        clear(groups_[i]);
+    }
+}
+
+void RateScheduler::publish() {
+    rate_task_stats_t stats[RATE_MAX_TASKS];
+    const std::size_t n = this->stats(stats, RATE_MAX_TASKS);
+    double jitter = 0.0;
+    int overruns = 0;
+    double load = 0.0;
+    for (std::size_t i = 0; i < n; ++i) {
+        if (stats[i].jitter_max_us > jitter) {
+            jitter = stats[i].jitter_max_us;
+        }
+        overruns += static_cast<int>(stats[i].skipped + stats[i].misses);
+        load += stats[i].load;
+    }
+    SharedMemory& sharedMemory = SharedMemory::getInstance();
+    sharedMemory.storeDouble(REG_RT_JITTER, jitter);
+    sharedMemory.storeInt(REG_RT_OVERRUN, overruns);
+    sharedMemory.storeDouble(REG_RT_LOAD, load * 100.0);
+}
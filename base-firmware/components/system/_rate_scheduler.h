@@ -0,0 +1,202 @@
+/*MIT License
+Copyright (c) 2023 limitless Aeronautics
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#ifndef RATE_SCHEDULER_H
+#define RATE_SCHEDULER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "../PTAM/_ptam_clock.h"
+#include "../Profiling/_timestep.h"
+
+#ifdef ESP_PLATFORM
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#endif
+
+//Rate groups per scheduler
+#define RATE_MAX_TASKS 4
+//FreeRTOS priority of the fastest group, slower groups get one less each
+//(kept below the esp_timer task that releases them)
+#define RATE_PRIORITY_TOP 20
+
+typedef int64_t (*rate_clock_t)();
+
+//What a rate group sees on each release
+struct rate_tick_t {
+    int64_t now_us;         //Start of this run
+    double dt_s;            //Measured time since the previous run (period on the first
+                            //run and after a re-enable, capped on a stall, see TimeStep)
+    uint32_t release;       //Runs so far, 0 on the first
+};
+
+typedef void (*rate_fn_t)(void* ctx, const rate_tick_t& tick);
+
+struct rate_task_def_t {
+    const char* name;       //FreeRTOS task name, <= 15 characters
+    uint16_t rate_hz;       //Must divide 1 000 000 us evenly
+    rate_fn_t fn;
+    void* ctx;
+    uint8_t core;           //PRO_CPU 0 / APP_CPU 1
+    uint32_t stack;         //Bytes
+};
+
+//Per group accounting, see RateScheduler::stats()
+struct rate_task_stats_t {
+    const char* name;
+    uint16_t rate_hz;
+    uint8_t core;
+    uint32_t releases;      //Runs completed
+    uint32_t skipped;       //Releases dropped because the previous run was still pending
+    uint32_t misses;        //Runs that finished after their deadline (next release)
+    uint32_t jitter_max_us; //Start delay after the ideal release time
+    uint32_t jitter_mean_us;
+    uint32_t exec_max_us;
+    uint32_t exec_mean_us;
+    float load;             //exec_mean / period
+};
+
+//____________________________________________________________
+/* Rate-monotonic fixed-rate scheduler
+===========================================================================
+|    Each group runs at a fixed rate on its own task, priorities ordered
+|    by rate (fastest highest). Ideal release times are epoch + n * period,
+|    jitter is the start delay from that, a release arriving while the
+|    previous one is still pending is skipped (never queued).
+|
+|    Target: a periodic esp_timer at the base rate (GCD of the periods)
+|    notifies the pinned group tasks; FreeRTOS ticks (100 Hz) are too
+|    coarse for 400 Hz.
+|    Host: simulate() runs the groups on one core, non-preemptive, against
+|    the injected clock, so tests are deterministic.
+===========================================================================
+*/
+class RateScheduler {
+public:
+    explicit RateScheduler(rate_clock_t clock = ptam_time_us);
+
+    //____________________________________________________________
+    /* Main subroutine -> declare a rate group (before start / simulate)
+    ===========================================================================
+    |    def             Group definition, copied
+    |    Returns         Group index, -1 if full or the rate does not divide 1 s
+    ===========================================================================
+    */
+    int add(const rate_task_def_t& def);
+
+    //____________________________________________________________
+    /* Main subroutine -> gate releases (e.g. only while ARMED)
+    ===========================================================================
+    |    enabled         Enabling restarts the ideal release timeline
+    ===========================================================================
+    */
+    void setEnabled(bool enabled);
+    bool enabled() const { return enabled_.load(std::memory_order_acquire); }
+
+    //____________________________________________________________
+    /* Main subroutine -> wait for released runs to finish (after setEnabled(false))
+    ===========================================================================
+    |    timeout_us      Longest wait, polled at the FreeRTOS tick on target
+    |    Returns         true once no group is released or running, false
+    |                    if one still is after the timeout
+    ===========================================================================
+    */
+    bool waitIdle(int64_t timeout_us);
+
+#ifdef ESP_PLATFORM
+    //Creates the pinned tasks and the base rate timer, once
+    bool start();
+#else
+    //____________________________________________________________
+    /* Main subroutine -> run the groups until the clock reaches until_us
+    ===========================================================================
+    |    until_us        Simulated end time
+    |    advanceTo       Moves the simulated clock forward; group functions
+    |                    model their cost by advancing it too
+    ===========================================================================
+    */
+    void simulate(int64_t until_us, void (*advanceTo)(int64_t us));
+#endif
+
+    std::size_t stats(rate_task_stats_t* out, std::size_t max) const;
+    void resetStats();
+
+    //____________________________________________________________
+    /* Main subroutine -> export a summary to PTAM
+    ===========================================================================
+    |    REG_RT_JITTER   Worst jitter_max_us of any group
+    |    REG_RT_OVERRUN  Skipped releases + deadline misses, all groups
+    |    REG_RT_LOAD     Summed group load in percent
+    |    Call at a low rate (main loop), not from the groups
+    ===========================================================================
+    */
+    void publish();
+
+    //Base release period, the GCD of the group periods
+    int64_t basePeriodUs() const { return basePeriodUs_; }
+
+private:
+    struct Group {
+        RateScheduler* owner;
+        rate_task_def_t def;
+        int64_t period_us;
+        uint32_t divider;               //Base ticks per release
+        uint8_t priority;
+        TimeStep step;                  //Owner task only, dt between runs
+        uint32_t runs;                  //Owner task only
+        std::atomic<bool> restart;      //Timeline rebased, the next dt is the period
+        std::atomic<bool> pending;      //Released and not finished
+        std::atomic<int64_t> ideal_us;  //Ideal time of the pending release
+        std::atomic<uint32_t> releases;
+        std::atomic<uint32_t> skipped;
+        std::atomic<uint32_t> misses;
+        std::atomic<uint32_t> jitter_max_us;
+        std::atomic<uint64_t> jitter_sum_us;
+        std::atomic<uint32_t> exec_max_us;
+        std::atomic<uint64_t> exec_sum_us;
+#ifdef ESP_PLATFORM
+        TaskHandle_t handle;
+#else
+        int64_t next_us;                //Simulation: ideal time of the next release
+#endif
+    };
+
+    void run(Group& group, int64_t ideal_us);
+    static void clear(Group& group);
+
+#ifdef ESP_PLATFORM
+    static void taskEntry(void* arg);
+    static void onTimer(void* arg);
+
+    esp_timer_handle_t timer_;
+    uint64_t tick_;                     //esp_timer task only
+#endif
+
+    rate_clock_t clock_;
+    Group groups_[RATE_MAX_TASKS];
+    std::size_t count_;
+    int64_t basePeriodUs_;
+    std::atomic<bool> enabled_;
+    std::atomic<bool> rebase_;          //Restart the timeline on the next release
+    std::atomic<bool> releasing_;       //onTimer past its enabled check
+    int64_t epoch_us_;
+};
+
+#endif // RATE_SCHEDULER_H
@@ -85,6 +85,8 @@ uint8_t state = 1;
     void STATE::updateState(std::string state){
         //Update state description value
         stateDescript = state;
+        //Mirror into PTAM, this write wakes the main loop
+        SharedMemory::getInstance().storeString(REG_STATE_DESCRIPT, state);
     }
 
 //____________________________________________________________
@@ -0,0 +1,108 @@
+/*MIT License
+Copyright (c) 2023 limitless Aeronautics
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#ifndef TASK_LAYOUT_H
+#define TASK_LAYOUT_H
+
+#include "_rate_scheduler.h"
+
+#ifdef ESP_PLATFORM
+#include "sdkconfig.h"
+#endif
+
+//____________________________________________________________
+/* Core affinity plan -> every firmware task, its core, priority and stack
+===========================================================================
+|    APP_CPU (1) only runs estimation and control: the rate groups of
+|    CONTROLLER_TASKS::scheduler(), rate-monotonic from RATE_PRIORITY_TOP.
+|    PRO_CPU (0) runs everything that talks to the outside world: Wi-Fi,
+|    lwIP, the HTTP server, the display I2C writes, the FSM main loop,
+|    logging, the memory / battery monitor and the health monitor.
+|
+|    Data crosses between the cores without locks: PTAMSnapshot for
+|    latest values (attitude, wings) and PTAMQueue for streams
+|    (SharedMemory::actuation()). Control tasks must not take the PTAM
+|    register lock, a web UI dump holds it.
+|
+|    The esp_timer task that releases the rate groups stays on PRO_CPU
+|    (sdkconfig); its callback only notifies the APP_CPU tasks.
+===========================================================================
+*/
+#define CORE_PRO 0
+#define CORE_APP 1
+
+//Estimation / control (APP_CPU)
+#define CONTROL_CORE        CORE_APP
+#define CONTROL_SENSE_HZ    400
+#define CONTROL_LOOP_HZ     200
+#define CONTROL_ACTUATE_HZ  50
+#define CONTROL_SENSE_STACK    3072
+#define CONTROL_LOOP_STACK     4096
+#define CONTROL_ACTUATE_STACK  3072
+//Per-tick scratch arena of the control group (static, not on the stack)
+#define CONTROL_ARENA_BYTES    1024
+//Health deadline of the control group (10 periods), checked while ARMED
+#define CONTROL_LOOP_DEADLINE_US   50000
+//Longest ARMED exit waits for in-flight group runs (one slowest period)
+#define CONTROL_STOP_TIMEOUT_US    (1000000 / CONTROL_ACTUATE_HZ)
+
+//Main loop: FSM, display, bypass, persistence (PRO_CPU)
+#define MAIN_TASK_CORE      CORE_PRO
+#define MAIN_TASK_PRIORITY  5
+#define MAIN_TASK_STACK     4096
+//A pass plus the idle wait (MAIN_LOOP_IDLE_MS) with room for display writes
+#define MAIN_TASK_DEADLINE_US   1000000
+
+//Memory / battery monitor (PRO_CPU)
+#define MONITOR_TASK_CORE      CORE_PRO
+#define MONITOR_TASK_PRIORITY  4
+#define MONITOR_TASK_STACK     3072
+#define MONITOR_TASK_DEADLINE_US   3000000
+
+//Health monitor (PRO_CPU), above the tasks it watches there, sole TWDT subscriber
+#define HEALTH_TASK_CORE       CORE_PRO
+#define HEALTH_TASK_PRIORITY   6
+#define HEALTH_TASK_STACK      3072
+
+//HTTP server (PRO_CPU), applied to httpd_config_t
+#define HTTPD_TASK_CORE     CORE_PRO
+#define HTTPD_TASK_PRIORITY 5
+//Per-request scratch arena of the HTTP handlers
+#define HTTPD_ARENA_BYTES   1024
+
+static_assert(MAIN_TASK_PRIORITY < RATE_PRIORITY_TOP - RATE_MAX_TASKS,
+              "Control rate groups must outrank every PRO_CPU task");
+static_assert(HEALTH_TASK_PRIORITY > MAIN_TASK_PRIORITY && HEALTH_TASK_PRIORITY > HTTPD_TASK_PRIORITY,
+              "The health monitor must not be starved by the tasks it watches");
+static_assert(HEALTH_TASK_PRIORITY < RATE_PRIORITY_TOP - RATE_MAX_TASKS,
+              "Control rate groups must outrank every PRO_CPU task");
+
+#ifdef ESP_PLATFORM
+//Wi-Fi and lwIP belong to PRO_CPU, keep sdkconfig in line with the plan
+#if !CONFIG_ESP_WIFI_TASK_PINNED_TO_CORE_0
+#error "Task layout: pin the Wi-Fi task to core 0 (CONFIG_ESP_WIFI_TASK_PINNED_TO_CORE_0)"
+#endif
+#if !CONFIG_LWIP_TCPIP_TASK_AFFINITY_CPU0
+#error "Task layout: pin the lwIP task to core 0 (CONFIG_LWIP_TCPIP_TASK_AFFINITY_CPU0)"
+#endif
+#if !CONFIG_ESP_TIMER_TASK_AFFINITY_CPU0
+#error "Task layout: the esp_timer task is expected on core 0"
+#endif
+#endif
+
+#endif // TASK_LAYOUT_H
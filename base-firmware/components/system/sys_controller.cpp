@@ -21,12 +21,56 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.*/
 
 #include"sys_controller.h"
+#include"../HALX/BMI088/bmi088.h"
+
+#include <cmath>
+
+//Bypass change detection, survives the per-loop CONTROLLER_TASKS instances
+const ptam_reg_t CONTROLLER_TASKS::bypassWingRegs_[BYPASS_WINGS] = {REG_WING_FL, REG_WING_FR, REG_WING_RL, REG_WING_RR};
+const uint8_t CONTROLLER_TASKS::bypassServoPins_[BYPASS_WINGS] = {SERVO_FL, SERVO_FR, SERVO_RL, SERVO_RR};
+CONTROLLER_TASKS::bypass_seen_t CONTROLLER_TASKS::bypassSeen_[BYPASS_WINGS] = {};
+uint32_t CONTROLLER_TASKS::actuatedVersion_ = 0;
+double CONTROLLER_TASKS::actuatedAngle_[BYPASS_WINGS] = {NAN, NAN, NAN, NAN};
+ptam_wings_t CONTROLLER_TASKS::lastActuated_ = {NAN, NAN, NAN, NAN, 0};
+bool CONTROLLER_TASKS::imuReady_ = false;
+double CONTROLLER_TASKS::missionLat_ = 0.0;
+double CONTROLLER_TASKS::missionLong_ = 0.0;
 
 //Start comms and attach RF interrupt 
 //ATTACH PIN NUMBERS
 void CONTROLLER_TASKS::_init_(){
+    //Warm restart: mission targets come back from NVS before defaults are seeded
+    size_t restored = persistence().restore();
+    ESP_LOGI("PTAM", "Restored %d persisted registers", int(restored));
     PTAM_REGISTER_SET();
+    persistence().attach();
+
+    //Gain table of the last upload, the fixed gains without one
+    static gain_table_t table;
+    if(GainSchedule::restore(gainStore(), table) && gainSchedule().load(table)){
+        ESP_LOGI("GAINS", "Restored %ux%u gain table", table.speed_points, table.alt_points);
+    }
+
+    //IMU on its own I2C port (the display has the other), sampled by _SENSE_
+    imuReady_ = BMI088_IMU::IMU_START() == ESP_OK;
+    SharedMemory::getInstance().storeInt(REG_IMU_CHECK, imuReady_ ? 1 : 0);
+    if(!imuReady_){
+        ESP_LOGE("IMU", "BMI088 not found, no attitude for ARMED");
+    }
+
+    //Linkage calibration, before any servo is written
+    wing_calibration_t calibration;
+    if(WingCalibration::restore(calibrationStore(), calibration) && wingCalibration().load(calibration)){
+        ESP_LOGI("WINGCAL", "Restored wing calibration");
+    }
+}
 
+PTAMPersistence& CONTROLLER_TASKS::persistence(){
+    static PTAMNvsStore store;
+    static PTAMPersistence persistence(SharedMemory::getInstance().registers(), store);
+    //NVS must be initialised first, open() is a no-op once it succeeded
+    store.open();
+    return persistence;
 }
 
 void CONTROLLER_TASKS::_IDLE_(){
@@ -51,11 +95,11 @@ uint8_t CONTROLLER_TASKS::verifyFlightConfiguration(){
     */
     SharedMemory& sharedMemory = SharedMemory::getInstance();
     uint8_t verified = 0;
-    auto _lat = sharedMemory.getLastDouble("TLat");
-    auto _long = sharedMemory.getLastDouble("TLong");
-    auto _Talt = sharedMemory.getLastDouble("TAlt");
-    auto _Calt = sharedMemory.getLastDouble("CAlt");
-    auto _vel = sharedMemory.getLastDouble("TVel");
+    auto _lat = sharedMemory.getLastDouble(REG_TLAT);
+    auto _long = sharedMemory.getLastDouble(REG_TLONG);
+    auto _Talt = sharedMemory.getLastDouble(REG_TALT);
+    auto _Calt = sharedMemory.getLastDouble(REG_CALT);
+    auto _vel = sharedMemory.getLastDouble(REG_TVEL);
 
     // Check if all variables contain non-zero values
     if (_lat != 0.0 && 
@@ -89,21 +133,263 @@ std::string CONTROLLER_TASKS::generateRandomAlphanumericToken(uint32_t seed1, ui
 }
 
 void CONTROLLER_TASKS::restart_after_idle_task() {
-    const uint32_t restart_interval = 12 * 60 * 60;  // 12 hours in seconds
+    //Only called from safe states (PREP / BYPASS), ARMED never restarts.
+    //The idle interval is reached rather than matched to the second, and
+    //a memory restart requested while ARMED is taken here afterwards
+    const mem_restart_t reason = MemoryManager::getInstance().restartDue(true);
+    if (reason == MEM_RESTART_NONE) {
+        return;
+    }
+    if (reason == MEM_RESTART_MEMORY) {
+        ESP_LOGW("Restart", "Restarting, heap exhausted (min free %u bytes).",
+                 unsigned(MemoryManager::getInstance().minFree()));
+    } else {
+        ESP_LOGI("Restart", "Restarting after %d hours of idle time.", int(MEM_IDLE_RESTART_US / 3600000000LL));
+    }
+    //Keep the mission configuration across the restart
+    persistence().flush(true);
+    esp_restart();
+}
 
-    // Get the time elapsed since boot in seconds
-    uint32_t uptime = esp_timer_get_time() / 1000000;  // Convert microseconds to seconds
+void CONTROLLER_TASKS::_ARMED_(){
+    //Start App
+    //The flight pipeline runs in the scheduler() rate groups (_CONTROL_),
+    //armPipeline() loaded its mission on ARMED entry
+}
+
+RateScheduler& CONTROLLER_TASKS::scheduler(){
+    static RateScheduler scheduler;
+    static bool declared = false;
+    if(!declared){
+        scheduler.add({"rt_sense", CONTROL_SENSE_HZ, _SENSE_, nullptr, CONTROL_CORE, CONTROL_SENSE_STACK});
+        scheduler.add({"rt_control", CONTROL_LOOP_HZ, _CONTROL_, nullptr, CONTROL_CORE, CONTROL_LOOP_STACK});
+        scheduler.add({"rt_actuate", CONTROL_ACTUATE_HZ, _ACTUATE_, nullptr, CONTROL_CORE, CONTROL_ACTUATE_STACK});
+        declared = true;
+    }
+    return scheduler;
+}
 
-    // Check if it's time to restart after every 12-hour period
-    if (uptime % restart_interval == 0) {
-        ESP_LOGI("Restart", "Restarting after %d hours of idle time.", int(restart_interval / 3600));
-        esp_restart();
+//____________________________________________________________
+/* Rate group -> sensor sampling (CONTROL_SENSE_HZ)
+===========================================================================
+|    One BMI088 attitude sample into SharedMemory::attitude(), yaw
+|    integrated over the measured dt. A failed I2C read drops the sample
+|    (the estimate ages, _CONTROL_ keeps the last one). Without an IMU
+|    found at boot (REG_IMU_CHECK 0) nothing is published and ARMED
+|    leaves the wings where they are.
+===========================================================================
+*/
+void CONTROLLER_TASKS::_SENSE_(void* ctx, const rate_tick_t& tick){
+    PROBE_SCOPE("rt.sense");
+    if(!imuReady_){
+        return;
+    }
+    ptam_attitude_t attitude;
+    if(BMI088_IMU::read_attitude(attitude.pitch, attitude.roll, attitude.yaw, tick.dt_s) != ESP_OK){
+        return;
     }
+    attitude.time_us = tick.now_us;
+    SharedMemory::getInstance().attitude().publish(attitude);
+}
 
+FlightPipeline& CONTROLLER_TASKS::pipeline(){
+    static FlightPipeline pipeline(PIPELINE_DEFAULT_CONFIG, publishWings, nullptr);
+    return pipeline;
 }
 
-void CONTROLLER_TASKS::_ARMED_(){
-    //Start App
+GainSchedule& CONTROLLER_TASKS::gainSchedule(){
+    static GainSchedule schedule;
+    return schedule;
+}
+
+PTAMStore& CONTROLLER_TASKS::gainStore(){
+    static PTAMNvsStore store;
+    //Own namespace, the register persistence commits on its own schedule
+    store.open(GAIN_STORE_NAMESPACE);
+    return store;
+}
+
+WingCalibration& CONTROLLER_TASKS::wingCalibration(){
+    static WingCalibration calibration;
+    return calibration;
+}
+
+PTAMStore& CONTROLLER_TASKS::calibrationStore(){
+    static PTAMNvsStore store;
+    store.open(WING_CAL_STORE_NAMESPACE);
+    return store;
+}
+
+bool CONTROLLER_TASKS::uploadGains(const char* text, std::size_t len){
+    //Too big for the HTTP task's stack, uploads are handled one at a time
+    static gain_table_t table;
+    if(!GainSchedule::parse(text, len, table)){
+        ESP_LOGW("GAINS", "Rejected gain table (%u bytes)", unsigned(len));
+        return false;
+    }
+    gainSchedule().load(table);
+    if(!GainSchedule::save(gainStore(), table)){
+        //Flies now, but a restart goes back to the previous table
+        ESP_LOGE("GAINS", "Gain table not stored");
+    }
+    ESP_LOGI("GAINS", "Loaded %ux%u gain table", table.speed_points, table.alt_points);
+    return true;
+}
+
+ScratchArena& CONTROLLER_TASKS::controlArena(){
+    static StaticArena<CONTROL_ARENA_BYTES> arena;
+    return arena;
+}
+
+int CONTROLLER_TASKS::controlHealth(){
+    //Inactive until the ARMED entry enables the groups
+    static const int id = HealthMonitor::getInstance().add({"rt_control", CONTROL_LOOP_DEADLINE_US, true, false});
+    return id;
+}
+
+//Pipeline actuator stage: lock-free hand-off to _ACTUATE_
+void CONTROLLER_TASKS::publishWings(void* ctx, const wing_set_t& wings){
+    SharedMemory::getInstance().wings().publish({wings.fl, wings.fr, wings.rl, wings.rr, esp_timer_get_time()});
+}
+
+void CONTROLLER_TASKS::armPipeline(){
+    SharedMemory& sharedMemory = SharedMemory::getInstance();
+    missionLat_ = sharedMemory.getLastDouble(REG_TLAT);
+    missionLong_ = sharedMemory.getLastDouble(REG_TLONG);
+    //Single waypoint: the target, which is the origin of the local frame
+    const waypoint_t target = {0.0, 0.0, sharedMemory.getLastDouble(REG_TALT)};
+    pipeline().setMission(&target, 1);
+    pipeline().setSchedule(&gainSchedule());
+    pipeline().resetStats();
+    //Servos may have moved under BYPASS, the first flight frame always goes out
+    for(uint8_t i = 0; i < BYPASS_WINGS; i++){
+        actuatedAngle_[i] = NAN;
+    }
+    //Bumpless: continue from the wings BYPASS (or the last flight) left,
+    //disarmPipeline() keeps bypassSeen_ on the flown position
+    nav_state_t nav;
+    if(readNav(nav)){
+        const wing_set_t wings = {
+            bypassSeen_[0].angle, bypassSeen_[1].angle, bypassSeen_[2].angle, bypassSeen_[3].angle,
+        };
+        pipeline().transfer(wings, nav);
+    }
+}
+
+void CONTROLLER_TASKS::disarmPipeline(){
+    drainActuation();
+    RegisterFile& regs = SharedMemory::getInstance().registers();
+    for(uint8_t i = 0; i < BYPASS_WINGS; i++){
+        //Operator writes made while ARMED are stale, BYPASS acts on new ones only
+        bypassSeen_[i].seq = regs.seq(bypassWingRegs_[i]);
+        //The servos hold the last flight frame (groups idle, safe to read)
+        if(!std::isnan(actuatedAngle_[i])){
+            bypassSeen_[i].angle = actuatedAngle_[i];
+        }
+    }
+}
+
+bool CONTROLLER_TASKS::readNav(nav_state_t& nav){
+    SharedMemory& sharedMemory = SharedMemory::getInstance();
+    if(sharedMemory.attitude().version() == 0){
+        return false;
+    }
+    const ptam_attitude_t attitude = sharedMemory.attitude().read();
+    nav = {0.0, 0.0, 0.0, attitude.pitch, attitude.roll, attitude.yaw, false};
+    if(sharedMemory.position().version() != 0){
+        const ptam_position_t position = sharedMemory.position().read();
+        FlightPipeline::geoToLocal(position.lat, position.lon, missionLat_, missionLong_, nav.x, nav.y);
+        nav.z = position.alt;
+        nav.position_valid = true;
+    }
+    return true;
+}
+
+//____________________________________________________________
+/* Rate group -> flight application (CONTROL_LOOP_HZ)
+===========================================================================
+|    Builds the nav state from the attitude and position snapshots and
+|    runs one FlightPipeline step with the measured dt. The pipeline's
+|    actuator stage publishes SharedMemory::wings() for _ACTUATE_.
+|    No attitude estimate yet -> nothing to control, wings stay put.
+===========================================================================
+*/
+void CONTROLLER_TASKS::_CONTROL_(void* ctx, const rate_tick_t& tick){
+    PROBE_SCOPE("rt.control");
+    if(tick.release == 0){
+        //Registered from the main task, the stack mark is this task's
+        HealthMonitor::getInstance().attach(controlHealth());
+    }
+    //Every run is progress, beats when the tick ends
+    HealthMonitor::Work alive(controlHealth());
+    //Tick scratch is dropped on every return path
+    ArenaCycle cycle(controlArena());
+    nav_state_t nav;
+    if(!readNav(nav)){
+        return;
+    }
+    pipeline().step(nav, tick.dt_s);
+}
+
+//____________________________________________________________
+/* Rate group -> servo output (CONTROL_ACTUATE_HZ, the MG90S frame rate)
+===========================================================================
+|    Sends the latest wings snapshot, only when a new one was published,
+|    and queues the frame as telemetry for the main loop (never the
+|    register lock here).
+|    A servo is only rewritten once its angle moved by WING_DEADBAND_DEG,
+|    so sub-resolution PID wiggle does not make it chatter.
+===========================================================================
+*/
+void CONTROLLER_TASKS::_ACTUATE_(void* ctx, const rate_tick_t& tick){
+    PROBE_SCOPE("rt.actuate");
+    SharedMemory& sharedMemory = SharedMemory::getInstance();
+    PTAMSnapshot<ptam_wings_t>& wings = sharedMemory.wings();
+    const uint32_t version = wings.version();
+    if(version == actuatedVersion_){
+        return;
+    }
+    const ptam_wings_t position = wings.read();
+    const double angle[BYPASS_WINGS] = {position.fl, position.fr, position.rl, position.rr};
+    for(uint8_t i = 0; i < BYPASS_WINGS; i++){
+        //NaN (nothing sent yet) compares false, so the first frame always goes out
+        if(std::fabs(angle[i] - actuatedAngle_[i]) < WING_DEADBAND_DEG){
+            continue;
+        }
+        WingTranslate::servo_control(wingCalibration().servo(wing_id_t(i), angle[i]), bypassServoPins_[i]);
+        actuatedAngle_[i] = angle[i];
+    }
+    actuatedVersion_ = version;
+    //A full queue drops the frame, the servos already have it
+    sharedMemory.actuation().push(position);
+}
+
+void CONTROLLER_TASKS::safeWings(){
+    RateScheduler& groups = scheduler();
+    groups.setEnabled(false);
+    const bool idle = groups.waitIdle(CONTROL_STOP_TIMEOUT_US);
+    const double neutral[BYPASS_WINGS] = {WING_LEFT_DEPLOYED, WING_RIGHT_DEPLOYED, WING_LEFT_DEPLOYED, WING_RIGHT_DEPLOYED};
+    for(uint8_t i = 0; i < BYPASS_WINGS; i++){
+        WingTranslate::servo_control(wingCalibration().servo(wing_id_t(i), neutral[i]), bypassServoPins_[i]);
+        //A stuck actuate group still owns its state, the servos are written regardless
+        if(idle){
+            actuatedAngle_[i] = neutral[i];
+        }
+    }
+    ESP_LOGW("SAFE", "Wings neutral, control groups %s", idle ? "stopped" : "still running");
+}
+
+std::size_t CONTROLLER_TASKS::drainActuation(){
+    SharedMemory& sharedMemory = SharedMemory::getInstance();
+    std::size_t drained = 0;
+    ptam_wings_t frame;
+    //Telemetry only: REG_WING_* are operator commands (BYPASS) and wake
+    //the main loop, actuated frames never go there
+    while(sharedMemory.actuation().pop(frame)){
+        lastActuated_ = frame;
+        drained++;
+    }
+    return drained;
 }
 
 //For manual testing, implement bypass to respond to sensor and motor
@@ -114,56 +400,37 @@ void CONTROLLER_TASKS::_ARMED_(){
 //No function overloading possible so search SBC table to 
 //determine if return or non-return peripheral !! needs attention !!
 void CONTROLLER_TASKS::_bypass_(std::string sbc_id){
+    PROBE_SCOPE("ctl.bypass");
     //Check if there is any update to the ptam registers
     SharedMemory& sharedMemory = SharedMemory::getInstance();
-    //If there is a difference between Wing Register and referenceupdate register there has been an update
-    auto dtaWFL = sharedMemory.getLastDouble("WingFL");
-    auto dtaWFR = sharedMemory.getLastDouble("WingFR");
-    auto dtaWRL = sharedMemory.getLastDouble("WingRL");
-    auto dtaWRR = sharedMemory.getLastDouble("WingRR");
-
-    auto dtaWFL_ref = sharedMemory.getLastDouble("FL-ref-byp");
-    auto dtaWFR_ref = sharedMemory.getLastDouble("FR-ref-byp");
-    auto dtaWRL_ref = sharedMemory.getLastDouble("RL-ref-byp");
-    auto dtaWRR_ref = sharedMemory.getLastDouble("RR-ref-byp");
-
-    ESP_LOGI("SEN", "FL %f",dtaWFL);
-    ESP_LOGI("SEN", "FL-ref %f",dtaWFL_ref);
-
-    WingTranslate *obj = new WingTranslate();
-    if(dtaWFL != dtaWFL_ref){
-        //There has been an update, wings can be commanded
-        obj -> servo_control(dtaWFL,SERVO_FL);
-        //Update the reference register
-        //Clear previous register to avoid memory overflow
-        sharedMemory.clearData("FL-ref-byp");
-        sharedMemory.storeDouble("FL-ref-byp", dtaWFL);
-    }
-    if(dtaWFR != dtaWFR_ref){
-        //There has been an update, wings can be commanded
-        obj -> servo_control(dtaWFR,SERVO_FR);
-        //Update the reference register
-        //Clear previous register to avoid memory overflow
-        sharedMemory.clearData("FR-ref-byp");
-        sharedMemory.storeDouble("FR-ref-byp", dtaWFR);
-    }
-    if(dtaWRL != dtaWRL_ref){
-        //There has been an update, wings can be commanded
-        obj -> servo_control(dtaWRL,SERVO_RL);
-        //Update the reference register
-        //Clear previous register to avoid memory overflow
-        sharedMemory.clearData("RL-ref-byp");
-        sharedMemory.storeDouble("RL-ref-byp", dtaWRL);
-    }
-    if(dtaWRR != dtaWRR_ref){
-        //There has been an update, wings can be commanded
-        obj -> servo_control(dtaWRR,SERVO_RR);
-        //Update the reference register
-        //Clear previous register to avoid memory overflow
-        sharedMemory.clearData("RR-ref-byp");
-        sharedMemory.storeDouble("RR-ref-byp", dtaWRR);
-    }
-    delete obj;
+    RegisterFile& regs = sharedMemory.registers();
+
+    bool actuated = false;
+    double position[BYPASS_WINGS];
+    for(uint8_t i = 0; i < BYPASS_WINGS; i++){
+        const ptam_reg_t reg = bypassWingRegs_[i];
+        ptam_sample_t sample;
+        //Nothing written since the last pass, skip the register entirely
+        if(!regs.changedSince(reg, bypassSeen_[i].seq) || !regs.latest(reg, sample)){
+            position[i] = bypassSeen_[i].angle;
+            continue;
+        }
+        bypassSeen_[i].seq = sample.seq;
+        position[i] = RegisterFile::asDouble(reg, sample);
+        //Rewriting the same angle is not a new command
+        if(position[i] == bypassSeen_[i].angle){
+            continue;
+        }
+        ESP_LOGI("SEN", "%s %f (seq %u)", RegisterFile::describe(reg).id, position[i], (unsigned)sample.seq);
+        WingTranslate::servo_control(wingCalibration().servo(wing_id_t(i), position[i]), bypassServoPins_[i]);
+        bypassSeen_[i].angle = position[i];
+        actuated = true;
+    }
+    if(actuated){
+        //Own channel: the control group may still be finishing a wings()
+        //publish, each snapshot has a single writer
+        sharedMemory.bypassWings().publish({position[0], position[1], position[2], position[3], esp_timer_get_time()});
+    }
 }
  //Sensor bypass
 
@@ -173,63 +440,66 @@ void CONTROLLER_TASKS::PTAM_REGISTER_SET(){
     // Store data in shared memory
     SharedMemory& sharedMemory = SharedMemory::getInstance();
 
-    sharedMemory.storeInt("state", 1);
-    sharedMemory.storeString("stateDescript", "PREP");
+    sharedMemory.storeInt(REG_STATE, 1);
+    sharedMemory.storeString(REG_STATE_DESCRIPT, "PREP");
 
-    sharedMemory.storeString("arm_token", "");
+    sharedMemory.storeString(REG_ARM_TOKEN, "");
 
     //GPS functionality flag
-    sharedMemory.storeInt("GPScheck", 0);
+    sharedMemory.storeInt(REG_GPS_CHECK, 0);
     //IMU functionality flag
-    sharedMemory.storeInt("IMUcheck", 0);
+    sharedMemory.storeInt(REG_IMU_CHECK, 0);
     //BMP functionality flag
-    sharedMemory.storeInt("BMPcheck", 0);
+    sharedMemory.storeInt(REG_BMP_CHECK, 0);
     //Latitude functionality flag
-    sharedMemory.storeInt("LATITUDE_CHECK", 0);
+    sharedMemory.storeInt(REG_LATITUDE_CHECK, 0);
     //Longitude functionality flag
-    sharedMemory.storeInt("LONGITUDE_CHECK", 0);
+    sharedMemory.storeInt(REG_LONGITUDE_CHECK, 0);
     //Altitude functionality flag
-    sharedMemory.storeInt("ALTITUDE_CHECK", 0);
+    sharedMemory.storeInt(REG_ALTITUDE_CHECK, 0);
     //Velocity functionality flag
-    sharedMemory.storeInt("VELOCITY_CHECK", 0);
+    sharedMemory.storeInt(REG_VELOCITY_CHECK, 0);
     //Pitch functionality flag
-    sharedMemory.storeInt("PITCH_CHECK", 0);
+    sharedMemory.storeInt(REG_PITCH_CHECK, 0);
     //Roll functionality flag
-    sharedMemory.storeInt("ROLL_CHECK", 0);
+    sharedMemory.storeInt(REG_ROLL_CHECK, 0);
     //Yaw functionality flag
-    sharedMemory.storeInt("YAW_CHECK", 0);
+    sharedMemory.storeInt(REG_YAW_CHECK, 0);
     //Temperature functionality flag
-    sharedMemory.storeInt("TEMPERATURE_CHECK", 0);
+    sharedMemory.storeInt(REG_TEMPERATURE_CHECK, 0);
     //Pressure functionality flag
-    sharedMemory.storeInt("PRESSURE_CHECK", 0);
+    sharedMemory.storeInt(REG_PRESSURE_CHECK, 0);
 
     //ServerSetupFlag
-    sharedMemory.storeInt("setupSFlag", 0);
+    sharedMemory.storeInt(REG_SETUP_SFLAG, 0);
+    //Mission targets keep values restored from NVS, only unset ones are seeded
+    RegisterFile& regs = sharedMemory.registers();
     //Target Latitude 
-    sharedMemory.storeDouble("TLat", 0);
+    if(!regs.isSet(REG_TLAT)) sharedMemory.storeDouble(REG_TLAT, 0);
     //Target Longitude
-    sharedMemory.storeDouble("TLong", 0);
+    if(!regs.isSet(REG_TLONG)) sharedMemory.storeDouble(REG_TLONG, 0);
     //Target Altitude
-    sharedMemory.storeDouble("TAlt", 0);
+    if(!regs.isSet(REG_TALT)) sharedMemory.storeDouble(REG_TALT, 0);
     //Cruise Altitude
-    sharedMemory.storeDouble("CAlt", 0);
+    if(!regs.isSet(REG_CALT)) sharedMemory.storeDouble(REG_CALT, 0);
     //Target Velocity
-    sharedMemory.storeDouble("TVel", 0);
+    if(!regs.isSet(REG_TVEL)) sharedMemory.storeDouble(REG_TVEL, 0);
     //Wing FL
-    sharedMemory.storeDouble("WingFL", 0);
-    sharedMemory.storeDouble("FL-ref-byp", 0);
+    sharedMemory.storeDouble(REG_WING_FL, 0);
     //Wing FR
-    sharedMemory.storeDouble("WingFR", 0);
-    sharedMemory.storeDouble("FR-ref-byp", 0);
+    sharedMemory.storeDouble(REG_WING_FR, 0);
     //Wing RL
-    sharedMemory.storeDouble("WingRL", 0);
-    sharedMemory.storeDouble("RL-ref-byp", 0);
+    sharedMemory.storeDouble(REG_WING_RL, 0);
     //Wing RR
-    sharedMemory.storeDouble("WingRR", 0);
-    sharedMemory.storeDouble("RR-ref-byp", 0);
+    sharedMemory.storeDouble(REG_WING_RR, 0);
     //Throttle
-    sharedMemory.storeDouble("THR", 0);
-    sharedMemory.storeDouble("THR-ref-byp", 0);
+    sharedMemory.storeDouble(REG_THR, 0);
+
+    //Bypass only actuates on writes after the defaults
+    for(uint8_t i = 0; i < BYPASS_WINGS; i++){
+        bypassSeen_[i].seq = sharedMemory.registers().seq(bypassWingRegs_[i]);
+        bypassSeen_[i].angle = 0;
+    }
 
     //auto po = init.getStringData(std::string("stateDescript")).back();
     //std::cout << po << std::endl;
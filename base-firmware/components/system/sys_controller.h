@@ -26,6 +26,15 @@ SOFTWARE.*/
 #include<iostream>
 #include<string>
 #include"../PTAM/_ptam.h"
+#include"../PTAM/_ptam_persist.h"
+#include"../Profiling/_probe.h"
+#include"_rate_scheduler.h"
+#include"_memory.h"
+#include"_health.h"
+#include"../Memory/_arena.h"
+#include"_task_layout.h"
+#include"../App/_pipeline.h"
+#include"../App/_wing_calibration.h"
 #include"validateSensors.h"
 #include"esp_log.h"
 #include "esp_timer.h"
@@ -38,12 +47,17 @@ class CONTROLLER_TASKS {
 
         std::string generateRandomAlphanumericToken(uint32_t seed1, uint32_t seed2, int length);
 
+        //Takes a pending idle / memory restart (MemoryManager::restartDue),
+        //call from safe states only
         void restart_after_idle_task();
 
         bool log_event_handler();
 
         void PTAM_REGISTER_SET();
 
+        //Persisted PTAM registers (mission targets), flush() from the main loop
+        static PTAMPersistence& persistence();
+
         //Start comms and attach interrupts 
         void _init_();
 
@@ -54,12 +68,114 @@ class CONTROLLER_TASKS {
 
         void _ARMED_();
 
+        //Fixed-rate control groups (sense / control / actuate), pinned to
+        //CONTROL_CORE (see _task_layout.h). Created on first use, start()
+        //once from boot, setEnabled() follows the ARMED state.
+        static RateScheduler& scheduler();
+
+        //Rate group bodies, run on their own scheduler tasks
+        static void _SENSE_(void* ctx, const rate_tick_t& tick);
+        static void _CONTROL_(void* ctx, const rate_tick_t& tick);
+        static void _ACTUATE_(void* ctx, const rate_tick_t& tick);
+
+        //Flight application run by _CONTROL_, owned by the control task
+        static FlightPipeline& pipeline();
+
+        //PID gain schedule the pipeline looks up every tick, loaded from
+        //NVS by _init_ and replaced by uploadGains()
+        static GainSchedule& gainSchedule();
+
+        //Linkage curves every servo write goes through, loaded from NVS by
+        //_init_ (identity without a stored calibration)
+        static WingCalibration& wingCalibration();
+
+        //____________________________________________________________
+        /* Main subroutine -> new gain table from the ground (HTTP task)
+        ===========================================================================
+        |    text / len      Table in the GainSchedule::parse() format
+        |    Returns         false if it does not parse or validate; the
+        |                    table in use is kept. Stored in NVS otherwise,
+        |                    the next control tick flies it.
+        ===========================================================================
+        */
+        static bool uploadGains(const char* text, std::size_t len);
+
+        //Scratch data of one _CONTROL_ tick (reset when the tick ends),
+        //owned by the control task
+        static ScratchArena& controlArena();
+
+        //Health monitor id of the control group, only checked while ARMED
+        static int controlHealth();
+
+        //ARMED entry (before the groups are enabled): mission from the
+        //persisted target registers, fresh pipeline state
+        static void armPipeline();
+
+        //ARMED exit, once the groups are idle (RateScheduler::waitIdle):
+        //drains the actuation queue and hands the flown wing position to
+        //BYPASS, which then only acts on operator writes made after this
+        static void disarmPipeline();
+
+        //____________________________________________________________
+        /* Main subroutine -> safe mode, callable from any task
+        ===========================================================================
+        |    Disables the control groups, waits (bounded) for a run in flight,
+        |    then commands every wing to its deployed (neutral) position.
+        |    Does not need the main loop, the health task calls it directly.
+        ===========================================================================
+        */
+        static void safeWings();
+
+        //Main loop (PRO_CPU): drain actuated frames from the control core,
+        //keeps the newest (lastActuated). Returns frames drained.
+        static std::size_t drainActuation();
+        //Newest actuated frame drained, time_us 0 before the first one
+        static const ptam_wings_t& lastActuated() { return lastActuated_; }
+
         //For manual testing, implement bypass to respond to sensor and valve
         //comms without additional processes.
         //+1 Overload
         void _bypass_(std::string sbc_id);
         //void _bypass_(char* sbc_id,uint8_t peripheral_type=1); 
 
+    private:
+        //NVS namespace GAIN_STORE_NAMESPACE, holds the uploaded gain table
+        static PTAMStore& gainStore();
+        //NVS namespace WING_CAL_STORE_NAMESPACE, holds the wing calibration
+        static PTAMStore& calibrationStore();
+
+        static constexpr uint8_t BYPASS_WINGS = 4;
+
+        //Last register seq handled and last angle commanded per wing
+        struct bypass_seen_t {
+            uint32_t seq;
+            double angle;
+        };
+
+        static const ptam_reg_t bypassWingRegs_[BYPASS_WINGS];
+        static const uint8_t bypassServoPins_[BYPASS_WINGS];
+        static bypass_seen_t bypassSeen_[BYPASS_WINGS];
+
+        //Wings snapshot version last sent to the servos by _ACTUATE_
+        static uint32_t actuatedVersion_;
+        //Angle last sent per servo, NaN before the first frame
+        static double actuatedAngle_[BYPASS_WINGS];
+        //Main loop copy of the newest actuation queue frame
+        static ptam_wings_t lastActuated_;
+
+        //BMI088 started by _init_, _SENSE_ samples it only then
+        static bool imuReady_;
+
+        //Mission reference (target lat / long), cached at arm time so the
+        //control task never reads the PTAM registers
+        static double missionLat_;
+        static double missionLong_;
+
+        static void publishWings(void* ctx, const wing_set_t& wings);
+
+        //Nav state from the attitude / position snapshots, false without attitude
+        static bool readNav(nav_state_t& nav);
+
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,193 @@
+/**
+ * @file benchAffinity.cpp
+ * @brief Control loop release jitter under heavy web UI polling, shared vs partitioned
+ *
+ * A 400 Hz control thread (absolute sleeps) runs next to web UI poller
+ * threads that hammer the PTAM dump and history calls, as the HTTP
+ * handlers do. Two layouts are compared:
+ *
+ *  shared       everything on any CPU, control writes its outputs into the
+ *               PTAM registers (the lock the pollers hold)
+ *  partitioned  control pinned to its own CPU, pollers and the drain
+ *               thread on CPU 0, outputs cross through PTAMQueue
+ *
+ * This is the host model of _task_layout.h: Linux CFS instead of FreeRTOS,
+ * so absolute numbers differ from the target, the shape is what matters.
+ * With a single CPU both layouts share it and only the lock-free handoff
+ * differs. Not run by ctest.
+ *
+ * @copyright Copyright (c) 2023 limitless Aeronautics
+ *            This file is part of the MARS Flight System Firmware
+ *
+ * @license MIT License
+ *          Copyright (c) 2023 limitless Aeronautics
+ *          Permission is hereby granted, free of charge, to any person obtaining a copy
+ *          of this software and associated documentation files (the "Software"), to deal
+ *          in the Software without restriction, including without limitation the rights
+ *          to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *          copies of the Software, and to permit persons to whom the Software is
+ *          furnished to do so, subject to the following conditions:
+ *          The above copyright notice and this permission notice shall be included in all
+ *          copies or substantial portions of the Software.
+ *          THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *          IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *          FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *          AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *          LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *          OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *          SOFTWARE.
+ */
+/* System includes */
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <vector>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+/* Core includes */
+#include "_ptam.h"
+#include "_task_layout.h"
+
+#define BENCH_POLLERS       3
+#define BENCH_RATE_HZ       CONTROL_SENSE_HZ
+#define BENCH_CYCLES        2000
+#define BENCH_DUMP_BYTES    4096
+
+struct bench_ctx_t {
+    bool partitioned;
+    int cpus;
+    std::atomic<bool> done{false};
+    std::atomic<uint64_t> polls{0};
+    int64_t actuated_us = 0;        //Newest drained frame
+    std::vector<int64_t> jitter_ns;
+};
+
+static int64_t now_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+static void pin(int cpu) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+/* Web UI: /GET_PTAM dumps and history reads, back to back */
+static void* poller(void* arg) {
+    bench_ctx_t* ctx = static_cast<bench_ctx_t*>(arg);
+    if (ctx->partitioned) {
+        pin(CORE_PRO);
+    }
+    SharedMemory& sharedMemory = SharedMemory::getInstance();
+    static thread_local uint8_t buffer[BENCH_DUMP_BYTES];
+    uint64_t polls = 0;
+    while (!ctx->done.load(std::memory_order_relaxed)) {
+        sharedMemory.dump(buffer, sizeof(buffer));
+        sharedMemory.getDoubleData("WingFL");
+        polls++;
+    }
+    ctx->polls += polls;
+    return nullptr;
+}
+
+/* Main loop stand-in: drains queued frames, keeps the newest (telemetry) */
+static void* drain(void* arg) {
+    bench_ctx_t* ctx = static_cast<bench_ctx_t*>(arg);
+    pin(CORE_PRO);
+    SharedMemory& sharedMemory = SharedMemory::getInstance();
+    ptam_wings_t frame;
+    while (!ctx->done.load(std::memory_order_relaxed)) {
+        while (sharedMemory.actuation().pop(frame)) {
+            ctx->actuated_us = frame.time_us;
+        }
+        usleep(1000);
+    }
+    return nullptr;
+}
+
+/* Control: release on an absolute timeline, record how late each wake is */
+static void* control(void* arg) {
+    bench_ctx_t* ctx = static_cast<bench_ctx_t*>(arg);
+    if (ctx->partitioned) {
+        pin(ctx->cpus > 1 ? CORE_APP : CORE_PRO);
+    }
+    SharedMemory& sharedMemory = SharedMemory::getInstance();
+    const int64_t period = 1000000000 / BENCH_RATE_HZ;
+    int64_t ideal = now_ns() + period;
+    for (int i = 0; i < BENCH_CYCLES; ++i) {
+        timespec ts;
+        ts.tv_sec = ideal / 1000000000;
+        ts.tv_nsec = ideal % 1000000000;
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr);
+        const int64_t start = now_ns();
+
+        const double angle = static_cast<double>(i % 40);
+        const ptam_wings_t frame = {230.0 + angle, 130.0 - angle, 270.0 - angle, 90.0 + angle, start / 1000};
+        if (ctx->partitioned) {
+            sharedMemory.wings().publish(frame);
+            sharedMemory.actuation().push(frame);
+        } else {
+            sharedMemory.storeDouble(REG_WING_FL, frame.fl);
+            sharedMemory.storeDouble(REG_WING_FR, frame.fr);
+            sharedMemory.storeDouble(REG_WING_RL, frame.rl);
+            sharedMemory.storeDouble(REG_WING_RR, frame.rr);
+        }
+        //End of the cycle: jitter includes the time spent waiting on outputs
+        ctx->jitter_ns.push_back(now_ns() - ideal);
+        ideal += period;
+    }
+    ctx->done.store(true);
+    return nullptr;
+}
+
+static void run(const char* name, bool partitioned, int cpus) {
+    bench_ctx_t ctx;
+    ctx.partitioned = partitioned;
+    ctx.cpus = cpus;
+    ctx.jitter_ns.reserve(BENCH_CYCLES);
+
+    pthread_t pollers[BENCH_POLLERS];
+    pthread_t drainer;
+    pthread_t controller;
+    for (pthread_t& thread : pollers) {
+        pthread_create(&thread, nullptr, poller, &ctx);
+    }
+    if (partitioned) {
+        pthread_create(&drainer, nullptr, drain, &ctx);
+    }
+    pthread_create(&controller, nullptr, control, &ctx);
+    pthread_join(controller, nullptr);
+    for (pthread_t& thread : pollers) {
+        pthread_join(thread, nullptr);
+    }
+    if (partitioned) {
+        pthread_join(drainer, nullptr);
+    }
+
+    std::vector<int64_t>& j = ctx.jitter_ns;
+    std::sort(j.begin(), j.end());
+    double mean = 0.0;
+    for (int64_t v : j) {
+        mean += v;
+    }
+    mean /= j.size();
+    std::printf("[%-11s] %d cpu | %d Hz x %d | web polls %llu | jitter us: mean %.1f p50 %.1f p99 %.1f max %.1f | queue drops %u\n",
+                name, cpus, BENCH_RATE_HZ, BENCH_CYCLES,
+                static_cast<unsigned long long>(ctx.polls.load()),
+                mean / 1e3, j[j.size() / 2] / 1e3, j[j.size() * 99 / 100] / 1e3, j.back() / 1e3,
+                SharedMemory::getInstance().actuation().dropped());
+}
+
+int main() {
+    const int cpus = static_cast<int>(sysconf(_SC_NPROCESSORS_ONLN));
+    run("shared", false, cpus);
+    run("partitioned", true, cpus);
+    return EXIT_SUCCESS;
+}
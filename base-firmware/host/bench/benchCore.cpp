@@ -0,0 +1,297 @@
+/**
+ * @file benchCore.cpp
+ * @brief Per-cycle cost microbenchmarks for the host-built flight core
+ *
+ * Covers the calls the main loop makes every pass: PTAM store / load by
+ * register and by string ID, one PID step and a full decomposer sweep,
+ * plus the overhead of one probe scope. The PID step is measured for the
+ * legacy vector controller, its pointer overload and PIDBank<N, T> in
+ * double, float and Q16.16. One gain schedule lookup on a full table.
+ * Wing mixing: the legacy string dispatched decomposeXX (one wing, one
+ * axis and one PID step per call) against one WingMixer pass over all
+ * four wings, and the coupled WingAllocator solve. Range mapping: the
+ * double remap with its per call division against a Q16.16 FixedLUT, and
+ * one calibrated servo angle.
+ *
+ *
+ * @copyright Copyright (c) 2023 limitless Aeronautics
+ *            This file is part of the MARS Flight System Firmware
+ *
+ * @license MIT License
+ *          Copyright (c) 2023 limitless Aeronautics
+ *          Permission is hereby granted, free of charge, to any person obtaining a copy
+ *          of this software and associated documentation files (the "Software"), to deal
+ *          in the Software without restriction, including without limitation the rights
+ *          to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *          copies of the Software, and to permit persons to whom the Software is
+ *          furnished to do so, subject to the following conditions:
+ *          The above copyright notice and this permission notice shall be included in all
+ *          copies or substantial portions of the Software.
+ *          THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *          IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *          FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *          AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *          LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *          OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *          SOFTWARE.
+ */
+/* System includes */
+#include <string>
+#include <vector>
+
+/* Core includes */
+#include "_ptam.h"
+#include "_pid.h"
+#include "_pid_bank.h"
+#include "_gain_schedule.h"
+#include "decomposer.h"
+#include "_mixer.h"
+#include "_lut.h"
+#include "_wing_calibration.h"
+#include "_probe.h"
+
+/* Google benchmark */
+#include <benchmark/benchmark.h>
+
+//PTAM store through the fixed register, no string lookup
+static void BM_PTAMStoreReg(benchmark::State& state) {
+    SharedMemory& sharedMemory = SharedMemory::getInstance();
+    double value = 0.0;
+    for (auto _ : state) {
+        sharedMemory.storeDouble(REG_WING_FL, value);
+        value += 1.0;
+    }
+}
+
+//PTAM store through the legacy string ID
+static void BM_PTAMStoreId(benchmark::State& state) {
+    SharedMemory& sharedMemory = SharedMemory::getInstance();
+    const std::string id = "WingFL";
+    double value = 0.0;
+    for (auto _ : state) {
+        sharedMemory.storeDouble(id, value);
+        value += 1.0;
+    }
+}
+
+static void BM_PTAMLoadReg(benchmark::State& state) {
+    SharedMemory& sharedMemory = SharedMemory::getInstance();
+    sharedMemory.storeDouble(REG_WING_FL, 42.0);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(sharedMemory.getLastDouble(REG_WING_FL));
+    }
+}
+
+static void BM_PTAMLoadId(benchmark::State& state) {
+    SharedMemory& sharedMemory = SharedMemory::getInstance();
+    const std::string id = "WingFL";
+    sharedMemory.storeDouble(REG_WING_FL, 42.0);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(sharedMemory.getLastDouble(id));
+    }
+}
+
+//Snapshot read, what the web and logging tasks use for the hot groups
+static void BM_PTAMSnapshotRead(benchmark::State& state) {
+    SharedMemory& sharedMemory = SharedMemory::getInstance();
+    sharedMemory.wings().publish({1.0, 2.0, 3.0, 4.0, 5});
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(sharedMemory.wings().read());
+    }
+}
+
+//One PID step on the three axis vector, as mapToRangePitch runs it
+static void BM_PIDStep(benchmark::State& state) {
+    PID pid;
+    std::vector<double> integral = {0.0, 0.0, 0.0};
+    std::vector<double> previous = {0.0, 0.0, 0.0};
+    const std::vector<double> target = {30.0, 0.0, 0.0};
+    std::vector<double> current = {0.0, 0.0, 0.0};
+    for (auto _ : state) {
+        std::vector<double> out = pid.pid_controller(target, current, 1.01, 0.12, 0.68,
+                                                     integral, previous, 0.1, 0, 90);
+        benchmark::DoNotOptimize(out.data());
+    }
+}
+
+//Same three axis step on caller-owned arrays, no allocation
+static void BM_PIDStepPointer(benchmark::State& state) {
+    PID pid;
+    double integral[3] = {0.0, 0.0, 0.0};
+    double previous[3] = {0.0, 0.0, 0.0};
+    const double target[3] = {30.0, 0.0, 0.0};
+    const double current[3] = {0.0, 0.0, 0.0};
+    double out[3];
+    for (auto _ : state) {
+        pid.pid_controller(target, current, 3, 1.01, 0.12, 0.68, integral, previous, 0.1, 0, 90, out);
+        benchmark::DoNotOptimize(out);
+    }
+}
+
+//One step of an N axis bank, std::array state, per-axis gains
+template <std::size_t N, typename T>
+static void BM_PIDBankStep(benchmark::State& state) {
+    PIDBank<N, T> bank(pid_bank_gains_t<N, T>::uniform(1.01, 0.12, 0.68, 0, 90));
+    typename PIDBank<N, T>::vector_t target, current, out;
+    for (std::size_t i = 0; i < N; ++i) {
+        target[i] = T(30.0);
+        current[i] = T(i * 0.5);
+    }
+    const T dt(0.1);
+    for (auto _ : state) {
+        bank.step(target, current, dt, out);
+        benchmark::DoNotOptimize(out);
+    }
+    state.SetItemsProcessed(state.iterations() * N);
+}
+
+//Bilinear lookup of both axes on a full 8 x 6 table, swept across its cells
+static void BM_GainLookup(benchmark::State& state) {
+    gain_table_t table = {};
+    table.version = GAIN_TABLE_VERSION;
+    table.speed_points = GAIN_SPEED_POINTS;
+    table.alt_points = GAIN_ALT_POINTS;
+    table.speed_min = 8.0f;
+    table.speed_step = 2.0f;
+    table.alt_min = 50.0f;
+    table.alt_step = 25.0f;
+    for (auto& axis : table.gains) {
+        for (auto& row : axis) {
+            for (gain_triplet_t& g : row) {
+                g = {0.08f, 0.01f, 0.02f};
+            }
+        }
+    }
+    GainSchedule schedule;
+    schedule.load(table);
+    gain_triplet_t out[GAIN_AXES];
+    double speed = 0.0;
+    for (auto _ : state) {
+        speed = speed > 30.0 ? 0.0 : speed + 0.37;
+        schedule.lookup(speed, 40.0 + 6.0 * speed, out);
+        benchmark::DoNotOptimize(out);
+    }
+}
+
+//Pitch and roll sweeps over the full 0 - 90 deg target range, one item = one axis pair
+static void BM_DecomposerSweep(benchmark::State& state) {
+    StaticArena<256> arena;
+    for (auto _ : state) {
+        for (int target = 0; target <= 90; ++target) {
+            ArenaCycle cycle(arena);
+            ScratchSpan<double> pitch = DECOMPOSER::pitchAxisToSweep(arena, 45.0, static_cast<double>(target));
+            ScratchSpan<double> roll = DECOMPOSER::rollAxisToSweep(arena, 45.0, static_cast<double>(target));
+            benchmark::DoNotOptimize(pitch.data);
+            benchmark::DoNotOptimize(roll.data);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * 91);
+}
+
+//Legacy path to all four wings for a pitch and a roll command: four string
+//dispatched calls, each one a PID step and an arena allocation
+static void BM_DecomposeLegacy(benchmark::State& state) {
+    StaticArena<256> arena;
+    double target = 0.0;
+    for (auto _ : state) {
+        ArenaCycle cycle(arena);
+        target = target > 90.0 ? 0.0 : target + 1.0;
+        ScratchSpan<double> fl = DECOMPOSER::decomposeFL(arena, "Pitch", 45.0, target);
+        ScratchSpan<double> fr = DECOMPOSER::decomposeFR(arena, "Pitch", 45.0, target);
+        ScratchSpan<double> rl = DECOMPOSER::decomposeRL(arena, "Roll", 45.0, target);
+        ScratchSpan<double> rr = DECOMPOSER::decomposeRR(arena, "Roll", 45.0, target);
+        benchmark::DoNotOptimize(fl.data);
+        benchmark::DoNotOptimize(fr.data);
+        benchmark::DoNotOptimize(rl.data);
+        benchmark::DoNotOptimize(rr.data);
+    }
+}
+
+//One table driven pass, all four inputs to all four wings with saturation priority
+static void BM_WingMixer(benchmark::State& state) {
+    const WingMixer mixer;
+    wing_set_t wings;
+    double command = -1.0;
+    for (auto _ : state) {
+        command = command > 1.0 ? -1.0 : command + 0.01;
+        const uint8_t cut = mixer.mix({command, -0.6 * command, 0.2, 0.1}, wings);
+        benchmark::DoNotOptimize(cut);
+        benchmark::DoNotOptimize(wings);
+    }
+}
+
+//Coupled pitch + roll allocation, saturated half of the time
+static void BM_WingAllocator(benchmark::State& state) {
+    const WingAllocator allocator;
+    wing_set_t wings;
+    double command = -1.0;
+    for (auto _ : state) {
+        command = command > 1.0 ? -1.0 : command + 0.01;
+        const alloc_moments_t achieved = allocator.allocate(command, -0.6 * command + 0.3, wings);
+        benchmark::DoNotOptimize(achieved);
+        benchmark::DoNotOptimize(wings);
+    }
+}
+
+//The remap decomposer, servo and IMU each carried: a division per call
+static void BM_RangeInterpolate(benchmark::State& state) {
+    double target = 0.0, end = 360.0;
+    //Ranges are arguments at run time, keep the division in the loop
+    benchmark::DoNotOptimize(end);
+    for (auto _ : state) {
+        target = target > 360.0 ? 0.0 : target + 0.7;
+        benchmark::DoNotOptimize(lut_interpolate(target, 0.0, end, 0.06, 2.1));
+    }
+}
+
+//Same remap from a table built once, fixed point in between
+static void BM_RangeFixedLUT(benchmark::State& state) {
+    static const FixedLUT<2> map = FixedLUT<2>::linear(0.0, 360.0, 0.06, 2.1);
+    q16_t target;
+    const q16_t step(0.7), wrap(360.0);
+    for (auto _ : state) {
+        target = target > wrap ? q16_t() : target + step;
+        benchmark::DoNotOptimize(map(target));
+    }
+}
+
+//One wing position through a nine point linkage curve
+static void BM_WingCalibration(benchmark::State& state) {
+    const WingCalibration calibration;
+    double position = 230.0;
+    for (auto _ : state) {
+        position = position > 270.0 ? 230.0 : position + 0.1;
+        benchmark::DoNotOptimize(calibration.servo(WING_RL, position));
+    }
+}
+
+//Cost of one PROBE_SCOPE around an empty body, the per-probe flight overhead
+static void BM_ProbeScope(benchmark::State& state) {
+    for (auto _ : state) {
+        PROBE_SCOPE("bench.scope");
+        benchmark::ClobberMemory();
+    }
+}
+
+BENCHMARK(BM_PTAMStoreReg);
+BENCHMARK(BM_PTAMStoreId);
+BENCHMARK(BM_PTAMLoadReg);
+BENCHMARK(BM_PTAMLoadId);
+BENCHMARK(BM_PTAMSnapshotRead);
+BENCHMARK(BM_PIDStep);
+BENCHMARK(BM_PIDStepPointer);
+BENCHMARK_TEMPLATE(BM_PIDBankStep, 3, double);
+BENCHMARK_TEMPLATE(BM_PIDBankStep, 3, float);
+BENCHMARK_TEMPLATE(BM_PIDBankStep, 3, q16_t);
+BENCHMARK_TEMPLATE(BM_PIDBankStep, 8, float);
+BENCHMARK(BM_GainLookup);
+BENCHMARK(BM_DecomposerSweep);
+BENCHMARK(BM_DecomposeLegacy);
+BENCHMARK(BM_WingMixer);
+BENCHMARK(BM_WingAllocator);
+BENCHMARK(BM_RangeInterpolate);
+BENCHMARK(BM_RangeFixedLUT);
+BENCHMARK(BM_WingCalibration);
+BENCHMARK(BM_ProbeScope);
+
+BENCHMARK_MAIN();
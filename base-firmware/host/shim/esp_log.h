@@ -0,0 +1,88 @@
+/*MIT License
+Copyright (c) 2023 limitless Aeronautics
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#ifndef HOST_SHIM_ESP_LOG_H
+#define HOST_SHIM_ESP_LOG_H
+
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+
+typedef enum {
+    ESP_LOG_NONE,
+    ESP_LOG_ERROR,
+    ESP_LOG_WARN,
+    ESP_LOG_INFO,
+    ESP_LOG_DEBUG,
+    ESP_LOG_VERBOSE
+} esp_log_level_t;
+
+//____________________________________________________________
+/* Host shim -> ESP_LOGx to stderr
+===========================================================================
+|    Level           Messages above the tag's esp_log_shim_level() are
+|                    dropped. Per-tag levels as in esp_log: "*" sets the
+|                    default and forgets every per-tag level. Defaults to
+|                    WARN so tests and benchmarks stay quiet.
+===========================================================================
+*/
+inline esp_log_level_t& esp_log_shim_default() {
+    static esp_log_level_t level = ESP_LOG_WARN;
+    return level;
+}
+
+inline std::map<std::string, esp_log_level_t>& esp_log_shim_tags() {
+    static std::map<std::string, esp_log_level_t> tags;
+    return tags;
+}
+
+inline esp_log_level_t esp_log_shim_level(const char* tag = "*") {
+    const auto it = esp_log_shim_tags().find(tag);
+    return it == esp_log_shim_tags().end() ? esp_log_shim_default() : it->second;
+}
+
+inline void esp_log_level_set(const char* tag, esp_log_level_t level) {
+    if (std::strcmp(tag, "*") == 0) {
+        esp_log_shim_default() = level;
+        esp_log_shim_tags().clear();
+        return;
+    }
+    esp_log_shim_tags()[tag] = level;
+}
+
+inline void esp_log_shim_write(esp_log_level_t level, char letter, const char* tag, const char* format, ...) {
+    if (level > esp_log_shim_level(tag)) {
+        return;
+    }
+    va_list args;
+    va_start(args, format);
+    std::fprintf(stderr, "%c (%s) ", letter, tag);
+    std::vfprintf(stderr, format, args);
+    std::fputc('\n', stderr);
+    va_end(args);
+}
+
+#define ESP_LOGE(tag, format, ...) esp_log_shim_write(ESP_LOG_ERROR, 'E', tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) esp_log_shim_write(ESP_LOG_WARN, 'W', tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) esp_log_shim_write(ESP_LOG_INFO, 'I', tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...) esp_log_shim_write(ESP_LOG_DEBUG, 'D', tag, format, ##__VA_ARGS__)
+#define ESP_LOGV(tag, format, ...) esp_log_shim_write(ESP_LOG_VERBOSE, 'V', tag, format, ##__VA_ARGS__)
+
+#endif // HOST_SHIM_ESP_LOG_H
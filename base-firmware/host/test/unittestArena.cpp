@@ -0,0 +1,237 @@
+/**
+ * @file unittestArena.cpp
+ * @brief Host tests for the scratch arenas, driver pools and allocation counter
+ *
+ * Arena alignment, exhaustion and O(1) reset, pool slots and their RAII
+ * handles, the arena backed decomposer sweeps, and the steady state check:
+ * many control cycles with no heap allocation at all.
+ *
+ * @copyright Copyright (c) 2023 limitless Aeronautics
+ *            This file is part of the MARS Flight System Firmware
+ *
+ * @license MIT License
+ *          Copyright (c) 2023 limitless Aeronautics
+ *          Permission is hereby granted, free of charge, to any person obtaining a copy
+ *          of this software and associated documentation files (the "Software"), to deal
+ *          in the Software without restriction, including without limitation the rights
+ *          to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *          copies of the Software, and to permit persons to whom the Software is
+ *          furnished to do so, subject to the following conditions:
+ *          The above copyright notice and this permission notice shall be included in all
+ *          copies or substantial portions of the Software.
+ *          THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *          IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *          FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *          AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *          LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *          OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *          SOFTWARE.
+ */
+/* System includes */
+#include <cmath>
+#include <cstring>
+
+/* Memory includes */
+#include "_arena.h"
+#include "_pool.h"
+#include "_alloc_count.h"
+
+/* Control path includes */
+#include "decomposer.h"
+#include "_pipeline.h"
+#include "_pid.h"
+
+/* Google testing */
+#include <gtest/gtest.h>
+
+/**
+ * @brief Blocks honour their alignment and a full arena fails without the heap
+ */
+TEST(Arena, Alignment_And_Exhaustion){
+    StaticArena<64> arena;
+    uint8_t* byte = static_cast<uint8_t*>(arena.allocate(1, 1));
+    ASSERT_NE(byte, nullptr);
+    double* value = arena.make<double>(2.5);
+    ASSERT_NE(value, nullptr);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(value) % alignof(double), 0u);
+    EXPECT_DOUBLE_EQ(*value, 2.5);
+
+    const uint32_t before = mem_alloc_count();
+    EXPECT_EQ(arena.allocate(128), nullptr);
+    ScratchSpan<double> none = arena.array<double>(64);
+    EXPECT_TRUE(none.empty());
+    EXPECT_EQ(none.data, nullptr);
+    EXPECT_EQ(arena.failures(), 2u);
+    EXPECT_EQ(mem_alloc_count(), before);
+}
+
+/**
+ * @brief reset() rewinds in one step, the high-water mark survives it
+ */
+TEST(Arena, Reset_And_High_Water){
+    StaticArena<256> arena;
+    {
+        ArenaCycle cycle(arena);
+        ScratchSpan<int> values = arena.array<int>(10);
+        ASSERT_EQ(values.size(), 10u);
+        for (int v : values) {
+            EXPECT_EQ(v, 0);
+        }
+        EXPECT_GE(arena.used(), 10 * sizeof(int));
+    }
+    EXPECT_EQ(arena.used(), 0u);
+    EXPECT_GE(arena.highWater(), 10 * sizeof(int));
+
+    //Same memory handed out again after the reset
+    ScratchSpan<int> first = arena.array<int>(4);
+    arena.reset();
+    ScratchSpan<int> second = arena.array<int>(4);
+    EXPECT_EQ(first.data, second.data);
+    EXPECT_EQ(arena.capacity(), 256u);
+}
+
+/**
+ * @brief format() writes a terminated string sized without the terminator
+ */
+TEST(Arena, Format){
+    StaticArena<64> arena;
+    ScratchSpan<char> text = arena.format("%s%g_%s%g", "alt", 12.5, "temp", 20.0);
+    ASSERT_FALSE(text.empty());
+    EXPECT_STREQ(text.data, "alt12.5_temp20");
+    EXPECT_EQ(text.size(), std::strlen("alt12.5_temp20"));
+
+    //Too long for what is left: empty, counted
+    ScratchSpan<char> big = arena.format("%080d", 1);
+    EXPECT_TRUE(big.empty());
+    EXPECT_EQ(arena.failures(), 1u);
+}
+
+struct driver_t {
+    explicit driver_t(int* live) : live_(live) { ++*live_; }
+    ~driver_t() { --*live_; }
+    int* live_;
+};
+
+/**
+ * @brief Pool slots are reused, an empty pool fails, PoolRef releases on scope exit
+ */
+TEST(Pool, Acquire_Release){
+    int live = 0;
+    StaticPool<driver_t, 2> pool;
+    driver_t* a = pool.acquire(&live);
+    driver_t* b = pool.acquire(&live);
+    ASSERT_NE(a, nullptr);
+    ASSERT_NE(b, nullptr);
+    EXPECT_EQ(pool.acquire(&live), nullptr);
+    EXPECT_EQ(pool.failures(), 1u);
+    EXPECT_EQ(live, 2);
+
+    pool.release(a);
+    EXPECT_EQ(live, 1);
+    EXPECT_EQ(pool.inUse(), 1u);
+    //A pointer the pool does not own is ignored
+    driver_t stray(&live);
+    pool.release(&stray);
+    EXPECT_EQ(pool.inUse(), 1u);
+    pool.release(b);
+
+    {
+        PoolRef<driver_t, 2> ref(pool, &live);
+        ASSERT_TRUE(ref);
+        EXPECT_EQ(pool.inUse(), 1u);
+    }
+    EXPECT_EQ(pool.inUse(), 0u);
+    EXPECT_EQ(live, 1);
+}
+
+/**
+ * @brief The sweeps fill spans from the arena, one position per wing of the axis
+ */
+TEST(Arena, Decomposer_Sweeps){
+    StaticArena<256> arena;
+    ArenaCycle cycle(arena);
+    ScratchSpan<double> pitch = DECOMPOSER::pitchAxisToSweep(arena, 45.0, 90.0);
+    ScratchSpan<double> roll = DECOMPOSER::rollAxisToSweep(arena, 45.0, 0.0);
+    ASSERT_EQ(pitch.size(), 2u);
+    ASSERT_EQ(roll.size(), 2u);
+    EXPECT_GT(arena.used(), 0u);
+    EXPECT_EQ(arena.failures(), 0u);
+
+    //A tiny arena degrades to an empty result, never a heap fallback
+    StaticArena<8> tiny;
+    EXPECT_TRUE(DECOMPOSER::pitchAxisToSweep(tiny, 45.0, 90.0).size() < 2);
+    EXPECT_GT(tiny.failures(), 0u);
+}
+
+/**
+ * @brief Steady state control cycles do not touch the heap
+ */
+TEST(Arena, Steady_State_Without_Heap){
+    const waypoint_t mission[] = {{400, 0, 110}, {400, 400, 110}};
+    FlightPipeline pipeline;
+    ASSERT_TRUE(pipeline.setMission(mission, 2));
+    StaticArena<512> arena;
+    pid_axis_t axis{};
+    const pid_gains_t gains = PIPELINE_DEFAULT_CONFIG.pitch;
+
+    //Warm up: first-use statics (probes, PTAM lookups) may allocate once
+    nav_state_t nav = {0, 0, 100, 0, 0, 0, true};
+    pipeline.step(nav, 0.005);
+
+    const uint32_t allocs = mem_alloc_count();
+    const uint32_t frees = mem_free_count();
+    double sink = 0.0;
+    for (int cycle = 0; cycle < 5000; ++cycle) {
+        ArenaCycle reset(arena);
+        nav.x += 0.1;
+        nav.pitch = 2.0 * std::sin(cycle * 0.01);
+        pipeline.step(nav, 0.005);
+        ScratchSpan<double> pitch = DECOMPOSER::pitchAxisToSweep(arena, 45.0, 45.0 + (cycle % 45));
+        ScratchSpan<double> roll = DECOMPOSER::rollAxisToSweep(arena, 45.0, 45.0 - (cycle % 45));
+        sink += pitch.empty() ? 0.0 : pitch[0];
+        sink += roll.empty() ? 0.0 : roll[0];
+        sink += PID::step(gains, axis, 5.0, nav.pitch, 0.005);
+    }
+    EXPECT_EQ(mem_alloc_count() - allocs, 0u);
+    EXPECT_EQ(mem_free_count() - frees, 0u);
+    EXPECT_EQ(arena.failures(), 0u);
+    EXPECT_NE(sink, 0.0);
+}
+
+/**
+ * @brief The counter does see heap traffic
+ */
+TEST(AllocCount, Counts_New_And_Delete){
+    const uint32_t allocs = mem_alloc_count();
+    const uint32_t frees = mem_free_count();
+    //volatile keeps the compiler from eliding the new / delete pairs
+    int* volatile value = new int(3);
+    delete value;
+    double* volatile values = new double[4];
+    delete[] values;
+    EXPECT_EQ(mem_alloc_count() - allocs, 2u);
+    EXPECT_EQ(mem_free_count() - frees, 2u);
+}
+
+/**
+ * @brief Over-aligned types go through the aligned overloads, counted too
+ */
+TEST(AllocCount, Counts_Aligned_New){
+    struct alignas(64) line_t { uint8_t bytes[64]; };
+    const uint32_t allocs = mem_alloc_count();
+    const uint32_t frees = mem_free_count();
+    line_t* volatile line = new line_t();
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(line) % 64, 0u);
+    delete line;
+    line_t* volatile lines = new line_t[3];
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(lines) % 64, 0u);
+    delete[] lines;
+    EXPECT_EQ(mem_alloc_count() - allocs, 2u);
+    EXPECT_EQ(mem_free_count() - frees, 2u);
+}
+
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,189 @@
+/**
+ * @file unittestAutotune.cpp
+ * @brief Host tests for the offline PID autotuner
+ *
+ * Relay feedback against the model's analytic ultimate point, the
+ * Ziegler-Nichols rules, step response metrics, the grid / Nelder-Mead
+ * search beating its starting points and the shipped gains, thread count
+ * independence, and a tuned table surviving the upload format.
+ *
+ * @copyright Copyright (c) 2023 limitless Aeronautics
+ *            This file is part of the MARS Flight System Firmware
+ *
+ * @license MIT License
+ *          Copyright (c) 2023 limitless Aeronautics
+ *          Permission is hereby granted, free of charge, to any person obtaining a copy
+ *          of this software and associated documentation files (the "Software"), to deal
+ *          in the Software without restriction, including without limitation the rights
+ *          to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *          copies of the Software, and to permit persons to whom the Software is
+ *          furnished to do so, subject to the following conditions:
+ *          The above copyright notice and this permission notice shall be included in all
+ *          copies or substantial portions of the Software.
+ *          THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *          IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *          FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *          AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *          LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *          OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *          SOFTWARE.
+ */
+/* System includes */
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+/* Tuner includes */
+#include "_autotune.h"
+
+/* Google testing */
+#include <gtest/gtest.h>
+
+/* Phase crossover of delay * servo lag * A / (s (s + D)), by bisection.
+   The zero-order hold of the control output adds half a period of delay */
+static void ultimate_point(const tune_plant_t& p, double rate_hz, double& ku, double& pu) {
+    const double delay = p.delay + 0.5 / rate_hz;
+    auto phase = [&](double w) { return -M_PI / 2 - std::atan(w / p.damping) - std::atan(w * p.servo_tau) - w * delay; };
+    double lo = 0.01, hi = 1000.0;
+    for (int i = 0; i < 100; ++i) {
+        const double mid = std::sqrt(lo * hi);
+        (phase(mid) > -M_PI ? lo : hi) = mid;
+    }
+    const double w = lo;
+    const double gain = p.authority / (w * std::hypot(w, p.damping) * std::hypot(1.0, w * p.servo_tau));
+    ku = 1.0 / gain;
+    pu = 2.0 * M_PI / w;
+}
+
+static void print_result(const char* name, const tune_result_t& r) {
+    std::printf("[tune    ] %-8s kp %.4f ki %.4f kd %.4f | rise %.3f s overshoot %.1f %% settling %.3f s"
+                " | cost %.3f (%u runs)\n", name, r.gains.kp, r.gains.ki, r.gains.kd, r.metrics.rise,
+                r.metrics.overshoot, r.metrics.settling, r.cost, r.evaluations);
+}
+
+/**
+ * @brief The relay cycle lands on the plant's ultimate gain and period
+ */
+TEST(Autotune, Relay_Finds_Ultimate_Point){
+    const PIDAutotuner tuner;
+    for (double speed : {10.0, 15.0, 20.0}) {
+        const tune_plant_t plant = tuner.plant(0, speed, TUNE_REF_ALT);
+        double ku, pu;
+        ultimate_point(plant, tuner.config().rate_hz, ku, pu);
+        const tune_relay_t relay = tuner.relay(plant);
+        std::printf("[relay   ] %.0f m/s: Ku %.4f (analytic %.4f) Pu %.3f s (analytic %.3f s)\n",
+                    speed, relay.ku, ku, relay.pu, pu);
+        ASSERT_TRUE(relay.ok);
+        //The describing function is a first harmonic approximation
+        EXPECT_NEAR(relay.ku, ku, 0.1 * ku);
+        EXPECT_NEAR(relay.pu, pu, 0.1 * pu);
+    }
+}
+
+/**
+ * @brief Ziegler-Nichols rules in FlightPID's parallel form
+ */
+TEST(Autotune, Ziegler_Nichols_Rules){
+    const tune_relay_t relay = {true, 0.5, 0.8, 1.0};
+    const gain_triplet_t classic = PIDAutotuner::zieglerNichols(relay);
+    EXPECT_FLOAT_EQ(classic.kp, 0.3f);
+    EXPECT_FLOAT_EQ(classic.ki, 0.3f / 0.4f);
+    EXPECT_FLOAT_EQ(classic.kd, 0.3f * 0.1f);
+    const gain_triplet_t soft = PIDAutotuner::zieglerNichols(relay, TUNE_ZN_NO_OVERSHOOT);
+    EXPECT_FLOAT_EQ(soft.kp, 0.1f);
+    EXPECT_LT(soft.kp, PIDAutotuner::zieglerNichols(relay, TUNE_ZN_SOME_OVERSHOOT).kp);
+}
+
+/**
+ * @brief Step metrics of a sound and of an unstable gain set
+ */
+TEST(Autotune, Step_Metrics){
+    const PIDAutotuner tuner;
+    const tune_plant_t plant = tuner.plant(0, TUNE_REF_SPEED, TUNE_REF_ALT);
+    const pid_gains_t& fixed = PIPELINE_DEFAULT_CONFIG.pitch;
+    const tune_metrics_t sound = tuner.evaluate(plant, {float(fixed.kp), float(fixed.ki), float(fixed.kd)});
+    EXPECT_TRUE(sound.stable);
+    EXPECT_GT(sound.rise, 0.0);
+    EXPECT_LT(sound.rise, sound.settling);
+    EXPECT_LT(sound.steady_error, 0.02 * tuner.config().step);
+    EXPECT_GT(sound.travel, 0.0);
+    EXPECT_LT(tuner.cost(sound), 1e6);
+
+    const tune_metrics_t wild = tuner.evaluate(plant, {5.0f, 0.0f, 0.0f});
+    EXPECT_FALSE(wild.stable);
+    EXPECT_GE(tuner.cost(wild), 1e6);
+}
+
+/**
+ * @brief Each search stage improves on the last and on the shipped gains
+ */
+TEST(Autotune, Search_Beats_Start_And_Defaults){
+    const PIDAutotuner tuner;
+    const tune_point_t point = tuner.tuneAxis(0, TUNE_REF_SPEED, TUNE_REF_ALT);
+    const pid_gains_t& fixed = PIPELINE_DEFAULT_CONFIG.pitch;
+    const tune_plant_t plant = tuner.plant(0, TUNE_REF_SPEED, TUNE_REF_ALT);
+    const gain_triplet_t shipped = {float(fixed.kp), float(fixed.ki), float(fixed.kd)};
+    const tune_metrics_t metrics = tuner.evaluate(plant, shipped);
+    const tune_result_t defaults = {shipped, metrics, tuner.cost(metrics), 1};
+    print_result("shipped", defaults);
+    print_result("zn", point.zn);
+    print_result("grid", point.grid);
+    print_result("best", point.best);
+
+    ASSERT_TRUE(point.relay.ok);
+    EXPECT_TRUE(point.best.metrics.stable);
+    EXPECT_LE(point.grid.cost, point.zn.cost);
+    EXPECT_LE(point.best.cost, point.grid.cost);
+    EXPECT_LT(point.best.cost, defaults.cost);
+}
+
+/**
+ * @brief The grid picks the same gains however many threads run it
+ */
+TEST(Autotune, Grid_Independent_Of_Threads){
+    const PIDAutotuner tuner;
+    const tune_plant_t plant = tuner.plant(1, 12.0, 150.0);
+    const gain_triplet_t start = {0.05f, 0.02f, 0.01f};
+    const tune_result_t one = tuner.grid(plant, start, 5, 2.0, 1);
+    const tune_result_t many = tuner.grid(plant, start, 5, 2.0, 4);
+    EXPECT_EQ(std::memcmp(&one.gains, &many.gains, sizeof(one.gains)), 0);
+    EXPECT_EQ(one.cost, many.cost);
+    EXPECT_EQ(one.evaluations, 125u);
+}
+
+/**
+ * @brief A tuned table validates, follows the dynamic pressure and round
+ *        trips through the upload format
+ */
+TEST(Autotune, Table_Upload_Format){
+    const PIDAutotuner tuner;
+    gain_table_t table = {};
+    table.speed_points = 2;
+    table.speed_min = 10.0f;
+    table.speed_step = 10.0f;
+    table.alt_points = 2;
+    table.alt_min = 0.0f;
+    table.alt_step = 2000.0f;
+    std::vector<tune_point_t> points(GAIN_AXES * 4);
+    ASSERT_TRUE(tuner.tuneTable(table, points.data()));
+    for (const tune_point_t& p : points) {
+        EXPECT_TRUE(p.best.metrics.stable);
+    }
+    //More authority at speed and low altitude: less proportional gain needed
+    EXPECT_GT(table.gains[0][0][0].kp, table.gains[0][0][1].kp);
+    EXPECT_GT(table.gains[0][1][0].kp, table.gains[0][0][0].kp);
+
+    static char text[GAIN_UPLOAD_MAX_BYTES];
+    const std::size_t len = GainSchedule::format(table, text, sizeof(text));
+    ASSERT_GT(len, 0u);
+    gain_table_t parsed;
+    ASSERT_TRUE(GainSchedule::parse(text, len, parsed));
+    EXPECT_EQ(std::memcmp(&parsed, &table, sizeof(table)), 0);
+}
+
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
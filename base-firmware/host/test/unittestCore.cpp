@@ -0,0 +1,113 @@
+/**
+ * @file unittestCore.cpp
+ * @brief Host tests for the flight core built natively (PID, decomposer, state machine)
+ *
+ * Smoke coverage for the modules compiled into mars_core so a host build
+ * regression fails ctest, the per-module suites stay under test/.
+ *
+ *
+ * @copyright Copyright (c) 2023 limitless Aeronautics
+ *            This file is part of the MARS Flight System Firmware
+ *
+ * @license MIT License
+ *          Copyright (c) 2023 limitless Aeronautics
+ *          Permission is hereby granted, free of charge, to any person obtaining a copy
+ *          of this software and associated documentation files (the "Software"), to deal
+ *          in the Software without restriction, including without limitation the rights
+ *          to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *          copies of the Software, and to permit persons to whom the Software is
+ *          furnished to do so, subject to the following conditions:
+ *          The above copyright notice and this permission notice shall be included in all
+ *          copies or substantial portions of the Software.
+ *          THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *          IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *          FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *          AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *          LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *          OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *          SOFTWARE.
+ */
+/* System includes */
+#include <string>
+#include <vector>
+
+/* Core includes */
+#include "_pid.h"
+#include "decomposer.h"
+#include "_state.h"
+
+/* Google testing */
+#include <gtest/gtest.h>
+
+extern std::string stateDescript;
+extern uint8_t state;
+
+/**
+ * @brief Zero error gives zero control signal, positive error is clamped to the limits
+ */
+TEST(TestPID, Step_Clamped){
+    PID pid;
+    std::vector<double> integral = {0.0, 0.0, 0.0};
+    std::vector<double> previous = {0.0, 0.0, 0.0};
+
+    std::vector<double> out = pid.pid_controller({10.0, 0.0, 0.0}, {10.0, 0.0, 0.0},
+                                                 1.0, 0.1, 0.5, integral, previous, 0.1, 0, 90);
+    ASSERT_EQ(out.size(), 3u);
+    EXPECT_DOUBLE_EQ(out[0], 0.0);
+
+    out = pid.pid_controller({1000.0, 0.0, 0.0}, {0.0, 0.0, 0.0},
+                             1.0, 0.1, 0.5, integral, previous, 0.1, 0, 90);
+    EXPECT_DOUBLE_EQ(out[0], 90.0);
+}
+
+/**
+ * @brief Pitch up moves the rear pair, pitch down the front pair, always inside the 40 deg limit
+ */
+TEST(TestDecomposer, Pitch_Sweep_Limits){
+    StaticArena<256> arena;
+    for (int target = 0; target <= 90; target += 5) {
+        ArenaCycle cycle(arena);
+        ScratchSpan<double> pos = DECOMPOSER::pitchAxisToSweep(arena, 45.0, static_cast<double>(target));
+        ASSERT_EQ(pos.size(), 2u);
+        EXPECT_GE(pos[0], 230.0);
+        EXPECT_LE(pos[0], 270.0);
+        EXPECT_GE(pos[1], 90.0);
+        EXPECT_LE(pos[1], 130.0);
+    }
+}
+
+/**
+ * @brief Unknown angle types are ignored
+ */
+TEST(TestDecomposer, Unknown_Axis){
+    StaticArena<64> arena;
+    EXPECT_TRUE(DECOMPOSER::decomposeFL(arena, "Yaw", 0.0, 10.0).empty());
+    EXPECT_EQ(arena.used(), 0u);
+}
+
+/**
+ * @brief updateState drives the SWITCH2x transitions and mirrors into PTAM
+ */
+TEST(TestState, Transitions){
+    STATE machine;
+    machine.updateState(ARMED);
+    EXPECT_EQ(machine.SWITCH2PREP(), 0);
+    EXPECT_EQ(machine.SWITCH2ARMED(), 1);
+    EXPECT_EQ(state, 2);
+    EXPECT_EQ(SharedMemory::getInstance().getLastString(REG_STATE_DESCRIPT), "ARMED");
+
+    machine.updateState(BYPASS);
+    EXPECT_EQ(machine.SWITCH2BYPASS(), 1);
+    EXPECT_EQ(state, 3);
+
+    machine.updateState(PREP);
+    EXPECT_EQ(machine.SWITCH2PREP(), 1);
+    EXPECT_EQ(state, 1);
+    EXPECT_EQ(stateDescript, "PREP");
+}
+
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
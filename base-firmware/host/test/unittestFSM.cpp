@@ -0,0 +1,299 @@
+/**
+ * @file unittestFSM.cpp
+ * @brief Host tests for the table-driven state machine and the MARS flight table
+ *
+ * Runs on a deterministic test clock so transition latencies are exact.
+ *
+ *
+ * @copyright Copyright (c) 2023 limitless Aeronautics
+ *            This file is part of the MARS Flight System Firmware
+ *
+ * @license MIT License
+ *          Copyright (c) 2023 limitless Aeronautics
+ *          Permission is hereby granted, free of charge, to any person obtaining a copy
+ *          of this software and associated documentation files (the "Software"), to deal
+ *          in the Software without restriction, including without limitation the rights
+ *          to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *          copies of the Software, and to permit persons to whom the Software is
+ *          furnished to do so, subject to the following conditions:
+ *          The above copyright notice and this permission notice shall be included in all
+ *          copies or substantial portions of the Software.
+ *          THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *          IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *          FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *          AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *          LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *          OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *          SOFTWARE.
+ */
+/* System includes */
+#include <cstdio>
+#include <string>
+
+/* State machine includes */
+#include "_flight_fsm.h"
+#include "_ptam.h"
+
+/* Google testing */
+#include <gtest/gtest.h>
+
+/* Test clock, advanced by hand */
+static int64_t test_now_us = 0;
+static int64_t test_clock() { return test_now_us; }
+
+/* Minimal two state table for engine tests */
+enum : fsm_state_id_t { S_OFF, S_ON };
+enum : fsm_event_id_t { E_TOGGLE, E_TICK, E_NOPE };
+
+struct trace_t {
+    std::string calls;
+    bool allow = true;
+};
+
+static void off_entry(void* ctx) { static_cast<trace_t*>(ctx)->calls += "+off"; }
+static void off_exit(void* ctx) { static_cast<trace_t*>(ctx)->calls += "-off"; }
+static void on_entry(void* ctx) { static_cast<trace_t*>(ctx)->calls += "+on"; test_now_us += 40; }
+static void on_exit(void* ctx) { static_cast<trace_t*>(ctx)->calls += "-on"; }
+static void toggle_action(void* ctx) { static_cast<trace_t*>(ctx)->calls += "*"; }
+static void tick_action(void* ctx) { static_cast<trace_t*>(ctx)->calls += "t"; }
+static bool allowed(void* ctx) { return static_cast<trace_t*>(ctx)->allow; }
+
+static const fsm_state_def_t TEST_STATES[] = {
+    {S_OFF, "OFF", off_entry, off_exit},
+    {S_ON,  "ON",  on_entry,  on_exit },
+};
+
+static const fsm_transition_t TEST_TRANSITIONS[] = {
+    {S_OFF,   E_TOGGLE, allowed, S_ON,         toggle_action},
+    {S_ON,    E_TOGGLE, nullptr, S_OFF,        toggle_action},
+    {FSM_ANY, E_TICK,   nullptr, FSM_INTERNAL, tick_action  },
+};
+
+class FSM_Test : public ::testing::Test {
+protected:
+    void SetUp() override { test_now_us = 1000; }
+
+    trace_t trace;
+    FSMEngine engine{TEST_STATES, 2, TEST_TRANSITIONS, 3, S_OFF, &trace, test_clock};
+};
+
+/**
+ * @brief exit -> action -> entry order, internal rows skip exit / entry
+ */
+TEST_F(FSM_Test, Action_Order){
+    engine.start();
+    EXPECT_EQ(trace.calls, "+off");
+
+    engine.post(E_TOGGLE);
+    engine.post(E_TICK);
+    EXPECT_EQ(engine.state(), S_OFF);
+    EXPECT_EQ(engine.dispatch(), 1u);
+    EXPECT_EQ(engine.state(), S_ON);
+    EXPECT_EQ(trace.calls, "+off-off*+ont");
+    EXPECT_STREQ(engine.name(engine.state()), "ON");
+}
+
+/**
+ * @brief A refused guard or an unknown event leaves the state alone and is counted
+ */
+TEST_F(FSM_Test, Guard_And_Rejected){
+    engine.start();
+    trace.allow = false;
+    engine.post(E_TOGGLE);
+    engine.post(E_NOPE);
+    EXPECT_EQ(engine.dispatch(), 0u);
+    EXPECT_EQ(engine.state(), S_OFF);
+    fsm_stats_t stats = engine.stats();
+    EXPECT_EQ(stats.dispatched, 2u);
+    EXPECT_EQ(stats.rejected, 2u);
+    EXPECT_EQ(stats.transitions, 0u);
+}
+
+/**
+ * @brief Latency is post() -> entry done on the engine clock, worst case is kept
+ */
+TEST_F(FSM_Test, Latency_Deterministic){
+    engine.start();
+    engine.post(E_TOGGLE);          //posted at 1000
+    test_now_us += 250;             //dispatched 250us later, on_entry adds 40us
+    engine.dispatch();
+    fsm_stats_t stats = engine.stats();
+    EXPECT_EQ(stats.last_latency_us, 290);
+    EXPECT_EQ(stats.worst_latency_us, 290);
+    EXPECT_EQ(stats.worst_from, S_OFF);
+    EXPECT_EQ(stats.worst_to, S_ON);
+
+    engine.post(E_TOGGLE);          //ON -> OFF, no entry delay
+    test_now_us += 10;
+    engine.dispatch();
+    stats = engine.stats();
+    EXPECT_EQ(stats.last_latency_us, 10);
+    EXPECT_EQ(stats.worst_latency_us, 290);
+    EXPECT_EQ(stats.worst_to, S_ON);
+
+    engine.resetStats();
+    EXPECT_EQ(engine.stats().worst_latency_us, 0);
+}
+
+/**
+ * @brief The queue is fixed, overflow drops and counts, order is kept
+ */
+TEST_F(FSM_Test, Queue_Overflow){
+    engine.start();
+    for (int i = 0; i < FSM_QUEUE_LEN; ++i) {
+        EXPECT_TRUE(engine.post(E_TICK));
+    }
+    EXPECT_FALSE(engine.post(E_TOGGLE));
+    EXPECT_EQ(engine.stats().dropped, 1u);
+    engine.dispatch();
+    EXPECT_EQ(engine.state(), S_OFF);
+    EXPECT_EQ(trace.calls, "+off" + std::string(FSM_QUEUE_LEN, 't'));
+}
+
+/**
+ * @brief post() wakes the attached notifier
+ */
+TEST_F(FSM_Test, Notifier_Wake){
+    PTAMNotifier notifier;
+    engine.attach(&notifier, 0x4);
+    engine.post(E_TICK);
+    EXPECT_EQ(notifier.wait(0), 0x4u);
+    engine.attach(nullptr, 0);
+    engine.post(E_TICK);
+    EXPECT_EQ(notifier.wait(0), 0u);
+}
+
+/* MARS flight table */
+class FlightFSM_Test : public ::testing::Test {
+protected:
+    void SetUp() override {
+        test_now_us = 1000;
+        fsm.start();
+    }
+
+    void run(flight_event_t event) {
+        fsm.post(event);
+        test_now_us += 100;
+        fsm.dispatch();
+    }
+
+    FlightStateMachine fsm{test_clock};
+};
+
+/**
+ * @brief State codes and descriptions are mirrored into PTAM on entry
+ */
+TEST_F(FlightFSM_Test, Mirrors_PTAM){
+    SharedMemory& sharedMemory = SharedMemory::getInstance();
+    EXPECT_EQ(fsm.state(), FLIGHT_PREP);
+    EXPECT_EQ(sharedMemory.getLastInt(REG_STATE), 1);
+    run(EVT_REQ_ARMED);
+    EXPECT_EQ(fsm.state(), FLIGHT_ARMED);
+    EXPECT_EQ(sharedMemory.getLastInt(REG_STATE), 2);
+    EXPECT_EQ(sharedMemory.getLastString(REG_STATE_DESCRIPT), "ARMED");
+    run(EVT_REQ_BYPASS);
+    EXPECT_EQ(sharedMemory.getLastString(REG_STATE_DESCRIPT), "BYPASS");
+    run(EVT_REQ_PREP);
+    EXPECT_EQ(sharedMemory.getLastInt(REG_STATE), 1);
+}
+
+/**
+ * @brief Arm token auth arms from PREP and BYPASS
+ */
+TEST_F(FlightFSM_Test, Auth_Arms){
+    run(EVT_AUTH_OK);
+    EXPECT_EQ(fsm.state(), FLIGHT_ARMED);
+    run(EVT_REQ_BYPASS);
+    run(EVT_AUTH_OK);
+    EXPECT_EQ(fsm.state(), FLIGHT_ARMED);
+}
+
+/**
+ * @brief Low battery refuses arming and aborts an armed vehicle, recovery re-enables arming
+ */
+TEST_F(FlightFSM_Test, Low_Battery){
+    fsm.batteryLevel(50.0);
+    fsm.batteryLevel(10.0);
+    fsm.batteryLevel(12.0);          //No second edge
+    test_now_us += 100;
+    fsm.dispatch();
+    EXPECT_TRUE(fsm.batteryLow());
+    EXPECT_EQ(fsm.engine().stats().dispatched, 1u);
+
+    run(EVT_REQ_ARMED);
+    EXPECT_EQ(fsm.state(), FLIGHT_PREP);
+
+    fsm.batteryLevel(18.0);          //Inside the hysteresis band
+    fsm.dispatch();
+    EXPECT_TRUE(fsm.batteryLow());
+    fsm.batteryLevel(30.0);
+    fsm.dispatch();
+    EXPECT_FALSE(fsm.batteryLow());
+
+    run(EVT_REQ_ARMED);
+    EXPECT_EQ(fsm.state(), FLIGHT_ARMED);
+    fsm.batteryLevel(5.0);
+    fsm.dispatch();
+    EXPECT_EQ(fsm.state(), FLIGHT_ABORT);
+}
+
+/**
+ * @brief Abort latches, only an operator PREP request leaves it
+ */
+TEST_F(FlightFSM_Test, Abort_Latches){
+    run(EVT_REQ_BYPASS);
+    run(EVT_ABORT);
+    EXPECT_EQ(fsm.state(), FLIGHT_ABORT);
+    run(EVT_REQ_ARMED);
+    run(EVT_AUTH_OK);
+    run(EVT_REQ_BYPASS);
+    run(EVT_ABORT);
+    EXPECT_EQ(fsm.state(), FLIGHT_ABORT);
+    run(EVT_REQ_PREP);
+    EXPECT_EQ(fsm.state(), FLIGHT_PREP);
+}
+
+/**
+ * @brief Entry / exit hooks run on the matching state changes
+ */
+static int armed_entries = 0;
+static int armed_exits = 0;
+
+TEST_F(FlightFSM_Test, Hooks){
+    fsm.onEntry(FLIGHT_ARMED, [](void*) { armed_entries++; }, nullptr);
+    fsm.onExit(FLIGHT_ARMED, [](void*) { armed_exits++; }, nullptr);
+    run(EVT_REQ_ARMED);
+    run(EVT_REQ_ARMED);              //Already ARMED, rejected
+    EXPECT_EQ(armed_entries, 1);
+    EXPECT_EQ(armed_exits, 0);
+    run(EVT_ABORT);
+    EXPECT_EQ(armed_exits, 1);
+}
+
+/**
+ * @brief Worst-case transition latency over a scripted session, reported for tracking
+ */
+TEST_F(FlightFSM_Test, Worst_Case_Latency){
+    const flight_event_t script[] = {EVT_REQ_ARMED, EVT_REQ_BYPASS, EVT_AUTH_OK, EVT_REQ_PREP,
+                                     EVT_REQ_BYPASS, EVT_ABORT, EVT_REQ_PREP};
+    int64_t delay = 50;
+    for (flight_event_t event : script) {
+        fsm.post(event);
+        test_now_us += delay;
+        delay += 50;
+        fsm.dispatch();
+    }
+    fsm_stats_t stats = fsm.engine().stats();
+    EXPECT_EQ(stats.transitions, 7u);
+    EXPECT_EQ(stats.worst_latency_us, 350);
+    EXPECT_EQ(stats.worst_to, FLIGHT_PREP);
+    std::printf("[fsm] %u transitions | worst latency %lldus (%s -> %s)\n", stats.transitions,
+                static_cast<long long>(stats.worst_latency_us),
+                fsm.engine().name(stats.worst_from), fsm.engine().name(stats.worst_to));
+}
+
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,273 @@
+/**
+ * @file unittestHealth.cpp
+ * @brief Host tests for the task health monitor
+ *
+ * Drives HealthMonitor with a simulated clock: deadlines and progress,
+ * the log -> degrade -> safe -> watchdog escalation, inactive tasks, stack
+ * marks and CPU share, and a hung control group under the rate scheduler.
+ *
+ * @copyright Copyright (c) 2023 limitless Aeronautics
+ *            This file is part of the MARS Flight System Firmware
+ *
+ * @license MIT License
+ *          Copyright (c) 2023 limitless Aeronautics
+ *          Permission is hereby granted, free of charge, to any person obtaining a copy
+ *          of this software and associated documentation files (the "Software"), to deal
+ *          in the Software without restriction, including without limitation the rights
+ *          to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *          copies of the Software, and to permit persons to whom the Software is
+ *          furnished to do so, subject to the following conditions:
+ *          The above copyright notice and this permission notice shall be included in all
+ *          copies or substantial portions of the Software.
+ *          THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *          IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *          FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *          AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *          LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *          OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *          SOFTWARE.
+ */
+/* System includes */
+#include <vector>
+
+/* Health includes */
+#include "_health.h"
+#include "_rate_scheduler.h"
+
+/* Google testing */
+#include <gtest/gtest.h>
+
+/* Simulated clock and stacks (the task handle points at its free bytes) */
+static int64_t sim_now_us = 0;
+static int64_t sim_clock() { return sim_now_us; }
+static void sim_advance(int64_t us) { sim_now_us = us; }
+static uint32_t sim_stack(void* task) { return task == nullptr ? UINT32_MAX : *static_cast<uint32_t*>(task); }
+
+/* Escalation actions seen, in order */
+struct escalation_t {
+    health_level_t level;
+    int64_t at_us;
+    const char* task;
+};
+
+static void record(void* ctx, health_level_t level, const char* task) {
+    static_cast<std::vector<escalation_t>*>(ctx)->push_back({level, sim_now_us, task});
+}
+
+class Health_Test : public ::testing::Test {
+protected:
+    void SetUp() override {
+        sim_now_us = 0;
+        for (uint8_t level = HEALTH_LATE; level < HEALTH_LEVEL_COUNT; ++level) {
+            monitor.onLevel(health_level_t(level), record, &seen);
+        }
+    }
+
+    health_task_stats_t stat(int id) {
+        health_task_stats_t out[HEALTH_MAX_TASKS];
+        const std::size_t n = monitor.stats(out, HEALTH_MAX_TASKS);
+        EXPECT_LT(std::size_t(id), n);
+        return out[id];
+    }
+
+    HealthMonitor monitor{sim_clock, sim_stack};
+    std::vector<escalation_t> seen;
+};
+
+/**
+ * @brief Progressing beats keep a task OK, beats without progress do not
+ */
+TEST_F(Health_Test, Progress_Not_Just_Beats){
+    const int id = monitor.add({"loop", 100000, true, true});
+    ASSERT_EQ(id, 0);
+    for (int i = 0; i < 10; ++i) {
+        sim_now_us += 50000;
+        monitor.beat(id);
+        EXPECT_EQ(monitor.check(), HEALTH_OK);
+    }
+
+    //Still beating, but stuck in a retry loop
+    for (int i = 0; i < 3; ++i) {
+        sim_now_us += 50000;
+        monitor.beat(id, 0);
+    }
+    EXPECT_EQ(monitor.check(), HEALTH_LATE);
+    EXPECT_EQ(stat(id).beats, 13u);
+    EXPECT_EQ(stat(id).progress, 10u);
+    EXPECT_EQ(stat(id).misses, 1u);
+
+    monitor.beat(id);
+    EXPECT_EQ(monitor.check(), HEALTH_OK);
+    EXPECT_EQ(stat(id).overdue_max_us, 150000u);
+}
+
+/**
+ * @brief An overdue critical task climbs every step, each action runs once
+ */
+TEST_F(Health_Test, Escalates_Log_Degrade_Safe_Reset){
+    const int id = monitor.add({"control", 10000, true, true});
+    monitor.beat(id);
+    const uint32_t fed = monitor.watchdogFeeds();
+
+    //Jumping straight to SAFE still runs the DEGRADED action first
+    sim_now_us = 45000;
+    EXPECT_EQ(monitor.check(), HEALTH_SAFE);
+    ASSERT_EQ(seen.size(), 3u);
+    EXPECT_EQ(seen[0].level, HEALTH_LATE);
+    EXPECT_EQ(seen[1].level, HEALTH_DEGRADED);
+    EXPECT_EQ(seen[2].level, HEALTH_SAFE);
+    EXPECT_STREQ(seen[2].task, "control");
+    EXPECT_TRUE(monitor.degraded());
+    EXPECT_EQ(monitor.watchdogFeeds(), fed + 1);
+
+    sim_now_us = 60000;
+    EXPECT_EQ(monitor.check(), HEALTH_SAFE);
+    EXPECT_EQ(seen.size(), 3u);
+
+    sim_now_us = 80000;
+    EXPECT_EQ(monitor.check(), HEALTH_RESET);
+    EXPECT_EQ(seen.back().level, HEALTH_RESET);
+    EXPECT_EQ(monitor.watchdogFeeds(), fed + 2);
+
+    //Recovering after the reset decision does not feed the watchdog again
+    monitor.beat(id);
+    EXPECT_EQ(monitor.check(), HEALTH_OK);
+    EXPECT_EQ(monitor.watchdogFeeds(), fed + 2);
+}
+
+/**
+ * @brief Non-critical tasks stop at DEGRADED, inactive tasks are not checked
+ */
+TEST_F(Health_Test, Non_Critical_And_Inactive){
+    const int display = monitor.add({"display", 10000, false, true});
+    const int armed = monitor.add({"rt_control", 10000, true, false});
+
+    sim_now_us = 500000;
+    EXPECT_EQ(monitor.check(), HEALTH_DEGRADED);
+    EXPECT_EQ(seen.size(), 2u);
+    EXPECT_EQ(stat(armed).level, HEALTH_OK);
+    EXPECT_FALSE(stat(armed).active);
+
+    //Activation restarts the deadline
+    monitor.beat(display);
+    monitor.setActive(armed, true);
+    EXPECT_EQ(monitor.check(), HEALTH_OK);
+    sim_now_us += 15000;
+    monitor.beat(display);
+    EXPECT_EQ(monitor.check(), HEALTH_LATE);
+    EXPECT_EQ(stat(armed).level, HEALTH_LATE);
+    monitor.setActive(armed, false);
+    EXPECT_EQ(monitor.check(), HEALTH_OK);
+}
+
+/**
+ * @brief Stack low-water marks and CPU share per window
+ */
+TEST_F(Health_Test, Stack_And_CPU_Share){
+    uint32_t stackFree = 2048;
+    const int id = monitor.add({"worker", 100000, false, true}, &stackFree);
+    EXPECT_EQ(monitor.add({"bad", 0, false, true}), -1);
+
+    monitor.check();
+    sim_now_us += HEALTH_WINDOW_US;
+    monitor.beat(id);
+    monitor.check();
+    stackFree = 900;
+    sim_now_us += HEALTH_WINDOW_US;
+    monitor.beat(id);
+    monitor.check();
+    //A mark is a minimum, a later reading with more room does not raise it
+    stackFree = 1500;
+    sim_now_us += HEALTH_WINDOW_US;
+    monitor.beat(id);
+    monitor.check();
+
+    const health_task_stats_t s = stat(id);
+    EXPECT_EQ(s.stack_free_min, 900u);
+    EXPECT_EQ(s.level, HEALTH_OK);
+
+    uint8_t out[HEALTH_DUMP_MAX_BYTES];
+    const std::size_t len = monitor.dump(out, sizeof(out));
+    ASSERT_GT(len, 0u);
+    //Map of 5 pairs, first key "v"
+    EXPECT_EQ(out[0], 0xa5);
+    EXPECT_EQ(out[2], 'v');
+    EXPECT_EQ(monitor.dump(out, 8), 0u);
+}
+
+/**
+ * @brief Busy share of a window is the summed Work time over the window length
+ */
+TEST_F(Health_Test, CPU_Share_Window){
+    const int id = monitor.add({"worker", 100000, false, true});
+    monitor.check();
+    for (int i = 0; i < 10; ++i) {
+        {
+            HealthMonitor::Work work(id, monitor);
+            sim_now_us += 25000;
+        }
+        sim_now_us += 75000;
+        monitor.check();
+    }
+    EXPECT_NEAR(stat(id).cpu_share, 0.25f, 1e-4);
+    EXPECT_EQ(stat(id).progress, 10u);
+}
+
+/* Control group that hangs (spins without progress) after hang_at_us */
+struct control_ctx_t {
+    HealthMonitor* monitor;
+    int id;
+    int64_t hang_at_us;
+};
+
+static void control_fn(void* arg, const rate_tick_t& tick) {
+    control_ctx_t* ctx = static_cast<control_ctx_t*>(arg);
+    const bool hung = tick.now_us >= ctx->hang_at_us;
+    sim_now_us += 300;
+    ctx->monitor->beat(ctx->id, hung ? 0 : 1, 300);
+}
+
+static void monitor_fn(void* arg, const rate_tick_t&) {
+    static_cast<HealthMonitor*>(arg)->check();
+    sim_now_us += 50;
+}
+
+/**
+ * @brief Simulated tick source: a 200 Hz control group hangs, the 10 Hz health task escalates it
+ */
+TEST_F(Health_Test, Hung_Control_Group_Under_Scheduler){
+    control_ctx_t control{&monitor, monitor.add({"rt_control", 50000, true, true}), 1000000};
+    RateScheduler scheduler(sim_clock);
+    scheduler.add({"rt_control", 200, control_fn, &control, 1, 4096});
+    scheduler.add({"health", HEALTH_CHECK_HZ, monitor_fn, &monitor, 0, 3072});
+    scheduler.setEnabled(true);
+    scheduler.simulate(1000000, sim_advance);
+    EXPECT_EQ(monitor.level(), HEALTH_OK);
+    EXPECT_TRUE(seen.empty());
+    const uint32_t fed = monitor.watchdogFeeds();
+    EXPECT_GE(fed, 9u);
+
+    scheduler.simulate(2000000, sim_advance);
+    ASSERT_EQ(seen.size(), 4u);
+    for (std::size_t i = 0; i < seen.size(); ++i) {
+        EXPECT_EQ(seen[i].level, health_level_t(HEALTH_LATE + i));
+    }
+    //Steps entered at 1, 2, 4 and 8 deadlines, within one check period
+    const int64_t hang = 1000000;
+    const int64_t check = 1000000 / HEALTH_CHECK_HZ;
+    EXPECT_GE(seen[1].at_us - hang, 2 * 50000);
+    EXPECT_LE(seen[1].at_us - hang, 2 * 50000 + check);
+    EXPECT_GE(seen[2].at_us - hang, 4 * 50000);
+    EXPECT_LE(seen[2].at_us - hang, 4 * 50000 + check);
+    EXPECT_GE(seen[3].at_us - hang, 8 * 50000);
+    EXPECT_LE(seen[3].at_us - hang, 8 * 50000 + check);
+    //No feeds after the reset decision, the TWDT would fire
+    EXPECT_LE(monitor.watchdogFeeds(), fed + 5);
+    EXPECT_GT(stat(control.id).cpu_share, 0.05f);
+}
+
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,221 @@
+/**
+ * @file unittestMemory.cpp
+ * @brief Host tests for the memory pressure manager
+ *
+ * Drives MemoryManager with an injected heap sampler and clock: pressure
+ * levels and their hysteresis, the order work is shed in, restarts that
+ * wait for a safe state, the idle restart and the PTAM / CBOR exports.
+ *
+ * @copyright Copyright (c) 2023 limitless Aeronautics
+ *            This file is part of the MARS Flight System Firmware
+ *
+ * @license MIT License
+ *          Copyright (c) 2023 limitless Aeronautics
+ *          Permission is hereby granted, free of charge, to any person obtaining a copy
+ *          of this software and associated documentation files (the "Software"), to deal
+ *          in the Software without restriction, including without limitation the rights
+ *          to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *          copies of the Software, and to permit persons to whom the Software is
+ *          furnished to do so, subject to the following conditions:
+ *          The above copyright notice and this permission notice shall be included in all
+ *          copies or substantial portions of the Software.
+ *          THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *          IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *          FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *          AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *          LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *          OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *          SOFTWARE.
+ */
+/* Memory includes */
+#include "_memory.h"
+#include "_ptam.h"
+
+/* Google testing */
+#include <gtest/gtest.h>
+
+/* Simulated heap and clock */
+static mem_sample_t sim_heap = {100000, 60000, 100000};
+static int64_t sim_now_us = 0;
+static mem_sample_t sim_sampler() { return sim_heap; }
+static int64_t sim_clock() { return sim_now_us; }
+
+class Memory_Test : public ::testing::Test {
+protected:
+    void SetUp() override {
+        sim_heap = {100000, 60000, 100000};
+        sim_now_us = 0;
+    }
+
+    //Restore the shim's quiet default, update() moves it with the level
+    void TearDown() override { esp_log_level_set("*", ESP_LOG_WARN); }
+
+    mem_pressure_t feed(uint32_t free_bytes, uint32_t largest) {
+        sim_heap.free_bytes = free_bytes;
+        sim_heap.largest_block = largest;
+        if (free_bytes < sim_heap.min_free) {
+            sim_heap.min_free = free_bytes;
+        }
+        return memory.update();
+    }
+
+    MemoryManager memory{sim_sampler, sim_clock};
+};
+
+TEST_F(Memory_Test, Levels_From_Free_And_Largest_Block){
+    EXPECT_EQ(feed(100000, 60000), MEM_NORMAL);
+    //Fragmentation alone raises the level
+    EXPECT_EQ(feed(100000, 12000), MEM_LOW);
+    EXPECT_EQ(feed(100000, 6000), MEM_CRITICAL);
+    EXPECT_EQ(feed(9000, 6000), MEM_EXHAUSTED);
+}
+
+TEST_F(Memory_Test, Hysteresis_On_The_Way_Down){
+    EXPECT_EQ(feed(39000, 60000), MEM_LOW);
+    //Just above the threshold is still inside the hysteresis band
+    EXPECT_EQ(feed(41000, 60000), MEM_LOW);
+    EXPECT_EQ(feed(43000, 60000), MEM_LOW);
+    EXPECT_EQ(feed(46000, 60000), MEM_NORMAL);
+
+    EXPECT_EQ(feed(15000, 60000), MEM_CRITICAL);
+    //Clears critical but not low's band: steps down one level only
+    EXPECT_EQ(feed(30000, 60000), MEM_LOW);
+}
+
+TEST_F(Memory_Test, Low_Water_Marks){
+    feed(80000, 50000);
+    feed(30000, 20000);
+    feed(90000, 55000);
+    EXPECT_EQ(memory.minFree(), 30000u);
+    EXPECT_EQ(memory.minLargest(), 20000u);
+    EXPECT_EQ(memory.sample().free_bytes, 90000u);
+}
+
+TEST_F(Memory_Test, Sheds_Display_Then_Logs_Then_Telemetry){
+    const mem_shed_t& normal = MemoryManager::shedding(MEM_NORMAL);
+    const mem_shed_t& low = MemoryManager::shedding(MEM_LOW);
+    const mem_shed_t& critical = MemoryManager::shedding(MEM_CRITICAL);
+    EXPECT_EQ(normal.display_every, 1);
+    EXPECT_EQ(normal.telemetry_every, 1);
+    EXPECT_GT(low.display_every, normal.display_every);
+    EXPECT_LT(low.log_level, normal.log_level);
+    EXPECT_EQ(critical.display_every, 0);
+    EXPECT_LT(critical.log_level, low.log_level);
+    EXPECT_GT(critical.telemetry_every, low.telemetry_every);
+    //Configured elsewhere, not a firmware tag
+    esp_log_level_set("wifi", ESP_LOG_DEBUG);
+
+    feed(100000, 60000);
+    int shown = 0, published = 0;
+    for (int pass = 0; pass < 16; ++pass) {
+        shown += memory.displayDue();
+        published += memory.telemetryDue();
+    }
+    EXPECT_EQ(shown, 16);
+    EXPECT_EQ(published, 16);
+
+    feed(30000, 60000);
+    EXPECT_EQ(esp_log_shim_level("Memory"), ESP_LOG_WARN);
+    shown = 0;
+    for (int pass = 0; pass < 16; ++pass) {
+        shown += memory.displayDue();
+    }
+    EXPECT_EQ(shown, 4);
+
+    feed(15000, 60000);
+    EXPECT_EQ(esp_log_shim_level("Memory"), ESP_LOG_ERROR);
+    EXPECT_EQ(esp_log_shim_level("FSM"), ESP_LOG_ERROR);
+    //Only the firmware's own tags are lowered
+    EXPECT_EQ(esp_log_shim_level("wifi"), ESP_LOG_DEBUG);
+    shown = published = 0;
+    for (int pass = 0; pass < 32; ++pass) {
+        shown += memory.displayDue();
+        published += memory.telemetryDue();
+    }
+    EXPECT_EQ(shown, 0);
+    EXPECT_EQ(published, 2);
+    //A state change is still shown
+    EXPECT_TRUE(memory.displayDue(true));
+
+    feed(100000, 60000);
+    EXPECT_EQ(esp_log_shim_level("Memory"), ESP_LOG_INFO);
+    EXPECT_EQ(esp_log_shim_level("wifi"), ESP_LOG_DEBUG);
+}
+
+TEST_F(Memory_Test, Memory_Restart_Waits_For_Safe_State){
+    feed(9000, 6000);
+    ASSERT_EQ(memory.pressure(), MEM_EXHAUSTED);
+    //ARMED: never restarts, keeps shedding
+    EXPECT_EQ(memory.restartDue(false), MEM_RESTART_NONE);
+    EXPECT_EQ(memory.displayDue(), false);
+
+    //Heap recovers in flight, the restart stays scheduled
+    feed(100000, 60000);
+    EXPECT_EQ(memory.pressure(), MEM_NORMAL);
+    EXPECT_EQ(memory.restartDue(false), MEM_RESTART_NONE);
+    EXPECT_EQ(memory.restartDue(true), MEM_RESTART_MEMORY);
+}
+
+TEST_F(Memory_Test, Idle_Restart_Is_Reached_Not_Matched){
+    memory.setIdleRestart(12LL * 3600 * 1000000);
+    sim_now_us = 12LL * 3600 * 1000000 - 1;
+    EXPECT_EQ(memory.restartDue(true), MEM_RESTART_NONE);
+    //The old uptime % interval check missed any sample not in that exact second
+    sim_now_us = 12LL * 3600 * 1000000 + 1500000;
+    EXPECT_EQ(memory.restartDue(true), MEM_RESTART_IDLE);
+    EXPECT_EQ(memory.restartDue(false), MEM_RESTART_NONE);
+    sim_now_us = 30LL * 3600 * 1000000;
+    EXPECT_EQ(memory.restartDue(true), MEM_RESTART_IDLE);
+
+    memory.setIdleRestart(0);
+    EXPECT_EQ(memory.restartDue(true), MEM_RESTART_NONE);
+}
+
+TEST_F(Memory_Test, Component_Accounting){
+    {
+        MemoryManager::Scope charge(MEM_COMP_COMMS, memory);
+        sim_heap.free_bytes -= 30000;
+    }
+    {
+        MemoryManager::Scope charge(MEM_COMP_COMMS, memory);
+        sim_heap.free_bytes += 10000;
+    }
+    memory.account(MEM_COMP_DISPLAY, 1024);
+
+    mem_usage_t usage[MEM_COMPONENT_COUNT];
+    ASSERT_EQ(memory.usage(usage, MEM_COMPONENT_COUNT), static_cast<std::size_t>(MEM_COMPONENT_COUNT));
+    EXPECT_STREQ(usage[MEM_COMP_COMMS].name, "comms");
+    EXPECT_EQ(usage[MEM_COMP_COMMS].current, 20000);
+    EXPECT_EQ(usage[MEM_COMP_COMMS].peak, 30000);
+    EXPECT_EQ(usage[MEM_COMP_DISPLAY].current, 1024);
+    EXPECT_EQ(usage[MEM_COMP_PTAM].peak, 0);
+}
+
+TEST_F(Memory_Test, Publish_And_Dump){
+    sim_heap.min_free = 25000;
+    feed(50000, 30000);
+    feed(70000, 40000);
+    memory.publish();
+
+    SharedMemory& sharedMemory = SharedMemory::getInstance();
+    EXPECT_EQ(sharedMemory.getLastInt(REG_HEAP_FREE), 70000);
+    EXPECT_EQ(sharedMemory.getLastInt(REG_HEAP_LARGEST), 40000);
+    //The allocator's own mark is lower than any sample
+    EXPECT_EQ(sharedMemory.getLastInt(REG_HEAP_MIN), 25000);
+    EXPECT_EQ(sharedMemory.getLastInt("HeapFree"), 70000);
+
+    uint8_t out[MEM_DUMP_MAX_BYTES];
+    const std::size_t len = memory.dump(out, sizeof(out));
+    ASSERT_GT(len, 0u);
+    //Map of 8 pairs, first key "v"
+    EXPECT_EQ(out[0], 0xa8);
+    EXPECT_EQ(out[1], 0x61);
+    EXPECT_EQ(out[2], 'v');
+    EXPECT_EQ(memory.dump(out, 8), 0u);
+}
+
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,516 @@
+/**
+ * @file unittestPID.cpp
+ * @brief Host tests for the multi-axis PID bank and Q16.16 fixed point
+ *
+ * PIDBank against the scalar PID::step it replaces, per-axis gains and
+ * limits, reset, and the float / fixed-point variants tracking the double
+ * one. Also the saturating q16_t arithmetic they rely on. FlightPID: no
+ * derivative kick, filtered derivative, anti-windup, slew limiting and a
+ * bumpless transfer, with the actuator travel they save. GainSchedule:
+ * the upload format both ways, bilinear lookup, NVS round trip and table swaps
+ * under a running lookup. FixedLUT: Q16.16 interpolation against the
+ * double remap it replaces and a nonlinear curve.
+ *
+ * @copyright Copyright (c) 2023 limitless Aeronautics
+ *            This file is part of the MARS Flight System Firmware
+ *
+ * @license MIT License
+ *          Copyright (c) 2023 limitless Aeronautics
+ *          Permission is hereby granted, free of charge, to any person obtaining a copy
+ *          of this software and associated documentation files (the "Software"), to deal
+ *          in the Software without restriction, including without limitation the rights
+ *          to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *          copies of the Software, and to permit persons to whom the Software is
+ *          furnished to do so, subject to the following conditions:
+ *          The above copyright notice and this permission notice shall be included in all
+ *          copies or substantial portions of the Software.
+ *          THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *          IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *          FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *          AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *          LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *          OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *          SOFTWARE.
+ */
+/* System includes */
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+
+/* PID includes */
+#include "_pid.h"
+#include "_pid_bank.h"
+#include "_fixed.h"
+#include "_lut.h"
+#include "_pid_flight.h"
+#include "_gain_schedule.h"
+
+/* Google testing */
+#include <gtest/gtest.h>
+
+/* Setpoint / measurement sequence shared by the tests (a step, then a ramp) */
+static double sim_target(int k, std::size_t axis) { return k < 50 ? 10.0 + axis : 10.0 + axis - 0.1 * (k - 50); }
+static double sim_current(int k, std::size_t axis) { return 8.0 * std::sin(0.05 * k + axis); }
+
+/**
+ * @brief A double bank steps every axis like PID::step (1 / dt is hoisted, so to rounding)
+ */
+TEST(PIDBank, Matches_Scalar_Step){
+    const pid_gains_t scalar[3] = {
+        {0.8, 0.2, 0.05, -5.0, 5.0},
+        {1.2, 0.0, 0.10, -2.0, 3.0},
+        {0.5, 0.4, 0.00, -1.0, 1.0},
+    };
+    pid_bank_gains_t<3, double> gains;
+    for (std::size_t i = 0; i < 3; ++i) {
+        gains.kp[i] = scalar[i].kp;
+        gains.ki[i] = scalar[i].ki;
+        gains.kd[i] = scalar[i].kd;
+        gains.min_output[i] = scalar[i].min_output;
+        gains.max_output[i] = scalar[i].max_output;
+    }
+    PIDBank<3, double> bank(gains);
+    pid_axis_t axes[3] = {};
+
+    for (int k = 0; k < 200; ++k) {
+        PIDBank<3, double>::vector_t target, current, out;
+        for (std::size_t i = 0; i < 3; ++i) {
+            target[i] = sim_target(k, i);
+            current[i] = sim_current(k, i);
+        }
+        bank.step(target, current, 0.01, out);
+        for (std::size_t i = 0; i < 3; ++i) {
+            ASSERT_NEAR(out[i], PID::step(scalar[i], axes[i], target[i], current[i], 0.01), 1e-9) << "axis " << i << " step " << k;
+        }
+    }
+}
+
+/**
+ * @brief Limits are per axis, the output keeps its sign
+ */
+TEST(PIDBank, Per_Axis_Limits){
+    pid_bank_gains_t<2, double> gains = pid_bank_gains_t<2, double>::uniform(1.0, 0.0, 0.0, -1.0, 1.0);
+    gains.min_output[1] = -10.0;
+    gains.max_output[1] = 10.0;
+    PIDBank<2, double> bank(gains);
+    const PIDBank<2, double>::vector_t out = bank.step({-4.0, -4.0}, {0.0, 0.0}, 0.01);
+    EXPECT_DOUBLE_EQ(out[0], -1.0);
+    EXPECT_DOUBLE_EQ(out[1], -4.0);
+}
+
+/**
+ * @brief No derivative on the first step, after reset() or with dt <= 0
+ */
+TEST(PIDBank, Derivative_Priming_And_Reset){
+    PIDBank<1, double> bank(pid_bank_gains_t<1, double>::uniform(0.0, 0.0, 1.0, -100.0, 100.0));
+    EXPECT_DOUBLE_EQ(bank.step({5.0}, {0.0}, 0.1)[0], 0.0);
+    EXPECT_DOUBLE_EQ(bank.step({6.0}, {0.0}, 0.1)[0], 10.0);
+    EXPECT_DOUBLE_EQ(bank.step({7.0}, {0.0}, 0.0)[0], 0.0);
+
+    bank.reset();
+    EXPECT_DOUBLE_EQ(bank.integral()[0], 0.0);
+    EXPECT_DOUBLE_EQ(bank.step({9.0}, {0.0}, 0.1)[0], 0.0);
+    EXPECT_DOUBLE_EQ(bank.previousError()[0], 9.0);
+}
+
+/**
+ * @brief Float (target arithmetic) and Q16.16 track the double bank
+ */
+TEST(PIDBank, Float_And_Fixed_Track_Double){
+    PIDBank<3, double> ref(pid_bank_gains_t<3, double>::uniform(0.8, 0.2, 0.05, -20.0, 20.0));
+    PIDBank<3, float> single(pid_bank_gains_t<3, float>::uniform(0.8, 0.2, 0.05, -20.0, 20.0));
+    PIDBank<3, q16_t> fixed(pid_bank_gains_t<3, q16_t>::uniform(0.8, 0.2, 0.05, -20.0, 20.0));
+
+    double floatErr = 0.0, fixedErr = 0.0;
+    for (int k = 0; k < 500; ++k) {
+        PIDBank<3, double>::vector_t t, c;
+        PIDBank<3, float>::vector_t tf, cf;
+        PIDBank<3, q16_t>::vector_t tq, cq;
+        for (std::size_t i = 0; i < 3; ++i) {
+            t[i] = sim_target(k, i);
+            c[i] = sim_current(k, i);
+            tf[i] = float(t[i]);
+            cf[i] = float(c[i]);
+            tq[i] = q16_t(t[i]);
+            cq[i] = q16_t(c[i]);
+        }
+        const PIDBank<3, double>::vector_t out = ref.step(t, c, 0.01);
+        const PIDBank<3, float>::vector_t outF = single.step(tf, cf, 0.01f);
+        const PIDBank<3, q16_t>::vector_t outQ = fixed.step(tq, cq, q16_t(0.01));
+        for (std::size_t i = 0; i < 3; ++i) {
+            floatErr = std::max(floatErr, std::fabs(double(outF[i]) - out[i]));
+            fixedErr = std::max(fixedErr, std::fabs(double(outQ[i]) - out[i]));
+        }
+    }
+    EXPECT_LT(floatErr, 1e-4);
+    //dt = 0.01 is 655 / 65536 in Q16.16, 0.05 % off, hence the looser bound
+    EXPECT_LT(fixedErr, 0.05);
+}
+
+/**
+ * @brief Q16.16 rounds to nearest and saturates instead of wrapping
+ */
+TEST(Fixed, Q16_Arithmetic){
+    EXPECT_EQ(q16_t(1.0).raw, q16_t::ONE);
+    EXPECT_EQ(q16_t(-0.5).raw, -q16_t::ONE / 2);
+    EXPECT_DOUBLE_EQ(double(q16_t(2.5) * q16_t(-4.0)), -10.0);
+    EXPECT_DOUBLE_EQ(double(q16_t(1.0) / q16_t(4.0)), 0.25);
+    EXPECT_NEAR(double(q16_t(3.14159)), 3.14159, 1.0 / q16_t::ONE);
+
+    const q16_t big(30000.0);
+    EXPECT_EQ((big + big).raw, INT32_MAX);
+    EXPECT_EQ((-big - big).raw, INT32_MIN);
+    EXPECT_EQ((big * q16_t(2.0)).raw, INT32_MAX);
+    EXPECT_EQ((q16_t(-1.0) / q16_t()).raw, INT32_MIN);
+    EXPECT_LT(q16_t(-1.0), q16_t(0.5));
+}
+
+//Built and looked up at compile time: breakpoints land exactly
+constexpr FixedLUT<2> SERVO_MS = FixedLUT<2>::linear(0.0, 360.0, 0.06, 2.1);
+static_assert(SERVO_MS(0.0) == double(q16_t(0.06)) && SERVO_MS(360.0) == double(q16_t(2.1)), "end breakpoints");
+static_assert(FixedLUT<2>::linear(-90.0, 90.0, -180.0, 180.0)(90.0) == 180.0, "last breakpoint");
+static_assert(FixedLUT<5>::linear(0.0, 40.0, 270.0, 230.0)(10.0) == 260.0, "inner breakpoint");
+
+/**
+ * @brief A two point table is the linear remap, to Q16.16 resolution,
+ *        clamped at its ends
+ */
+TEST(FixedLUT, Linear_Matches_Interpolate){
+    const FixedLUT<2> pitch = FixedLUT<2>::linear(-90.0, 90.0, -180.0, 180.0);
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<double> angle(-90.0, 90.0), turn(0.0, 360.0);
+    for (int k = 0; k < 10000; ++k) {
+        const double a = angle(rng), t = turn(rng);
+        //Input and output each rounded once: slope / 2 + 1 / 2 steps
+        EXPECT_NEAR(pitch(a), lut_interpolate(a, -90.0, 90.0, -180.0, 180.0), 2.0 / q16_t::ONE);
+        EXPECT_NEAR(SERVO_MS(t), lut_interpolate(t, 0.0, 360.0, 0.06, 2.1), 1.0 / q16_t::ONE);
+    }
+    EXPECT_DOUBLE_EQ(pitch(120.0), 180.0);
+    EXPECT_DOUBLE_EQ(pitch(-1e9), -180.0);
+    EXPECT_DOUBLE_EQ(pitch(INFINITY), 180.0);
+    EXPECT_DOUBLE_EQ(pitch(NAN), -180.0);
+    EXPECT_TRUE(pitch.monotonic());
+}
+
+/* Servo angle behind a wing sweep through a crank linkage (deg) */
+static double crank(double sweep) {
+    const double rad = M_PI / 180.0;
+    return std::asin(1.2 * std::sin(sweep * rad)) / rad;
+}
+
+/**
+ * @brief More breakpoints follow a nonlinear curve, descending tables work
+ */
+TEST(FixedLUT, Nonlinear_Curve){
+    const FixedLUT<9> coarse = FixedLUT<9>::sample(0.0, 40.0, crank);
+    const FixedLUT<33> fine = FixedLUT<33>::sample(0.0, 40.0, crank);
+    const FixedLUT<2> straight = FixedLUT<2>::sample(0.0, 40.0, crank);
+    double coarseMax = 0.0, fineMax = 0.0, straightMax = 0.0;
+    for (double x = 0.0; x <= 40.0; x += 0.01) {
+        coarseMax = std::max(coarseMax, std::fabs(coarse(x) - crank(x)));
+        fineMax = std::max(fineMax, std::fabs(fine(x) - crank(x)));
+        straightMax = std::max(straightMax, std::fabs(straight(x) - crank(x)));
+    }
+    std::printf("[lut     ] crank linkage, max error: 2 points %.3f deg, 9 points %.4f deg, 33 points %.5f deg\n",
+                straightMax, coarseMax, fineMax);
+    EXPECT_GT(straightMax, 1.0);
+    EXPECT_LT(coarseMax, 0.1);
+    EXPECT_LT(fineMax, 0.01);
+    EXPECT_TRUE(coarse.monotonic());
+
+    const double down[4] = {270.0, 262.0, 250.0, 230.0};
+    const FixedLUT<4> left = FixedLUT<4>::points(0.0, 30.0, down);
+    EXPECT_DOUBLE_EQ(left(10.0), 262.0);
+    EXPECT_NEAR(left(15.0), 256.0, 1.0 / q16_t::ONE);
+    EXPECT_TRUE(left.monotonic());
+    const double bump[3] = {0.0, 1.0, 0.5};
+    EXPECT_FALSE(FixedLUT<3>::points(0.0, 1.0, bump).monotonic());
+}
+
+/* Single axis production controller, unshaped unless the test sets it */
+static FlightPID<1, double>::config_t flight_config(double kp, double ki, double kd, double limit,
+                                                   const pid_shaping_t& shaping = {0.0, 0.0, 0.0}) {
+    FlightPID<1, double>::config_t config;
+    config.set(0, {kp, ki, kd, -limit, limit}, shaping);
+    return config;
+}
+
+/**
+ * @brief Derivative acts on the measurement: a setpoint step gives no kick
+ */
+TEST(FlightPID, No_Derivative_Kick){
+    FlightPID<1, double> pid(flight_config(0.0, 0.0, 1.0, 100.0));
+    PIDBank<1, double> bank(pid_bank_gains_t<1, double>::uniform(0.0, 0.0, 1.0, -100.0, 100.0));
+    pid.step({0.0}, {0.0}, 0.01);
+    bank.step({0.0}, {0.0}, 0.01);
+    EXPECT_DOUBLE_EQ(pid.step({10.0}, {0.0}, 0.01)[0], 0.0);
+    EXPECT_DOUBLE_EQ(bank.step({10.0}, {0.0}, 0.01)[0], 100.0);
+
+    //Measurement moving up damps (negative output)
+    EXPECT_LT(pid.step({10.0}, {0.5}, 0.01)[0], 0.0);
+}
+
+/**
+ * @brief The low-pass cuts the derivative noise of a noisy measurement
+ */
+TEST(FlightPID, Derivative_Low_Pass){
+    FlightPID<1, double> raw(flight_config(0.0, 0.0, 0.02, 100.0));
+    FlightPID<1, double> filtered(flight_config(0.0, 0.0, 0.02, 100.0, {0.0, 5.0, 0.0}));
+    std::mt19937 rng(7);
+    std::normal_distribution<double> noise(0.0, 0.2);
+    double rawVar = 0.0, filteredVar = 0.0;
+    for (int k = 0; k < 2000; ++k) {
+        const double y = 0.01 * k + noise(rng);
+        const double a = raw.step({0.0}, {y}, 0.005)[0];
+        const double b = filtered.step({0.0}, {y}, 0.005)[0];
+        if (k > 100) {
+            //The true derivative term is -0.02 * 2 = -0.04
+            rawVar += (a + 0.04) * (a + 0.04);
+            filteredVar += (b + 0.04) * (b + 0.04);
+        }
+    }
+    EXPECT_LT(filteredVar, rawVar / 20.0);
+}
+
+/**
+ * @brief Back-calculation and clamping leave saturation far sooner than a plain integrator
+ */
+TEST(FlightPID, Anti_Windup){
+    const double dt = 0.01;
+    FlightPID<1, double> backCalc(flight_config(0.5, 2.0, 0.0, 1.0, {4.0, 0.0, 0.0}));
+    FlightPID<1, double> clamping(flight_config(0.5, 2.0, 0.0, 1.0));
+    PIDBank<1, double> windup(pid_bank_gains_t<1, double>::uniform(0.5, 2.0, 0.0, -1.0, 1.0));
+
+    //5 s pinned against the upper limit
+    for (int k = 0; k < 500; ++k) {
+        backCalc.step({10.0}, {0.0}, dt);
+        clamping.step({10.0}, {0.0}, dt);
+        windup.step({10.0}, {0.0}, dt);
+    }
+    EXPECT_LE(backCalc.integral()[0], 1.0);
+    EXPECT_LE(clamping.integral()[0], 1.0);
+    EXPECT_GT(windup.integral()[0], 40.0);
+
+    //Error reverses: count the steps until the output leaves the limit
+    auto release = [dt](auto& pid) {
+        for (int k = 0; k < 5000; ++k) {
+            if (pid.step({-1.0}, {0.0}, dt)[0] < 1.0) {
+                return k;
+            }
+        }
+        return 5000;
+    };
+    const int fast = release(backCalc);
+    const int clamp = release(clamping);
+    const int slow = release(windup);
+    EXPECT_LT(fast, 10);
+    EXPECT_LT(clamp, 10);
+    EXPECT_GT(slow, 20 * fast);
+}
+
+/**
+ * @brief The applied output never moves faster than the slew rate
+ */
+TEST(FlightPID, Slew_Limit){
+    FlightPID<1, double> pid(flight_config(5.0, 0.0, 0.0, 1.0, {0.0, 0.0, 2.0}));
+    double previous = 0.0;
+    for (int k = 0; k < 100; ++k) {
+        const double target = (k / 25) % 2 == 0 ? 1.0 : -1.0;
+        const double out = pid.step({target}, {0.0}, 0.01)[0];
+        EXPECT_LE(std::fabs(out - previous), 2.0 * 0.01 + 1e-12);
+        previous = out;
+    }
+    //dt <= 0 holds the output
+    EXPECT_DOUBLE_EQ(pid.step({1.0}, {0.0}, 0.0)[0], previous);
+}
+
+/**
+ * @brief transfer() continues from the manual output, then converges as usual
+ */
+TEST(FlightPID, Bumpless_Transfer){
+    FlightPID<1, double> pid(flight_config(0.8, 0.5, 0.05, 1.0, {2.0, 10.0, 8.0}));
+    pid.transfer({0.6}, {3.0}, {1.0});
+    EXPECT_NEAR(pid.step({3.0}, {1.0}, 0.005)[0], 0.6, 0.5 * 2.0 * 0.005 + 1e-12);
+
+    //Without it the first output is the P term alone (or slewed from neutral)
+    FlightPID<1, double> cold(flight_config(0.8, 0.5, 0.05, 1.0, {2.0, 10.0, 8.0}));
+    EXPECT_NEAR(cold.step({3.0}, {1.0}, 0.005)[0], 0.04, 1e-12);
+
+    //Gain changes keep the integrator in output units: no bump either
+    const double before = pid.step({3.0}, {1.0}, 0.005)[0];
+    pid.setConfig(flight_config(0.8, 2.0, 0.05, 1.0, {2.0, 10.0, 8.0}));
+    EXPECT_NEAR(pid.step({3.0}, {1.0}, 0.005)[0], before, 0.02);
+}
+
+/**
+ * @brief Noisy hold: the shaped controller moves the actuator far less
+ */
+TEST(FlightPID, Less_Actuator_Travel){
+    FlightPID<1, double> shaped(flight_config(0.08, 0.01, 0.02, 1.0, {2.0, 10.0, 8.0}));
+    PIDBank<1, double> plain(pid_bank_gains_t<1, double>::uniform(0.08, 0.01, 0.02, -1.0, 1.0));
+    std::mt19937 rng(11);
+    std::normal_distribution<double> noise(0.0, 0.3);
+    double travelShaped = 0.0, travelPlain = 0.0, lastShaped = 0.0, lastPlain = 0.0;
+    for (int k = 0; k < 4000; ++k) {
+        const double y = noise(rng);
+        const double a = shaped.step({0.0}, {y}, 0.005)[0];
+        const double b = plain.step({0.0}, {y}, 0.005)[0];
+        travelShaped += std::fabs(a - lastShaped);
+        travelPlain += std::fabs(b - lastPlain);
+        lastShaped = a;
+        lastPlain = b;
+    }
+    std::printf("[travel  ] plain %.1f shaped %.1f (normalised units over 20 s)\n", travelPlain, travelShaped);
+    EXPECT_LT(travelShaped, travelPlain / 3.0);
+}
+
+/* 3 speeds x 2 altitudes: kp = speed / 10 + (alt - 90) / 100, ki = 0.1, kd = axis */
+static const char* const GAIN_TEXT =
+    "3 2 10 5 100 50\n"
+    "1.1,0.1,0  1.6,0.1,0  2.1,0.1,0\n"
+    "1.6,0.1,0  2.1,0.1,0  2.6,0.1,0\n"
+    "1.1 0.1 1  1.6 0.1 1  2.1 0.1 1\n"
+    "1.6 0.1 1  2.1 0.1 1  2.6 0.1 1\n";
+
+static gain_table_t parsed_table() {
+    gain_table_t table;
+    EXPECT_TRUE(GainSchedule::parse(GAIN_TEXT, std::strlen(GAIN_TEXT), table));
+    return table;
+}
+
+/**
+ * @brief The upload format round trips, anything malformed is refused
+ */
+TEST(GainSchedule, Parse_And_Reject){
+    const gain_table_t table = parsed_table();
+    EXPECT_EQ(table.speed_points, 3);
+    EXPECT_EQ(table.alt_points, 2);
+    EXPECT_FLOAT_EQ(table.speed_step, 5.0f);
+    EXPECT_FLOAT_EQ(table.gains[0][1][2].kp, 2.6f);
+    EXPECT_FLOAT_EQ(table.gains[1][0][1].kd, 1.0f);
+
+    //format() writes what parse() reads, bit exact
+    char formatted[GAIN_UPLOAD_MAX_BYTES];
+    const std::size_t formattedLen = GainSchedule::format(table, formatted, sizeof(formatted));
+    gain_table_t reparsed;
+    ASSERT_TRUE(GainSchedule::parse(formatted, formattedLen, reparsed));
+    EXPECT_EQ(std::memcmp(&reparsed, &table, sizeof(table)), 0);
+    EXPECT_EQ(GainSchedule::format(table, formatted, 16), 0u);
+
+    const std::string text = GAIN_TEXT;
+    gain_table_t out;
+    //Short, long, out of range sizes, negative and non numeric gains
+    EXPECT_FALSE(GainSchedule::parse(text.c_str(), text.size() - 4, out));
+    EXPECT_FALSE(GainSchedule::parse((text + " 1").c_str(), text.size() + 2, out));
+    EXPECT_FALSE(GainSchedule::parse("9 1 0 1 0 1", 11, out));
+    EXPECT_FALSE(GainSchedule::parse("1 1 0 1 0 1 1 0 0 -1 0 0", 24, out));
+    EXPECT_FALSE(GainSchedule::parse("1 1 0 1 0 1 1 0 0 nan 0 0", 25, out));
+    EXPECT_FALSE(GainSchedule::parse("1 1 0 1 0 1 1 0 0 1x 0 0", 24, out));
+    //Two breakpoints need a positive step
+    EXPECT_FALSE(GainSchedule::parse("2 1 0 0 0 1 1 0 0 1 0 0 1 0 0 1 0 0", 36, out));
+    EXPECT_TRUE(GainSchedule::parse("1 1 0 0 0 0 1 0 0 1 0 0\n", 24, out));
+    EXPECT_FALSE(GainSchedule::parse(GAIN_TEXT, GAIN_UPLOAD_MAX_BYTES + 1, out));
+
+    GainSchedule schedule;
+    gain_table_t bad = table;
+    bad.version = GAIN_TABLE_VERSION + 1;
+    EXPECT_FALSE(schedule.load(bad));
+    EXPECT_FALSE(schedule.active());
+}
+
+/**
+ * @brief Exact at breakpoints, bilinear between them, clamped outside
+ */
+TEST(GainSchedule, Bilinear_Lookup){
+    GainSchedule schedule;
+    gain_triplet_t g[GAIN_AXES];
+    EXPECT_FALSE(schedule.lookup(15.0, 120.0, g));
+    ASSERT_TRUE(schedule.load(parsed_table()));
+    const uint32_t loaded = schedule.version();
+
+    ASSERT_TRUE(schedule.lookup(15.0, 100.0, g));
+    EXPECT_FLOAT_EQ(g[0].kp, 1.6f);
+    EXPECT_FLOAT_EQ(g[1].kd, 1.0f);
+    //The table is linear in both axes, so interpolation reproduces it
+    ASSERT_TRUE(schedule.lookup(12.5, 125.0, g));
+    EXPECT_NEAR(g[0].kp, 1.25 + 0.35, 1e-5);
+    EXPECT_NEAR(g[0].ki, 0.1, 1e-6);
+    EXPECT_NEAR(g[1].kd, 1.0, 1e-6);
+    //Below and above the table
+    ASSERT_TRUE(schedule.lookup(0.0, 0.0, g));
+    EXPECT_FLOAT_EQ(g[0].kp, 1.1f);
+    ASSERT_TRUE(schedule.lookup(99.0, 900.0, g));
+    EXPECT_FLOAT_EQ(g[0].kp, 2.6f);
+    //No speed estimate yet: the slowest column
+    ASSERT_TRUE(schedule.lookup(NAN, 150.0, g));
+    EXPECT_FLOAT_EQ(g[0].kp, 1.6f);
+
+    const gain_triplet_t fixed[GAIN_AXES] = {{0.5f, 0.1f, 0.2f}, {0.7f, 0.0f, 0.3f}};
+    ASSERT_TRUE(schedule.load(GainSchedule::uniform(fixed)));
+    ASSERT_TRUE(schedule.lookup(31.0, -40.0, g));
+    EXPECT_FLOAT_EQ(g[0].kp, 0.5f);
+    EXPECT_FLOAT_EQ(g[1].kd, 0.3f);
+
+    schedule.clear();
+    EXPECT_FALSE(schedule.active());
+    EXPECT_FALSE(schedule.lookup(15.0, 120.0, g));
+    EXPECT_EQ(schedule.version(), loaded + 2);
+}
+
+/**
+ * @brief A saved table survives a restart, a missing one reads as none
+ */
+TEST(GainSchedule, Store_Round_Trip){
+    const std::string path = ::testing::TempDir() + "gain_schedule.bin";
+    std::remove(path.c_str());
+    gain_table_t restored;
+    {
+        PTAMFileStore store(path);
+        EXPECT_FALSE(GainSchedule::restore(store, restored));
+        EXPECT_TRUE(GainSchedule::save(store, parsed_table()));
+    }
+    PTAMFileStore store(path);
+    ASSERT_TRUE(GainSchedule::restore(store, restored));
+    const gain_table_t saved = parsed_table();
+    EXPECT_EQ(std::memcmp(&restored, &saved, sizeof(saved)), 0);
+}
+
+/**
+ * @brief Tables swapped under a running lookup are never seen half written
+ */
+TEST(GainSchedule, Swap_During_Lookup){
+    const gain_triplet_t low[GAIN_AXES] = {{1.0f, 1.0f, 1.0f}, {1.0f, 1.0f, 1.0f}};
+    const gain_triplet_t high[GAIN_AXES] = {{2.0f, 2.0f, 2.0f}, {2.0f, 2.0f, 2.0f}};
+    const gain_table_t tables[2] = {GainSchedule::uniform(low), GainSchedule::uniform(high)};
+    GainSchedule schedule;
+    ASSERT_TRUE(schedule.load(tables[0]));
+
+    std::atomic<bool> done(false);
+    std::thread loader([&] {
+        for (int k = 0; k < 20000; ++k) {
+            schedule.load(tables[k % 2]);
+        }
+        done = true;
+    });
+    int torn = 0, lookups = 0;
+    gain_triplet_t g[GAIN_AXES];
+    while (!done) {
+        ASSERT_TRUE(schedule.lookup(15.0, 120.0, g));
+        const float v = g[0].kp;
+        torn += (v != 1.0f && v != 2.0f) || g[0].ki != v || g[0].kd != v || g[1].kp != v || g[1].kd != v;
+        lookups++;
+    }
+    loader.join();
+    EXPECT_EQ(torn, 0);
+    EXPECT_GT(lookups, 0);
+}
+
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,861 @@
+/**
+ * @file unittestPipeline.cpp
+ * @brief Host tests for the ARMED flight pipeline, including a closed-loop mission
+ *
+ * Stage tests check the decomposition, guidance hand-over and the no-fix
+ * fallback. The closed-loop test flies a four waypoint box against a
+ * simple rigid-body model driven only by the wing positions the pipeline
+ * outputs, then reports tracking error and per-stage time. A second
+ * mission slows the loop down under simulated load, fed with the measured
+ * time step and with the nominal one it replaced. A recorded flight is
+ * replayed open loop through flat and altitude gain schedules. The wing
+ * mixer: exact moments, decoupled yaw / throttle, saturation priority.
+ * Coupled allocation: the mixer's wings where the demands fit, lower
+ * combined moment error where they do not. Linkage calibration: identity
+ * pass-through, a measured crank curve, validation and NVS round trip.
+ *
+ * @copyright Copyright (c) 2023 limitless Aeronautics
+ *            This file is part of the MARS Flight System Firmware
+ *
+ * @license MIT License
+ *          Copyright (c) 2023 limitless Aeronautics
+ *          Permission is hereby granted, free of charge, to any person obtaining a copy
+ *          of this software and associated documentation files (the "Software"), to deal
+ *          in the Software without restriction, including without limitation the rights
+ *          to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *          copies of the Software, and to permit persons to whom the Software is
+ *          furnished to do so, subject to the following conditions:
+ *          The above copyright notice and this permission notice shall be included in all
+ *          copies or substantial portions of the Software.
+ *          THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *          IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *          FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *          AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *          LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *          OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *          SOFTWARE.
+ */
+/* System includes */
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+/* Pipeline includes */
+#include "_pipeline.h"
+#include "_timestep.h"
+#include "_mixer.h"
+#include "_wing_calibration.h"
+
+/* Google testing */
+#include <gtest/gtest.h>
+
+#define SIM_RATE_HZ     200
+#define SIM_SUBSTEPS    5
+#define SIM_MAX_S       400.0
+
+/* Actuator sink used by the tests: counts calls, keeps the last frame */
+struct sink_t {
+    int calls = 0;
+    wing_set_t last{};
+};
+
+static void sink(void* ctx, const wing_set_t& wings) {
+    sink_t* s = static_cast<sink_t*>(ctx);
+    s->calls++;
+    s->last = wings;
+}
+
+/**
+ * @brief Rigid-body stand-in for the airframe
+ *
+ * Constant airspeed. The wing sweeps are turned back into pitch and roll
+ * moments (rear minus front, right minus left), the moments drive damped
+ * angular accelerations, bank turns through the coordinated turn rate.
+ */
+struct airframe_t {
+    static constexpr double SPEED = 15.0;           //m/s
+    static constexpr double AUTHORITY = 120.0;      //deg/s^2 at full sweep
+    static constexpr double DAMPING = 3.0;          //1/s
+    static constexpr double G = 9.81;
+
+    double x = 0.0, y = 0.0, z = 100.0;
+    double pitch = 0.0, roll = 0.0, yaw = 0.0;
+    double pitch_rate = 0.0, roll_rate = 0.0;
+
+    void update(const wing_set_t& w, double dt) {
+        const double fl = WING_LEFT_DEPLOYED - w.fl, rl = WING_LEFT_DEPLOYED - w.rl;
+        const double fr = w.fr - WING_RIGHT_DEPLOYED, rr = w.rr - WING_RIGHT_DEPLOYED;
+        const double pitchMoment = (rl + rr - fl - fr) / (2.0 * WING_SWEEP_LIMIT);
+        const double rollMoment = (fr + rr - fl - rl) / (2.0 * WING_SWEEP_LIMIT);
+
+        pitch_rate += (AUTHORITY * pitchMoment - DAMPING * pitch_rate) * dt;
+        roll_rate += (AUTHORITY * rollMoment - DAMPING * roll_rate) * dt;
+        pitch += pitch_rate * dt;
+        roll += roll_rate * dt;
+
+        const double rad = M_PI / 180.0;
+        yaw += (G / SPEED) * std::tan(roll * rad) / rad * dt;
+        x += SPEED * std::cos(pitch * rad) * std::cos(yaw * rad) * dt;
+        y += SPEED * std::cos(pitch * rad) * std::sin(yaw * rad) * dt;
+        z += SPEED * std::sin(pitch * rad) * dt;
+    }
+
+    nav_state_t nav() const {
+        return {x, y, z, pitch, roll, yaw, true};
+    }
+};
+
+//Distance from p to the segment a -> b, horizontal plane
+static double cross_track(const waypoint_t& a, const waypoint_t& b, double px, double py) {
+    const double dx = b.x - a.x, dy = b.y - a.y;
+    const double len2 = dx * dx + dy * dy;
+    double t = len2 > 0.0 ? ((px - a.x) * dx + (py - a.y) * dy) / len2 : 0.0;
+    t = std::clamp(t, 0.0, 1.0);
+    const double ex = px - (a.x + t * dx), ey = py - (a.y + t * dy);
+    return std::sqrt(ex * ex + ey * ey);
+}
+
+/**
+ * @brief Neutral, single axis and saturated mixes land on the right wings
+ */
+TEST(Pipeline, Decompose_Mix){
+    wing_set_t w;
+    DECOMPOSER::mixToWings(0.0, 0.0, w);
+    EXPECT_DOUBLE_EQ(w.fl, 270.0);
+    EXPECT_DOUBLE_EQ(w.fr, 90.0);
+    EXPECT_DOUBLE_EQ(w.rl, 270.0);
+    EXPECT_DOUBLE_EQ(w.rr, 90.0);
+
+    //Nose up sweeps the rear pair
+    DECOMPOSER::mixToWings(0.5, 0.0, w);
+    EXPECT_DOUBLE_EQ(w.rl, 250.0);
+    EXPECT_DOUBLE_EQ(w.rr, 110.0);
+    EXPECT_DOUBLE_EQ(w.fl, 270.0);
+
+    //Roll left sweeps the left pair, nose down the front pair
+    DECOMPOSER::mixToWings(-0.5, -0.25, w);
+    EXPECT_DOUBLE_EQ(w.fl, 240.0);
+    EXPECT_DOUBLE_EQ(w.fr, 110.0);
+    EXPECT_DOUBLE_EQ(w.rl, 260.0);
+    EXPECT_DOUBLE_EQ(w.rr, 90.0);
+
+    //Full nose down leaves FL no room: roll gives way, pitch is kept
+    DECOMPOSER::mixToWings(-1.0, -0.5, w);
+    EXPECT_DOUBLE_EQ(w.fl, 230.0);
+    EXPECT_DOUBLE_EQ(w.fr, 130.0);
+    EXPECT_DOUBLE_EQ(w.rl, 270.0);
+    EXPECT_DOUBLE_EQ(w.rr, 90.0);
+
+    //Out of range commands are clamped
+    DECOMPOSER::mixToWings(0.0, 5.0, w);
+    EXPECT_DOUBLE_EQ(w.fr, 130.0);
+    EXPECT_DOUBLE_EQ(w.rr, 130.0);
+}
+
+/* Moments of a wing set, as the test airframe turns them into rates */
+static void wing_moments(const wing_set_t& w, double& pitch, double& roll) {
+    const double fl = WING_LEFT_DEPLOYED - w.fl, rl = WING_LEFT_DEPLOYED - w.rl;
+    const double fr = w.fr - WING_RIGHT_DEPLOYED, rr = w.rr - WING_RIGHT_DEPLOYED;
+    pitch = (rl + rr - fl - fr) / (2.0 * WING_SWEEP_LIMIT);
+    roll = (fr + rr - fl - rl) / (2.0 * WING_SWEEP_LIMIT);
+}
+
+//Checked at compile time: the default table's nose up mix
+constexpr double mixed_rear_left(double pitch) {
+    wing_set_t w{};
+    WingMixer().mix({pitch, 0.0, 0.0, 0.0}, w);
+    return w.rl;
+}
+static_assert(mixed_rear_left(1.0) == WING_LEFT_DEPLOYED - WING_SWEEP_LIMIT, "nose up sweeps the rear pair");
+
+/**
+ * @brief Inside the limits the mixer delivers the commanded moments exactly
+ */
+TEST(Mixer, Moments_Inside_Limits){
+    const WingMixer mixer;
+    wing_set_t w;
+    for (double p = -0.5; p <= 0.5; p += 0.25) {
+        for (double r = -0.5; r <= 0.5; r += 0.25) {
+            EXPECT_EQ(mixer.mix({p, r, 0.0, 0.0}, w), 0);
+            double pitch, roll;
+            wing_moments(w, pitch, roll);
+            EXPECT_NEAR(pitch, p, 1e-12);
+            EXPECT_NEAR(roll, r, 1e-12);
+        }
+    }
+}
+
+/**
+ * @brief Yaw and throttle move the wings without a pitch or roll moment
+ */
+TEST(Mixer, Yaw_And_Throttle_Are_Decoupled){
+    const WingMixer mixer;
+    wing_set_t w;
+    double pitch, roll;
+    mixer.mix({0.0, 0.0, 0.5, 0.0}, w);
+    wing_moments(w, pitch, roll);
+    EXPECT_DOUBLE_EQ(w.fl, 250.0);
+    EXPECT_DOUBLE_EQ(w.rr, 110.0);
+    EXPECT_DOUBLE_EQ(pitch, 0.0);
+    EXPECT_DOUBLE_EQ(roll, 0.0);
+
+    mixer.mix({0.2, -0.1, 0.0, 0.3}, w);
+    wing_moments(w, pitch, roll);
+    EXPECT_DOUBLE_EQ(w.fr, 102.0);
+    EXPECT_NEAR(pitch, 0.2, 1e-12);
+    EXPECT_NEAR(roll, -0.1, 1e-12);
+    //Negative throttle has no surface
+    wing_set_t idle;
+    mixer.mix({0.2, -0.1, 0.0, -1.0}, idle);
+    wing_moments(idle, pitch, roll);
+    EXPECT_NEAR(pitch, 0.2, 1e-12);
+}
+
+/**
+ * @brief Saturation cuts the low priority inputs first and reports them
+ */
+TEST(Mixer, Saturation_Priority){
+    const WingMixer mixer;
+    wing_set_t w;
+    double pitch, roll;
+    //RR is asked for 0.8 + 0.6: roll gets what pitch leaves
+    const uint8_t cut = mixer.mix({0.8, 0.6, 0.0, 0.0}, w);
+    EXPECT_EQ(cut, 1u << MIX_ROLL);
+    wing_moments(w, pitch, roll);
+    EXPECT_NEAR(pitch, 0.8, 1e-12);
+    EXPECT_NEAR(roll, 0.2, 1e-12);
+    EXPECT_DOUBLE_EQ(w.rr, WING_RIGHT_DEPLOYED + WING_SWEEP_LIMIT);
+
+    //Full nose up fills the rear pair: yaw (FL + RR) and throttle get nothing
+    EXPECT_EQ(mixer.mix({1.0, 0.0, 0.5, 1.0}, w), (1u << MIX_YAW) | (1u << MIX_THROTTLE));
+    wing_moments(w, pitch, roll);
+    EXPECT_NEAR(pitch, 1.0, 1e-12);
+    EXPECT_DOUBLE_EQ(w.fl, 270.0);
+    //With room left throttle takes what yaw leaves
+    EXPECT_EQ(mixer.mix({0.0, 0.0, 0.5, 0.8}, w), 1u << MIX_THROTTLE);
+    EXPECT_DOUBLE_EQ(w.fl, 230.0);
+    EXPECT_DOUBLE_EQ(w.fr, 110.0);
+
+    //Roll first instead: now pitch gives way
+    mixer_table_t table = MIXER_DEFAULT_TABLE;
+    table.priority[0] = MIX_ROLL;
+    table.priority[1] = MIX_PITCH;
+    ASSERT_TRUE(mixer_valid(table));
+    EXPECT_EQ(WingMixer(table).mix({0.8, 0.6, 0.0, 0.0}, w), 1u << MIX_PITCH);
+    wing_moments(w, pitch, roll);
+    EXPECT_NEAR(roll, 0.6, 1e-12);
+
+    table.priority[1] = MIX_ROLL;
+    EXPECT_FALSE(mixer_valid(table));
+}
+
+/**
+ * @brief Per-surface limits and directions, NaN and out of range commands
+ */
+TEST(Mixer, Surface_Limits){
+    mixer_table_t table = MIXER_DEFAULT_TABLE;
+    table.surfaces[WING_RR].limit = 20.0;
+    const WingMixer mixer(table);
+    wing_set_t w;
+    mixer.mix({1.0, 0.0, 0.0, 0.0}, w);
+    EXPECT_DOUBLE_EQ(w.rl, 230.0);
+    EXPECT_DOUBLE_EQ(w.rr, 110.0);
+
+    mixer.mix({5.0, NAN, 0.0, 0.0}, w);
+    EXPECT_DOUBLE_EQ(w.rl, 230.0);
+    EXPECT_DOUBLE_EQ(w.fr, 90.0);
+
+    table.surfaces[WING_FL].limit = 0.0;
+    EXPECT_FALSE(mixer_valid(table));
+}
+
+/* Largest servo difference between two wing sets */
+static double wing_delta(const wing_set_t& a, const wing_set_t& b) {
+    return std::max({std::fabs(a.fl - b.fl), std::fabs(a.fr - b.fr), std::fabs(a.rl - b.rl), std::fabs(a.rr - b.rr)});
+}
+
+/* Moment error of a wing set against the demand */
+static double moment_error(const wing_set_t& w, double p, double r) {
+    double pitch, roll;
+    wing_moments(w, pitch, roll);
+    return std::hypot(pitch - p, roll - r);
+}
+
+/**
+ * @brief Where both demands fit, the allocator gives the mixer's wings
+ */
+TEST(Allocation, Matches_Mixer_When_Feasible){
+    const WingAllocator allocator;
+    const WingMixer mixer;
+    wing_set_t a, m;
+    for (double p = -1.0; p <= 1.0; p += 0.125) {
+        for (double r = -1.0; r <= 1.0; r += 0.125) {
+            if (std::fabs(p) + std::fabs(r) > 1.0) {
+                continue;
+            }
+            const alloc_moments_t achieved = allocator.allocate(p, r, a);
+            mixer.mix({p, r, 0.0, 0.0}, m);
+            EXPECT_NEAR(achieved.pitch, p, 1e-5);
+            EXPECT_NEAR(achieved.roll, r, 1e-5);
+            EXPECT_LT(moment_error(a, p, r), 1e-5);
+            EXPECT_LT(wing_delta(a, m), 1e-3);
+        }
+    }
+}
+
+/**
+ * @brief Over the whole command square the coupled solve never does worse
+ *        than the priority mixer and does better wherever a wing saturates
+ */
+TEST(Allocation, Lower_Combined_Error){
+    const WingAllocator allocator;
+    const WingMixer mixer;
+    wing_set_t a, m;
+    double allocError = 0.0, mixError = 0.0;
+    int saturated = 0, better = 0;
+    for (double p = -1.0; p <= 1.0; p += 0.05) {
+        for (double r = -1.0; r <= 1.0; r += 0.05) {
+            allocator.allocate(p, r, a);
+            mixer.mix({p, r, 0.0, 0.0}, m);
+            const double ea = moment_error(a, p, r), em = moment_error(m, p, r);
+            EXPECT_LE(ea, em + 1e-5);
+            allocError += ea * ea;
+            mixError += em * em;
+            if (std::fabs(p) + std::fabs(r) > 1.0 + 1e-9) {
+                saturated++;
+                better += ea < em - 1e-3;
+            }
+        }
+    }
+    std::printf("[allocate] combined moment error (sum of squares): mixer %.2f allocation %.2f\n",
+                mixError, allocError);
+    EXPECT_LT(allocError, 0.6 * mixError);
+    //Only full single axis demands (one of them 0) come out the same
+    EXPECT_GE(better, saturated - 4 * 20);
+
+    //RR asked for 0.8 + 0.5: the mixer keeps pitch and drops 0.3 of roll,
+    //the allocator meets |pitch| + |roll| = 1 at the nearest point
+    allocator.allocate(0.8, 0.5, a);
+    double pitch, roll;
+    wing_moments(a, pitch, roll);
+    EXPECT_NEAR(pitch, 0.65, 1e-5);
+    EXPECT_NEAR(roll, 0.35, 1e-5);
+    mixer.mix({0.8, 0.5, 0.0, 0.0}, m);
+    EXPECT_NEAR(moment_error(m, 0.8, 0.5), 0.3, 1e-9);
+    EXPECT_NEAR(moment_error(a, 0.8, 0.5), 0.15 * std::sqrt(2.0), 1e-5);
+}
+
+/**
+ * @brief Axis weights decide who gives way, the surfaces are never exceeded
+ */
+TEST(Allocation, Weights_And_Limits){
+    alloc_model_t model = ALLOC_DEFAULT_MODEL;
+    model.weight[ALLOC_PITCH] = 4.0;
+    const WingAllocator allocator(model);
+    wing_set_t w;
+    //min 4 (x - 0.8)^2 + (1 - x - 0.5)^2 -> x = 0.74
+    const alloc_moments_t achieved = allocator.allocate(0.8, 0.5, w);
+    EXPECT_NEAR(achieved.pitch, 0.74, 1e-5);
+    EXPECT_NEAR(achieved.roll, 0.26, 1e-5);
+
+    const WingAllocator fair;
+    for (double p = -3.0; p <= 3.0; p += 0.5) {
+        fair.allocate(p, -p / 2.0, w);
+        EXPECT_TRUE(w.fl >= 230.0 && w.fl <= 270.0 && w.rl >= 230.0 && w.rl <= 270.0);
+        EXPECT_TRUE(w.fr >= 90.0 && w.fr <= 130.0 && w.rr >= 90.0 && w.rr <= 130.0);
+    }
+    const alloc_moments_t held = fair.allocate(NAN, 0.25, w);
+    EXPECT_NEAR(held.pitch, 0.0, 1e-9);
+    EXPECT_NEAR(held.roll, 0.25, 1e-5);
+}
+
+/**
+ * @brief Both axes in one tick: four wings carrying both corrections
+ *        instead of two pairs that overwrite each other
+ */
+TEST(Allocation, Axes_To_Sweep){
+    StaticArena<256> arena;
+    ArenaCycle cycle(arena);
+    //Nose up and right wing down wanted together
+    ScratchSpan<double> pos = DECOMPOSER::axesToSweep(arena, 40.0, 50.0, 40.0, 50.0);
+    ASSERT_EQ(pos.size(), size_t(WING_COUNT));
+    const wing_set_t w = {pos[WING_FL], pos[WING_FR], pos[WING_RL], pos[WING_RR]};
+    double pitch, roll;
+    wing_moments(w, pitch, roll);
+    EXPECT_GT(pitch, 0.0);
+    EXPECT_GT(roll, 0.0);
+    //Same error on both axes, the PIDs only differ by their measured dt
+    EXPECT_NEAR(pitch, roll, 1e-3 * pitch);
+
+    StaticArena<16> tiny;
+    EXPECT_TRUE(DECOMPOSER::axesToSweep(tiny, 40.0, 50.0, 40.0, 50.0).empty());
+}
+
+/* Servo sweep behind a wing sweep through a crank linkage (deg) */
+static double crank_servo(double sweep) {
+    const double rad = M_PI / 180.0;
+    return std::asin(1.2 * std::sin(sweep * rad)) / rad;
+}
+
+/* Calibration measured on a crank linkage: servo angle per breakpoint */
+static wing_calibration_t crank_calibration() {
+    wing_calibration_t table = WingCalibration::identity();
+    for (int w = 0; w < WING_COUNT; ++w) {
+        const mix_surface_t& s = MIXER_DEFAULT_TABLE.surfaces[w];
+        for (int i = 0; i < WING_CAL_POINTS; ++i) {
+            const double sweep = s.limit * i / (WING_CAL_POINTS - 1);
+            table.servo[w][i] = static_cast<float>(s.deployed + s.direction * crank_servo(sweep));
+        }
+    }
+    return table;
+}
+
+/**
+ * @brief Without a stored calibration every position goes through unchanged,
+ *        manual positions outside the wing travel included
+ */
+TEST(Calibration, Identity_Passes_Through){
+    const WingCalibration calibration;
+    for (double p = 0.0; p <= 360.0; p += 0.5) {
+        for (int w = 0; w < WING_COUNT; ++w) {
+            EXPECT_EQ(calibration.servo(wing_id_t(w), p), p);
+        }
+    }
+}
+
+/**
+ * @brief A nonlinear linkage: the calibrated servo angle puts the wing where
+ *        the decomposer asked, the ideal linkage is degrees off
+ */
+TEST(Calibration, Linkage_Curve){
+    WingCalibration calibration;
+    ASSERT_TRUE(calibration.load(crank_calibration()));
+    double calibratedMax = 0.0, idealMax = 0.0;
+    for (double sweep = 0.0; sweep <= WING_SWEEP_LIMIT; sweep += 0.05) {
+        const double left = WING_LEFT_DEPLOYED - sweep, right = WING_RIGHT_DEPLOYED + sweep;
+        const double wantLeft = WING_LEFT_DEPLOYED - crank_servo(sweep);
+        const double wantRight = WING_RIGHT_DEPLOYED + crank_servo(sweep);
+        calibratedMax = std::max({calibratedMax, std::fabs(calibration.servo(WING_FL, left) - wantLeft),
+                                  std::fabs(calibration.servo(WING_RR, right) - wantRight)});
+        idealMax = std::max(idealMax, std::fabs(left - wantLeft));
+    }
+    std::printf("[wingcal ] crank linkage, servo error: ideal %.2f deg calibrated %.3f deg\n", idealMax,
+                calibratedMax);
+    EXPECT_GT(idealMax, 5.0);
+    EXPECT_LT(calibratedMax, 0.1);
+    //Past the travel the end correction is held
+    const double end = calibration.servo(WING_FR, WING_RIGHT_DEPLOYED + WING_SWEEP_LIMIT);
+    EXPECT_NEAR(calibration.servo(WING_FR, 140.0), end + 10.0, 1e-4);
+    EXPECT_NEAR(calibration.servo(WING_FR, 80.0), 80.0, 1e-4);
+}
+
+/**
+ * @brief Bad curves are rejected and leave the loaded one in place,
+ *        a stored one comes back from NVS
+ */
+TEST(Calibration, Validate_And_Store){
+    WingCalibration calibration;
+    ASSERT_TRUE(calibration.load(crank_calibration()));
+    const double before = calibration.servo(WING_RL, 250.0);
+
+    wing_calibration_t bad = crank_calibration();
+    std::swap(bad.servo[WING_RL][3], bad.servo[WING_RL][4]);
+    EXPECT_FALSE(calibration.load(bad));
+    bad = crank_calibration();
+    bad.servo[WING_FR][8] += 25.0f;
+    EXPECT_FALSE(WingCalibration::validate(bad));
+    bad = crank_calibration();
+    bad.servo[WING_FL][2] = NAN;
+    EXPECT_FALSE(WingCalibration::validate(bad));
+    bad = crank_calibration();
+    bad.version = WING_CAL_VERSION + 1;
+    EXPECT_FALSE(WingCalibration::validate(bad));
+    EXPECT_EQ(calibration.servo(WING_RL, 250.0), before);
+
+    const std::string path = ::testing::TempDir() + "wing_calibration.bin";
+    std::remove(path.c_str());
+    wing_calibration_t restored;
+    {
+        PTAMFileStore store(path);
+        EXPECT_FALSE(WingCalibration::restore(store, restored));
+        EXPECT_FALSE(WingCalibration::save(store, bad));
+        EXPECT_TRUE(WingCalibration::save(store, crank_calibration()));
+    }
+    PTAMFileStore store(path);
+    ASSERT_TRUE(WingCalibration::restore(store, restored));
+    WingCalibration reloaded;
+    ASSERT_TRUE(reloaded.load(restored));
+    EXPECT_EQ(reloaded.servo(WING_RL, 250.0), before);
+}
+
+/**
+ * @brief Signed output, clamped, no derivative kick on the first step
+ */
+TEST(Pipeline, PID_Step){
+    pid_gains_t gains = {1.0, 0.0, 1.0, -2.0, 2.0};
+    pid_axis_t axis{};
+    EXPECT_DOUBLE_EQ(PID::step(gains, axis, 0.0, 1.5, 0.01), -1.5);
+    EXPECT_DOUBLE_EQ(PID::step(gains, axis, 0.0, 1.5, 0.01), -1.5);
+    EXPECT_DOUBLE_EQ(PID::step(gains, axis, 10.0, 0.0, 0.01), 2.0);
+}
+
+/**
+ * @brief Waypoints inside the acceptance radius hand over, the last one completes
+ */
+TEST(Pipeline, Guidance_Handover){
+    sink_t s;
+    FlightPipeline pipeline(PIPELINE_DEFAULT_CONFIG, sink, &s);
+    const waypoint_t mission[] = {{100, 0, 100}, {100, 100, 100}};
+    ASSERT_TRUE(pipeline.setMission(mission, 2));
+
+    pipeline.step({0, 0, 100, 0, 0, 0, true}, 0.005);
+    EXPECT_EQ(pipeline.guidance().index, 0);
+    EXPECT_NEAR(pipeline.guidance().distance, 100.0, 1e-9);
+    EXPECT_NEAR(pipeline.guidance().bearing, 0.0, 1e-9);
+
+    pipeline.step({95, 0, 100, 0, 0, 0, true}, 0.005);
+    EXPECT_EQ(pipeline.guidance().index, 1);
+    EXPECT_NEAR(pipeline.guidance().bearing, std::atan2(100.0, 5.0) * 180.0 / M_PI, 1e-9);
+    //Heading error of about 90 deg saturates the bank command to the right
+    EXPECT_DOUBLE_EQ(pipeline.attitudeCommand().roll, PIPELINE_DEFAULT_CONFIG.max_roll);
+
+    pipeline.step({100, 95, 100, 0, 0, 90, true}, 0.005);
+    EXPECT_TRUE(pipeline.guidance().complete);
+    EXPECT_DOUBLE_EQ(pipeline.attitudeCommand().roll, 0.0);
+    EXPECT_EQ(s.calls, 3);
+}
+
+/**
+ * @brief No fix (or no mission) flies wings level, bad missions are refused
+ */
+TEST(Pipeline, No_Fix_Holds_Level){
+    sink_t s;
+    FlightPipeline pipeline(PIPELINE_DEFAULT_CONFIG, sink, &s);
+    waypoint_t mission[PIPELINE_MAX_WAYPOINTS + 1] = {};
+    EXPECT_FALSE(pipeline.setMission(mission, 0));
+    EXPECT_FALSE(pipeline.setMission(mission, PIPELINE_MAX_WAYPOINTS + 1));
+
+    mission[0] = {500, 500, 200};
+    ASSERT_TRUE(pipeline.setMission(mission, 1));
+    //Banked right and nose up without a fix: command level, correct left / down
+    pipeline.step({0, 0, 100, 10, 20, 0, false}, 0.005);
+    EXPECT_DOUBLE_EQ(pipeline.attitudeCommand().pitch, 0.0);
+    EXPECT_DOUBLE_EQ(pipeline.attitudeCommand().roll, 0.0);
+    EXPECT_LT(pipeline.axisCommand().pitch, 0.0);
+    EXPECT_LT(pipeline.axisCommand().roll, 0.0);
+    EXPECT_LT(s.last.fl, WING_LEFT_DEPLOYED);
+    EXPECT_EQ(pipeline.guidance().index, 0);
+    EXPECT_FALSE(pipeline.guidance().complete);
+}
+
+/**
+ * @brief wingsToAxes inverts mixToWings inside the travel limits
+ */
+TEST(Pipeline, Wings_To_Axes){
+    const double cases[][2] = {{0.0, 0.0}, {0.5, 0.0}, {-0.3, 0.4}, {0.2, -0.6}};
+    for (const auto& c : cases) {
+        wing_set_t w;
+        double pitch, roll;
+        DECOMPOSER::mixToWings(c[0], c[1], w);
+        DECOMPOSER::wingsToAxes(w, pitch, roll);
+        EXPECT_NEAR(pitch, c[0], 1e-9);
+        EXPECT_NEAR(roll, c[1], 1e-9);
+    }
+}
+
+/**
+ * @brief BYPASS -> ARMED: the first frame continues from the manual wings
+ */
+TEST(Pipeline, Bumpless_Transfer){
+    sink_t s;
+    FlightPipeline pipeline(PIPELINE_DEFAULT_CONFIG, sink, &s);
+    const nav_state_t nav = {0, 0, 100, 4, -6, 0, true};
+    wing_set_t manual;
+    DECOMPOSER::mixToWings(0.4, -0.3, manual);
+
+    pipeline.transfer(manual, nav);
+    pipeline.step(nav, 0.005);
+    EXPECT_NEAR(s.last.fl, manual.fl, 0.5);
+    EXPECT_NEAR(s.last.fr, manual.fr, 0.5);
+    EXPECT_NEAR(s.last.rl, manual.rl, 0.5);
+    EXPECT_NEAR(s.last.rr, manual.rr, 0.5);
+
+    //A cold start jumps to the P term alone
+    sink_t cold;
+    FlightPipeline coldPipeline(PIPELINE_DEFAULT_CONFIG, sink, &cold);
+    coldPipeline.step(nav, 0.005);
+    EXPECT_GT(std::fabs(cold.last.fl - manual.fl), 2.0);
+}
+
+TEST(Pipeline, Geo_To_Local){
+    double north, east;
+    FlightPipeline::geoToLocal(51.001, 0.0, 51.0, 0.0, north, east);
+    EXPECT_NEAR(north, 111.2, 0.1);
+    EXPECT_NEAR(east, 0.0, 1e-9);
+    FlightPipeline::geoToLocal(0.0, 0.001, 0.0, 0.0, north, east);
+    EXPECT_NEAR(east, 111.2, 0.1);
+}
+
+/**
+ * @brief Fly a box mission closed loop, report tracking error and stage times
+ */
+TEST(Pipeline, Closed_Loop_Mission){
+    const waypoint_t mission[] = {
+        {400, 0, 110}, {400, 400, 110}, {0, 400, 100}, {0, 0, 100},
+    };
+    airframe_t airframe;
+    FlightPipeline pipeline;
+    ASSERT_TRUE(pipeline.setMission(mission, 4));
+
+    const double dt = 1.0 / SIM_RATE_HZ;
+    double t = 0.0;
+    uint8_t leg = 0;
+    double pitchErr2 = 0.0, rollErr2 = 0.0, xtrack2 = 0.0, xtrackMax = 0.0;
+    double pitchMax = 0.0, rollMax = 0.0;
+    long steps = 0;
+    while (!pipeline.guidance().complete && t < SIM_MAX_S) {
+        pipeline.step(airframe.nav(), dt);
+        //Tracking against the command of this tick, after the model responds
+        for (int i = 0; i < SIM_SUBSTEPS; ++i) {
+            airframe.update(pipeline.wings(), dt / SIM_SUBSTEPS);
+        }
+        const double pe = pipeline.attitudeCommand().pitch - airframe.pitch;
+        const double re = pipeline.attitudeCommand().roll - airframe.roll;
+        pitchErr2 += pe * pe;
+        rollErr2 += re * re;
+
+        leg = pipeline.guidance().index;
+        const waypoint_t from = leg == 0 ? waypoint_t{0, 0, 100} : mission[leg - 1];
+        const double xt = cross_track(from, mission[leg], airframe.x, airframe.y);
+        xtrack2 += xt * xt;
+        xtrackMax = std::max(xtrackMax, xt);
+        pitchMax = std::max(pitchMax, std::fabs(airframe.pitch));
+        rollMax = std::max(rollMax, std::fabs(airframe.roll));
+        steps++;
+        t += dt;
+    }
+
+    const double pitchRms = std::sqrt(pitchErr2 / steps);
+    const double rollRms = std::sqrt(rollErr2 / steps);
+    const double xtrackRms = std::sqrt(xtrack2 / steps);
+    std::printf("[mission ] %s in %.1f s | attitude error rms: pitch %.2f deg roll %.2f deg"
+                " | cross-track rms %.1f m max %.1f m | |pitch| max %.1f |roll| max %.1f\n",
+                pipeline.guidance().complete ? "complete" : "INCOMPLETE", t,
+                pitchRms, rollRms, xtrackRms, xtrackMax, pitchMax, rollMax);
+
+    pipeline_stage_stats_t stats[PIPELINE_STAGE_COUNT];
+    ASSERT_EQ(pipeline.stats(stats, PIPELINE_STAGE_COUNT), size_t(PIPELINE_STAGE_COUNT));
+    for (const pipeline_stage_stats_t& s : stats) {
+        std::printf("[stage   ] %-10s runs %u mean %u ns max %u ns\n", s.name, s.runs, s.mean_ns, s.max_ns);
+        EXPECT_EQ(s.runs, static_cast<uint32_t>(steps));
+    }
+
+    EXPECT_TRUE(pipeline.guidance().complete);
+    EXPECT_LT(pitchRms, 2.0);
+    EXPECT_LT(rollRms, 5.0);
+    EXPECT_LT(xtrackMax, 60.0);
+    EXPECT_LT(rollMax, PIPELINE_DEFAULT_CONFIG.max_roll + 5.0);
+    EXPECT_NEAR(airframe.z, 100.0, PIPELINE_DEFAULT_CONFIG.accept_radius);
+}
+
+/* Simulated clock for the measured time step */
+static int64_t sim_now_us = 0;
+static int64_t sim_clock() { return sim_now_us; }
+
+struct mission_result_t {
+    bool complete;
+    double attitudeRms;
+    double xtrackMax;
+};
+
+/**
+ * @brief Box mission with the loop interval stretched (and jittering) under load
+ *
+ * measured: the pipeline gets TimeStep::tick(), else the nominal period
+ * whatever the interval really was.
+ */
+static mission_result_t fly_loaded(bool measured) {
+    const waypoint_t mission[] = {
+        {400, 0, 110}, {400, 400, 110}, {0, 400, 100}, {0, 0, 100},
+    };
+    airframe_t airframe;
+    FlightPipeline pipeline;
+    pipeline.setMission(mission, 4);
+    const uint32_t nominal_us = 1000000 / SIM_RATE_HZ;
+    sim_now_us = 0;
+    TimeStep step("sim.control", nominal_us, sim_clock);
+    std::mt19937 rng(3);
+    //Under load the loop runs at 50..100 Hz instead of 200 Hz
+    std::uniform_int_distribution<int64_t> loaded(2 * nominal_us, 4 * nominal_us);
+
+    double err2 = 0.0, xtrackMax = 0.0;
+    long steps = 0;
+    while (!pipeline.guidance().complete && sim_now_us < SIM_MAX_S * 1e6) {
+        const double dt = step.tick();
+        pipeline.step(airframe.nav(), measured ? dt : nominal_us / 1e6);
+        const bool underLoad = sim_now_us > 20000000 && sim_now_us < 120000000;
+        const int64_t interval = underLoad ? loaded(rng) : nominal_us;
+        for (int i = 0; i < SIM_SUBSTEPS; ++i) {
+            airframe.update(pipeline.wings(), interval / 1e6 / SIM_SUBSTEPS);
+        }
+        sim_now_us += interval;
+
+        const double pe = pipeline.attitudeCommand().pitch - airframe.pitch;
+        const double re = pipeline.attitudeCommand().roll - airframe.roll;
+        err2 += pe * pe + re * re;
+        const uint8_t leg = pipeline.guidance().index;
+        const waypoint_t from = leg == 0 ? waypoint_t{0, 0, 100} : mission[leg - 1];
+        xtrackMax = std::max(xtrackMax, cross_track(from, mission[leg], airframe.x, airframe.y));
+        steps++;
+    }
+
+    const timestep_stats_t stats = step.stats();
+    std::printf("[loaded  ] %-8s dt: mean %u us jitter mean %u max %u us | attitude rms %.2f deg"
+                " | cross-track max %.1f m\n", measured ? "measured" : "nominal", stats.mean_us,
+                stats.jitter_mean_us, stats.jitter_max_us, std::sqrt(err2 / steps), xtrackMax);
+    return {pipeline.guidance().complete, std::sqrt(err2 / steps), xtrackMax};
+}
+
+/**
+ * @brief The loop slows down under load: control still holds with the measured dt
+ */
+TEST(Pipeline, Rate_Change_Under_Load){
+    const mission_result_t measured = fly_loaded(true);
+    const mission_result_t nominal = fly_loaded(false);
+    EXPECT_TRUE(measured.complete);
+    EXPECT_LT(measured.xtrackMax, 60.0);
+    EXPECT_LT(measured.attitudeRms, nominal.attitudeRms);
+}
+
+/* Default gains as a schedule row (pitch, roll), scale multiplies every gain */
+static void default_gains(gain_triplet_t out[GAIN_AXES], float scale) {
+    const pid_gains_t& pitch = PIPELINE_DEFAULT_CONFIG.pitch;
+    const pid_gains_t& roll = PIPELINE_DEFAULT_CONFIG.roll;
+    out[0] = {float(pitch.kp) * scale, float(pitch.ki) * scale, float(pitch.kd) * scale};
+    out[1] = {float(roll.kp) * scale, float(roll.ki) * scale, float(roll.kd) * scale};
+}
+
+/* Default gains up to 105 m, twice as stiff from 115 m */
+static gain_table_t altitude_table() {
+    gain_triplet_t low[GAIN_AXES], high[GAIN_AXES];
+    default_gains(low, 1.0f);
+    default_gains(high, 2.0f);
+    gain_table_t table = GainSchedule::uniform(low);
+    table.alt_points = 2;
+    table.alt_min = 105.0f;
+    table.alt_step = 10.0f;
+    for (int axis = 0; axis < GAIN_AXES; ++axis) {
+        table.gains[axis][1][0] = high[axis];
+    }
+    return table;
+}
+
+/* Box mission flown closed loop, the nav states are kept for replays */
+static bool fly_recorded(const GainSchedule* schedule, std::vector<nav_state_t>* record, double* speed) {
+    const waypoint_t mission[] = {
+        {400, 0, 110}, {400, 400, 110}, {0, 400, 100}, {0, 0, 100},
+    };
+    airframe_t airframe;
+    FlightPipeline pipeline;
+    pipeline.setMission(mission, 4);
+    pipeline.setSchedule(schedule);
+    const double dt = 1.0 / SIM_RATE_HZ;
+    double err2 = 0.0, t = 0.0;
+    long steps = 0;
+    while (!pipeline.guidance().complete && t < SIM_MAX_S) {
+        if (record != nullptr) {
+            record->push_back(airframe.nav());
+        }
+        pipeline.step(airframe.nav(), dt);
+        for (int i = 0; i < SIM_SUBSTEPS; ++i) {
+            airframe.update(pipeline.wings(), dt / SIM_SUBSTEPS);
+        }
+        const double pe = pipeline.attitudeCommand().pitch - airframe.pitch;
+        const double re = pipeline.attitudeCommand().roll - airframe.roll;
+        err2 += pe * pe + re * re;
+        steps++;
+        t += dt;
+    }
+    std::printf("[schedule] %-9s %s in %.1f s | attitude rms %.2f deg | speed %.2f m/s\n",
+                schedule == nullptr ? "fixed" : "scheduled", pipeline.guidance().complete ? "complete" : "INCOMPLETE",
+                t, std::sqrt(err2 / steps), pipeline.speed());
+    if (speed != nullptr) {
+        *speed = pipeline.speed();
+    }
+    return pipeline.guidance().complete;
+}
+
+/* Open loop replay of recorded nav states, wings of every step */
+static std::vector<wing_set_t> replay(const std::vector<nav_state_t>& record, const GainSchedule* schedule) {
+    const waypoint_t mission[] = {
+        {400, 0, 110}, {400, 400, 110}, {0, 400, 100}, {0, 0, 100},
+    };
+    FlightPipeline pipeline;
+    pipeline.setMission(mission, 4);
+    pipeline.setSchedule(schedule);
+    std::vector<wing_set_t> wings;
+    wings.reserve(record.size());
+    for (const nav_state_t& nav : record) {
+        pipeline.step(nav, 1.0 / SIM_RATE_HZ);
+        wings.push_back(pipeline.wings());
+    }
+    return wings;
+}
+
+/**
+ * @brief Replayed flight: a flat table flies like the fixed gains, an
+ *        altitude table takes over once the climb crosses its first row
+ */
+TEST(Pipeline, Gain_Schedule_Replay){
+    std::vector<nav_state_t> record;
+    double speed = 0.0;
+    ASSERT_TRUE(fly_recorded(nullptr, &record, &speed));
+    //Speed over ground from the fixes, the airframe flies 15 m/s
+    EXPECT_NEAR(speed, airframe_t::SPEED, 0.5);
+
+    const std::vector<wing_set_t> fixed = replay(record, nullptr);
+    GainSchedule schedule;
+    gain_triplet_t defaults[GAIN_AXES];
+    default_gains(defaults, 1.0f);
+    ASSERT_TRUE(schedule.load(GainSchedule::uniform(defaults)));
+    const std::vector<wing_set_t> flat = replay(record, &schedule);
+    double flatMax = 0.0;
+    for (std::size_t k = 0; k < record.size(); ++k) {
+        flatMax = std::max(flatMax, wing_delta(fixed[k], flat[k]));
+    }
+    //Only the float rounding of the stored gains
+    EXPECT_LT(flatMax, 1e-3);
+
+    ASSERT_TRUE(schedule.load(altitude_table()));
+    const std::vector<wing_set_t> scheduled = replay(record, &schedule);
+    std::size_t crossed = 0;
+    while (crossed < record.size() && record[crossed].z <= 105.0) {
+        crossed++;
+    }
+    ASSERT_LT(crossed, record.size());
+    double belowMax = 0.0, aboveMax = 0.0;
+    for (std::size_t k = 0; k < record.size(); ++k) {
+        double& worst = k < crossed ? belowMax : aboveMax;
+        worst = std::max(worst, wing_delta(fixed[k], scheduled[k]));
+    }
+    std::printf("[replay  ] %zu steps, 105 m crossed at %.1f s | wing delta below %.2g deg above %.2f deg\n",
+                record.size(), crossed / double(SIM_RATE_HZ), belowMax, aboveMax);
+    EXPECT_LT(belowMax, 1e-3);
+    EXPECT_GT(aboveMax, 0.5);
+
+    //Closed loop the stiffer cruise gains still fly the mission
+    EXPECT_TRUE(fly_recorded(&schedule, nullptr, nullptr));
+    schedule.clear();
+    //An attached but empty schedule falls back to the fixed gains
+    const std::vector<wing_set_t> cleared = replay(record, &schedule);
+    EXPECT_EQ(wing_delta(fixed.back(), cleared.back()), 0.0);
+}
+
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
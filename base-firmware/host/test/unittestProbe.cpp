@@ -0,0 +1,260 @@
+/**
+ * @file unittestProbe.cpp
+ * @brief Host tests for the cycle-count probe table and the time-step service
+ *
+ *
+ * @copyright Copyright (c) 2023 limitless Aeronautics
+ *            This file is part of the MARS Flight System Firmware
+ *
+ * @license MIT License
+ *          Copyright (c) 2023 limitless Aeronautics
+ *          Permission is hereby granted, free of charge, to any person obtaining a copy
+ *          of this software and associated documentation files (the "Software"), to deal
+ *          in the Software without restriction, including without limitation the rights
+ *          to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *          copies of the Software, and to permit persons to whom the Software is
+ *          furnished to do so, subject to the following conditions:
+ *          The above copyright notice and this permission notice shall be included in all
+ *          copies or substantial portions of the Software.
+ *          THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *          IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *          FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *          AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *          LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *          OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *          SOFTWARE.
+ */
+/* System includes */
+#include <cstring>
+#include <string>
+
+/* Profiling includes */
+#include "_probe.h"
+#include "_timestep.h"
+
+/* Google testing */
+#include <gtest/gtest.h>
+
+static const probe_stats_t* find(const probe_stats_t* stats, std::size_t n, const char* name) {
+    for (std::size_t i = 0; i < n; ++i) {
+        if (std::strcmp(stats[i].name, name) == 0) {
+            return &stats[i];
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Every tick value lands in a bucket whose bound covers it, buckets are monotonic
+ */
+TEST(TestProbe, Bucket_Layout){
+    for (uint64_t ticks = 0; ticks <= UINT32_MAX; ticks = ticks * 3 / 2 + 1) {
+        const std::size_t bucket = probe_bucket(static_cast<uint32_t>(ticks));
+        ASSERT_LT(bucket, PROBE_BUCKETS);
+        EXPECT_LE(ticks, probe_bucket_max(bucket));
+        if (bucket > 0) {
+            EXPECT_GT(ticks, probe_bucket_max(bucket - 1));
+        }
+        //Bound is at most 25% above the value
+        EXPECT_LE(probe_bucket_max(bucket), ticks + ticks / 4 + 1);
+    }
+}
+
+/**
+ * @brief Same name resolves to the same probe
+ */
+TEST(TestProbe, Lookup_Same_Name){
+    ProbeTable& table = ProbeTable::getInstance();
+    Probe* a = table.probe("test.lookup");
+    ASSERT_NE(a, nullptr);
+    EXPECT_EQ(table.probe("test.lookup"), a);
+    EXPECT_STREQ(a->name(), "test.lookup");
+}
+
+/**
+ * @brief min / mean / max / p99 from known durations (host ticks are ns)
+ */
+TEST(TestProbe, Statistics){
+    ProbeTable& table = ProbeTable::getInstance();
+    Probe* probe = table.probe("test.stats");
+    ASSERT_NE(probe, nullptr);
+    //99 fast samples and one slow outlier
+    for (int i = 0; i < 99; ++i) {
+        probe->record(1000);
+    }
+    probe->record(100000);
+
+    probe_stats_t stats[PROBE_MAX];
+    std::size_t n = table.snapshot(stats, PROBE_MAX);
+    const probe_stats_t* s = find(stats, n, "test.stats");
+    ASSERT_NE(s, nullptr);
+    EXPECT_EQ(s->count, 100u);
+    EXPECT_EQ(s->min_ns, 1000u);
+    EXPECT_EQ(s->max_ns, 100000u);
+    EXPECT_EQ(s->mean_ns, (99u * 1000u + 100000u) / 100u);
+    //p99 is the 99th sample, inside the 1000 tick bucket
+    EXPECT_GE(s->p99_ns, 1000u);
+    EXPECT_LE(s->p99_ns, 1250u);
+
+    table.reset();
+    n = table.snapshot(stats, PROBE_MAX);
+    s = find(stats, n, "test.stats");
+    ASSERT_NE(s, nullptr);
+    EXPECT_EQ(s->count, 0u);
+    EXPECT_EQ(s->max_ns, 0u);
+}
+
+/**
+ * @brief PROBE_SCOPE records once per pass, stop() ends the scope early
+ */
+TEST(TestProbe, Scope_Macros){
+    for (int i = 0; i < 5; ++i) {
+        PROBE_SCOPE("test.scope");
+    }
+    {
+        PROBE_SCOPE_AS(early, "test.early");
+        early.stop();
+        early.stop();
+    }
+
+    probe_stats_t stats[PROBE_MAX];
+    std::size_t n = ProbeTable::getInstance().snapshot(stats, PROBE_MAX);
+    ASSERT_NE(find(stats, n, "test.scope"), nullptr);
+    EXPECT_EQ(find(stats, n, "test.scope")->count, 5u);
+    ASSERT_NE(find(stats, n, "test.early"), nullptr);
+    EXPECT_EQ(find(stats, n, "test.early")->count, 1u);
+}
+
+/**
+ * @brief Probes are fixed, the table refuses names beyond PROBE_MAX
+ */
+TEST(TestProbe, Table_Full){
+    ProbeTable& table = ProbeTable::getInstance();
+    for (std::size_t i = table.size(); i < PROBE_MAX; ++i) {
+        ASSERT_NE(table.probe(("test.fill" + std::to_string(i)).c_str()), nullptr);
+    }
+    EXPECT_EQ(table.probe("test.overflow"), nullptr);
+    //A null probe is a no-op scope
+    ProbeScope scope(nullptr);
+    scope.stop();
+    EXPECT_EQ(table.size(), static_cast<std::size_t>(PROBE_MAX));
+}
+
+/**
+ * @brief dump() fits PROBE_DUMP_MAX_BYTES with a full table and fails cleanly when short
+ */
+TEST(TestProbe, Dump_Bound){
+    ProbeTable& table = ProbeTable::getInstance();
+    for (std::size_t i = table.size(); i < PROBE_MAX; ++i) {
+        table.probe(("test.longname_padding" + std::to_string(i)).c_str());
+    }
+    uint8_t out[PROBE_DUMP_MAX_BYTES];
+    const std::size_t len = table.dump(out, sizeof(out));
+    EXPECT_GT(len, 0u);
+    EXPECT_LE(len, PROBE_DUMP_MAX_BYTES);
+    //Map of 3, first key "v"
+    EXPECT_EQ(out[0], 0xa3);
+    EXPECT_EQ(table.dump(out, 8), 0u);
+}
+
+/* Simulated clock for the time steps */
+static int64_t sim_now_us = 0;
+static int64_t sim_clock() { return sim_now_us; }
+
+/**
+ * @brief dt is the measured interval: nominal first, capped on a stall, restartable
+ */
+TEST(TestTimeStep, Measured_Interval){
+    sim_now_us = 1000;
+    TimeStep step("t.measured", 5000, sim_clock);
+    EXPECT_DOUBLE_EQ(step.tick(), 0.005);       //No previous sample yet
+    sim_now_us += 7000;
+    EXPECT_DOUBLE_EQ(step.tick(), 0.007);
+    //Back to back: nothing elapsed, callers hold
+    EXPECT_DOUBLE_EQ(step.tick(), 0.0);
+    sim_now_us += 3000;
+    EXPECT_DOUBLE_EQ(step.tick(), 0.003);
+    //A 2 s stall is capped at TIMESTEP_STALL_RATIO periods
+    sim_now_us += 2000000;
+    EXPECT_DOUBLE_EQ(step.tick(), 0.005 * TIMESTEP_STALL_RATIO);
+
+    sim_now_us += 900000;
+    step.restart();
+    EXPECT_DOUBLE_EQ(step.tick(), 0.005);
+    //An explicit timestamp (the caller already read the clock)
+    EXPECT_DOUBLE_EQ(step.tick(sim_now_us + 4000), 0.004);
+}
+
+/**
+ * @brief Interval and jitter statistics
+ */
+TEST(TestTimeStep, Jitter_Statistics){
+    sim_now_us = 0;
+    TimeStep step("t.jitter", 5000, sim_clock);
+    const int64_t intervals[] = {5000, 4000, 6000, 5000, 30000};
+    step.tick();
+    for (int64_t interval : intervals) {
+        sim_now_us += interval;
+        step.tick();
+    }
+    timestep_stats_t stats = step.stats();
+    EXPECT_STREQ(stats.name, "t.jitter");
+    EXPECT_EQ(stats.nominal_us, 5000u);
+    EXPECT_EQ(stats.count, 5u);
+    EXPECT_EQ(stats.min_us, 4000u);
+    EXPECT_EQ(stats.max_us, 30000u);
+    EXPECT_EQ(stats.mean_us, 10000u);
+    EXPECT_EQ(stats.jitter_mean_us, (0u + 1000 + 1000 + 0 + 25000) / 5);
+    EXPECT_EQ(stats.jitter_max_us, 25000u);
+    EXPECT_EQ(stats.capped, 1u);
+
+    step.resetStats();
+    stats = step.stats();
+    EXPECT_EQ(stats.count, 0u);
+    EXPECT_EQ(stats.max_us, 0u);
+}
+
+/**
+ * @brief Named time steps are shared, listed and dumped within the bound
+ */
+TEST(TestTimeStep, Table_And_Dump){
+    TimeStepTable& table = TimeStepTable::getInstance();
+    TimeStep* a = table.timestep("t.table", 10000);
+    ASSERT_NE(a, nullptr);
+    EXPECT_EQ(table.timestep("t.table", 1), a);
+    EXPECT_DOUBLE_EQ(a->nominal(), 0.01);
+
+    a->tick(0);
+    a->tick(12000);
+    timestep_stats_t stats[TIMESTEP_MAX];
+    const std::size_t n = table.snapshot(stats, TIMESTEP_MAX);
+    ASSERT_GE(n, 1u);
+    bool found = false;
+    for (std::size_t i = 0; i < n; ++i) {
+        if (std::strcmp(stats[i].name, "t.table") == 0) {
+            found = true;
+            EXPECT_EQ(stats[i].jitter_max_us, 2000u);
+        }
+    }
+    EXPECT_TRUE(found);
+
+    //Fill the table with names past TIMESTEP_NAME_LEN, the dump must still fit
+    for (int i = 0; table.size() < TIMESTEP_MAX; ++i) {
+        const std::string name = std::string("t.full.") + (i < 10 ? "0" : "") + std::to_string(i)
+                               + "." + std::string(TIMESTEP_NAME_LEN, 'x');
+        TimeStep* step = table.timestep(name.c_str(), UINT32_MAX);
+        ASSERT_NE(step, nullptr);
+        step->tick(0);
+        step->tick(INT32_MAX);
+    }
+    EXPECT_EQ(table.timestep("t.overflow", 1000), nullptr);
+    uint8_t out[TIMESTEP_DUMP_MAX_BYTES];
+    EXPECT_GT(table.dump(out, sizeof(out)), 0u);
+    EXPECT_EQ(table.dump(out, 16), 0u);
+}
+
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
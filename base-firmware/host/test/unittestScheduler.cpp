@@ -0,0 +1,307 @@
+/**
+ * @file unittestScheduler.cpp
+ * @brief Host tests for the rate-monotonic fixed-rate scheduler
+ *
+ * Runs RateScheduler::simulate() on a simulated clock. Group functions
+ * model their execution time by advancing that clock, so release times,
+ * jitter and overruns are exact.
+ *
+ * @copyright Copyright (c) 2023 limitless Aeronautics
+ *            This file is part of the MARS Flight System Firmware
+ *
+ * @license MIT License
+ *          Copyright (c) 2023 limitless Aeronautics
+ *          Permission is hereby granted, free of charge, to any person obtaining a copy
+ *          of this software and associated documentation files (the "Software"), to deal
+ *          in the Software without restriction, including without limitation the rights
+ *          to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *          copies of the Software, and to permit persons to whom the Software is
+ *          furnished to do so, subject to the following conditions:
+ *          The above copyright notice and this permission notice shall be included in all
+ *          copies or substantial portions of the Software.
+ *          THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *          IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *          FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *          AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *          LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *          OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *          SOFTWARE.
+ */
+/* System includes */
+#include <algorithm>
+#include <string>
+#include <vector>
+
+/* Scheduler includes */
+#include "_rate_scheduler.h"
+#include "_ptam.h"
+
+/* Google testing */
+#include <gtest/gtest.h>
+
+/* Simulated clock */
+static int64_t sim_now_us = 0;
+static int64_t sim_clock() { return sim_now_us; }
+static void sim_advance(int64_t us) { sim_now_us = us; }
+
+/* A group that records its releases and costs cost_us per run */
+struct group_ctx_t {
+    group_ctx_t(const char* tag, int64_t cost_us) : tag(tag), cost_us(cost_us) {}
+
+    const char* tag;
+    int64_t cost_us;
+    int64_t first_cost_us = -1;     //Cost of release 0 only, -1 uses cost_us
+    std::vector<rate_tick_t> ticks = {};
+    std::string* order = nullptr;
+};
+
+static void group_fn(void* arg, const rate_tick_t& tick) {
+    group_ctx_t* ctx = static_cast<group_ctx_t*>(arg);
+    ctx->ticks.push_back(tick);
+    if (ctx->order != nullptr) {
+        *ctx->order += ctx->tag;
+    }
+    sim_now_us += (tick.release == 0 && ctx->first_cost_us >= 0) ? ctx->first_cost_us : ctx->cost_us;
+}
+
+class Scheduler_Test : public ::testing::Test {
+protected:
+    void SetUp() override { sim_now_us = 0; }
+
+    int add(group_ctx_t& ctx, uint16_t rate_hz) {
+        return scheduler.add({ctx.tag, rate_hz, group_fn, &ctx, 1, 4096});
+    }
+
+    rate_task_stats_t stat(std::size_t index) {
+        rate_task_stats_t out[RATE_MAX_TASKS];
+        std::size_t n = scheduler.stats(out, RATE_MAX_TASKS);
+        EXPECT_LT(index, n);
+        return out[index];
+    }
+
+    RateScheduler scheduler{sim_clock};
+};
+
+/**
+ * @brief Base period is the GCD of the group periods, bad rates and a full table are refused
+ */
+TEST_F(Scheduler_Test, Add_And_Base_Period){
+    group_ctx_t sense{"S", 0}, control{"C", 0}, actuate{"A", 0}, spare{"X", 0};
+    EXPECT_EQ(add(actuate, 50), 0);
+    EXPECT_EQ(scheduler.basePeriodUs(), 20000);
+    EXPECT_EQ(add(control, 200), 1);
+    EXPECT_EQ(add(sense, 400), 2);
+    EXPECT_EQ(scheduler.basePeriodUs(), 2500);
+
+    EXPECT_EQ(add(spare, 0), -1);
+    EXPECT_EQ(add(spare, 3), -1);       //333.33 us does not divide 1 s
+    EXPECT_EQ(add(spare, 1000), 3);
+    EXPECT_EQ(add(spare, 1000), -1);    //RATE_MAX_TASKS
+    EXPECT_EQ(scheduler.basePeriodUs(), 500);
+}
+
+/**
+ * @brief Releases due together run fastest group first, whatever the add() order
+ */
+TEST_F(Scheduler_Test, Rate_Monotonic_Order){
+    std::string order;
+    group_ctx_t sense{"S", 10}, control{"C", 10}, actuate{"A", 10};
+    sense.order = control.order = actuate.order = &order;
+    add(actuate, 50);
+    add(control, 200);
+    add(sense, 400);
+
+    scheduler.setEnabled(true);
+    scheduler.simulate(5000, sim_advance);
+    //t=0 all three, t=2500 sense, t=5000 sense then control
+    EXPECT_EQ(order, "SCASSC");
+}
+
+/**
+ * @brief Nothing runs while disabled, the clock still moves
+ */
+TEST_F(Scheduler_Test, Disabled_Does_Not_Release){
+    group_ctx_t sense{"S", 10};
+    add(sense, 400);
+    scheduler.simulate(100000, sim_advance);
+    EXPECT_EQ(sim_now_us, 100000);
+    EXPECT_TRUE(sense.ticks.empty());
+    EXPECT_EQ(stat(0).releases, 0u);
+}
+
+/**
+ * @brief A lightly loaded group runs on time every period
+ */
+TEST_F(Scheduler_Test, Nominal_Rate_No_Jitter){
+    group_ctx_t sense{"S", 100};
+    add(sense, 400);
+    scheduler.setEnabled(true);
+    scheduler.simulate(999999, sim_advance);
+
+    rate_task_stats_t s = stat(0);
+    EXPECT_EQ(s.releases, 400u);
+    EXPECT_EQ(s.skipped, 0u);
+    EXPECT_EQ(s.misses, 0u);
+    EXPECT_EQ(s.jitter_max_us, 0u);
+    EXPECT_EQ(s.exec_max_us, 100u);
+    EXPECT_EQ(s.exec_mean_us, 100u);
+    EXPECT_FLOAT_EQ(s.load, 0.04f);
+    EXPECT_EQ(sense.ticks[399].now_us, 399 * 2500);
+    for (const rate_tick_t& tick : sense.ticks) {
+        EXPECT_DOUBLE_EQ(tick.dt_s, 0.0025);
+    }
+}
+
+/**
+ * @brief A slower group released with a faster one starts late by the faster group's run
+ */
+TEST_F(Scheduler_Test, Jitter_From_Higher_Priority){
+    group_ctx_t sense{"S", 300}, control{"C", 50};
+    add(sense, 400);
+    add(control, 200);
+    scheduler.setEnabled(true);
+    scheduler.simulate(49999, sim_advance);
+
+    rate_task_stats_t s = stat(0), c = stat(1);
+    EXPECT_EQ(s.jitter_max_us, 0u);
+    EXPECT_EQ(s.releases, 20u);
+    EXPECT_EQ(c.releases, 10u);
+    EXPECT_EQ(c.jitter_max_us, 300u);
+    EXPECT_EQ(c.jitter_mean_us, 300u);
+    EXPECT_EQ(c.misses, 0u);
+}
+
+/**
+ * @brief dt is the measured time since the previous start, not the nominal period
+ */
+TEST_F(Scheduler_Test, Measured_Dt){
+    group_ctx_t sense{"S", 0}, control{"C", 0};
+    sense.first_cost_us = 300;          //Only the first release delays control
+    add(sense, 400);
+    add(control, 200);
+    scheduler.setEnabled(true);
+    scheduler.simulate(10000, sim_advance);
+
+    ASSERT_EQ(control.ticks.size(), 3u);
+    EXPECT_DOUBLE_EQ(control.ticks[0].dt_s, 0.005);     //First run reports the period
+    EXPECT_EQ(control.ticks[0].now_us, 300);
+    EXPECT_DOUBLE_EQ(control.ticks[1].dt_s, 0.0047);
+    EXPECT_DOUBLE_EQ(control.ticks[2].dt_s, 0.005);
+    EXPECT_EQ(control.ticks[2].release, 2u);
+}
+
+/**
+ * @brief A pause (disabled, e.g. out of ARMED) does not show up as one huge dt
+ */
+TEST_F(Scheduler_Test, Dt_Restarts_After_Pause){
+    group_ctx_t control{"C", 0};
+    add(control, 200);
+    scheduler.setEnabled(true);
+    scheduler.simulate(10000, sim_advance);
+    scheduler.setEnabled(false);
+    scheduler.simulate(5000000, sim_advance);
+    scheduler.setEnabled(true);
+    scheduler.simulate(5010000, sim_advance);
+
+    ASSERT_EQ(control.ticks.size(), 6u);
+    EXPECT_EQ(control.ticks[3].now_us, 5000000);
+    EXPECT_DOUBLE_EQ(control.ticks[3].dt_s, 0.005);
+    EXPECT_DOUBLE_EQ(control.ticks[4].dt_s, 0.005);
+}
+
+/* Records whether the scheduler looked idle from inside a run */
+static RateScheduler* idle_probe_scheduler = nullptr;
+static bool idle_probe_seen = true;
+static void idle_probe_fn(void*, const rate_tick_t&) {
+    idle_probe_seen = idle_probe_scheduler->waitIdle(0);
+    sim_now_us += 100;
+}
+
+/**
+ * @brief waitIdle() reports a run in flight, and idle once the groups are disabled
+ */
+TEST_F(Scheduler_Test, Wait_Idle_After_Disable){
+    idle_probe_scheduler = &scheduler;
+    scheduler.add({"P", 200, idle_probe_fn, nullptr, 1, 4096});
+    EXPECT_TRUE(scheduler.waitIdle(0));
+    scheduler.setEnabled(true);
+    scheduler.simulate(1000, sim_advance);
+    EXPECT_FALSE(idle_probe_seen);
+
+    scheduler.setEnabled(false);
+    EXPECT_TRUE(scheduler.waitIdle(0));
+}
+
+/**
+ * @brief An overrunning group misses its deadline and the release behind it is dropped
+ */
+TEST_F(Scheduler_Test, Overrun_Skips_And_Misses){
+    group_ctx_t control{"C", 7000};
+    add(control, 200);
+    scheduler.setEnabled(true);
+    scheduler.simulate(99999, sim_advance);
+
+    rate_task_stats_t c = stat(0);
+    EXPECT_EQ(c.releases, 10u);
+    EXPECT_EQ(c.misses, 10u);
+    EXPECT_EQ(c.skipped, 10u);
+    //Never queued: every run starts on its own release, never back to back
+    EXPECT_EQ(c.jitter_max_us, 0u);
+    EXPECT_DOUBLE_EQ(control.ticks[1].dt_s, 0.01);
+    EXPECT_FLOAT_EQ(c.load, 1.4f);
+
+    scheduler.resetStats();
+    c = stat(0);
+    EXPECT_EQ(c.releases, 0u);
+    EXPECT_EQ(c.misses, 0u);
+    EXPECT_FLOAT_EQ(c.load, 0.0f);
+}
+
+/**
+ * @brief Re-enabling restarts the release timeline instead of reporting the gap as jitter
+ */
+TEST_F(Scheduler_Test, Enable_Rebases_Timeline){
+    group_ctx_t sense{"S", 10};
+    add(sense, 400);
+    scheduler.setEnabled(true);
+    scheduler.simulate(9999, sim_advance);
+    EXPECT_EQ(sense.ticks.size(), 4u);
+
+    scheduler.setEnabled(false);
+    scheduler.simulate(1000123, sim_advance);
+    EXPECT_EQ(sense.ticks.size(), 4u);
+
+    scheduler.setEnabled(true);
+    scheduler.simulate(1000123 + 9999, sim_advance);
+    ASSERT_EQ(sense.ticks.size(), 8u);
+    EXPECT_EQ(sense.ticks[4].now_us, 1000123);
+    EXPECT_EQ(stat(0).jitter_max_us, 0u);
+    EXPECT_EQ(stat(0).skipped, 0u);
+}
+
+/**
+ * @brief publish() exports worst jitter, total overruns and load to PTAM
+ */
+TEST_F(Scheduler_Test, Publish_To_PTAM){
+    group_ctx_t sense{"S", 1000}, control{"C", 7000};
+    add(sense, 400);
+    add(control, 200);
+    scheduler.setEnabled(true);
+    scheduler.simulate(99999, sim_advance);
+    scheduler.publish();
+
+    rate_task_stats_t s = stat(0), c = stat(1);
+    SharedMemory& sharedMemory = SharedMemory::getInstance();
+    EXPECT_DOUBLE_EQ(sharedMemory.getLastDouble(REG_RT_JITTER),
+                     double(std::max(s.jitter_max_us, c.jitter_max_us)));
+    EXPECT_GT(sharedMemory.getLastDouble(REG_RT_JITTER), 0.0);
+    EXPECT_EQ(sharedMemory.getLastInt(REG_RT_OVERRUN), int(s.skipped + s.misses + c.skipped + c.misses));
+    EXPECT_GT(sharedMemory.getLastInt(REG_RT_OVERRUN), 0);
+    EXPECT_NEAR(sharedMemory.getLastDouble(REG_RT_LOAD), (s.load + c.load) * 100.0, 1e-3);
+}
+
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
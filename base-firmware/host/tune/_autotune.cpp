@@ -0,0 +1,427 @@
+/*MIT License
+Copyright (c) 2023 limitless Aeronautics
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#include "_autotune.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <functional>
+#include <thread>
+#include <vector>
+
+//Longest transport delay the plant can hold, in control steps
+#define TUNE_MAX_DELAY_STEPS 64
+//Cost of a run that never settles, above any settled one
+#define TUNE_UNSTABLE_COST 1e6
+
+//____________________________________________________________
+/* Utillity subroutine -> run fn(0 .. count - 1) on a worker pool
+===========================================================================
+|    threads         0 = every core, never more than count
+|    Indices are handed out one at a time, fn must only write its own
+|    index's results
+===========================================================================
+*/
+static void parallel_for(std::size_t count, unsigned threads, const std::function<void(std::size_t)>& fn) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threads = static_cast<unsigned>(std::min<std::size_t>(threads, count));
+    if (threads <= 1) {
+        for (std::size_t i = 0; i < count; ++i) {
+            fn(i);
+        }
+        return;
+    }
+    std::atomic<std::size_t> next(0);
+    std::vector<std::thread> workers;
+    workers.reserve(threads);
+    for (unsigned t = 0; t < threads; ++t) {
+        workers.emplace_back([&] {
+            for (std::size_t i = next++; i < count; i = next++) {
+                fn(i);
+            }
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+//ISA troposphere density relative to sea level
+static double isa_density(double alt) {
+    return std::pow(1.0 - 2.25577e-5 * alt, 4.2559);
+}
+
+//____________________________________________________________
+/* Simulated axis: delay line -> servo lag -> damped rigid body
+===========================================================================
+|    apply() pushes one control output and advances the plant by one
+|    control period in substeps (semi-implicit Euler)
+===========================================================================
+*/
+class AxisPlant {
+public:
+    AxisPlant(const tune_plant_t& plant, double rate_hz, int substeps)
+        : plant_(plant), dt_(1.0 / rate_hz), substeps_(std::max(1, substeps)), line_(), head_(0),
+          servo_(0.0), rate_(0.0), angle_(0.0) {
+        delaySteps_ = std::clamp(static_cast<int>(std::lround(plant.delay * rate_hz)), 0, TUNE_MAX_DELAY_STEPS - 1);
+    }
+
+    double angle() const { return angle_; }
+
+    void apply(double command) {
+        line_[head_] = command;
+        const double delayed = line_[(head_ + TUNE_MAX_DELAY_STEPS - delaySteps_) % TUNE_MAX_DELAY_STEPS];
+        head_ = (head_ + 1) % TUNE_MAX_DELAY_STEPS;
+        const double h = dt_ / substeps_;
+        const double lag = plant_.servo_tau > 0.0 ? std::min(1.0, h / plant_.servo_tau) : 1.0;
+        for (int i = 0; i < substeps_; ++i) {
+            servo_ += lag * (delayed - servo_);
+            rate_ += (plant_.authority * servo_ - plant_.damping * rate_) * h;
+            angle_ += rate_ * h;
+        }
+    }
+
+private:
+    tune_plant_t plant_;
+    double dt_;
+    int substeps_;
+    int delaySteps_;
+    double line_[TUNE_MAX_DELAY_STEPS];
+    int head_;
+    double servo_;
+    double rate_;
+    double angle_;
+};
+
+PIDAutotuner::PIDAutotuner(const tune_config_t& config, const tune_airframe_t& airframe)
+    : config_(config), airframe_(airframe) {
+}
+
+tune_plant_t PIDAutotuner::plant(std::size_t axis, double speed, double alt) const {
+    const double v = std::max(speed, 1.0) / TUNE_REF_SPEED;
+    const double rho = isa_density(alt) / isa_density(TUNE_REF_ALT);
+    const double authority = axis == 0 ? airframe_.pitch_authority : airframe_.roll_authority;
+    return {authority * rho * v * v, airframe_.damping * rho * v, airframe_.servo_tau, airframe_.delay};
+}
+
+tune_metrics_t PIDAutotuner::evaluate(const tune_plant_t& plant, const gain_triplet_t& gains) const {
+    pid_flight_config_t<1, double> pidConfig;
+    pidConfig.set(0, {gains.kp, gains.ki, gains.kd, config_.min_output, config_.max_output}, config_.shaping);
+    FlightPID<1, double> pid(pidConfig);
+    AxisPlant axis(plant, config_.rate_hz, config_.substeps);
+
+    const double dt = 1.0 / config_.rate_hz;
+    const int steps = static_cast<int>(config_.duration * config_.rate_hz);
+    const int tail = std::max(1, steps / 10);
+    const double target = config_.step;
+    tune_metrics_t m = {};
+    double t10 = -1.0, t90 = -1.0, peak = 0.0, lastOut = 0.0, lastOutside = 0.0, tailError = 0.0;
+    bool diverged = false;
+    for (int k = 0; k < steps; ++k) {
+        const double t = k * dt;
+        const double y = axis.angle();
+        const double r = y / target;
+        const double e = std::fabs(target - y);
+        if (t10 < 0.0 && r >= 0.1) {
+            t10 = t;
+        }
+        if (t90 < 0.0 && r >= 0.9) {
+            t90 = t;
+        }
+        peak = std::max(peak, r);
+        if (std::fabs(r - 1.0) > 0.02) {
+            lastOutside = t + dt;
+        }
+        m.iae += e * dt;
+        m.itae += t * e * dt;
+        if (k >= steps - tail) {
+            tailError += e;
+        }
+        if (!std::isfinite(y) || std::fabs(r) > 5.0) {
+            diverged = true;
+            break;
+        }
+
+        const double out = pid.step({target}, {y}, dt)[0];
+        m.travel += std::fabs(out - lastOut);
+        lastOut = out;
+        axis.apply(out);
+    }
+    m.rise = t10 >= 0.0 && t90 >= 0.0 ? t90 - t10 : config_.duration;
+    m.overshoot = std::max(0.0, peak - 1.0) * 100.0;
+    m.settling = lastOutside;
+    m.steady_error = tailError / tail;
+    //Settled before the last tenth of the run
+    m.stable = !diverged && lastOutside < config_.duration - tail * dt;
+    return m;
+}
+
+double PIDAutotuner::cost(const tune_metrics_t& metrics) const {
+    const double itae = metrics.itae / config_.step;
+    if (!metrics.stable) {
+        return TUNE_UNSTABLE_COST + (std::isfinite(itae) ? itae : 0.0);
+    }
+    return itae + config_.w_overshoot * metrics.overshoot + config_.w_travel * metrics.travel;
+}
+
+tune_result_t PIDAutotuner::score(const tune_plant_t& plant, const gain_triplet_t& gains) const {
+    const tune_metrics_t metrics = evaluate(plant, gains);
+    return {gains, metrics, cost(metrics), 1};
+}
+
+tune_relay_t PIDAutotuner::relay(const tune_plant_t& plant, double amplitude, double hysteresis) const {
+    AxisPlant axis(plant, config_.rate_hz, config_.substeps);
+    const double dt = 1.0 / config_.rate_hz;
+    //Long enough for the cycle to settle at the slowest operating points
+    const int steps = static_cast<int>(30.0 * config_.rate_hz);
+    double out = amplitude;
+    double previous = 0.0, high = -INFINITY, low = INFINITY;
+    std::vector<double> crossings;
+    for (int k = 0; k < steps; ++k) {
+        const double y = axis.angle();
+        const double e = -y;
+        if (e > hysteresis) {
+            out = amplitude;
+        } else if (e < -hysteresis) {
+            out = -amplitude;
+        }
+        //Cycle statistics over the second half only, past the transient
+        if (k > steps / 2) {
+            high = std::max(high, y);
+            low = std::min(low, y);
+            if (previous < 0.0 && y >= 0.0) {
+                crossings.push_back(k * dt);
+            }
+        }
+        previous = y;
+        if (!std::isfinite(y)) {
+            return {false, 0.0, 0.0, 0.0};
+        }
+        axis.apply(out);
+    }
+
+    tune_relay_t result = {false, 0.0, 0.0, 0.0};
+    if (crossings.size() < 3) {
+        return result;
+    }
+    result.amplitude = (high - low) / 2.0;
+    result.pu = (crossings.back() - crossings.front()) / (crossings.size() - 1);
+    if (!(result.amplitude > hysteresis)) {
+        return result;
+    }
+    const double a2 = result.amplitude * result.amplitude - hysteresis * hysteresis;
+    result.ku = 4.0 * amplitude / (M_PI * std::sqrt(a2));
+    result.ok = std::isfinite(result.ku) && result.pu > 0.0;
+    return result;
+}
+
+gain_triplet_t PIDAutotuner::zieglerNichols(const tune_relay_t& relay, tune_rule_t rule) {
+    double kp, ti, td;
+    switch (rule) {
+        case TUNE_ZN_SOME_OVERSHOOT:
+            kp = relay.ku / 3.0;
+            ti = relay.pu / 2.0;
+            td = relay.pu / 3.0;
+            break;
+        case TUNE_ZN_NO_OVERSHOOT:
+            kp = 0.2 * relay.ku;
+            ti = relay.pu / 2.0;
+            td = relay.pu / 3.0;
+            break;
+        case TUNE_ZN_CLASSIC:
+        default:
+            kp = 0.6 * relay.ku;
+            ti = relay.pu / 2.0;
+            td = relay.pu / 8.0;
+            break;
+    }
+    //Parallel form, FlightPID's integral is ki * sum(error dt)
+    return {static_cast<float>(kp), static_cast<float>(kp / ti), static_cast<float>(kp * td)};
+}
+
+//A candidate gain, kept inside what GainSchedule accepts
+static float gain_clamp(double value) {
+    return static_cast<float>(std::clamp(value, 0.0, static_cast<double>(GAIN_MAX_VALUE)));
+}
+
+tune_result_t PIDAutotuner::grid(const tune_plant_t& plant, const gain_triplet_t& center, int points,
+                                 double span, unsigned threads) const {
+    points = std::max(points, 1);
+    const std::size_t count = static_cast<std::size_t>(points) * points * points;
+    std::vector<double> scale(points, 1.0);
+    for (int i = 0; i < points && points > 1; ++i) {
+        scale[i] = std::exp2(-span + 2.0 * span * i / (points - 1));
+    }
+    std::vector<tune_result_t> results(count);
+    parallel_for(count, threads, [&](std::size_t n) {
+        const std::size_t p = n / (points * points), i = (n / points) % points, d = n % points;
+        const gain_triplet_t gains = {gain_clamp(center.kp * scale[p]), gain_clamp(center.ki * scale[i]),
+                                      gain_clamp(center.kd * scale[d])};
+        results[n] = score(plant, gains);
+    });
+    //Lowest cost, the lowest index on a tie, whichever thread ran it
+    std::size_t best = 0;
+    for (std::size_t n = 1; n < count; ++n) {
+        if (results[n].cost < results[best].cost) {
+            best = n;
+        }
+    }
+    tune_result_t result = results[best];
+    result.evaluations = static_cast<uint32_t>(count);
+    return result;
+}
+
+tune_result_t PIDAutotuner::nelderMead(const tune_plant_t& plant, const gain_triplet_t& start, int iterations,
+                                       double tolerance) const {
+    typedef std::array<double, 3> point_t;
+    uint32_t evaluations = 0;
+    auto gains_at = [](const point_t& x) {
+        return gain_triplet_t{gain_clamp(std::exp(x[0])), gain_clamp(std::exp(x[1])), gain_clamp(std::exp(x[2]))};
+    };
+    auto f = [&](const point_t& x) {
+        evaluations++;
+        return cost(evaluate(plant, gains_at(x)));
+    };
+    //log(0) has no place in the simplex, a vanishing gain starts small
+    auto log_gain = [](float g) { return std::log(std::max(static_cast<double>(g), 1e-6)); };
+
+    point_t simplex[4];
+    double value[4];
+    simplex[0] = {log_gain(start.kp), log_gain(start.ki), log_gain(start.kd)};
+    for (int v = 1; v < 4; ++v) {
+        simplex[v] = simplex[0];
+        simplex[v][v - 1] += 0.5;
+    }
+    for (int v = 0; v < 4; ++v) {
+        value[v] = f(simplex[v]);
+    }
+
+    for (int it = 0; it < iterations; ++it) {
+        int order[4] = {0, 1, 2, 3};
+        std::sort(order, order + 4, [&](int a, int b) { return value[a] < value[b]; });
+        const int best = order[0], second = order[2], worst = order[3];
+        if (value[worst] - value[best] < tolerance * std::max(1.0, std::fabs(value[best]))) {
+            break;
+        }
+        point_t centroid = {0.0, 0.0, 0.0};
+        for (int v = 0; v < 4; ++v) {
+            if (v == worst) {
+                continue;
+            }
+            for (int d = 0; d < 3; ++d) {
+                centroid[d] += simplex[v][d] / 3.0;
+            }
+        }
+        auto along = [&](double t) {
+            point_t x;
+            for (int d = 0; d < 3; ++d) {
+                x[d] = centroid[d] + t * (simplex[worst][d] - centroid[d]);
+            }
+            return x;
+        };
+
+        const point_t reflected = along(-1.0);
+        const double fr = f(reflected);
+        if (fr < value[best]) {
+            const point_t expanded = along(-2.0);
+            const double fe = f(expanded);
+            simplex[worst] = fe < fr ? expanded : reflected;
+            value[worst] = fe < fr ? fe : fr;
+        } else if (fr < value[second]) {
+            simplex[worst] = reflected;
+            value[worst] = fr;
+        } else {
+            //Contract towards the better of the worst and its reflection
+            const point_t contracted = along(fr < value[worst] ? -0.5 : 0.5);
+            const double fc = f(contracted);
+            if (fc < std::min(fr, value[worst])) {
+                simplex[worst] = contracted;
+                value[worst] = fc;
+            } else {
+                for (int v = 0; v < 4; ++v) {
+                    if (v == best) {
+                        continue;
+                    }
+                    for (int d = 0; d < 3; ++d) {
+                        simplex[v][d] = simplex[best][d] + 0.5 * (simplex[v][d] - simplex[best][d]);
+                    }
+                    value[v] = f(simplex[v]);
+                }
+            }
+        }
+    }
+
+    int best = 0;
+    for (int v = 1; v < 4; ++v) {
+        if (value[v] < value[best]) {
+            best = v;
+        }
+    }
+    tune_result_t result = score(plant, gains_at(simplex[best]));
+    result.evaluations = evaluations + 1;
+    return result;
+}
+
+tune_point_t PIDAutotuner::tuneAxis(std::size_t axis, double speed, double alt, unsigned threads) const {
+    const tune_plant_t p = plant(axis, speed, alt);
+    tune_point_t point = {};
+    point.speed = speed;
+    point.alt = alt;
+    point.relay = relay(p);
+    gain_triplet_t start;
+    if (point.relay.ok) {
+        start = zieglerNichols(point.relay);
+    } else {
+        //No limit cycle: start from the shipped gains
+        const pid_gains_t& fixed = axis == 0 ? PIPELINE_DEFAULT_CONFIG.pitch : PIPELINE_DEFAULT_CONFIG.roll;
+        start = {float(fixed.kp), float(fixed.ki), float(fixed.kd)};
+    }
+    point.zn = score(p, start);
+    point.grid = grid(p, start, 7, 2.0, threads);
+    point.best = nelderMead(p, point.grid.gains);
+    if (point.best.cost > point.grid.cost) {
+        point.best = point.grid;
+    }
+    return point;
+}
+
+bool PIDAutotuner::tuneTable(gain_table_t& table, tune_point_t* points, unsigned threads) const {
+    table.version = GAIN_TABLE_VERSION;
+    if (table.speed_points < 1 || table.speed_points > GAIN_SPEED_POINTS || table.alt_points < 1 ||
+        table.alt_points > GAIN_ALT_POINTS) {
+        return false;
+    }
+    const std::size_t perAxis = static_cast<std::size_t>(table.alt_points) * table.speed_points;
+    //Whole operating points in parallel, each one's grid on its own thread
+    parallel_for(GAIN_AXES * perAxis, threads, [&](std::size_t n) {
+        const std::size_t axis = n / perAxis;
+        const int j = static_cast<int>((n % perAxis) / table.speed_points);
+        const int i = static_cast<int>(n % table.speed_points);
+        const tune_point_t point = tuneAxis(axis, table.speed_min + i * table.speed_step,
+                                            table.alt_min + j * table.alt_step, 1);
+        table.gains[axis][j][i] = point.best.gains;
+        if (points != nullptr) {
+            points[n] = point;
+        }
+    });
+    return GainSchedule::validate(table);
+}
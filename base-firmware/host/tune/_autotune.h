@@ -0,0 +1,218 @@
+/*MIT License
+Copyright (c) 2023 limitless Aeronautics
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#ifndef PID_AUTOTUNE_H
+#define PID_AUTOTUNE_H
+
+#include <cstddef>
+#include <cstdint>
+#include "_pid_flight.h"
+#include "_gain_schedule.h"
+#include "_pipeline.h"
+#include "_task_layout.h"
+
+//Speed and altitude the reference airframe constants hold at
+#define TUNE_REF_SPEED 15.0
+#define TUNE_REF_ALT 100.0
+
+//Single axis of the airframe: servo lag and transport delay in front of
+//a damped rigid body, command (normalised sweep) -> attitude (deg)
+struct tune_plant_t {
+    double authority;       //Angular acceleration at full command (deg/s^2)
+    double damping;         //Aerodynamic rate damping (1/s)
+    double servo_tau;       //First-order servo lag (s)
+    double delay;           //Sensor + one control period (s)
+};
+
+//Reference airframe: the host test model at 15 m/s and 100 m
+struct tune_airframe_t {
+    double pitch_authority;
+    double roll_authority;
+    double damping;
+    double servo_tau;
+    double delay;
+};
+
+constexpr tune_airframe_t TUNE_DEFAULT_AIRFRAME = {
+    120.0,
+    120.0,
+    3.0,
+    0.03,
+    0.015,
+};
+
+//How one candidate is flown and scored
+struct tune_config_t {
+    double rate_hz;         //Control rate
+    int substeps;           //Plant integration steps per control step
+    double duration;        //Step response length (s)
+    double step;            //Attitude step (deg)
+    double min_output;
+    double max_output;
+    pid_shaping_t shaping;  //Anti-windup, derivative filter, slew limit
+    double w_overshoot;     //Cost per % of overshoot
+    double w_travel;        //Cost per unit of actuator travel
+};
+
+//Control loop rate, the ARMED pipeline's shaping and output limits
+constexpr tune_config_t TUNE_DEFAULT_CONFIG = {
+    CONTROL_LOOP_HZ,
+    5,
+    4.0,
+    10.0,
+    PIPELINE_DEFAULT_CONFIG.pitch.min_output,
+    PIPELINE_DEFAULT_CONFIG.pitch.max_output,
+    PIPELINE_DEFAULT_CONFIG.pitch_shaping,
+    0.01,
+    0.01,
+};
+
+struct tune_metrics_t {
+    bool stable;            //Settled inside the run, never diverged
+    double rise;            //10 - 90 % (s)
+    double overshoot;       //% of the step
+    double settling;        //Last exit of the 2 % band (s)
+    double iae;             //Integral of |error| (deg s)
+    double itae;            //Integral of t |error| (deg s^2)
+    double steady_error;    //Mean |error| over the last 10 % (deg)
+    double travel;          //Sum of |output change| (normalised sweeps)
+};
+
+struct tune_relay_t {
+    bool ok;                //A limit cycle was found
+    double ku;              //Ultimate gain (output per deg)
+    double pu;              //Ultimate period (s)
+    double amplitude;       //Attitude amplitude of the cycle (deg)
+};
+
+enum tune_rule_t : uint8_t {
+    TUNE_ZN_CLASSIC = 0,    //Kp 0.6 Ku, Ti Pu / 2, Td Pu / 8
+    TUNE_ZN_SOME_OVERSHOOT, //Kp Ku / 3, Ti Pu / 2, Td Pu / 3
+    TUNE_ZN_NO_OVERSHOOT,   //Kp 0.2 Ku, Ti Pu / 2, Td Pu / 3
+};
+
+struct tune_result_t {
+    gain_triplet_t gains;
+    tune_metrics_t metrics;
+    double cost;
+    uint32_t evaluations;
+};
+
+//Every stage of one operating point, for reports
+struct tune_point_t {
+    double speed;
+    double alt;
+    tune_relay_t relay;
+    tune_result_t zn;       //Classic Ziegler-Nichols, scored
+    tune_result_t grid;     //Best of the grid around it
+    tune_result_t best;     //Nelder-Mead from the grid's best
+};
+
+//____________________________________________________________
+/* Offline PID tuner, host only
+===========================================================================
+|    Flies FlightPID<1> (the ARMED controller, with its shaping) against a
+|    tune_plant_t in closed loop, no hardware in the loop.
+|    Per operating point:
+|      relay()         Relay feedback (Astrom-Hagglund) -> Ku, Pu
+|      zieglerNichols  Gains from Ku, Pu
+|      grid()          Log-spaced grid around the ZN gains, parallel
+|      nelderMead()    Simplex refinement in log gain space
+|    Candidates are scored on a step response: ITAE plus weighted
+|    overshoot and actuator travel, unstable runs are rejected.
+|    Results do not depend on the thread count.
+===========================================================================
+*/
+class PIDAutotuner {
+public:
+    explicit PIDAutotuner(const tune_config_t& config = TUNE_DEFAULT_CONFIG,
+                          const tune_airframe_t& airframe = TUNE_DEFAULT_AIRFRAME);
+
+    //Axis 0 pitch, 1 roll at an operating point: authority scales with
+    //dynamic pressure (rho V^2), damping with rho V
+    tune_plant_t plant(std::size_t axis, double speed, double alt) const;
+
+    //____________________________________________________________
+    /* Main subroutine -> step response of one gain set
+    ===========================================================================
+    |    Target steps from 0 to config.step at t = 0, the plant starts at
+    |    rest
+    ===========================================================================
+    */
+    tune_metrics_t evaluate(const tune_plant_t& plant, const gain_triplet_t& gains) const;
+    double cost(const tune_metrics_t& metrics) const;
+
+    //____________________________________________________________
+    /* Main subroutine -> relay feedback experiment
+    ===========================================================================
+    |    amplitude       Relay output (normalised sweep)
+    |    hysteresis      Error band the relay holds in (deg). The model is
+    |                    noise free, so 0: a band lowers the cycle's
+    |                    frequency below the phase crossover
+    |    Ku = 4 d / (pi sqrt(a^2 - eps^2)), Pu averaged over the last cycles
+    ===========================================================================
+    */
+    tune_relay_t relay(const tune_plant_t& plant, double amplitude = 0.3, double hysteresis = 0.0) const;
+    static gain_triplet_t zieglerNichols(const tune_relay_t& relay, tune_rule_t rule = TUNE_ZN_CLASSIC);
+
+    //____________________________________________________________
+    /* Main subroutine -> exhaustive grid around a gain set
+    ===========================================================================
+    |    points          Per gain, multipliers 2^-span .. 2^span
+    |    threads         0 = every core
+    ===========================================================================
+    */
+    tune_result_t grid(const tune_plant_t& plant, const gain_triplet_t& center, int points = 7,
+                       double span = 2.0, unsigned threads = 0) const;
+
+    //____________________________________________________________
+    /* Main subroutine -> Nelder-Mead from a gain set
+    ===========================================================================
+    |    Searches log(kp, ki, kd), so gains stay positive and scale free
+    |    iterations      Upper bound, stops earlier once the simplex cost
+    |                    spread falls under tolerance
+    ===========================================================================
+    */
+    tune_result_t nelderMead(const tune_plant_t& plant, const gain_triplet_t& start, int iterations = 200,
+                             double tolerance = 1e-4) const;
+
+    //Relay, ZN, grid and Nelder-Mead at one operating point
+    tune_point_t tuneAxis(std::size_t axis, double speed, double alt, unsigned threads = 0) const;
+
+    //____________________________________________________________
+    /* Main subroutine -> whole gain table, both axes
+    ===========================================================================
+    |    table           Breakpoints read from it (speed / alt min, step,
+    |                    points), gains written
+    |    points          Optional, GAIN_AXES x alt_points x speed_points
+    |                    reports, axis major
+    |    Operating points are tuned in parallel, one per core
+    ===========================================================================
+    */
+    bool tuneTable(gain_table_t& table, tune_point_t* points = nullptr, unsigned threads = 0) const;
+
+    const tune_config_t& config() const { return config_; }
+
+private:
+    tune_result_t score(const tune_plant_t& plant, const gain_triplet_t& gains) const;
+
+    tune_config_t config_;
+    tune_airframe_t airframe_;
+};
+
+#endif // PID_AUTOTUNE_H
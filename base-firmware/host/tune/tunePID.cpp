@@ -0,0 +1,138 @@
+/**
+ * @file tunePID.cpp
+ * @brief Offline autotuner: gain schedule for the ARMED pitch / roll PIDs
+ *
+ * Tunes FlightPID against the host airframe model at every operating point
+ * of a speed x altitude grid (relay feedback, Ziegler-Nichols, a parallel
+ * grid, then Nelder-Mead, see PIDAutotuner), prints the step response of
+ * each stage and writes the table in the /INC_GAINS upload format:
+ *
+ *   tunePID [--speeds min step n] [--alts min step n] [--threads n] [--out file]
+ *   curl --data-binary @gains.txt http://<vehicle>/INC_GAINS
+ *
+ * Defaults: 10 - 20 m/s in 2.5 m/s steps, 50 - 150 m in 50 m steps, every
+ * core, gains.txt. Not run by ctest.
+ *
+ * @copyright Copyright (c) 2023 limitless Aeronautics
+ *            This file is part of the MARS Flight System Firmware
+ *
+ * @license MIT License
+ *          Copyright (c) 2023 limitless Aeronautics
+ *          Permission is hereby granted, free of charge, to any person obtaining a copy
+ *          of this software and associated documentation files (the "Software"), to deal
+ *          in the Software without restriction, including without limitation the rights
+ *          to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *          copies of the Software, and to permit persons to whom the Software is
+ *          furnished to do so, subject to the following conditions:
+ *          The above copyright notice and this permission notice shall be included in all
+ *          copies or substantial portions of the Software.
+ *          THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *          IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *          FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *          AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *          LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *          OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *          SOFTWARE.
+ */
+/* System includes */
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+/* Tuner */
+#include "_autotune.h"
+
+static void usage() {
+    std::fprintf(stderr, "usage: tunePID [--speeds min step n] [--alts min step n] [--threads n] [--out file]\n");
+}
+
+//Three numbers after a flag, n within 1 .. max
+static bool axis_args(int argc, char** argv, int& i, float& min, float& step, uint8_t& points, int max) {
+    if (i + 3 >= argc) {
+        return false;
+    }
+    min = static_cast<float>(std::atof(argv[++i]));
+    step = static_cast<float>(std::atof(argv[++i]));
+    const int n = std::atoi(argv[++i]);
+    if (n < 1 || n > max || (n > 1 && !(step > 0.0f))) {
+        return false;
+    }
+    points = static_cast<uint8_t>(n);
+    return true;
+}
+
+static void print_stage(const char* stage, const tune_result_t& r) {
+    std::printf("  %-5s kp %7.4f ki %7.4f kd %7.4f | rise %.3f s overshoot %5.1f %% settling %.3f s"
+                " itae %.3f travel %.2f%s (%u runs)\n", stage, r.gains.kp, r.gains.ki, r.gains.kd,
+                r.metrics.rise, r.metrics.overshoot, r.metrics.settling, r.metrics.itae, r.metrics.travel,
+                r.metrics.stable ? "" : " UNSTABLE", r.evaluations);
+}
+
+int main(int argc, char** argv) {
+    gain_table_t table = {};
+    table.speed_min = 10.0f;
+    table.speed_step = 2.5f;
+    table.speed_points = 5;
+    table.alt_min = 50.0f;
+    table.alt_step = 50.0f;
+    table.alt_points = 3;
+    unsigned threads = 0;
+    const char* path = "gains.txt";
+    for (int i = 1; i < argc; ++i) {
+        bool ok = true;
+        if (std::strcmp(argv[i], "--speeds") == 0) {
+            ok = axis_args(argc, argv, i, table.speed_min, table.speed_step, table.speed_points, GAIN_SPEED_POINTS);
+        } else if (std::strcmp(argv[i], "--alts") == 0) {
+            ok = axis_args(argc, argv, i, table.alt_min, table.alt_step, table.alt_points, GAIN_ALT_POINTS);
+        } else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+            path = argv[++i];
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            usage();
+            return 2;
+        }
+    }
+
+    const PIDAutotuner tuner;
+    std::vector<tune_point_t> points(GAIN_AXES * table.alt_points * table.speed_points);
+    const auto start = std::chrono::steady_clock::now();
+    const bool valid = tuner.tuneTable(table, points.data(), threads);
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    uint64_t runs = 0;
+    for (std::size_t n = 0; n < points.size(); ++n) {
+        const tune_point_t& p = points[n];
+        std::printf("%s %.1f m/s %.0f m | relay %s Ku %.4f Pu %.3f s\n", n < points.size() / 2 ? "pitch" : "roll",
+                    p.speed, p.alt, p.relay.ok ? "ok" : "FAILED", p.relay.ku, p.relay.pu);
+        print_stage("zn", p.zn);
+        print_stage("grid", p.grid);
+        print_stage("best", p.best);
+        runs += p.zn.evaluations + p.grid.evaluations + p.best.evaluations;
+    }
+    std::printf("%zu operating points, %llu closed-loop runs in %.1f s\n", points.size(),
+                static_cast<unsigned long long>(runs), elapsed);
+    if (!valid) {
+        std::fprintf(stderr, "tuned table failed validation\n");
+        return 1;
+    }
+
+    static char text[GAIN_UPLOAD_MAX_BYTES];
+    const std::size_t len = GainSchedule::format(table, text, sizeof(text));
+    FILE* out = std::fopen(path, "w");
+    if (len == 0 || out == nullptr || std::fwrite(text, 1, len, out) != len) {
+        std::fprintf(stderr, "cannot write %s\n", path);
+        if (out != nullptr) {
+            std::fclose(out);
+        }
+        return 1;
+    }
+    std::fclose(out);
+    std::printf("gain table written to %s (%zu bytes)\n", path, len);
+    return 0;
+}
@@ -26,9 +26,16 @@ SOFTWARE.*/
 #include"../components/HALX/Fan_cooling/fan_relay.h"
 #include"../components/HALX/Barometer/_barometerEntry.h"
 #include"../components/PTAM/_ptam.h"
+#include"../components/Profiling/_probe.h"
 #include"../components/system/validateSensors.h"
 #include"../components/system/_state.h"
 #include"../components/system/sys_controller.h"
+#include"../components/system/_flight_fsm.h"
+#include"../components/system/_task_layout.h"
+#include"../components/system/_memory.h"
+#include"../components/Memory/_alloc_count.h"
+#include"../components/system/_health.h"
+#include"../components/HALX/Battery/_battery.h"
 #include"../components/Logging/logger.hpp"
 #include "esp_system.h"
 #include "esp_wifi.h"
@@ -39,30 +46,55 @@ SOFTWARE.*/
 #include <esp_ota_ops.h>
 #include"os_config.h"
 
-uint8_t DRONE_STATE = 1;
-
 void monitor_memory_task(void *pvParameters);
+void monitor_health_task(void *pvParameters);
 void INIT_CORE0(void *pvParameters);
 
 extern "C"{
     void app_main(void){
-        xTaskCreate(&monitor_memory_task, "memory_task", 2048, NULL, 5, NULL);
-        xTaskCreate(&INIT_CORE0, "INIT_CORE0", 4096, NULL, 5, NULL);
+        //All on PRO_CPU, APP_CPU is left to the control rate groups (_task_layout.h)
+        xTaskCreatePinnedToCore(&monitor_health_task, "health_task", HEALTH_TASK_STACK, NULL, HEALTH_TASK_PRIORITY, NULL, HEALTH_TASK_CORE);
+        xTaskCreatePinnedToCore(&monitor_memory_task, "memory_task", MONITOR_TASK_STACK, NULL, MONITOR_TASK_PRIORITY, NULL, MONITOR_TASK_CORE);
+        xTaskCreatePinnedToCore(&INIT_CORE0, "INIT_CORE0", MAIN_TASK_STACK, NULL, MAIN_TASK_PRIORITY, NULL, MAIN_TASK_CORE);
+    }
+}
+
+void monitor_health_task(void *pvParameters) {
+    HealthMonitor& health = HealthMonitor::getInstance();
+    //Safe mode acts here, not on the main loop, which may be the stalled
+    //task: groups disabled and wings neutral now, the FSM latches ABORT
+    //on its next dispatch
+    health.onLevel(HEALTH_SAFE, [](void* ctx, health_level_t level, const char* task){
+        CONTROLLER_TASKS::safeWings();
+        FlightStateMachine::getInstance().post(EVT_ABORT);
+    }, nullptr);
+    //From here on a hung health task, or HEALTH_RESET, ends in a TWDT reset
+    health.startWatchdog();
+    TickType_t wake = xTaskGetTickCount();
+    while (1) {
+        health.check();
+        vTaskDelayUntil(&wake, pdMS_TO_TICKS(1000 / HEALTH_CHECK_HZ));
     }
 }
 
 void monitor_memory_task(void *pvParameters) {
+    MemoryManager& memory = MemoryManager::getInstance();
+    HealthMonitor& health = HealthMonitor::getInstance();
+    const int alive = health.add({"memory_task", MONITOR_TASK_DEADLINE_US, false, true});
     while (1) {
-        // Get the free heap memory size in bytes
-        size_t free_heap_size = esp_get_free_heap_size();
-        
-        // Print the free heap memory size
-        ESP_LOGI("Memory", "Free Heap Size: %u bytes", free_heap_size);
-        if(free_heap_size < 10000){
-            esp_restart();
+        {
+            //Beats once the pass is done, the delay is not busy time
+            HealthMonitor::Work pass(alive, health);
+            //Heap sample, low-water marks and pressure level (sheds work, never restarts)
+            memory.update();
+            const mem_sample_t heap = memory.sample();
+            ESP_LOGI("Memory", "Free %u, largest block %u, min free %u bytes (%s), new / delete %u / %u", unsigned(heap.free_bytes),
+                     unsigned(heap.largest_block), unsigned(heap.min_free), MemoryManager::levelName(memory.pressure()),
+                     unsigned(mem_alloc_count()), unsigned(mem_free_count()));
+            //Battery edges (with hysteresis) become state machine events
+            FlightStateMachine::getInstance().batteryLevel(BATTERY::returnBatteryPercent());
         }
-        // Delay for some time before checking again
-        vTaskDelay(pdMS_TO_TICKS(1000)); // Delay for 5 seconds
+        vTaskDelay(pdMS_TO_TICKS(1000));
     }
 }
 
@@ -77,8 +109,12 @@ void INIT_CORE0(void *pvParameters){
             }
         }
 
-        SSD1306_Init();
-        displayBOOT();
+        MemoryManager& memory = MemoryManager::getInstance();
+        {
+            MemoryManager::Scope charge(MEM_COMP_DISPLAY);
+            SSD1306_Init();
+            displayBOOT();
+        }
         vTaskDelay(pdMS_TO_TICKS(4000)); // Boot delay
 
         //VEHICLE_BARO *baro = new VEHICLE_BARO();
@@ -89,15 +125,7 @@ void INIT_CORE0(void *pvParameters){
         //cool -> init_relay();
         //delete cool;
 
-        CONTROLLER_TASKS *CTobj = new CONTROLLER_TASKS();
-        //Boot 
-        CTobj -> _init_();
-        delete CTobj;
-
-        
-        // Wait for Wi-Fi to initialize
-        vTaskDelay(pdMS_TO_TICKS(2000)); // Delay for 2 seconds
-        //Initialize NVS
+        //Initialize NVS, before boot so persisted PTAM registers can be restored
         esp_err_t ret = nvs_flash_init();
         if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
         ESP_ERROR_CHECK(nvs_flash_erase());
@@ -105,86 +133,130 @@ void INIT_CORE0(void *pvParameters){
         }
         ESP_ERROR_CHECK(ret);
 
+        {
+            MemoryManager::Scope charge(MEM_COMP_PTAM);
+            CONTROLLER_TASKS *CTobj = new CONTROLLER_TASKS();
+            //Boot 
+            CTobj -> _init_();
+            delete CTobj;
+        }
+
+        // Wait for Wi-Fi to initialize
+        vTaskDelay(pdMS_TO_TICKS(2000)); // Delay for 2 seconds
+
+        //Wake the main loop on web UI writes instead of spinning on them
+        //(operator commands only, actuated frames stay out of these registers)
+        PTAMNotifier mainEvents;
+        SharedMemory& sharedMemory = SharedMemory::getInstance();
+        sharedMemory.subscribe(ptam_mask(REG_WING_FL, REG_WING_FR, REG_WING_RL, REG_WING_RR), mainEvents, MAIN_EVT_WINGS);
+
+        //State changes arrive as events (web UI, arm token, abort, battery)
+        FlightStateMachine& fsm = FlightStateMachine::getInstance();
+        fsm.engine().attach(&mainEvents, MAIN_EVT_STATE);
+        //Fixed-rate control groups on APP_CPU, released only while ARMED
+        RateScheduler& scheduler = CONTROLLER_TASKS::scheduler();
+        fsm.onEntry(FLIGHT_ARMED, [](void* ctx){
+            //Groups are disabled here, the pipeline has no other user
+            CONTROLLER_TASKS::armPipeline();
+            HealthMonitor::getInstance().setActive(CONTROLLER_TASKS::controlHealth(), true);
+            static_cast<RateScheduler*>(ctx)->setEnabled(true);
+        }, &scheduler);
+        fsm.onExit(FLIGHT_ARMED, [](void* ctx){
+            RateScheduler* groups = static_cast<RateScheduler*>(ctx);
+            groups->setEnabled(false);
+            //The next state's work (BYPASS) must not overlap a control tick
+            if(!groups->waitIdle(CONTROL_STOP_TIMEOUT_US)){
+                ESP_LOGW("SCHED", "Control groups still running after disable");
+            }
+            CONTROLLER_TASKS::disarmPipeline();
+            HealthMonitor::getInstance().setActive(CONTROLLER_TASKS::controlHealth(), false);
+        }, &scheduler);
+        //Any abort (web UI, battery, health) ends with neutral wings, which
+        //BYPASS and the next arm then start from
+        fsm.onEntry(FLIGHT_ABORT, [](void* ctx){
+            CONTROLLER_TASKS::safeWings();
+            CONTROLLER_TASKS::disarmPipeline();
+        }, nullptr);
+        if(!scheduler.start()){
+            ESP_LOGE("SCHED", "Control rate groups failed to start");
+        }
+        fsm.start();
+
         BroadcastedServer server;
-        server.wifi_init_softap();
+        {
+            MemoryManager::Scope charge(MEM_COMP_COMMS);
+            server.wifi_init_softap();
+        }
+
+        CONTROLLER_TASKS controller;
+        flight_state_t shownState = fsm.state();
+        //Checked from the first pass on, boot delays above are not covered
+        HealthMonitor& health = HealthMonitor::getInstance();
+        const int alive = health.add({"core0.main", MAIN_TASK_DEADLINE_US, true, true});
 
         while(1){
-            CONTROLLER_TASKS *CTobj = new CONTROLLER_TASKS();
-            STATE *change = new STATE(); 
-            //VEHICLE_BARO *baro = new VEHICLE_BARO();
-            //FAN_COOLING *cool = new FAN_COOLING();
-
-            if(DRONE_STATE == 1){ // STANDBY
-                //Idle Restart Task
-                CTobj -> restart_after_idle_task();
-                //Display Controller
-                displayStandByClientSuccess();
-                //Fan Controller
-                //cool -> coolSierra_task(baro -> pushTemperature());
-                //FROM STANDBY PREP WE CAN EITHER SWITCH TO ARMED OR BYPASS
-                CTobj -> _PREP_();
-                if(change -> SWITCH2ARMED() == 1){
-                    DRONE_STATE = 2;
-                    //Set a stategic delay so we dont trigger CPU1 watchdog timer
-                    vTaskDelay(1);
-                    continue;
-                }
-                if(change -> SWITCH2BYPASS() == 1){
-                    DRONE_STATE = 3;
-                    //Set a stategic delay so we dont trigger CPU1 watchdog timer
-                    vTaskDelay(1);
-                    continue;
-                }
-            }
+            //One state machine pass, the idle wait below is excluded
+            PROBE_SCOPE_AS(passProbe, "core0.pass");
+            const int64_t passStart = ptam_time_us();
+            //Run queued transitions (exit / entry actions) before the state work
+            fsm.dispatch();
+            //Display refresh is the first work shed under memory pressure
+            //or a degraded health level, a state change is always shown
+            const bool changed = fsm.state() != shownState;
+            const bool display = memory.displayDue(changed) && (changed || !health.degraded());
+            shownState = fsm.state();
 
-            if(DRONE_STATE == 2){ // ARMED
-                //Display Controller
-                displayARMED();
-                //Fan Controller
-                //cool -> coolSierra_task(baro -> pushTemperature());
-                //FROM ARMED WE CAN EITHER SWITCH TO STANDY PREP OR BYPASS
-                CTobj -> _ARMED_();
-                if(change -> SWITCH2PREP() == 1){
-                    DRONE_STATE = 1;
-                    //Set a stategic delay so we dont trigger CPU1 watchdog timer
-                    vTaskDelay(1);
-                    continue;
-                }
-                if(change -> SWITCH2BYPASS() == 1){
-                    DRONE_STATE = 3;
-                    //Set a stategic delay so we dont trigger CPU1 watchdog timer
-                    vTaskDelay(1);
-                    continue;
-                }
+            switch(fsm.state()){
+                case FLIGHT_PREP:
+                    //Idle Restart Task
+                    controller.restart_after_idle_task();
+                    //Display Controller
+                    if(display){
+                        displayStandByClientSuccess();
+                    }
+                    //Fan Controller
+                    //cool -> coolSierra_task(baro -> pushTemperature());
+                    controller._PREP_();
+                    break;
+                case FLIGHT_ARMED:
+                    //Display Controller
+                    if(display){
+                        displayARMED();
+                    }
+                    controller._ARMED_();
+                    break;
+                case FLIGHT_BYPASS:
+                    //Idle Restart Task
+                    controller.restart_after_idle_task();
+                    //Display Controller
+                    if(display){
+                        displayBYPASS();
+                    }
+                    controller._bypass_(std::string("ID"));
+                    break;
+                case FLIGHT_ABORT:
+                    //Latched until the operator requests PREP
+                    if(display){
+                        displayERROR();
+                    }
+                    break;
             }
-            
-            if(DRONE_STATE == 3){ // BYPASS
-                //Idle Restart Task
-                CTobj -> restart_after_idle_task();
-                //Display Controller
-                displayBYPASS();
-                //Fan Controller
-                //cool -> coolSierra_task(baro -> pushTemperature());
-                //FROM BYPASS WE CAN EITHER SWITCH TO STANDY PREP OR ARMED
-                CTobj -> _bypass_(std::string("ID"));
-                if(change -> SWITCH2PREP() == 1){
-                    DRONE_STATE = 1;
-                    //Set a stategic delay so we dont trigger CPU1 watchdog timer
-                    vTaskDelay(1);
-                    continue;
-                }
-                if(change -> SWITCH2ARMED() == 1){
-                    DRONE_STATE = 2;
-                    //Set a stategic delay so we dont trigger CPU1 watchdog timer
-                    vTaskDelay(1);
-                    continue;
-                }
+
+            //Batched, rate-limited NVS write-back of mission targets
+            CONTROLLER_TASKS::persistence().flush();
+            //Servo frames from the control core (telemetry, no register writes)
+            CONTROLLER_TASKS::drainActuation();
+            //Rate group and heap summaries for the web UI, slowed under memory
+            //pressure and skipped while degraded
+            if(memory.telemetryDue() && !health.degraded()){
+                scheduler.publish();
+                memory.publish();
             }
 
-            //delete cool;
-            delete change;
-            //delete baro;
-            delete CTobj;
+            passProbe.stop();
+            health.beat(alive, 1, uint32_t(ptam_time_us() - passStart));
+            //Sleep until an event or wing write, or the idle tick
+            mainEvents.wait(MAIN_LOOP_IDLE_MS);
         }
 }
 
@@ -25,9 +25,15 @@ SOFTWARE.*/
 
 #define OS_VERSION "1.0.1"
 
-#define PTAM_VERSION "1.0"
+#define PTAM_VERSION "1.1"
 
 #define LOGGER_VERSION "1.0"
 
+//Main loop wake-up bits (PTAM subscriptions)
+#define MAIN_EVT_STATE  (1u << 0)
+#define MAIN_EVT_WINGS  (1u << 1)
+//Longest the main loop sleeps without a PTAM write (display / idle restart)
+#define MAIN_LOOP_IDLE_MS 250
+
 
 #endif //FIRMWARE_CONFIGURATION
\ No newline at end of file
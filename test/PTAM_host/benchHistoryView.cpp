@@ -0,0 +1,155 @@
+/**
+ * @file benchHistoryView.cpp
+ * @brief PTAM history copy vs view microbenchmark
+ *
+ * Compares returning a register history by value (legacy getXData) against
+ * iterating it in place through a read-locked ring view, for history sizes
+ * from 10 to 100k samples. Not part of ctest, run it directly:
+ *
+ *   ./benchHistoryView --benchmark_counters_tabular=true
+ *
+ * @copyright Copyright (c) 2023 limitless Aeronautics
+ *            This file is part of the MARS Flight System Firmware
+ *
+ * @license MIT License
+ *          Copyright (c) 2023 limitless Aeronautics
+ *          Permission is hereby granted, free of charge, to any person obtaining a copy
+ *          of this software and associated documentation files (the "Software"), to deal
+ *          in the Software without restriction, including without limitation the rights
+ *          to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *          copies of the Software, and to permit persons to whom the Software is
+ *          furnished to do so, subject to the following conditions:
+ *          The above copyright notice and this permission notice shall be included in all
+ *          copies or substantial portions of the Software.
+ *          THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *          IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *          FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *          AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *          LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *          OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *          SOFTWARE.
+ */
+/* System includes */
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/* Ptam includes */
+#include "_ptam.h"
+
+/* Google benchmark */
+#include <benchmark/benchmark.h>
+
+//Legacy store: vector per string ID, copied out under the map lock
+static void BM_LegacyVectorCopy(benchmark::State& state) {
+    const std::size_t n = static_cast<std::size_t>(state.range(0));
+    std::unordered_map<std::string, std::vector<double>> store;
+    std::mutex lock;
+    std::vector<double>& history = store["WingFL"];
+    for (std::size_t i = 0; i < n; ++i) {
+        history.push_back(static_cast<double>(i));
+    }
+
+    for (auto _ : state) {
+        std::vector<double> copy;
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            copy = store["WingFL"];
+        }
+        double sum = 0.0;
+        for (double v : copy) {
+            sum += v;
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+
+//Ring buffer copied into a vector (window + convert, like the shim)
+static void BM_RingCopy(benchmark::State& state) {
+    const std::size_t n = static_cast<std::size_t>(state.range(0));
+    std::vector<ptam_sample_t> storage(n);
+    PTAMRing<ptam_sample_t> ring(storage.data(), n);
+    std::mutex lock;
+    for (std::size_t i = 0; i < n; ++i) {
+        ptam_sample_t sample = {};
+        sample.value.d = static_cast<double>(i);
+        ring.push(sample);
+    }
+
+    for (auto _ : state) {
+        std::vector<double> copy;
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            copy.reserve(ring.size());
+            for (const ptam_sample_t& sample : ring) {
+                copy.push_back(sample.value.d);
+            }
+        }
+        double sum = 0.0;
+        for (double v : copy) {
+            sum += v;
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+
+//Read-locked in-place iteration, what PTAMHistoryView does
+static void BM_RingView(benchmark::State& state) {
+    const std::size_t n = static_cast<std::size_t>(state.range(0));
+    std::vector<ptam_sample_t> storage(n);
+    PTAMRing<ptam_sample_t> ring(storage.data(), n);
+    std::mutex lock;
+    for (std::size_t i = 0; i < n; ++i) {
+        ptam_sample_t sample = {};
+        sample.value.d = static_cast<double>(i);
+        ring.push(sample);
+    }
+
+    for (auto _ : state) {
+        std::unique_lock<std::mutex> guard(lock);
+        double sum = 0.0;
+        for (const ptam_sample_t& sample : ring) {
+            sum += sample.value.d;
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+
+//Real register at its configured depth, shim copy vs view
+static void BM_RegisterGetDoubleData(benchmark::State& state) {
+    SharedMemory& sharedMemory = SharedMemory::getInstance();
+    for (std::size_t i = 0; i < RegisterFile::depth(REG_WING_FL); ++i) {
+        sharedMemory.storeDouble(REG_WING_FL, static_cast<double>(i));
+    }
+    for (auto _ : state) {
+        std::vector<double> copy = sharedMemory.getDoubleData("WingFL");
+        benchmark::DoNotOptimize(copy.data());
+    }
+}
+
+static void BM_RegisterView(benchmark::State& state) {
+    SharedMemory& sharedMemory = SharedMemory::getInstance();
+    for (std::size_t i = 0; i < RegisterFile::depth(REG_WING_FL); ++i) {
+        sharedMemory.storeDouble(REG_WING_FL, static_cast<double>(i));
+    }
+    for (auto _ : state) {
+        PTAMHistoryView history = sharedMemory.view(REG_WING_FL);
+        double sum = 0.0;
+        for (const ptam_sample_t& sample : history) {
+            sum += sample.value.d;
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+}
+
+BENCHMARK(BM_LegacyVectorCopy)->RangeMultiplier(10)->Range(10, 100000);
+BENCHMARK(BM_RingCopy)->RangeMultiplier(10)->Range(10, 100000);
+BENCHMARK(BM_RingView)->RangeMultiplier(10)->Range(10, 100000);
+BENCHMARK(BM_RegisterGetDoubleData);
+BENCHMARK(BM_RegisterView);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,141 @@
+/**
+ * @file stressQueue.cpp
+ * @brief PTAM single-producer / single-consumer queue tests
+ *
+ * Checks ordering, the full and empty edges and drop counting, then runs
+ * one pthread producer against one pthread consumer and verifies every
+ * record arrives once, in order and untorn.
+ *
+ * @copyright Copyright (c) 2023 limitless Aeronautics
+ *            This file is part of the MARS Flight System Firmware
+ *
+ * @license MIT License
+ *          Copyright (c) 2023 limitless Aeronautics
+ *          Permission is hereby granted, free of charge, to any person obtaining a copy
+ *          of this software and associated documentation files (the "Software"), to deal
+ *          in the Software without restriction, including without limitation the rights
+ *          to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *          copies of the Software, and to permit persons to whom the Software is
+ *          furnished to do so, subject to the following conditions:
+ *          The above copyright notice and this permission notice shall be included in all
+ *          copies or substantial portions of the Software.
+ *          THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *          IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *          FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *          AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *          LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *          OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *          SOFTWARE.
+ */
+/* System includes */
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <pthread.h>
+#include <sched.h>
+
+/* Ptam includes */
+#include "_ptam_queue.h"
+#include "_ptam_snapshot.h"
+
+/* Google testing */
+#include <gtest/gtest.h>
+
+#define STRESS_RECORDS 2000000
+
+static ptam_wings_t make_wings(uint64_t n) {
+    double base = static_cast<double>(n);
+    return {base, base + 1.0, base + 2.0, base + 3.0, static_cast<int64_t>(n)};
+}
+
+TEST(PTAMQueue, Order_Full_Empty){
+    PTAMQueue<ptam_wings_t, 4> queue;
+    ptam_wings_t out;
+    EXPECT_FALSE(queue.pop(out));
+    EXPECT_EQ(queue.size(), 0u);
+
+    for (uint64_t n = 1; n <= 4; ++n) {
+        EXPECT_TRUE(queue.push(make_wings(n)));
+    }
+    EXPECT_EQ(queue.size(), 4u);
+    EXPECT_FALSE(queue.push(make_wings(5)));
+    EXPECT_EQ(queue.dropped(), 1u);
+
+    for (uint64_t n = 1; n <= 4; ++n) {
+        ASSERT_TRUE(queue.pop(out));
+        EXPECT_EQ(out.time_us, static_cast<int64_t>(n));
+    }
+    EXPECT_FALSE(queue.pop(out));
+}
+
+TEST(PTAMQueue, Wraps_Index){
+    PTAMQueue<ptam_wings_t, 2> queue;
+    ptam_wings_t out;
+    //Many laps of a two slot ring, one in one out
+    for (uint64_t n = 1; n <= 1000; ++n) {
+        ASSERT_TRUE(queue.push(make_wings(n)));
+        ASSERT_TRUE(queue.pop(out));
+        EXPECT_EQ(out.fr, static_cast<double>(n) + 1.0);
+    }
+    EXPECT_EQ(queue.dropped(), 0u);
+}
+
+struct queue_ctx_t {
+    PTAMQueue<ptam_wings_t, 64> queue;
+    std::atomic<uint64_t> pushed{0};
+};
+
+static void* producer(void* arg) {
+    queue_ctx_t* ctx = static_cast<queue_ctx_t*>(arg);
+    uint64_t n = 1;
+    while (n <= STRESS_RECORDS) {
+        //Retry on full so the consumer must see every record
+        if (ctx->queue.push(make_wings(n))) {
+            ++n;
+        } else {
+            sched_yield();
+        }
+    }
+    ctx->pushed.store(n - 1);
+    return nullptr;
+}
+
+TEST(PTAMQueue, Cross_Thread_In_Order){
+    queue_ctx_t* ctx = new queue_ctx_t();
+    pthread_t thread;
+    auto start = std::chrono::steady_clock::now();
+    pthread_create(&thread, nullptr, producer, ctx);
+
+    uint64_t expected = 1, torn = 0, gaps = 0;
+    ptam_wings_t out;
+    while (expected <= STRESS_RECORDS) {
+        if (!ctx->queue.pop(out)) {
+            sched_yield();
+            continue;
+        }
+        const double base = static_cast<double>(out.time_us);
+        if (out.fl != base || out.fr != base + 1.0 || out.rl != base + 2.0 || out.rr != base + 3.0) {
+            ++torn;
+        }
+        if (out.time_us != static_cast<int64_t>(expected)) {
+            ++gaps;
+        }
+        ++expected;
+    }
+    pthread_join(thread, nullptr);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::printf("[queue   ] %.2f Mrecord/s | dropped (retried) %u\n",
+                STRESS_RECORDS / seconds / 1e6, ctx->queue.dropped());
+
+    EXPECT_EQ(torn, 0u);
+    EXPECT_EQ(gaps, 0u);
+    EXPECT_EQ(ctx->pushed.load(), static_cast<uint64_t>(STRESS_RECORDS));
+    EXPECT_EQ(ctx->queue.size(), 0u);
+    delete ctx;
+}
+
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
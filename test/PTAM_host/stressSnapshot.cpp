@@ -0,0 +1,213 @@
+/**
+ * @file stressSnapshot.cpp
+ * @brief PTAM snapshot channel stress test
+ *
+ * Runs PTAMSnapshot with one pthread producer and several pthread readers,
+ * reports throughput and counts torn reads. A mutex-protected struct runs
+ * the same workload as a baseline.
+ *
+ * @copyright Copyright (c) 2023 limitless Aeronautics
+ *            This file is part of the MARS Flight System Firmware
+ *
+ * @license MIT License
+ *          Copyright (c) 2023 limitless Aeronautics
+ *          Permission is hereby granted, free of charge, to any person obtaining a copy
+ *          of this software and associated documentation files (the "Software"), to deal
+ *          in the Software without restriction, including without limitation the rights
+ *          to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *          copies of the Software, and to permit persons to whom the Software is
+ *          furnished to do so, subject to the following conditions:
+ *          The above copyright notice and this permission notice shall be included in all
+ *          copies or substantial portions of the Software.
+ *          THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *          IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *          FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *          AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *          LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *          OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *          SOFTWARE.
+ */
+/* System includes */
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <pthread.h>
+
+/* Ptam includes */
+#include "_ptam_snapshot.h"
+
+/* Google testing */
+#include <gtest/gtest.h>
+
+#define STRESS_READERS      4
+#define STRESS_PUBLISHES    2000000
+
+struct stress_result_t {
+    uint64_t publishes;
+    uint64_t reads;
+    uint64_t retries;
+    uint64_t torn;
+    double seconds;
+};
+
+/* Every field is derived from the same counter, any mix of two publishes is detectable */
+static ptam_wings_t make_wings(uint64_t n) {
+    double base = static_cast<double>(n);
+    return {base, base + 1.0, base + 2.0, base + 3.0, static_cast<int64_t>(n)};
+}
+
+static bool consistent(const ptam_wings_t& w) {
+    double base = static_cast<double>(w.time_us);
+    return w.fl == base && w.fr == base + 1.0 && w.rl == base + 2.0 && w.rr == base + 3.0;
+}
+
+/* Seqlock snapshot workload */
+struct snapshot_ctx_t {
+    PTAMSnapshot<ptam_wings_t> channel;
+    std::atomic<bool> done{false};
+    std::atomic<uint64_t> reads{0};
+    std::atomic<uint64_t> retries{0};
+    std::atomic<uint64_t> torn{0};
+};
+
+static void* snapshot_writer(void* arg) {
+    snapshot_ctx_t* ctx = static_cast<snapshot_ctx_t*>(arg);
+    for (uint64_t n = 1; n <= STRESS_PUBLISHES; ++n) {
+        ctx->channel.publish(make_wings(n));
+    }
+    ctx->done.store(true);
+    return nullptr;
+}
+
+static void* snapshot_reader(void* arg) {
+    snapshot_ctx_t* ctx = static_cast<snapshot_ctx_t*>(arg);
+    uint64_t reads = 0, retries = 0, torn = 0;
+    ptam_wings_t out;
+    while (!ctx->done.load(std::memory_order_relaxed)) {
+        if (!ctx->channel.tryRead(out)) {
+            ++retries;
+            continue;
+        }
+        ++reads;
+        //time_us 0 is the zeroed state before the first publish
+        if (out.time_us != 0 && !consistent(out)) {
+            ++torn;
+        }
+    }
+    ctx->reads += reads;
+    ctx->retries += retries;
+    ctx->torn += torn;
+    return nullptr;
+}
+
+/* Mutex baseline workload */
+struct mutex_ctx_t {
+    ptam_wings_t data{};
+    std::mutex lock;
+    std::atomic<bool> done{false};
+    std::atomic<uint64_t> reads{0};
+    std::atomic<uint64_t> torn{0};
+};
+
+static void* mutex_writer(void* arg) {
+    mutex_ctx_t* ctx = static_cast<mutex_ctx_t*>(arg);
+    for (uint64_t n = 1; n <= STRESS_PUBLISHES; ++n) {
+        std::lock_guard<std::mutex> guard(ctx->lock);
+        ctx->data = make_wings(n);
+    }
+    ctx->done.store(true);
+    return nullptr;
+}
+
+static void* mutex_reader(void* arg) {
+    mutex_ctx_t* ctx = static_cast<mutex_ctx_t*>(arg);
+    uint64_t reads = 0, torn = 0;
+    ptam_wings_t out;
+    while (!ctx->done.load(std::memory_order_relaxed)) {
+        {
+            std::lock_guard<std::mutex> guard(ctx->lock);
+            out = ctx->data;
+        }
+        ++reads;
+        if (out.time_us != 0 && !consistent(out)) {
+            ++torn;
+        }
+    }
+    ctx->reads += reads;
+    ctx->torn += torn;
+    return nullptr;
+}
+
+template <typename Ctx>
+static stress_result_t run(Ctx& ctx, void* (*writer)(void*), void* (*reader)(void*)) {
+    pthread_t readers[STRESS_READERS];
+    pthread_t producer;
+
+    auto start = std::chrono::steady_clock::now();
+    for (pthread_t& thread : readers) {
+        pthread_create(&thread, nullptr, reader, &ctx);
+    }
+    pthread_create(&producer, nullptr, writer, &ctx);
+    pthread_join(producer, nullptr);
+    for (pthread_t& thread : readers) {
+        pthread_join(thread, nullptr);
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    stress_result_t result{};
+    result.publishes = STRESS_PUBLISHES;
+    result.reads = ctx.reads.load();
+    result.torn = ctx.torn.load();
+    result.seconds = std::chrono::duration<double>(end - start).count();
+    return result;
+}
+
+static void report(const char* name, const stress_result_t& r) {
+    std::printf("[%-8s] %d readers | %.2f Mpublish/s | %.2f Mread/s | retries %llu | torn %llu\n",
+                name, STRESS_READERS,
+                r.publishes / r.seconds / 1e6, r.reads / r.seconds / 1e6,
+                static_cast<unsigned long long>(r.retries),
+                static_cast<unsigned long long>(r.torn));
+}
+
+TEST(StressSnapshot, Seqlock_No_Torn_Reads){
+    snapshot_ctx_t* ctx = new snapshot_ctx_t();
+    stress_result_t result = run(*ctx, snapshot_writer, snapshot_reader);
+    result.retries = ctx->retries.load();
+    report("seqlock", result);
+
+    EXPECT_EQ(result.torn, 0u);
+    EXPECT_GT(result.reads, 0u);
+    EXPECT_EQ(ctx->channel.version(), static_cast<uint32_t>(STRESS_PUBLISHES));
+    EXPECT_TRUE(consistent(ctx->channel.read()));
+    EXPECT_EQ(ctx->channel.read().time_us, STRESS_PUBLISHES);
+    delete ctx;
+}
+
+TEST(StressSnapshot, Mutex_Baseline){
+    mutex_ctx_t* ctx = new mutex_ctx_t();
+    stress_result_t result = run(*ctx, mutex_writer, mutex_reader);
+    report("mutex", result);
+
+    EXPECT_EQ(result.torn, 0u);
+    delete ctx;
+}
+
+TEST(StressSnapshot, Read_Before_Publish){
+    PTAMSnapshot<ptam_attitude_t> channel;
+    EXPECT_EQ(channel.version(), 0u);
+    ptam_attitude_t out = channel.read();
+    EXPECT_EQ(out.pitch, 0.0);
+
+    channel.publish({1.0, 2.0, 3.0, 4});
+    out = channel.read();
+    EXPECT_EQ(out.roll, 2.0);
+    EXPECT_EQ(channel.version(), 1u);
+}
+
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,200 @@
+/**
+ * @file unittestDump.cpp
+ * @brief PTAM introspection and CBOR dump unit testing
+ *
+ * Host-side tests for RegisterFile::info/enumerate/dump, the dump is decoded
+ * with a small CBOR reader below
+ *
+ * @copyright Copyright (c) 2023 limitless Aeronautics
+ *            This file is part of the MARS Flight System Firmware
+ *
+ * @license MIT License
+ *          Copyright (c) 2023 limitless Aeronautics
+ *          Permission is hereby granted, free of charge, to any person obtaining a copy
+ *          of this software and associated documentation files (the "Software"), to deal
+ *          in the Software without restriction, including without limitation the rights
+ *          to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *          copies of the Software, and to permit persons to whom the Software is
+ *          furnished to do so, subject to the following conditions:
+ *          The above copyright notice and this permission notice shall be included in all
+ *          copies or substantial portions of the Software.
+ *          THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *          IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *          FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *          AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *          LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *          OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *          SOFTWARE.
+ */
+/* System includes */
+#include <cstring>
+#include <string>
+
+/* Ptam includes */
+#include "_ptam.h"
+
+/* Google testing */
+#include <gtest/gtest.h>
+
+//Just enough CBOR to walk a PTAM dump
+struct cbor_reader_t {
+    const uint8_t* data;
+    std::size_t len;
+    std::size_t pos;
+
+    uint8_t peek() const { return data[pos]; }
+
+    uint64_t head(uint8_t& major) {
+        const uint8_t initial = data[pos++];
+        major = initial >> 5;
+        const uint8_t info = initial & 0x1f;
+        if (info < 24) {
+            return info;
+        }
+        const int bytes = 1 << (info - 24);
+        uint64_t value = 0;
+        for (int i = 0; i < bytes; ++i) {
+            value = (value << 8) | data[pos++];
+        }
+        return value;
+    }
+
+    uint64_t expect(uint8_t major) {
+        uint8_t got;
+        uint64_t value = head(got);
+        EXPECT_EQ(got, major);
+        return value;
+    }
+
+    int64_t integer() {
+        uint8_t major;
+        uint64_t value = head(major);
+        return major == 1 ? -1 - static_cast<int64_t>(value) : static_cast<int64_t>(value);
+    }
+
+    std::string text() {
+        std::size_t n = expect(3);
+        std::string out(reinterpret_cast<const char*>(data + pos), n);
+        pos += n;
+        return out;
+    }
+
+    double float64() {
+        EXPECT_EQ(data[pos], 0xfb);
+        ++pos;
+        uint64_t bits = 0;
+        for (int i = 0; i < 8; ++i) {
+            bits = (bits << 8) | data[pos++];
+        }
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+};
+
+TEST(TestIntrospection, Info_And_Enumerate){
+    RegisterFile regs;
+    ptam_reg_info_t info = regs.info(REG_WING_FR);
+    EXPECT_STREQ(info.id, "WingFR");
+    EXPECT_EQ(info.type, ptam_type_t::DOUBLE);
+    EXPECT_EQ(info.depth, RegisterFile::depth(REG_WING_FR));
+    EXPECT_EQ(info.seq, 0u);
+    EXPECT_EQ(info.last_write_us, 0);
+    EXPECT_EQ(info.write_rate_hz, 0.0f);
+
+    for (int i = 0; i < 4; ++i) {
+        regs.storeDouble(REG_WING_FR, i);
+        //Keep writes on distinct timestamps so there is an interval to measure
+        const int64_t written = ptam_time_us();
+        while (ptam_time_us() == written) {}
+    }
+    info = regs.info(REG_WING_FR);
+    EXPECT_EQ(info.seq, 4u);
+    EXPECT_EQ(info.size, 4u);
+    EXPECT_GT(info.last_write_us, 0);
+    EXPECT_GT(info.write_rate_hz, 0.0f);
+
+    ptam_reg_info_t all[PTAM_REG_COUNT];
+    ASSERT_EQ(regs.enumerate(all, PTAM_REG_COUNT), static_cast<std::size_t>(PTAM_REG_COUNT));
+    EXPECT_STREQ(all[REG_STATE_DESCRIPT].id, "stateDescript");
+    EXPECT_EQ(all[REG_WING_FR].seq, 4u);
+    EXPECT_EQ(regs.enumerate(all, 3), 3u);
+}
+
+TEST(TestIntrospection, Dump_Decodes){
+    RegisterFile regs;
+    regs.storeInt(REG_STATE, 3);
+    regs.storeString(REG_STATE_DESCRIPT, "BYPASS");
+    regs.storeDouble(REG_TLAT, -49.5);
+
+    uint8_t buffer[PTAM_DUMP_MAX_BYTES];
+    std::size_t len = regs.dump(buffer, sizeof(buffer));
+    ASSERT_GT(len, 0u);
+
+    cbor_reader_t cbor = {buffer, len, 0};
+    EXPECT_EQ(cbor.expect(5), 3u);
+    EXPECT_EQ(cbor.text(), "v");
+    EXPECT_EQ(cbor.integer(), 1);
+    EXPECT_EQ(cbor.text(), "t");
+    EXPECT_GT(cbor.integer(), 0);
+    EXPECT_EQ(cbor.text(), "regs");
+    ASSERT_EQ(cbor.expect(4), static_cast<uint64_t>(PTAM_REG_COUNT));
+
+    for (uint8_t i = 0; i < PTAM_REG_COUNT; ++i) {
+        const ptam_reg_def_t& def = RegisterFile::describe(static_cast<ptam_reg_t>(i));
+        ASSERT_EQ(cbor.expect(4), 7u);
+        EXPECT_EQ(cbor.text(), def.id);
+        EXPECT_EQ(cbor.integer(), static_cast<int64_t>(def.type));
+        EXPECT_EQ(cbor.integer(), def.depth);
+        const int64_t seq = cbor.integer();
+        cbor.integer();     //last write
+        cbor.float64();     //rate
+        if (seq == 0) {
+            EXPECT_EQ(cbor.peek(), 0xf6);
+            ++cbor.pos;
+            continue;
+        }
+        switch (def.reg) {
+            case REG_STATE:
+                EXPECT_EQ(cbor.integer(), 3);
+                break;
+            case REG_STATE_DESCRIPT:
+                EXPECT_EQ(cbor.text(), "BYPASS");
+                break;
+            case REG_TLAT:
+                EXPECT_DOUBLE_EQ(cbor.float64(), -49.5);
+                break;
+            default:
+                FAIL() << def.id << " should be unset";
+        }
+    }
+    EXPECT_EQ(cbor.pos, len);
+}
+
+TEST(TestIntrospection, Dump_Bound_And_Small_Buffer){
+    RegisterFile regs;
+    //Every register at its largest encoding
+    for (uint8_t i = 0; i < PTAM_REG_COUNT; ++i) {
+        const ptam_reg_t reg = static_cast<ptam_reg_t>(i);
+        if (RegisterFile::describe(reg).type == ptam_type_t::STRING) {
+            regs.storeString(reg, "FIFTEEN-CHARS-X");
+        } else {
+            regs.storeDouble(reg, -1.0e300);
+        }
+    }
+    uint8_t buffer[PTAM_DUMP_MAX_BYTES];
+    std::size_t len = regs.dump(buffer, sizeof(buffer));
+    EXPECT_GT(len, 0u);
+    EXPECT_LE(len, PTAM_DUMP_MAX_BYTES);
+
+    uint8_t small[32];
+    EXPECT_EQ(regs.dump(small, sizeof(small)), 0u);
+    //Locks are released after a failed dump
+    EXPECT_TRUE(regs.storeInt(REG_STATE, 1));
+}
+
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
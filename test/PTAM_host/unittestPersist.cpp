@@ -0,0 +1,179 @@
+/**
+ * @file unittestPersist.cpp
+ * @brief PTAM persistence unit testing
+ *
+ * Host-side tests for PTAMPersistence against the file-backed NVS stand-in
+ *
+ * @copyright Copyright (c) 2023 limitless Aeronautics
+ *            This file is part of the MARS Flight System Firmware
+ *
+ * @license MIT License
+ *          Copyright (c) 2023 limitless Aeronautics
+ *          Permission is hereby granted, free of charge, to any person obtaining a copy
+ *          of this software and associated documentation files (the "Software"), to deal
+ *          in the Software without restriction, including without limitation the rights
+ *          to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *          copies of the Software, and to permit persons to whom the Software is
+ *          furnished to do so, subject to the following conditions:
+ *          The above copyright notice and this permission notice shall be included in all
+ *          copies or substantial portions of the Software.
+ *          THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *          IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *          FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *          AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *          LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *          OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *          SOFTWARE.
+ */
+/* System includes */
+#include <cstdio>
+#include <string>
+
+/* Ptam includes */
+#include "_ptam_persist.h"
+
+/* Google testing */
+#include <gtest/gtest.h>
+
+#define TEST_INTERVAL_US 1000000
+
+static std::string store_path(const char* name) {
+    std::string path = ::testing::TempDir() + name;
+    std::remove(path.c_str());
+    return path;
+}
+
+static void enter_mission(RegisterFile& regs) {
+    regs.storeDouble(REG_TLAT, 49.8951);
+    regs.storeDouble(REG_TLONG, -97.1384);
+    regs.storeDouble(REG_TALT, 120.0);
+    regs.storeDouble(REG_CALT, 80.0);
+    regs.storeDouble(REG_TVEL, 12.5);
+}
+
+TEST(TestPersist, Warm_Restart_Restores_Targets){
+    const std::string path = store_path("ptam_warm_restart.bin");
+    {
+        RegisterFile regs;
+        PTAMFileStore store(path);
+        PTAMPersistence persistence(regs, store, TEST_INTERVAL_US);
+        EXPECT_EQ(persistence.restore(), 0u);
+        ASSERT_TRUE(persistence.attach());
+
+        enter_mission(regs);
+        regs.storeDouble(REG_WING_FL, 90.0);    //Not flagged
+        EXPECT_EQ(persistence.dirty(), ptam_persist_mask());
+        EXPECT_TRUE(persistence.flush(true));
+    }
+
+    //"Restart": fresh register file and store on the same file
+    RegisterFile regs;
+    PTAMFileStore store(path);
+    PTAMPersistence persistence(regs, store, TEST_INTERVAL_US);
+    EXPECT_EQ(persistence.restore(), 5u);
+    EXPECT_DOUBLE_EQ(regs.getDouble(REG_TLAT), 49.8951);
+    EXPECT_DOUBLE_EQ(regs.getDouble(REG_TLONG), -97.1384);
+    EXPECT_DOUBLE_EQ(regs.getDouble(REG_TVEL), 12.5);
+    EXPECT_FALSE(regs.isSet(REG_WING_FL));
+
+    //Restored values are not dirty, nothing to write back
+    ASSERT_TRUE(persistence.attach());
+    EXPECT_EQ(persistence.dirty(), 0u);
+    EXPECT_FALSE(persistence.flush(true));
+}
+
+TEST(TestPersist, Batched_And_Rate_Limited){
+    RegisterFile regs;
+    PTAMFileStore store(store_path("ptam_rate_limit.bin"));
+    PTAMPersistence persistence(regs, store, TEST_INTERVAL_US);
+    persistence.attach();
+    const int64_t t0 = 5000000;
+
+    //Five registers, one commit
+    enter_mission(regs);
+    EXPECT_TRUE(persistence.flush(t0, false));
+    EXPECT_EQ(store.writes(), 5u);
+    EXPECT_EQ(store.commits(), 1u);
+
+    //Inside the interval writes stay dirty
+    regs.storeDouble(REG_TALT, 150.0);
+    EXPECT_FALSE(persistence.flush(t0 + TEST_INTERVAL_US / 2, false));
+    EXPECT_EQ(store.commits(), 1u);
+    EXPECT_EQ(persistence.dirty(), ptam_mask(REG_TALT));
+
+    //Interval elapsed, only the changed register is written
+    EXPECT_TRUE(persistence.flush(t0 + TEST_INTERVAL_US, false));
+    EXPECT_EQ(store.writes(), 6u);
+    EXPECT_EQ(store.commits(), 2u);
+    EXPECT_EQ(persistence.dirty(), 0u);
+}
+
+TEST(TestPersist, Unchanged_Values_Not_Rewritten){
+    RegisterFile regs;
+    PTAMFileStore store(store_path("ptam_unchanged.bin"));
+    PTAMPersistence persistence(regs, store, TEST_INTERVAL_US);
+    persistence.attach();
+
+    regs.storeDouble(REG_TVEL, 10.0);
+    EXPECT_TRUE(persistence.flush(true));
+    //Web UI resubmits the same mission
+    regs.storeDouble(REG_TVEL, 10.0);
+    EXPECT_FALSE(persistence.flush(true));
+    EXPECT_EQ(store.writes(), 1u);
+    EXPECT_EQ(store.commits(), 1u);
+}
+
+TEST(TestPersist, Only_Flagged_Registers){
+    static_assert(ptam_persist_mask() == ptam_mask(REG_TLAT, REG_TLONG, REG_TALT, REG_CALT, REG_TVEL));
+
+    RegisterFile regs;
+    PTAMFileStore store(store_path("ptam_flagged.bin"));
+    PTAMPersistence persistence(regs, store, TEST_INTERVAL_US);
+    persistence.attach();
+
+    regs.storeInt(REG_STATE, 3);
+    regs.storeDouble(REG_THR, 40.0);
+    EXPECT_EQ(persistence.dirty(), 0u);
+    EXPECT_FALSE(persistence.flush(true));
+}
+
+/* File store whose commit() can be made to fail (flash full, power loss) */
+class FailingStore : public PTAMFileStore {
+public:
+    explicit FailingStore(const std::string& path) : PTAMFileStore(path), fail(true) {}
+    bool commit() override { return fail ? false : PTAMFileStore::commit(); }
+    bool fail;
+};
+
+TEST(TestPersist, Failed_Commit_Is_Retried){
+    const std::string path = store_path("ptam_failed_commit.bin");
+    {
+        RegisterFile regs;
+        FailingStore store(path);
+        PTAMPersistence persistence(regs, store, TEST_INTERVAL_US);
+        persistence.attach();
+
+        regs.storeDouble(REG_TVEL, 10.0);
+        EXPECT_FALSE(persistence.flush(true));
+        EXPECT_EQ(persistence.dirty(), ptam_mask(REG_TVEL));
+
+        //Same value again: not known stored, so still written
+        regs.storeDouble(REG_TVEL, 10.0);
+        store.fail = false;
+        EXPECT_TRUE(persistence.flush(true));
+        EXPECT_EQ(persistence.dirty(), 0u);
+        EXPECT_EQ(store.writes(), 2u);
+    }
+
+    RegisterFile regs;
+    PTAMFileStore store(path);
+    PTAMPersistence persistence(regs, store, TEST_INTERVAL_US);
+    EXPECT_EQ(persistence.restore(), 1u);
+    EXPECT_DOUBLE_EQ(regs.getDouble(REG_TVEL), 10.0);
+}
+
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
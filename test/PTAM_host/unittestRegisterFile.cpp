@@ -0,0 +1,286 @@
+/**
+ * @file unittestRegisterFile.cpp
+ * @brief PTAM fixed register file unit testing
+ *
+ * Host-side tests for RegisterFile and the SharedMemory string shim
+ *
+ * @copyright Copyright (c) 2023 limitless Aeronautics
+ *            This file is part of the MARS Flight System Firmware
+ *
+ * @license MIT License
+ *          Copyright (c) 2023 limitless Aeronautics
+ *          Permission is hereby granted, free of charge, to any person obtaining a copy
+ *          of this software and associated documentation files (the "Software"), to deal
+ *          in the Software without restriction, including without limitation the rights
+ *          to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *          copies of the Software, and to permit persons to whom the Software is
+ *          furnished to do so, subject to the following conditions:
+ *          The above copyright notice and this permission notice shall be included in all
+ *          copies or substantial portions of the Software.
+ *          THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *          IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *          FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *          AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *          LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *          OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *          SOFTWARE.
+ */
+/* System includes */
+#include <iostream>
+
+/* Ptam includes */
+#include "_ptam.h"
+
+/* Google testing */
+#include <gtest/gtest.h>
+
+/* Literal IDs resolve at compile time */
+static_assert([] { ptam_reg_t r{}; return ptam_lookup("WingFL", r) && r == REG_WING_FL; }());
+static_assert([] { ptam_reg_t r{}; return !ptam_lookup("NotARegister", r); }());
+
+TEST(TestRegisterFile, Typed_Access){
+    RegisterFile regs;
+
+    regs.set<REG_WING_FL>(142.5);
+    regs.set<REG_STATE>(2);
+    regs.set<REG_ARM_TOKEN>("a1B2c3");
+
+    EXPECT_DOUBLE_EQ(regs.get<REG_WING_FL>(), 142.5);
+    EXPECT_EQ(regs.get<REG_STATE>(), 2);
+    EXPECT_EQ(regs.get<REG_ARM_TOKEN>(), "a1B2c3");
+}
+
+TEST(TestRegisterFile, Unset_Defaults){
+    RegisterFile regs;
+
+    EXPECT_FALSE(regs.isSet(REG_TLAT));
+    EXPECT_EQ(regs.getDouble(REG_TLAT), 0.0);
+    EXPECT_EQ(regs.getInt(REG_STATE), 0);
+    EXPECT_EQ(regs.getString(REG_STATE_DESCRIPT), "");
+}
+
+TEST(TestRegisterFile, Numeric_Conversion_And_Type_Mismatch){
+    RegisterFile regs;
+
+    //HTTP AUTH stores the state register as a double
+    EXPECT_TRUE(regs.storeDouble(REG_STATE, 2.0));
+    EXPECT_EQ(regs.getInt(REG_STATE), 2);
+
+    EXPECT_FALSE(regs.storeDouble(REG_STATE_DESCRIPT, 1.0));
+    EXPECT_FALSE(regs.storeString(REG_WING_FR, "90"));
+    EXPECT_FALSE(regs.isSet(REG_WING_FR));
+}
+
+TEST(TestRegisterFile, String_Truncation){
+    RegisterFile regs;
+
+    regs.storeString(REG_STATE_DESCRIPT, "THIS-STRING-IS-TOO-LONG");
+    EXPECT_EQ(regs.getString(REG_STATE_DESCRIPT).size(), PTAM_STRING_LEN - 1);
+}
+
+TEST(TestRegisterFile, Clear){
+    RegisterFile regs;
+
+    regs.storeDouble(REG_THR, 40);
+    regs.storeInt(REG_GPS_CHECK, 1);
+    regs.clear(REG_THR);
+    EXPECT_FALSE(regs.isSet(REG_THR));
+    EXPECT_TRUE(regs.isSet(REG_GPS_CHECK));
+
+    regs.clearAll();
+    EXPECT_FALSE(regs.isSet(REG_GPS_CHECK));
+}
+
+TEST(TestSharedMemoryShim, String_IDs_Reach_Fixed_Registers){
+    SharedMemory& sharedMemory = SharedMemory::getInstance();
+    sharedMemory.clearAllData();
+
+    sharedMemory.storeDouble("WingRL", 231.0);
+    EXPECT_DOUBLE_EQ(sharedMemory.getLastDouble(REG_WING_RL), 231.0);
+    EXPECT_DOUBLE_EQ(sharedMemory.registers().get<REG_WING_RL>(), 231.0);
+
+    sharedMemory.storeString(REG_STATE_DESCRIPT, "BYPASS");
+    EXPECT_EQ(sharedMemory.getLastString("stateDescript"), "BYPASS");
+
+    std::vector<double> data = sharedMemory.getDoubleData("WingRL");
+    ASSERT_EQ(data.size(), 1);
+    EXPECT_DOUBLE_EQ(data[0], 231.0);
+}
+
+TEST(TestSharedMemoryShim, Undeclared_IDs_Use_Legacy_Store){
+    SharedMemory& sharedMemory = SharedMemory::getInstance();
+    sharedMemory.clearAllData();
+
+    sharedMemory.storeDouble("scratch", 1.5);
+    sharedMemory.storeDouble("scratch", 2.5);
+    EXPECT_EQ(sharedMemory.getDoubleData("scratch").size(), 2);
+    EXPECT_DOUBLE_EQ(sharedMemory.getLastDouble("scratch"), 2.5);
+}
+
+TEST(TestRingHistory, Bounded_By_Depth){
+    RegisterFile regs;
+    const std::size_t depth = RegisterFile::depth(REG_WING_FL);
+
+    for (std::size_t i = 0; i < depth * 3; ++i) {
+        regs.storeDouble(REG_WING_FL, static_cast<double>(i));
+    }
+    EXPECT_EQ(regs.size(REG_WING_FL), depth);
+    EXPECT_DOUBLE_EQ(regs.getDouble(REG_WING_FL), static_cast<double>(depth * 3 - 1));
+
+    //Flags only keep their latest value
+    regs.storeInt(REG_GPS_CHECK, 0);
+    regs.storeInt(REG_GPS_CHECK, 1);
+    EXPECT_EQ(regs.size(REG_GPS_CHECK), 1);
+    EXPECT_EQ(regs.getInt(REG_GPS_CHECK), 1);
+}
+
+TEST(TestRingHistory, Latest_And_Window){
+    RegisterFile regs;
+    ptam_sample_t sample;
+    EXPECT_FALSE(regs.latest(REG_THR, sample));
+
+    for (int i = 1; i <= 5; ++i) {
+        regs.storeDouble(REG_THR, i * 10.0);
+    }
+    ASSERT_TRUE(regs.latest(REG_THR, sample));
+    EXPECT_DOUBLE_EQ(sample.value.d, 50.0);
+
+    ptam_sample_t window[3];
+    ASSERT_EQ(regs.window(REG_THR, 3, window), 3);
+    EXPECT_DOUBLE_EQ(window[0].value.d, 30.0);
+    EXPECT_DOUBLE_EQ(window[2].value.d, 50.0);
+    EXPECT_LE(window[0].time_us, window[2].time_us);
+
+    //Asking for more than is stored returns what is there
+    ptam_sample_t all[PTAM_MAX_DEPTH];
+    EXPECT_EQ(regs.window(REG_THR, PTAM_MAX_DEPTH, all), 5);
+}
+
+TEST(TestRingHistory, Since_Timestamp){
+    RegisterFile regs;
+    regs.storeDouble(REG_WING_RR, 100.0);
+    regs.storeDouble(REG_WING_RR, 101.0);
+
+    ptam_sample_t mark;
+    ASSERT_TRUE(regs.latest(REG_WING_RR, mark));
+    //Make sure following writes get a later timestamp
+    while (ptam_time_us() == mark.time_us) {}
+
+    regs.storeDouble(REG_WING_RR, 102.0);
+    regs.storeDouble(REG_WING_RR, 103.0);
+
+    ptam_sample_t out[PTAM_MAX_DEPTH];
+    std::size_t n = regs.since(REG_WING_RR, mark.time_us, out, PTAM_MAX_DEPTH);
+    ASSERT_EQ(n, 2);
+    EXPECT_DOUBLE_EQ(out[0].value.d, 102.0);
+    EXPECT_DOUBLE_EQ(out[1].value.d, 103.0);
+
+    EXPECT_EQ(regs.since(REG_WING_RR, ptam_time_us(), out, PTAM_MAX_DEPTH), 0);
+}
+
+TEST(TestRingHistory, Shim_Returns_Bounded_History){
+    SharedMemory& sharedMemory = SharedMemory::getInstance();
+    sharedMemory.clearAllData();
+
+    //Repeated stores no longer grow without bound
+    for (int i = 0; i < 1000; ++i) {
+        sharedMemory.storeDouble("TLat", 45.0 + i);
+    }
+    std::vector<double> data = sharedMemory.getDoubleData("TLat");
+    ASSERT_EQ(data.size(), RegisterFile::depth(REG_TLAT));
+    EXPECT_DOUBLE_EQ(data.back(), 1044.0);
+    EXPECT_TRUE(sharedMemory.getStringData("TLat").empty());
+}
+
+TEST(TestFreshness, Sequence_Numbers){
+    RegisterFile regs;
+    EXPECT_EQ(regs.seq(REG_WING_FL), 0u);
+    EXPECT_EQ(regs.ageUs(REG_WING_FL), -1);
+
+    regs.storeDouble(REG_WING_FL, 90.0);
+    uint32_t seen = regs.seq(REG_WING_FL);
+    EXPECT_EQ(seen, 1u);
+    EXPECT_FALSE(regs.changedSince(REG_WING_FL, seen));
+    EXPECT_GE(regs.ageUs(REG_WING_FL), 0);
+
+    //Same value written again is still a new write
+    regs.storeDouble(REG_WING_FL, 90.0);
+    EXPECT_TRUE(regs.changedSince(REG_WING_FL, seen));
+
+    ptam_sample_t sample;
+    ASSERT_TRUE(regs.latest(REG_WING_FL, sample));
+    EXPECT_EQ(sample.seq, 2u);
+
+    //Other registers keep their own counter
+    EXPECT_EQ(regs.seq(REG_WING_FR), 0u);
+}
+
+TEST(TestFreshness, Clear_Keeps_Sequence){
+    RegisterFile regs;
+    regs.storeInt(REG_STATE, 1);
+    regs.storeInt(REG_STATE, 2);
+    regs.clear(REG_STATE);
+    EXPECT_EQ(regs.seq(REG_STATE), 2u);
+
+    //A reader that saw seq 2 must not miss the next write
+    regs.storeInt(REG_STATE, 3);
+    EXPECT_TRUE(regs.changedSince(REG_STATE, 2));
+    EXPECT_EQ(regs.seq(REG_STATE), 3u);
+}
+
+TEST(TestFreshness, History_Carries_Sequence){
+    RegisterFile regs;
+    for (int i = 0; i < 5; ++i) {
+        regs.storeDouble(REG_THR, i);
+    }
+    ptam_sample_t window[3];
+    ASSERT_EQ(regs.window(REG_THR, 3, window), 3);
+    EXPECT_EQ(window[0].seq, 3u);
+    EXPECT_EQ(window[2].seq, 5u);
+}
+
+TEST(TestHistoryView, Iterates_In_Place){
+    RegisterFile regs;
+    EXPECT_TRUE(regs.view(REG_THR).empty());
+
+    for (int i = 1; i <= 20; ++i) {
+        regs.storeDouble(REG_THR, i);
+    }
+    PTAMHistoryView history = regs.view(REG_THR);
+    ASSERT_EQ(history.size(), RegisterFile::depth(REG_THR));
+    EXPECT_EQ(history.reg(), REG_THR);
+
+    //Oldest first, after the ring wrapped
+    double expected = 20.0 - RegisterFile::depth(REG_THR) + 1.0;
+    for (const ptam_sample_t& sample : history) {
+        EXPECT_DOUBLE_EQ(sample.value.d, expected);
+        expected += 1.0;
+    }
+    EXPECT_DOUBLE_EQ(history.latest().value.d, 20.0);
+    EXPECT_DOUBLE_EQ(history[0].value.d, 5.0);
+}
+
+TEST(TestHistoryView, Shim_View_By_ID){
+    SharedMemory& sharedMemory = SharedMemory::getInstance();
+    sharedMemory.clearAllData();
+    sharedMemory.storeString(REG_STATE_DESCRIPT, "PREP");
+    sharedMemory.storeString(REG_STATE_DESCRIPT, "BYPASS");
+
+    {
+        PTAMHistoryView history = sharedMemory.view("stateDescript");
+        ASSERT_EQ(history.size(), 2u);
+        EXPECT_STREQ(history[1].value.s, "BYPASS");
+    }
+    //Undeclared IDs have no fixed storage to view
+    EXPECT_TRUE(sharedMemory.view("scratch").empty());
+
+    //The lock is released with the view
+    sharedMemory.storeString(REG_STATE_DESCRIPT, "ARMED");
+    EXPECT_EQ(sharedMemory.getLastString(REG_STATE_DESCRIPT), "ARMED");
+}
+
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
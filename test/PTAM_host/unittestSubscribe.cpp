@@ -0,0 +1,140 @@
+/**
+ * @file unittestSubscribe.cpp
+ * @brief PTAM change-notification unit testing
+ *
+ * Host-side tests for RegisterFile subscriptions using the PTAMNotifier mock
+ *
+ * @copyright Copyright (c) 2023 limitless Aeronautics
+ *            This file is part of the MARS Flight System Firmware
+ *
+ * @license MIT License
+ *          Copyright (c) 2023 limitless Aeronautics
+ *          Permission is hereby granted, free of charge, to any person obtaining a copy
+ *          of this software and associated documentation files (the "Software"), to deal
+ *          in the Software without restriction, including without limitation the rights
+ *          to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *          copies of the Software, and to permit persons to whom the Software is
+ *          furnished to do so, subject to the following conditions:
+ *          The above copyright notice and this permission notice shall be included in all
+ *          copies or substantial portions of the Software.
+ *          THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *          IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *          FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *          AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *          LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *          OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *          SOFTWARE.
+ */
+/* System includes */
+#include <pthread.h>
+#include <vector>
+
+/* Ptam includes */
+#include "_ptam.h"
+
+/* Google testing */
+#include <gtest/gtest.h>
+
+struct callback_log_t {
+    std::vector<ptam_reg_t> regs;
+    std::vector<uint32_t> seqs;
+};
+
+static void record(ptam_reg_t reg, const ptam_sample_t& sample, void* ctx) {
+    callback_log_t* log = static_cast<callback_log_t*>(ctx);
+    log->regs.push_back(reg);
+    log->seqs.push_back(sample.seq);
+}
+
+TEST(TestSubscribe, Callback_On_Matching_Writes){
+    RegisterFile regs;
+    callback_log_t log;
+    int id = regs.subscribe(ptam_mask(REG_WING_FL, REG_WING_RR), record, &log);
+    ASSERT_GE(id, 0);
+
+    regs.storeDouble(REG_WING_FL, 10.0);
+    regs.storeDouble(REG_WING_FR, 20.0);     //Not watched
+    regs.storeDouble(REG_WING_RR, 30.0);
+    regs.storeDouble(REG_WING_FL, 40.0);
+
+    ASSERT_EQ(log.regs.size(), 3u);
+    EXPECT_EQ(log.regs[0], REG_WING_FL);
+    EXPECT_EQ(log.regs[1], REG_WING_RR);
+    EXPECT_EQ(log.seqs[2], 2u);
+
+    //Rejected stores are not writes
+    regs.storeString(REG_WING_FL, "bad");
+    EXPECT_EQ(log.regs.size(), 3u);
+
+    regs.unsubscribe(id);
+    regs.storeDouble(REG_WING_FL, 50.0);
+    EXPECT_EQ(log.regs.size(), 3u);
+}
+
+TEST(TestSubscribe, Table_Full){
+    RegisterFile regs;
+    callback_log_t log;
+    int ids[PTAM_MAX_SUBSCRIBERS];
+    for (int& id : ids) {
+        id = regs.subscribe(ptam_mask(REG_THR), record, &log);
+        ASSERT_GE(id, 0);
+    }
+    EXPECT_EQ(regs.subscribe(ptam_mask(REG_THR), record, &log), -1);
+    EXPECT_EQ(regs.subscribe(0, record, &log), -1);
+
+    //A freed slot is reused
+    regs.unsubscribe(ids[3]);
+    EXPECT_EQ(regs.subscribe(ptam_mask(REG_THR), record, &log), ids[3]);
+
+    regs.storeDouble(REG_THR, 1.0);
+    EXPECT_EQ(log.regs.size(), static_cast<std::size_t>(PTAM_MAX_SUBSCRIBERS));
+}
+
+TEST(TestSubscribe, Notifier_Accumulates_Bits){
+    RegisterFile regs;
+    PTAMNotifier events;
+    regs.subscribe(ptam_mask(REG_STATE_DESCRIPT), events, 1u << 0);
+    regs.subscribe(ptam_mask(REG_WING_FL, REG_WING_FR), events, 1u << 1);
+
+    //Nothing written, times out with no bits
+    EXPECT_EQ(events.wait(1), 0u);
+
+    regs.storeString(REG_STATE_DESCRIPT, "BYPASS");
+    regs.storeDouble(REG_WING_FR, 90.0);
+    EXPECT_EQ(events.wait(0), (1u << 0) | (1u << 1));
+    //wait() consumes the pending bits
+    EXPECT_EQ(events.wait(0), 0u);
+}
+
+struct waiter_t {
+    PTAMNotifier* events;
+    uint32_t woken;
+};
+
+static void* wait_for_events(void* arg) {
+    waiter_t* waiter = static_cast<waiter_t*>(arg);
+    waiter->woken = waiter->events->wait(PTAM_WAIT_FOREVER);
+    return nullptr;
+}
+
+TEST(TestSubscribe, Notifier_Wakes_Waiting_Thread){
+    SharedMemory& sharedMemory = SharedMemory::getInstance();
+    PTAMNotifier events;
+    int id = sharedMemory.subscribe(ptam_mask(REG_WING_RL), events, 1u << 4);
+
+    waiter_t waiter = {&events, 0};
+    pthread_t consumer;
+    pthread_create(&consumer, nullptr, wait_for_events, &waiter);
+    //String ID writes go through the same register file
+    sharedMemory.storeDouble("WingRL", 120.0);
+    pthread_join(consumer, nullptr);
+
+    EXPECT_EQ(waiter.woken, 1u << 4);
+    sharedMemory.unsubscribe(id);
+}
+
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
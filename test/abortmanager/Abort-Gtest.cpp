@@ -30,6 +30,8 @@
 #include "gtest/gtest.h" // Include the Google Test framework
 #include "abort.h"       // Include the header file of the code to be tested
 #include <iostream>
+#include <chrono>
+#include <thread>
 
 // Define a test fixture class for common setup/teardown
 class VAMSTest : public ::testing::Test
@@ -46,7 +48,17 @@ protected:
     // Optional: Teardown code to be executed after each test
     void TearDown() override
     {
-        // Clean up resources if needed
+        // The pitch filter state is static, do not leak it into the next test
+        settle_level();
+    }
+
+    // Settle the pitch filter on a level attitude with the explicit-dt overload
+    void settle_level()
+    {
+        for (int i = 0; i < 2000; ++i)
+        {
+            vams.VERIFY_PITCH(0.0, 0.0, 9.81, 0.0, 0.0, 0.0, PITCH_NOMINAL_DT_S);
+        }
     }
 };
 
@@ -71,6 +83,47 @@ TEST_F(VAMSTest, PITCH_TEST)
 }
 
 
+TEST_F(VAMSTest, PITCH_EXPLICIT_DT_TEST)
+{
+    settle_level();
+
+    // Gyro rate integrated over dt, pulled towards the level accelerometer pitch
+    weighted_t result = vams.VERIFY_PITCH(0.0, 0.0, 9.81, 10.0, 0.0, 0.0, 0.1);
+    EXPECT_NEAR(result.data, ALPHA * 1.0, 1e-9);
+    EXPECT_EQ(result.vstatus, NO_LOSS_OF_CONTROL);
+
+    // No time elapsed: the estimate holds even with a tilted accelerometer
+    weighted_t held = vams.VERIFY_PITCH(9.81, 0.0, 0.0, 10.0, 0.0, 0.0, 0.0);
+    EXPECT_DOUBLE_EQ(held.data, result.data);
+
+    // A large rate over one step carries the estimate past the threshold
+    weighted_t lost = vams.VERIFY_PITCH(0.0, 0.0, 9.81, 2000.0, 0.0, 0.0, 0.1);
+    EXPECT_NEAR(lost.data, ALPHA * (held.data + 200.0), 1e-9);
+    EXPECT_EQ(lost.vstatus, LOSS_OF_CONTROL);
+}
+
+TEST_F(VAMSTest, PITCH_MEASURED_DT_TEST)
+{
+    settle_level();
+
+    // Level and still: only syncs the measured clock
+    weighted_t still = vams.VERIFY_PITCH(0.0, 0.0, 9.81, 0.0, 0.0, 0.0);
+    EXPECT_NEAR(still.data, 0.0, 1e-9);
+
+    // dt is the real interval, at least the 20 ms slept and at most PITCH_MAX_DT_S
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    weighted_t turning = vams.VERIFY_PITCH(0.0, 0.0, 9.81, 100.0, 0.0, 0.0);
+    EXPECT_GE(turning.data, ALPHA * still.data + ALPHA * 100.0 * 0.02 - 1e-9);
+    EXPECT_LE(turning.data, ALPHA * still.data + ALPHA * 100.0 * PITCH_MAX_DT_S + 1e-9);
+
+    // A gap longer than PITCH_MAX_DT_S is capped, not integrated in full
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    weighted_t capped = vams.VERIFY_PITCH(0.0, 0.0, 9.81, 100.0, 0.0, 0.0);
+    EXPECT_NEAR(capped.data, ALPHA * (turning.data + 100.0 * PITCH_MAX_DT_S), 1e-9);
+    EXPECT_EQ(capped.vstatus, NO_LOSS_OF_CONTROL);
+}
+
+
 TEST_F(VAMSTest, YAW_TEST)
 {
     double magn_x = 1.0;
@@ -29,12 +29,31 @@
 
 #include "abort.h"
 
+#ifdef ESP_PLATFORM
+#include "esp_timer.h"
+#else
+#include <chrono>
+#endif
+
 
 weighted_t VAMS::weighted_pitch;
 weighted_t VAMS::weighted_yaw;
 weighted_t VAMS::weighted_roll;
 weighted_t VAMS::weighted_path;
 
+double VAMS::pitch_estimate = NAN;
+int64_t VAMS::pitch_last_us = -1;
+
+int64_t VAMS::now_us() noexcept(true)
+{
+#ifdef ESP_PLATFORM
+    return esp_timer_get_time();
+#else
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
 
 /**
  * Calculate and verify the pitch angle using accelerometer and gyroscope data.
@@ -49,17 +68,42 @@ weighted_t VAMS::weighted_path;
  */
 weighted_t VAMS::VERIFY_PITCH(double accel_x, double accel_y, double accel_z, double gyro_x, double gyro_y, double gyro_z) noexcept(true)
 {
-    double pitch = atan2(accel_x, sqrt(accel_y * accel_y + accel_z * accel_z)) * 180.0 / M_PI;
-
+    // Real interval since the previous sample, not an assumed rate
+    const int64_t now = now_us();
+    double dt = pitch_last_us < 0 ? PITCH_NOMINAL_DT_S : (now - pitch_last_us) / 1e6;
+    pitch_last_us = now;
+    if (dt > PITCH_MAX_DT_S)
+    {
+        dt = PITCH_MAX_DT_S;
+    }
+    return VERIFY_PITCH(accel_x, accel_y, accel_z, gyro_x, gyro_y, gyro_z, dt);
+}
 
+/**
+ * Complementary filter step: the gyro rate integrated over dt from the
+ * previous estimate, pulled towards the accelerometer pitch.
+ *
+ * @param dt Seconds since the previous pitch sample.
+ * @return A weighted_t structure containing pitch angle information and a status flag.
+ */
+weighted_t VAMS::VERIFY_PITCH(double accel_x, double accel_y, double accel_z, double gyro_x, double gyro_y, double gyro_z, double dt) noexcept(true)
+{
+    double pitch = atan2(accel_x, sqrt(accel_y * accel_y + accel_z * accel_z)) * 180.0 / M_PI;
 
+    if (std::isnan(pitch_estimate))
+    {
+        // First sample: nothing to integrate from yet
+        pitch_estimate = pitch;
+    }
+    else if (dt > 0)
+    {
         // Calculate pitch from gyroscope data
-        double dt = 1.0; // Time interval
-        double pitchGyro = pitch + gyro_x * dt;
+        double pitchGyro = pitch_estimate + gyro_x * dt;
 
         // Combine accelerometer and gyroscope data using a complementary filter
-        pitch = ALPHA * pitchGyro + (1.0 - ALPHA) * pitch;
-
+        pitch_estimate = ALPHA * pitchGyro + (1.0 - ALPHA) * pitch;
+    }
+    pitch = pitch_estimate;
 
     weighted_t result;
     if ((pitch >= -PITCH_THRESHOLD_DEGREES && pitch <= PITCH_THRESHOLD_DEGREES) || pitch == 0)
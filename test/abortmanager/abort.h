@@ -31,9 +31,14 @@
 #define ABORT_H
 
 #include<cmath> // For math related functions
+#include<cstdint>
 #include"include/aborttypes.h" // For abort_t
 
 #define ALPHA                                 0.98
+//Expected interval between VERIFY_PITCH calls, used on the first call only
+#define PITCH_NOMINAL_DT_S                    0.01
+//Longer gaps (a paused check) are capped so the gyro term cannot run away
+#define PITCH_MAX_DT_S                        0.1
 
 #define PITCH_THRESHOLD_DEGREES             (int16_t)       90.00
 #define PITCH_THRESHOLD_RADIANS             (int16_t)       (PITCH_THRESHOLD_DEGREES * M_PI / 180)
@@ -66,6 +71,16 @@ public:
      */
     weighted_t VERIFY_PITCH(double accel_x, double accel_y, double accel_z, double gyro_x, double gyro_y, double gyro_z)noexcept(true);
 
+    /**
+     * @brief VERIFY_PITCH with an explicit time step
+     *
+     * The overload above measures the time since its previous call on the
+     * monotonic clock and passes it here.
+     *
+     * @param dt        Seconds since the previous pitch sample.
+     */
+    weighted_t VERIFY_PITCH(double accel_x, double accel_y, double accel_z, double gyro_x, double gyro_y, double gyro_z, double dt)noexcept(true);
+
     /**
      * @brief Verifies the range of vehicle YAW
      *
@@ -129,6 +144,14 @@ public:
     abort_t VAMS_MATRIX(weighted_t weighted_PI, weighted_t weighted_YA, weighted_t weighted_RO, weighted_t weightedPA);
 
 private:
+    /**
+     * @brief Monotonic time in microseconds (esp_timer on target, steady_clock on host)
+     */
+    static int64_t now_us()noexcept(true);
+
+    static double pitch_estimate;       // Complementary filter state, NAN before the first sample
+    static int64_t pitch_last_us;       // Time of the previous VERIFY_PITCH, -1 before the first
+
     static weighted_t weighted_pitch;
     static weighted_t weighted_yaw;
     static weighted_t weighted_roll;